@@ -1,6 +1,10 @@
 #ifndef __align_h__
 #define __align_h__ 1
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 #ifndef HAVE_POSIX_MEMALIGN
 
 #ifdef __GLIBC_PREREQ
@@ -56,21 +60,86 @@ inline void free0(void *p)
 
 namespace Array {
 
+// Arrays of at least HugePageBytes() bytes are aligned to, and padded to
+// a multiple of, hugepagesize bytes and, on Linux, marked for backing by
+// transparent huge pages, to reduce TLB misses in strided passes. If that
+// fails, the requested alignment is used instead. The default, 0, disables
+// huge pages.
+const size_t hugepagesize=2097152;
+
+inline size_t& HugePageBytes()
+{
+  static size_t bytes=0;
+  return bytes;
+}
+
+// Allocate bytes bytes aligned to align.
+inline int AllocateAlign(void **mem, size_t align, size_t bytes)
+{
+  size_t threshold=HugePageBytes();
+  if(threshold > 0 && bytes >= threshold && align <= hugepagesize) {
+    size_t padded=(bytes+hugepagesize-1)/hugepagesize*hugepagesize;
+#ifdef HAVE_POSIX_MEMALIGN
+    int rc=posix_memalign(mem,hugepagesize,padded);
+#else
+    int rc=posix_memalign0(mem,hugepagesize,padded);
+#endif
+    if(rc == 0) {
+#ifdef MADV_HUGEPAGE
+      madvise(*mem,padded,MADV_HUGEPAGE);
+#endif
+      return 0;
+    }
+  }
+#ifdef HAVE_POSIX_MEMALIGN
+  return posix_memalign(mem,align,bytes);
+#else
+  return posix_memalign0(mem,align,bytes);
+#endif
+}
+
+// The number of threads that construct the elements of the arrays
+// allocated by newAlign. With more than one thread, each thread first
+// touches, in the contiguous blocks of a static OpenMP schedule, the pages
+// of a large array that the parallel loops over it will later assign to
+// that thread, so that on a NUMA system they are placed on its own memory
+// node. The default is 1 (serial construction).
+inline unsigned int& FirstTouchThreads()
+{
+  static unsigned int threads=1;
+  return threads;
+}
+
+// Construct the len elements of v.
+template<class T>
+inline void Construct(T *v, size_t len)
+{
+#ifdef _OPENMP
+  int threads=FirstTouchThreads();
+  if(threads > 1 && len*sizeof(T) >= threads*4096UL) {
+    // Write to every page, even if T has a trivial constructor.
+#pragma omp parallel for num_threads(threads) schedule(static)
+    for(size_t i=0; i < len; i++) {
+      memset((void *) (v+i),0,sizeof(T));
+      new(v+i) T;
+    }
+    return;
+  }
+#endif
+  for(size_t i=0; i < len; i++) new(v+i) T;
+}
+
 template<class T>
 inline void newAlign(T *&v, size_t len, size_t align)
 {
   void *mem=NULL;
   const char *invalid="Invalid alignment requested";
   const char *nomem="Memory limits exceeded";
-#ifdef HAVE_POSIX_MEMALIGN
-  int rc=posix_memalign(&mem,align,len*sizeof(T));
-#else  
-  int rc=posix_memalign0(&mem,align,len*sizeof(T));
-#endif  
+  int rc=AllocateAlign(&mem,align,len*sizeof(T));
   if(rc == EINVAL) std::cerr << invalid << std::endl;
   if(rc == ENOMEM) std::cerr << nomem << std::endl;
   v=(T *) mem;
-  for(size_t i=0; i < len; i++) new(v+i) T;
+  Construct(v,len);
 }
 
 template<class T>
@@ -101,6 +170,17 @@ inline Complex *ComplexAlign(size_t size)
   return v;
 }
 
+// Allocate an array of size values of the complex type C (e.g.
+// std::complex<float>), aligned to at least sizeof(Complex).
+template<class C>
+inline C *ComplexAlign(size_t size)
+{
+  C *v;
+  Array::newAlign(v,size,sizeof(C) > sizeof(Complex) ? sizeof(C) :
+                  sizeof(Complex));
+  return v;
+}
+
 inline double *doubleAlign(size_t size)
 {
   double *v;
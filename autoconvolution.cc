@@ -0,0 +1,532 @@
+#include "autoconvolution.h"
+
+#include <vector>
+
+using namespace std;
+using namespace utils;
+
+namespace fftwpp {
+
+const char *EngineName[]={"implicit","explicit","direct"};
+
+unsigned int AutoConvolution::directmax=512;
+unsigned int AutoHConvolution::directmax=512;
+unsigned int AutoConvolution2::directmax=512;
+unsigned int AutoHConvolution2::directmax=512;
+unsigned int AutoConvolution3::directmax=512;
+unsigned int AutoHConvolution3::directmax=512;
+
+unsigned int fftsize(unsigned int n)
+{
+  static const unsigned int prime[]={2,3,5,7};
+  if(n <= 1) return 1;
+  for(;; ++n) {
+    unsigned int k=n;
+    for(unsigned int i=0; i < 4; ++i)
+      while(k % prime[i] == 0) k /= prime[i];
+    if(k == 1) return n;
+  }
+}
+
+// The engine chosen for each dimension, size mx x my x mz, number of
+// inputs A and outputs B, and number of threads, for complex
+// (hermitian=false) and Hermitian convolutions; never destroyed, so that
+// it outlives any static convolution objects.
+typedef vector<unsigned int> EngineKey;
+typedef map<EngineKey,Engine> EngineMap;
+
+static EngineMap& EngineCache(bool hermitian)
+{
+  static EngineMap *cache=new EngineMap[2];
+  return cache[hermitian];
+}
+
+// Return the mean time of a convolution of the arrays f and g with C.
+template<class T>
+static double Time(T& C, Complex *f, Complex *g)
+{
+  C.convolve(f,g);
+  double stop=totalseconds()+0.05*fftwbase::testseconds;
+  unsigned int N=0;
+  double t0=totalseconds();
+  double t;
+  do {
+    C.convolve(f,g);
+    ++N;
+  } while((t=totalseconds()) < stop && N < 1000);
+  return (t-t0)/N;
+}
+
+// Return the fastest engine for the binary convolution C, timing each
+// available engine on zero data the first time that its parameters are
+// seen.
+template<class T>
+static Engine Select(T& C, bool hermitian, unsigned int dimension,
+                     unsigned int mx, unsigned int my, unsigned int mz,
+                     unsigned int threads)
+{
+  Planlock lock;
+  EngineMap& cache=EngineCache(hermitian);
+  unsigned int A=2, B=1;
+  unsigned int k[]={dimension,mx,my,mz,A,B,threads};
+  EngineKey key(k,k+sizeof(k)/sizeof(unsigned int));
+  EngineMap::iterator p=cache.find(key);
+  if(p != cache.end()) return p->second;
+
+  Engine best=IMPLICIT;
+  if(!(fftwbase::effort & FFTW_ESTIMATE) && !fftwbase::upgrade) {
+    unsigned int n=C.size();
+    Complex *f=ComplexAlign(2*n);
+    double tbest=0.0;
+    for(int e=IMPLICIT; e <= DIRECT; ++e) {
+      if(!C.available((Engine) e)) continue;
+      for(unsigned int i=0; i < 2*n; ++i)
+        f[i]=0.0;
+      C.init((Engine) e);
+      double t=Time(C,f,f+n);
+      C.clear();
+      if(e == IMPLICIT || t < tbest) {
+        best=(Engine) e;
+        tbest=t;
+      }
+    }
+    deleteAlign(f);
+  }
+  cache[key]=best;
+  return best;
+}
+
+AutoConvolution::AutoConvolution(unsigned int m, unsigned int threads) :
+  ThreadBase(threads), m(m), n(0), u(NULL), v(NULL), implicit(NULL),
+  Explicit(NULL), direct(NULL)
+{
+  init(Select(*this,false,1,m,1,1,threads));
+}
+
+void AutoConvolution::init(Engine e)
+{
+  selected=e;
+  switch(e) {
+    case IMPLICIT:
+      implicit=new ImplicitConvolution(m,2,1,threads);
+      break;
+    case EXPLICIT:
+      n=fftsize(2*m);
+      u=ComplexAlign(n);
+      v=ComplexAlign(n);
+      Explicit=new ExplicitConvolution(n,m,u,threads);
+      break;
+    case DIRECT:
+      u=ComplexAlign(m);
+      direct=new DirectConvolution(m,1);
+      break;
+  }
+}
+
+void AutoConvolution::clear()
+{
+  delete implicit;
+  delete Explicit;
+  delete direct;
+  if(v) deleteAlign(v);
+  if(u) deleteAlign(u);
+  implicit=NULL;
+  Explicit=NULL;
+  direct=NULL;
+  u=v=NULL;
+}
+
+void AutoConvolution::convolve(Complex *f, Complex *g)
+{
+  switch(selected) {
+    case IMPLICIT: {
+      Complex *F[]={f,g};
+      implicit->convolve(F,multbinary);
+      break;
+    }
+    case EXPLICIT:
+      for(unsigned int i=0; i < m; ++i) {
+        u[i]=f[i];
+        v[i]=g[i];
+      }
+      Explicit->convolve(u,v);
+      for(unsigned int i=0; i < m; ++i)
+        f[i]=u[i];
+      break;
+    case DIRECT:
+      direct->convolve(u,f,g);
+      for(unsigned int i=0; i < m; ++i)
+        f[i]=u[i];
+      break;
+  }
+}
+
+AutoHConvolution::AutoHConvolution(unsigned int m, unsigned int threads) :
+  ThreadBase(threads), m(m), n(0), u(NULL), v(NULL), implicit(NULL),
+  Explicit(NULL), direct(NULL)
+{
+  init(Select(*this,true,1,m,1,1,threads));
+}
+
+void AutoHConvolution::init(Engine e)
+{
+  selected=e;
+  switch(e) {
+    case IMPLICIT:
+      implicit=new ImplicitHConvolution(m,true,2,1,threads);
+      break;
+    case EXPLICIT: {
+      n=fftsize(3*m-2);
+      unsigned int n2=n/2+1;
+      u=ComplexAlign(n2);
+      v=ComplexAlign(n2);
+      Explicit=new ExplicitHConvolution(n,m,u,threads);
+      break;
+    }
+    case DIRECT:
+      u=ComplexAlign(m);
+      direct=new DirectHConvolution(m,1);
+      break;
+  }
+}
+
+void AutoHConvolution::clear()
+{
+  delete implicit;
+  delete Explicit;
+  delete direct;
+  if(v) deleteAlign(v);
+  if(u) deleteAlign(u);
+  implicit=NULL;
+  Explicit=NULL;
+  direct=NULL;
+  u=v=NULL;
+}
+
+void AutoHConvolution::convolve(Complex *f, Complex *g)
+{
+  switch(selected) {
+    case IMPLICIT: {
+      Complex *F[]={f,g};
+      implicit->convolve(F,multbinary);
+      break;
+    }
+    case EXPLICIT:
+      for(unsigned int i=0; i < m; ++i) {
+        u[i]=f[i];
+        v[i]=g[i];
+      }
+      Explicit->convolve(u,v);
+      for(unsigned int i=0; i < m; ++i)
+        f[i]=u[i];
+      break;
+    case DIRECT:
+      direct->convolve(u,f,g);
+      for(unsigned int i=0; i < m; ++i)
+        f[i]=u[i];
+      break;
+  }
+}
+
+AutoConvolution2::AutoConvolution2(unsigned int mx, unsigned int my,
+                                   unsigned int threads) :
+  ThreadBase(threads), mx(mx), my(my), nx(0), ny(0), u(NULL), v(NULL),
+  implicit(NULL), Explicit(NULL), direct(NULL)
+{
+  init(Select(*this,false,2,mx,my,1,threads));
+}
+
+void AutoConvolution2::init(Engine e)
+{
+  selected=e;
+  switch(e) {
+    case IMPLICIT:
+      implicit=new ImplicitConvolution2(mx,my,2,1,threads);
+      break;
+    case EXPLICIT:
+      nx=fftsize(2*mx);
+      ny=fftsize(2*my);
+      u=ComplexAlign(nx*ny);
+      v=ComplexAlign(nx*ny);
+      Explicit=new ExplicitConvolution2(nx,ny,mx,my,u,true);
+      break;
+    case DIRECT:
+      u=ComplexAlign(mx*my);
+      direct=new DirectConvolution2(mx,my);
+      break;
+  }
+}
+
+void AutoConvolution2::clear()
+{
+  delete implicit;
+  delete Explicit;
+  delete direct;
+  if(v) deleteAlign(v);
+  if(u) deleteAlign(u);
+  implicit=NULL;
+  Explicit=NULL;
+  direct=NULL;
+  u=v=NULL;
+}
+
+void AutoConvolution2::convolve(Complex *f, Complex *g)
+{
+  switch(selected) {
+    case IMPLICIT: {
+      Complex *F[]={f,g};
+      implicit->convolve(F,multbinary);
+      break;
+    }
+    case EXPLICIT:
+      for(unsigned int i=0; i < mx; ++i) {
+        unsigned int myi=my*i;
+        unsigned int nyi=ny*i;
+        for(unsigned int j=0; j < my; ++j) {
+          u[nyi+j]=f[myi+j];
+          v[nyi+j]=g[myi+j];
+        }
+      }
+      Explicit->convolve(u,v);
+      for(unsigned int i=0; i < mx; ++i) {
+        unsigned int myi=my*i;
+        unsigned int nyi=ny*i;
+        for(unsigned int j=0; j < my; ++j)
+          f[myi+j]=u[nyi+j];
+      }
+      break;
+    case DIRECT: {
+      direct->convolve(u,f,g);
+      unsigned int n=mx*my;
+      for(unsigned int i=0; i < n; ++i)
+        f[i]=u[i];
+      break;
+    }
+  }
+}
+
+AutoHConvolution2::AutoHConvolution2(unsigned int mx, unsigned int my,
+                                     unsigned int threads) :
+  ThreadBase(threads), mx(mx), my(my), nx(0), ny(0), u(NULL), v(NULL),
+  implicit(NULL), Explicit(NULL), direct(NULL)
+{
+  init(Select(*this,true,2,mx,my,1,threads));
+}
+
+void AutoHConvolution2::init(Engine e)
+{
+  selected=e;
+  switch(e) {
+    case IMPLICIT:
+      implicit=new ImplicitHConvolution2(mx,my,true,true,2,1,threads);
+      break;
+    case EXPLICIT: {
+      // ExplicitHConvolution2 requires even nx, and is only pruned
+      // correctly for some sizes.
+      nx=2*fftsize(ceilquotient(3*mx-2,2));
+      ny=fftsize(3*my-2);
+      unsigned int nyp=ny/2+1;
+      u=ComplexAlign(nx*nyp);
+      v=ComplexAlign(nx*nyp);
+      Explicit=new ExplicitHConvolution2(nx,ny,mx,my,u);
+      break;
+    }
+    case DIRECT:
+      u=ComplexAlign(size());
+      direct=new DirectHConvolution2(mx,my);
+      break;
+  }
+}
+
+void AutoHConvolution2::clear()
+{
+  delete implicit;
+  delete Explicit;
+  delete direct;
+  if(v) deleteAlign(v);
+  if(u) deleteAlign(u);
+  implicit=NULL;
+  Explicit=NULL;
+  direct=NULL;
+  u=v=NULL;
+}
+
+void AutoHConvolution2::convolve(Complex *f, Complex *g)
+{
+  switch(selected) {
+    case IMPLICIT: {
+      Complex *F[]={f,g};
+      implicit->convolve(F,multbinary);
+      break;
+    }
+    case EXPLICIT: {
+      // The explicit x origin is at row nx/2.
+      unsigned int nyp=ny/2+1;
+      unsigned int stop=2*mx-1;
+      Complex *u0=u+(nx/2-mx+1)*nyp;
+      Complex *v0=v+(nx/2-mx+1)*nyp;
+      for(unsigned int i=0; i < stop; ++i) {
+        unsigned int myi=my*i;
+        unsigned int nyi=nyp*i;
+        for(unsigned int j=0; j < my; ++j) {
+          u0[nyi+j]=f[myi+j];
+          v0[nyi+j]=g[myi+j];
+        }
+      }
+      Explicit->convolve(u,v);
+      for(unsigned int i=0; i < stop; ++i) {
+        unsigned int myi=my*i;
+        unsigned int nyi=nyp*i;
+        for(unsigned int j=0; j < my; ++j)
+          f[myi+j]=u0[nyi+j];
+      }
+      break;
+    }
+    case DIRECT: {
+      direct->convolve(u,f,g);
+      unsigned int n=size();
+      for(unsigned int i=0; i < n; ++i)
+        f[i]=u[i];
+      break;
+    }
+  }
+}
+
+AutoConvolution3::AutoConvolution3(unsigned int mx, unsigned int my,
+                                   unsigned int mz, unsigned int threads) :
+  ThreadBase(threads), mx(mx), my(my), mz(mz), nx(0), ny(0), nz(0),
+  u(NULL), v(NULL), implicit(NULL), Explicit(NULL), direct(NULL)
+{
+  init(Select(*this,false,3,mx,my,mz,threads));
+}
+
+void AutoConvolution3::init(Engine e)
+{
+  selected=e;
+  switch(e) {
+    case IMPLICIT:
+      implicit=new ImplicitConvolution3(mx,my,mz,2,1,threads);
+      break;
+    case EXPLICIT:
+      nx=fftsize(2*mx);
+      ny=fftsize(2*my);
+      nz=fftsize(2*mz);
+      u=ComplexAlign(nx*ny*nz);
+      v=ComplexAlign(nx*ny*nz);
+      Explicit=new ExplicitConvolution3(nx,ny,nz,mx,my,mz,u,true);
+      break;
+    case DIRECT:
+      u=ComplexAlign(size());
+      direct=new DirectConvolution3(mx,my,mz);
+      break;
+  }
+}
+
+void AutoConvolution3::clear()
+{
+  delete implicit;
+  delete Explicit;
+  delete direct;
+  if(v) deleteAlign(v);
+  if(u) deleteAlign(u);
+  implicit=NULL;
+  Explicit=NULL;
+  direct=NULL;
+  u=v=NULL;
+}
+
+void AutoConvolution3::convolve(Complex *f, Complex *g)
+{
+  switch(selected) {
+    case IMPLICIT: {
+      Complex *F[]={f,g};
+      implicit->convolve(F,multbinary);
+      break;
+    }
+    case EXPLICIT:
+      for(unsigned int i=0; i < mx; ++i) {
+        for(unsigned int j=0; j < my; ++j) {
+          unsigned int mij=mz*(my*i+j);
+          unsigned int nij=nz*(ny*i+j);
+          for(unsigned int k=0; k < mz; ++k) {
+            u[nij+k]=f[mij+k];
+            v[nij+k]=g[mij+k];
+          }
+        }
+      }
+      Explicit->convolve(u,v);
+      for(unsigned int i=0; i < mx; ++i) {
+        for(unsigned int j=0; j < my; ++j) {
+          unsigned int mij=mz*(my*i+j);
+          unsigned int nij=nz*(ny*i+j);
+          for(unsigned int k=0; k < mz; ++k)
+            f[mij+k]=u[nij+k];
+        }
+      }
+      break;
+    case DIRECT: {
+      direct->convolve(u,f,g);
+      unsigned int n=size();
+      for(unsigned int i=0; i < n; ++i)
+        f[i]=u[i];
+      break;
+    }
+  }
+}
+
+AutoHConvolution3::AutoHConvolution3(unsigned int mx, unsigned int my,
+                                     unsigned int mz, unsigned int threads) :
+  ThreadBase(threads), mx(mx), my(my), mz(mz), u(NULL), implicit(NULL),
+  direct(NULL)
+{
+  init(Select(*this,true,3,mx,my,mz,threads));
+}
+
+void AutoHConvolution3::init(Engine e)
+{
+  selected=e;
+  switch(e) {
+    case IMPLICIT:
+      implicit=new ImplicitHConvolution3(mx,my,mz,true,true,true,2,1,
+                                         threads);
+      break;
+    case EXPLICIT:
+      break;
+    case DIRECT:
+      u=ComplexAlign(size());
+      direct=new DirectHConvolution3(mx,my,mz);
+      break;
+  }
+}
+
+void AutoHConvolution3::clear()
+{
+  delete implicit;
+  delete direct;
+  if(u) deleteAlign(u);
+  implicit=NULL;
+  direct=NULL;
+  u=NULL;
+}
+
+void AutoHConvolution3::convolve(Complex *f, Complex *g)
+{
+  switch(selected) {
+    case IMPLICIT: {
+      Complex *F[]={f,g};
+      implicit->convolve(F,multbinary);
+      break;
+    }
+    case EXPLICIT:
+      break;
+    case DIRECT: {
+      direct->convolve(u,f,g);
+      unsigned int n=size();
+      for(unsigned int i=0; i < n; ++i)
+        f[i]=u[i];
+      break;
+    }
+  }
+}
+
+} //end namespace fftwpp
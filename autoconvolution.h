@@ -0,0 +1,256 @@
+/* Automatic selection of the convolution engine.
+   Copyright (C) 2010-2015 John C. Bowman and Malcolm Roberts, Univ. of Alberta
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
+
+#include "convolution.h"
+#include "explicit.h"
+#include "direct.h"
+
+namespace fftwpp {
+
+#ifndef __autoconvolution_h__
+#define __autoconvolution_h__ 1
+
+// The ways of computing a binary convolution: implicit dealiasing,
+// explicit zero padding, and direct summation.
+enum Engine {IMPLICIT,EXPLICIT,DIRECT};
+extern const char *EngineName[]; // "implicit", "explicit", "direct"
+
+// Return the smallest integer greater than or equal to n whose only prime
+// factors are 2, 3, 5, and 7.
+unsigned int fftsize(unsigned int n);
+
+// In-place binary 1D complex convolution that uses whichever of the
+// implicitly dealiased, explicitly padded, and direct engines is fastest on
+// this processor. The engines are timed once for each dimension, size,
+// number of inputs and outputs, and number of threads; later objects with
+// the same parameters reuse the cached choice. Explicit padding is to the
+// size fftsize(2*m), and single-threaded direct summation is only tried
+// for m <= directmax. Under FFTW_ESTIMATE, IMPLICIT is used.
+class AutoConvolution : public ThreadBase {
+protected:
+  unsigned int m;
+  unsigned int n;
+  Engine selected;
+  Complex *u,*v;
+  ImplicitConvolution *implicit;
+  ExplicitConvolution *Explicit;
+  DirectConvolution *direct;
+public:
+  static unsigned int directmax;
+
+  AutoConvolution(unsigned int m, unsigned int threads=fftw::maxthreads);
+
+  ~AutoConvolution() {
+    clear();
+  }
+
+  void init(Engine e);
+  void clear();
+
+  // The number of values in each input.
+  unsigned int size() const {return m;}
+  bool available(Engine e) const {return e != DIRECT || m <= directmax;}
+
+  Engine engine() const {return selected;}
+
+  // Compute f (*) g, where f and g contain m complex values (contents not
+  // preserved). The output is returned in f.
+  void convolve(Complex *f, Complex *g);
+};
+
+// In-place binary 1D Hermitian convolution that uses the fastest engine,
+// like AutoConvolution. Explicit padding is to the size fftsize(3*m-2).
+class AutoHConvolution : public ThreadBase {
+protected:
+  unsigned int m;
+  unsigned int n;
+  Engine selected;
+  Complex *u,*v;
+  ImplicitHConvolution *implicit;
+  ExplicitHConvolution *Explicit;
+  DirectHConvolution *direct;
+public:
+  static unsigned int directmax;
+
+  AutoHConvolution(unsigned int m, unsigned int threads=fftw::maxthreads);
+
+  ~AutoHConvolution() {
+    clear();
+  }
+
+  void init(Engine e);
+  void clear();
+
+  unsigned int size() const {return m;}
+  bool available(Engine e) const {return e != DIRECT || m <= directmax;}
+
+  Engine engine() const {return selected;}
+
+  // Compute f (*) g, where f and g contain the m non-negative Fourier
+  // components of real functions (contents not preserved). The output is
+  // returned in f.
+  void convolve(Complex *f, Complex *g);
+};
+
+// In-place binary 2D complex convolution of mx x my arrays that uses the
+// fastest engine, like AutoConvolution. Explicit padding is to the size
+// fftsize(2*mx) x fftsize(2*my), and direct summation is only tried for
+// mx*my <= directmax.
+class AutoConvolution2 : public ThreadBase {
+protected:
+  unsigned int mx,my;
+  unsigned int nx,ny;
+  Engine selected;
+  Complex *u,*v;
+  ImplicitConvolution2 *implicit;
+  ExplicitConvolution2 *Explicit;
+  DirectConvolution2 *direct;
+public:
+  static unsigned int directmax;
+
+  AutoConvolution2(unsigned int mx, unsigned int my,
+                   unsigned int threads=fftw::maxthreads);
+
+  ~AutoConvolution2() {
+    clear();
+  }
+
+  void init(Engine e);
+  void clear();
+
+  unsigned int size() const {return mx*my;}
+  bool available(Engine e) const {return e != DIRECT || size() <= directmax;}
+
+  Engine engine() const {return selected;}
+
+  // Compute f (*) g, where f and g contain mx x my complex values (contents
+  // not preserved). The output is returned in f.
+  void convolve(Complex *f, Complex *g);
+};
+
+// In-place binary 2D Hermitian convolution that uses the fastest engine,
+// like AutoConvolution. The inputs are stored as in a compact
+// ImplicitHConvolution2: (2mx-1) x my arrays with the x origin at row mx-1.
+// Explicit padding is to the size nx x fftsize(3*my-2), where the even
+// length nx=2*fftsize(ceil((3*mx-2)/2)), and direct summation is only tried
+// for (2mx-1)*my <= directmax.
+class AutoHConvolution2 : public ThreadBase {
+protected:
+  unsigned int mx,my;
+  unsigned int nx,ny;
+  Engine selected;
+  Complex *u,*v;
+  ImplicitHConvolution2 *implicit;
+  ExplicitHConvolution2 *Explicit;
+  DirectHConvolution2 *direct;
+public:
+  static unsigned int directmax;
+
+  AutoHConvolution2(unsigned int mx, unsigned int my,
+                    unsigned int threads=fftw::maxthreads);
+
+  ~AutoHConvolution2() {
+    clear();
+  }
+
+  void init(Engine e);
+  void clear();
+
+  unsigned int size() const {return (2*mx-1)*my;}
+  bool available(Engine e) const {return e != DIRECT || size() <= directmax;}
+
+  Engine engine() const {return selected;}
+
+  // Compute f (*) g (contents not preserved). The output is returned in f.
+  void convolve(Complex *f, Complex *g);
+};
+
+// In-place binary 3D complex convolution of mx x my x mz arrays that uses
+// the fastest engine, like AutoConvolution. Explicit padding is to the size
+// fftsize(2*mx) x fftsize(2*my) x fftsize(2*mz), and direct summation is
+// only tried for mx*my*mz <= directmax.
+class AutoConvolution3 : public ThreadBase {
+protected:
+  unsigned int mx,my,mz;
+  unsigned int nx,ny,nz;
+  Engine selected;
+  Complex *u,*v;
+  ImplicitConvolution3 *implicit;
+  ExplicitConvolution3 *Explicit;
+  DirectConvolution3 *direct;
+public:
+  static unsigned int directmax;
+
+  AutoConvolution3(unsigned int mx, unsigned int my, unsigned int mz,
+                   unsigned int threads=fftw::maxthreads);
+
+  ~AutoConvolution3() {
+    clear();
+  }
+
+  void init(Engine e);
+  void clear();
+
+  unsigned int size() const {return mx*my*mz;}
+  bool available(Engine e) const {return e != DIRECT || size() <= directmax;}
+
+  Engine engine() const {return selected;}
+
+  // Compute f (*) g, where f and g contain mx x my x mz complex values
+  // (contents not preserved). The output is returned in f.
+  void convolve(Complex *f, Complex *g);
+};
+
+// In-place binary 3D Hermitian convolution that uses the faster of the
+// implicit and direct engines; there is no explicitly padded 3D Hermitian
+// convolution. The inputs are stored as in a compact ImplicitHConvolution3:
+// (2mx-1) x (2my-1) x mz arrays with the origin at (mx-1,my-1,0). Direct
+// summation is only tried for (2mx-1)*(2my-1)*mz <= directmax.
+class AutoHConvolution3 : public ThreadBase {
+protected:
+  unsigned int mx,my,mz;
+  Engine selected;
+  Complex *u;
+  ImplicitHConvolution3 *implicit;
+  DirectHConvolution3 *direct;
+public:
+  static unsigned int directmax;
+
+  AutoHConvolution3(unsigned int mx, unsigned int my, unsigned int mz,
+                    unsigned int threads=fftw::maxthreads);
+
+  ~AutoHConvolution3() {
+    clear();
+  }
+
+  void init(Engine e);
+  void clear();
+
+  unsigned int size() const {return (2*mx-1)*(2*my-1)*mz;}
+  bool available(Engine e) const {
+    return e == IMPLICIT || (e == DIRECT && size() <= directmax);
+  }
+
+  Engine engine() const {return selected;}
+
+  // Compute f (*) g (contents not preserved). The output is returned in f.
+  void convolve(Complex *f, Complex *g);
+};
+
+#endif
+
+} //end namespace fftwpp
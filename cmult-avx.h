@@ -0,0 +1,319 @@
+/* AVX and AVX-512 complex multiplication routines
+   Copyright (C) 2017 John C. Bowman, University of Alberta
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
+
+// A Pvec packs PVECSIZE consecutive complex values (2*PVECSIZE doubles);
+// the routines below act on each complex value like their Vec counterparts.
+
+// This file has no include guard: it defines the Pvec routines in the
+// enclosing namespace, for AVX-512 if PVECSIZE is 4 and for AVX2 with FMA
+// if PVECSIZE is 2, and may be included once for each, after <immintrin.h>
+// and cmult-sse2.h. The code must be compiled for the corresponding
+// instruction set, either by the compiler flags or by a target pragma.
+
+// Keep the Vec routines visible next to their Pvec overloads.
+using fftwpp::UNPACKL;
+using fftwpp::UNPACKH;
+using fftwpp::FLIP;
+using fftwpp::CONJ;
+using fftwpp::ZMULT;
+using fftwpp::ZMULTC;
+using fftwpp::ZMULTI;
+using fftwpp::ZMULTIC;
+#if defined(__INTEL_COMPILER) || !defined(__GNUC__)
+using fftwpp::operator -;
+using fftwpp::operator +;
+using fftwpp::operator *;
+using fftwpp::operator +=;
+using fftwpp::operator -=;
+using fftwpp::operator *=;
+#endif
+
+#if PVECSIZE == 4
+
+typedef __m512d Pvec;
+
+// The zero-masked forms of the permutations below, with every element
+// selected, avoid spurious uninitialized-value warnings from some versions
+// of GCC.
+const __mmask8 pvec_all=0xFF;
+
+#if defined(__INTEL_COMPILER) || !defined(__GNUC__)
+static inline Pvec operator -(const Pvec& a)
+{
+  return _mm512_sub_pd(_mm512_setzero_pd(),a);
+}
+
+static inline Pvec operator +(const Pvec& a, const Pvec& b)
+{
+  return _mm512_add_pd(a,b);
+}
+
+static inline Pvec operator -(const Pvec& a, const Pvec& b)
+{
+  return _mm512_sub_pd(a,b);
+}
+
+static inline Pvec operator *(const Pvec& a, const Pvec& b)
+{
+  return _mm512_mul_pd(a,b);
+}
+
+static inline void operator +=(Pvec& a, const Pvec& b)
+{
+  a=_mm512_add_pd(a,b);
+}
+
+static inline void operator -=(Pvec& a, const Pvec& b)
+{
+  a=_mm512_sub_pd(a,b);
+}
+
+static inline void operator *=(Pvec& a, const Pvec& b)
+{
+  a=_mm512_mul_pd(a,b);
+}
+#endif
+
+static inline Pvec PXOR(const Pvec& a, const Pvec& b)
+{
+  return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a),
+                                              _mm512_castpd_si512(b)));
+}
+
+// Return a*b+c.
+static inline Pvec MADD(const Pvec& a, const Pvec& b, const Pvec& c)
+{
+  return _mm512_fmadd_pd(a,b,c);
+}
+
+// Return a*b-c in the real parts and a*b+c in the imaginary parts.
+static inline Pvec MADDSUB(const Pvec& a, const Pvec& b, const Pvec& c)
+{
+  return _mm512_fmaddsub_pd(a,b,c);
+}
+
+// Return a*b+c in the real parts and a*b-c in the imaginary parts.
+static inline Pvec MSUBADD(const Pvec& a, const Pvec& b, const Pvec& c)
+{
+  return _mm512_fmsubadd_pd(a,b,c);
+}
+
+// Return (z.x,w.x) for each complex value.
+static inline Pvec UNPACKL(const Pvec& z, const Pvec& w)
+{
+  return _mm512_maskz_unpacklo_pd(pvec_all,z,w);
+}
+
+// Return (z.y,w.y) for each complex value.
+static inline Pvec UNPACKH(const Pvec& z, const Pvec& w)
+{
+  return _mm512_maskz_unpackhi_pd(pvec_all,z,w);
+}
+
+// Return (z.y,z.x) for each complex value.
+static inline Pvec FLIP(const Pvec& z)
+{
+  return _mm512_maskz_permute_pd(pvec_all,z,0x55);
+}
+
+// Return the complex values of z in reverse order.
+static inline Pvec REVERSE(const Pvec& z)
+{
+  return _mm512_maskz_shuffle_f64x2(pvec_all,z,z,0x1B);
+}
+
+// Return PVECSIZE copies of z.
+static inline Pvec PLOAD(const Vec& z)
+{
+  return _mm512_castps_pd(_mm512_maskz_broadcast_f32x4(0xFFFF,
+                                                         _mm_castpd_ps(z)));
+}
+
+static inline Pvec PLOAD(double x)
+{
+  return _mm512_set1_pd(x);
+}
+
+static inline Pvec PLOAD(const double *z)
+{
+  return _mm512_loadu_pd(z);
+}
+
+static inline void PSTORE(double *z, const Pvec& v)
+{
+  _mm512_storeu_pd(z,v);
+}
+
+#else
+
+typedef __m256d Pvec;
+
+#if defined(__INTEL_COMPILER) || !defined(__GNUC__)
+static inline Pvec operator -(const Pvec& a)
+{
+  return _mm256_sub_pd(_mm256_setzero_pd(),a);
+}
+
+static inline Pvec operator +(const Pvec& a, const Pvec& b)
+{
+  return _mm256_add_pd(a,b);
+}
+
+static inline Pvec operator -(const Pvec& a, const Pvec& b)
+{
+  return _mm256_sub_pd(a,b);
+}
+
+static inline Pvec operator *(const Pvec& a, const Pvec& b)
+{
+  return _mm256_mul_pd(a,b);
+}
+
+static inline void operator +=(Pvec& a, const Pvec& b)
+{
+  a=_mm256_add_pd(a,b);
+}
+
+static inline void operator -=(Pvec& a, const Pvec& b)
+{
+  a=_mm256_sub_pd(a,b);
+}
+
+static inline void operator *=(Pvec& a, const Pvec& b)
+{
+  a=_mm256_mul_pd(a,b);
+}
+#endif
+
+static inline Pvec PXOR(const Pvec& a, const Pvec& b)
+{
+  return _mm256_xor_pd(a,b);
+}
+
+static inline Pvec MADD(const Pvec& a, const Pvec& b, const Pvec& c)
+{
+  return _mm256_fmadd_pd(a,b,c);
+}
+
+static inline Pvec MADDSUB(const Pvec& a, const Pvec& b, const Pvec& c)
+{
+  return _mm256_fmaddsub_pd(a,b,c);
+}
+
+static inline Pvec MSUBADD(const Pvec& a, const Pvec& b, const Pvec& c)
+{
+  return _mm256_fmsubadd_pd(a,b,c);
+}
+
+static inline Pvec UNPACKL(const Pvec& z, const Pvec& w)
+{
+  return _mm256_unpacklo_pd(z,w);
+}
+
+static inline Pvec UNPACKH(const Pvec& z, const Pvec& w)
+{
+  return _mm256_unpackhi_pd(z,w);
+}
+
+static inline Pvec FLIP(const Pvec& z)
+{
+  return _mm256_permute_pd(z,5);
+}
+
+static inline Pvec REVERSE(const Pvec& z)
+{
+  return _mm256_permute2f128_pd(z,z,1);
+}
+
+static inline Pvec PLOAD(const Vec& z)
+{
+  return _mm256_broadcast_pd(&z);
+}
+
+static inline Pvec PLOAD(double x)
+{
+  return _mm256_set1_pd(x);
+}
+
+static inline Pvec PLOAD(const double *z)
+{
+  return _mm256_loadu_pd(z);
+}
+
+static inline void PSTORE(double *z, const Pvec& v)
+{
+  _mm256_storeu_pd(z,v);
+}
+
+#endif
+
+// Return (z.x,-z.y) for each complex value.
+static inline Pvec CONJ(const Pvec& z)
+{
+  return PXOR(PLOAD(sse2_pm.v),z);
+}
+
+static inline Pvec PLOAD(const Complex *z)
+{
+  return PLOAD((const double *) z);
+}
+
+static inline void PSTORE(Complex *z, const Pvec& v)
+{
+  PSTORE((double *) z,v);
+}
+
+// Return I*z.
+static inline Pvec ZMULTI(const Pvec& z)
+{
+  return FLIP(CONJ(z));
+}
+
+// Return the complex product of z and w.
+static inline Pvec ZMULT(const Pvec& z, const Pvec& w)
+{
+  return MADDSUB(UNPACKL(z,z),w,UNPACKH(z,z)*FLIP(w));
+}
+
+// Return the complex product of CONJ(z) and w.
+static inline Pvec ZMULTC(const Pvec& z, const Pvec& w)
+{
+  return MSUBADD(UNPACKL(z,z),w,UNPACKH(z,z)*FLIP(w));
+}
+
+// Return the complex product of z and I*w.
+static inline Pvec ZMULTI(const Pvec& z, const Pvec& w)
+{
+  return ZMULT(z,ZMULTI(w));
+}
+
+// Return the complex product of CONJ(z) and I*w.
+static inline Pvec ZMULTIC(const Pvec& z, const Pvec& w)
+{
+  return ZMULTC(z,ZMULTI(w));
+}
+
+static inline Pvec ZMULT(const Pvec& x, const Pvec& y, const Pvec& w)
+{
+  return MADD(x,w,y*FLIP(w));
+}
+
+static inline Pvec ZMULTI(const Pvec& x, const Pvec& y, const Pvec& w)
+{
+  Pvec z=CONJ(w);
+  return MADD(x,FLIP(z),y*z);
+}
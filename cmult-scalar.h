@@ -0,0 +1,168 @@
+/* Scalar complex multiplication routines
+   Copyright (C) 2017 John C. Bowman, University of Alberta
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
+
+// A Vec holds the two parts of a complex value of the floating-point type
+// Real, or two consecutive Real values; the routines below act like their
+// SSE2 counterparts in cmult-sse2.h.
+
+// This file has no include guard: it defines Vec and its routines in the
+// enclosing namespace, which must define the types Real and Complex (the
+// complex type of precision Real), and may be included once for each
+// precision. It leaves PVECSIZE undefined, so the kernels of kernels.h
+// then run one complex value at a time.
+
+class Vec {
+public:
+  Real x;
+  Real y;
+
+  Vec() {};
+  Vec(Real x, Real y) : x(x), y(y) {};
+  Vec(const Vec &v) : x(v.x), y(v.y) {};
+  Vec(const Complex &z) : x(z.real()), y(z.imag()) {};
+
+  const Vec& operator += (const Vec& v) {
+    x += v.x;
+    y += v.y;
+    return *this;
+  }
+
+  const Vec& operator -= (const Vec& v) {
+    x -= v.x;
+    y -= v.y;
+    return *this;
+  }
+
+  const Vec& operator *= (const Vec& v) {
+    x *= v.x;
+    y *= v.y;
+    return *this;
+  }
+};
+
+static inline Vec operator -(const Vec& a)
+{
+  return Vec(-a.x,-a.y);
+}
+
+static inline Vec operator +(const Vec& a, const Vec& b)
+{
+  return Vec(a.x+b.x,a.y+b.y);
+}
+
+static inline Vec operator -(const Vec& a, const Vec& b)
+{
+  return Vec(a.x-b.x,a.y-b.y);
+}
+
+static inline Vec operator *(const Vec& a, const Vec& b)
+{
+  return Vec(a.x*b.x,a.y*b.y);
+}
+
+// Return (z.x,w.x)
+static inline Vec UNPACKL(const Vec& z, const Vec& w)
+{
+  return Vec(z.x,w.x);
+}
+
+// Return (z.y,w.y)
+static inline Vec UNPACKH(const Vec& z, const Vec& w)
+{
+  return Vec(z.y,w.y);
+}
+
+// Return (z.y,z.x)
+static inline Vec FLIP(const Vec& z)
+{
+  return Vec(z.y,z.x);
+}
+
+// Return (z.x,-z.y)
+static inline Vec CONJ(const Vec& z)
+{
+  return Vec(z.x,-z.y);
+}
+
+static inline Vec LOAD(Real x)
+{
+  return Vec(x,x);
+}
+
+// The parts are copied rather than reinterpreted, since Complex may be
+// std::complex<Real>.
+static inline Vec LOAD(const Complex *z)
+{
+  return Vec(z->real(),z->imag());
+}
+
+static inline void STORE(Complex *z, const Vec& v)
+{
+  *z=Complex(v.x,v.y);
+}
+
+static inline Vec LOAD(const Real *z)
+{
+  return Vec(z[0],z[1]);
+}
+
+static inline void STORE(Real *z, const Vec& v)
+{
+  z[0]=v.x;
+  z[1]=v.y;
+}
+
+// Return I*z.
+static inline Vec ZMULTI(const Vec& z)
+{
+  return FLIP(CONJ(z));
+}
+
+// Return the complex product of z and w.
+static inline Vec ZMULT(const Vec& z, const Vec& w)
+{
+  return w*UNPACKL(z,z)+UNPACKH(z,z)*ZMULTI(w);
+}
+
+// Return the complex product of CONJ(z) and w.
+static inline Vec ZMULTC(const Vec& z, const Vec& w)
+{
+  return w*UNPACKL(z,z)-UNPACKH(z,z)*ZMULTI(w);
+}
+
+// Return the complex product of z and I*w.
+static inline Vec ZMULTI(const Vec& z, const Vec& w)
+{
+  return ZMULTI(w)*UNPACKL(z,z)-UNPACKH(z,z)*w;
+}
+
+// Return the complex product of CONJ(z) and I*w.
+static inline Vec ZMULTIC(const Vec& z, const Vec& w)
+{
+  return ZMULTI(w)*UNPACKL(z,z)+UNPACKH(z,z)*w;
+}
+
+static inline Vec ZMULT(const Vec& x, const Vec& y, const Vec& w)
+{
+  return x*w+y*FLIP(w);
+}
+
+static inline Vec ZMULTI(const Vec& x, const Vec& y, const Vec& w)
+{
+  Vec z=CONJ(w);
+  return x*FLIP(z)+y*z;
+}
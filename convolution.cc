@@ -1,5 +1,12 @@
 #include "convolution.h"
 
+#include <cstring>
+#include <cstdlib>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
 using namespace std;
 using namespace utils;
 
@@ -20,846 +27,385 @@ const double hsqrt3=0.5*sqrt3;
 const Complex zeta3(-0.5,hsqrt3);
 const double twopi=2.0*M_PI;
 
-// Build zeta table, returning the floor of the square root of m.
-unsigned int BuildZeta(double arg, unsigned int m,
-                       Complex *&ZetaH, Complex *&ZetaL, unsigned int threads)
-{
-  unsigned int s=(int) sqrt((double) m);
-  unsigned int t=m/s;
-  if(s*t < m) ++t;
-  ZetaH=ComplexAlign(t);
-  
-#ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
-#endif    
-  for(unsigned int a=0; a < t; ++a) {
-    double theta=s*a*arg;
-    ZetaH[a]=Complex(cos(theta),sin(theta));
-  }
-  ZetaL=ComplexAlign(s);
-#ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
-#endif    
-  for(unsigned int b=0; b < s; ++b) {
-    double theta=b*arg;
-    ZetaL[b]=Complex(cos(theta),sin(theta));
-  }
-  return s;
+typedef KernelsT<double> Kernels;
+
+namespace sse2 {
+typedef double Real;
+#include "kernels.h"
 }
 
-unsigned int BuildZeta(unsigned int n, unsigned int m,
-                       Complex *&ZetaH, Complex *&ZetaL, unsigned int threads)
-{
-  return BuildZeta(twopi/n,m,ZetaH,ZetaL,threads);
+// GCC compiles the AVX2 and AVX-512 kernels into every x86 binary, for
+// selection at run time; other compilers build only those enabled by
+// their flags.
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__INTEL_COMPILER) && \
+  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) &&           \
+  (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define DISPATCH 1
+#endif
+
+#if defined(DISPATCH) || (defined(__AVX2__) && defined(__FMA__))
+#ifdef DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+namespace avx2 {
+typedef double Real;
+#define PVECSIZE 2
+#include "cmult-avx.h"
+#include "kernels.h"
+#undef PVECSIZE
+}
+#ifdef DISPATCH
+#pragma GCC pop_options
+#endif
+#define HAVE_AVX2 1
+#endif
+
+#if defined(DISPATCH) || defined(__AVX512F__)
+#ifdef DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+#endif
+namespace avx512 {
+typedef double Real;
+#define PVECSIZE 4
+#include "cmult-avx.h"
+#include "kernels.h"
+#undef PVECSIZE
+}
+#ifdef DISPATCH
+#pragma GCC pop_options
+#endif
+#define HAVE_AVX512 1
+#endif
+
+// The scalar float and long double kernels.
+namespace scalarf {
+typedef float Real;
+typedef std::complex<float> Complex;
+const Real sqrt3=sqrt((Real) 3.0);
+const Real hsqrt3=0.5*sqrt3;
+#include "cmult-scalar.h"
+#include "kernels.h"
 }
 
-void ImplicitConvolution::convolve(Complex **F, multiplier *pmult,
-                                   unsigned int i, unsigned int offset)
-{ 
-  if(indexsize >= 1) index[indexsize-1]=i;
-  
-  unsigned int C=max(A,B);
-  Complex *P[C];
-  for(unsigned int a=0; a < C; ++a)
-    P[a]=F[a]+offset;
-  
-  // Backwards FFT (even indices):
-  for(unsigned int a=0; a < A; ++a) {
-    BackwardsO->fft(P[a],U[a]);
-  }
-  
-  if(A >= B)
-    (*pmult)(U,m,indexsize,index,0,threads); // multiply even indices
-
-  switch(A) {
-    case 1: pretransform<pretransform1>(P); break;
-    case 2: pretransform<pretransform2>(P); break;
-    case 3: pretransform<pretransform3>(P); break;
-    case 4: pretransform<pretransform4>(P); break;
-    default: pretransform<general>(P);
-  }
+namespace scalarl {
+typedef long double Real;
+typedef std::complex<long double> Complex;
+const Real sqrt3=sqrt((Real) 3.0);
+const Real hsqrt3=0.5*sqrt3;
+#include "cmult-scalar.h"
+#include "kernels.h"
+}
 
-  if(A > B) { // U[A-1] is free
-    Complex *W[A];
-    W[A-1]=U[A-1];
-    for(unsigned int a=1; a < A; ++a) 
-      W[a-1]=P[a];
+const char *ISAName[]={"sse2","avx2","avx512"};
 
-    for(unsigned int a=A; a-- > 0;) // Loop from A-1 to 0.
-      BackwardsO->fft(P[a],W[a]);
-    
-    (*pmult)(W,m,indexsize,index,1,threads); // multiply odd indices
-    
-    // Return to original space
-    Complex *lastW=W[A-1];
-    for(unsigned int b=0; b < B; ++b) {
-      Complex *Pb=P[b];
-      ForwardsO->fft(W[b],Pb);
-      ForwardsO->fft(U[b],lastW);
-      posttransform(Pb,lastW);
-    }
-    
-  } else if(A < B) { // U[B-1] is free
-    Complex *W[B];
-    W[B-1]=U[B-1];
-    for(unsigned int b=1; b < B; ++b) 
-      W[b-1]=P[b];
-
-    for(unsigned int a=A; a-- > 0;) // Loop from A-1 to 0.
-      BackwardsO->fft(P[a],W[a]);
-    
-    (*pmult)(W,m,indexsize,index,1,threads); // multiply odd indices
-    
-    // Return to original space
-    for(unsigned int b=0; b < B; ++b)
-      ForwardsO->fft(W[b],P[b]);
-    
-    (*pmult)(U,m,indexsize,index,0,threads); // multiply even indices
-    
-    Complex *f0=P[0];
-    Complex *u0=U[0];
-    Forwards->fft(u0);
-    posttransform(f0,u0);
-    for(unsigned int b=1; b < B; ++b) {
-      Complex *fb=P[b];
-      Complex *ub=U[b];
-      Complex *u0=U[0];
-      ForwardsO->fft(ub,u0);
-      posttransform(fb,u0);
-    }
-    
-  } else { // A == B
-    // Backwards FFT (odd indices):
-    for(unsigned int a=0; a < A; ++a)
-      Backwards->fft(P[a]);
-    (*pmult)(P,m,indexsize,index,1,threads); //multiply odd indices
-
-    // Return to original space:
-    Complex *f0=P[0];
-    Complex *u0=U[0];
-    Forwards->fft(f0);
-    Forwards->fft(u0);
-    posttransform(f0,u0);
-    for(unsigned int b=1; b < B; ++b) {
-      Complex *fb=P[b];
-      Complex *ub=U[b];
-      Complex *u0=U[0];
-      Forwards->fft(fb);
-      ForwardsO->fft(ub,u0);
-      posttransform(fb,u0);
-    }
-  }
+static const Kernels *KernelTable[]={
+  &sse2::kernels,
+#ifdef HAVE_AVX2
+  &avx2::kernels,
+#else
+  NULL,
+#endif
+#ifdef HAVE_AVX512
+  &avx512::kernels,
+#else
+  NULL,
+#endif
+};
+
+bool AvailableISA(ISA isa)
+{
+  if(isa < SSE2 || isa > AVX512 || KernelTable[isa] == NULL) return false;
+#ifdef DISPATCH
+  __builtin_cpu_init();
+  if(isa >= AVX2 && !(__builtin_cpu_supports("avx2") &&
+                      __builtin_cpu_supports("fma")))
+    return false;
+  if(isa >= AVX512 && !__builtin_cpu_supports("avx512f"))
+    return false;
+#endif
+  return true;
 }
 
-template<class T>
-inline void ImplicitConvolution::
-pretransform(Complex **F, unsigned int k, Vec& Zetak)
+// Return the kernels named by FFTWPP_ISA, if available, or else the best
+// available ones.
+static const Kernels *DefaultKernels()
 {
-  for(unsigned int a=0; a < A; ++a) {
-    Complex *fka=F[a]+k;
-    STORE(fka,ZMULT(Zetak,LOAD(fka)));
+  int isa=AVX512;
+  while(!AvailableISA((ISA) isa)) --isa;
+  const char *name=getenv("FFTWPP_ISA");
+  if(name) {
+    int i=AVX512;
+    while(i >= SSE2 && strcmp(name,ISAName[i]) != 0) --i;
+    if(i >= SSE2 && AvailableISA((ISA) i)) isa=i;
+    else cerr << "FFTWPP_ISA=" << name << " is unavailable" << endl;
   }
+  return KernelTable[isa];
 }
 
-template<>
-inline void ImplicitConvolution::
-pretransform<pretransform1>(Complex **F, unsigned int k, Vec& Zetak)
+// The kernels in use, initialized once even when first called from several
+// threads at once.
+static const Kernels *&SelectedKernels()
 {
-  Complex *fk0=F[0]+k;
-  Vec Fk0=LOAD(fk0);
-  STORE(fk0,ZMULT(Zetak,Fk0));
+  static const Kernels *kernels=DefaultKernels();
+  return kernels;
 }
 
 template<>
-inline void ImplicitConvolution::
-pretransform<pretransform2>(Complex **F, unsigned int k, Vec& Zetak)
+const Kernels *Selected<double>()
 {
-  Complex *fk0=F[0]+k;
-  Complex *fk1=F[1]+k;
-  Vec Fk0=LOAD(fk0);
-  Vec Fk1=LOAD(fk1);
-  STORE(fk0,ZMULT(Zetak,Fk0));
-  STORE(fk1,ZMULT(Zetak,Fk1));
+  return SelectedKernels();
 }
 
 template<>
-inline void ImplicitConvolution::
-pretransform<pretransform3>(Complex **F, unsigned int k, Vec& Zetak)
+const KernelsT<float> *Selected<float>()
 {
-  Complex *fk0=F[0]+k;
-  Complex *fk1=F[1]+k;
-  Complex *fk2=F[2]+k;
-  Vec Fk0=LOAD(fk0);
-  Vec Fk1=LOAD(fk1);
-  Vec Fk2=LOAD(fk2);
-  STORE(fk0,ZMULT(Zetak,Fk0));
-  STORE(fk1,ZMULT(Zetak,Fk1));
-  STORE(fk2,ZMULT(Zetak,Fk2));
+  return &scalarf::kernels;
 }
 
 template<>
-inline void ImplicitConvolution::
-pretransform<pretransform4>(Complex **F, unsigned int k, Vec& Zetak)
+const KernelsT<long double> *Selected<long double>()
 {
-  Complex *fk0=F[0]+k;
-  Complex *fk1=F[1]+k;
-  Complex *fk2=F[2]+k;
-  Complex *fk3=F[3]+k;
-  Vec Fk0=LOAD(fk0);
-  Vec Fk1=LOAD(fk1);
-  Vec Fk2=LOAD(fk2);
-  Vec Fk3=LOAD(fk3);
-  STORE(fk0,ZMULT(Zetak,Fk0));
-  STORE(fk1,ZMULT(Zetak,Fk1));
-  STORE(fk2,ZMULT(Zetak,Fk2));
-  STORE(fk3,ZMULT(Zetak,Fk3));
+  return &scalarl::kernels;
 }
 
-// multiply by root of unity to prepare for inverse FFT for odd modes
-template<class T>
-void ImplicitConvolution::pretransform(Complex **F)
-{  
-  PARALLEL(
-    for(unsigned int K=0; K < m; K += s) {
-      Complex *ZetaL0=ZetaL-K;
-      unsigned int stop=min(K+s,m);
-      Vec Zeta=LOAD(ZetaH+K/s);
-      Vec X=UNPACKL(Zeta,Zeta);
-      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-      for(unsigned int k=K; k < stop; ++k) {
-        Vec Zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
-        pretransform<T>(F,k,Zetak);
-      }
-    }
-    );
-}
-
-// multiply by root of unity to prepare and add for inverse FFT for odd modes
-void ImplicitConvolution::posttransform(Complex *f, Complex *u)
+ISA CurrentISA()
 {
-  double ninv=0.5/m;
-  Vec Ninv=LOAD(ninv);
-  PARALLEL(
-    for(unsigned int K=0; K < m; K += s) {
-      unsigned int stop=min(K+s,m);
-      Complex *ZetaL0=ZetaL-K;
-      Vec Zeta=Ninv*LOAD(ZetaH+K/s);
-      Vec X=UNPACKL(Zeta,Zeta);
-      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-      for(unsigned int k=K; k < stop; ++k) {
-        Vec Zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
-        Complex *fki=f+k;
-        STORE(fki,ZMULTC(Zetak,LOAD(fki))+Ninv*LOAD(u+k));
-      }
-    }
-    );
+  const Kernels *k=Selected<double>();
+  int isa=AVX512;
+  while(KernelTable[isa] != k) --isa;
+  return (ISA) isa;
 }
 
-void ImplicitHConvolution::pretransform(Complex *F, Complex *f1c, Complex *U)
+bool SelectISA(ISA isa)
 {
-  Vec Mhalf=LOAD(-0.5);
-  Vec HSqrt3=LOAD(hsqrt3);
-  
-  double Re=0.0, Im=0.0;
-
-  unsigned int m1=m-1;
-
-  U[0]=compact ? F->re : F->re-F[m].re; // Nyquist
-
-  if(even) {
-    unsigned int a=1/s;
-    Vec Zeta=LOAD(ZetaH+a);
-    Vec X=UNPACKL(Zeta,Zeta);
-    Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-    Vec zeta1=ZMULT(X,Y,LOAD(ZetaL+1-s*a));
-    Vec Fa=LOAD(F+1);
-    Vec Fb=LOAD(F+m1);
-    Vec B=Fb*Mhalf+CONJ(Fa);
-    Fb *= HSqrt3;
-    Vec A=ZMULTC(zeta1,UNPACKL(B,Fb)); // Optimize?
-    B=ZMULTIC(zeta1,UNPACKH(B,Fb));
-    STORE(f1c,CONJ(A+B));
-        
-    double re=F[c].re;
-    Re=2.0*re;
-    Im=re+sqrt3*F[c].im;
-  }
-  
-  unsigned int c1=c+1;
-  unsigned int d=c1/2;
-  unsigned int a=c1/s;
-  Vec Zeta=LOAD(ZetaH+a);
-  Vec X=UNPACKL(Zeta,Zeta);
-  Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-  Vec Zetac1=ZMULT(X,Y,LOAD(ZetaL+c1-s*a));
-  PARALLEL(
-    for(unsigned int K=0; K <= d; K += s) {
-      Complex *ZetaL0=ZetaL-K;
-      unsigned int stop=min(K+s,d+1);
-      Vec Zeta=LOAD(ZetaH+K/s);
-      Vec X=UNPACKL(Zeta,Zeta);
-      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-      Complex *fm=F+m;
-      Complex *fpc1=F+c1;
-      Complex *fmc1=fm-c1;
-      Complex *upc1=U+c1;
-      for(unsigned int k=max(1,K); k < stop; ++k) {
-        Vec zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
-        Vec Zetak=ZMULTC(zetak,Zetac1);
-          
-        Vec Fa=LOAD(F+k);
-        Vec FA=LOAD(fpc1-k);
-        Vec FB=LOAD(fmc1+k);
-        Vec Fb=LOAD(fm-k);
-          
-        Vec b=Fb*Mhalf+CONJ(Fa);
-        STORE(F+k,Fa+CONJ(Fb));
-        Fb *= HSqrt3;
-        Vec a=ZMULTC(zetak,UNPACKL(b,Fb));
-        b=ZMULTIC(zetak,UNPACKH(b,Fb));
-        
-        STORE(fmc1+k,CONJ(a+b));
-        STORE(U+k,a-b);
-        
-        b=FB*Mhalf+CONJ(FA);
-        STORE(fpc1-k,FA+CONJ(FB));
-        FB *= HSqrt3;
-        a=ZMULTC(Zetak,UNPACKL(b,FB));
-        b=ZMULTIC(Zetak,UNPACKH(b,FB));
-
-        STORE(upc1-k,a-b);
-        STORE(fm-k,CONJ(a+b));
-      }
-    }
-    );
-    
-  if(even) {
-    F[c]=Re;
-    U[c]=Im;
-  }
+  if(!AvailableISA(isa)) return false;
+  SelectedKernels()=KernelTable[isa];
+  return true;
 }
 
-void ImplicitHConvolution::posttransform(Complex *F, const Complex& w,
-                                         Complex *U)
+// Return 2*pi in the precision Real.
+template<class Real>
+inline Real Twopi()
 {
-  double ninv=1.0/(3.0*m);
-  Vec Ninv=LOAD(ninv);
-
-  Vec Mhalf=LOAD(-0.5);
-  Vec HSqrt3=LOAD(hsqrt3);
-
-  unsigned int m1=m-1;  
-  unsigned int c1=c+1;
-  unsigned int d=c1/2;
-  unsigned int a=c1/s;
-  Vec Zeta=LOAD(ZetaH+a);
-  Vec X=UNPACKL(Zeta,Zeta);
-  Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-  Vec Zetac1=ZMULT(X,Y,LOAD(ZetaL+c1-s*a));
-
-  if(even && m > 2) {
-    unsigned int a=1/s;
-    Vec Zeta=LOAD(ZetaH+a);
-    Vec X=UNPACKL(Zeta,Zeta);
-    Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-    Vec zeta1=Ninv*ZMULT(X,Y,LOAD(ZetaL+1-s*a));
-    Vec Zeta1=ZMULTC(zeta1,Zetac1);
-    Complex *f0=F;
-    Vec F0=LOAD(f0+1)*Ninv;
-    Vec F1=ZMULTC(zeta1,LOAD(&w));
-    Vec F2=ZMULT(zeta1,LOAD(U+1));
-    Vec S=F1+F2;
-    F2=CONJ(F0+Mhalf*S)-HSqrt3*FLIP(F1-F2);
-    STORE(f0+1,F0+S);
-    F0=LOAD(f0+c)*Ninv;
-    F1=ZMULTC(Zeta1,LOAD(f0+m1));
-    STORE(f0+m1,F2);
-    F2=ZMULT(Zeta1,LOAD(U+c));
-    STORE(f0+c,F0+F1+F2);
-  }
-  
-  unsigned int D=c-d;
-  PARALLEL(
-    for(unsigned int K=0; K <= D; K += s) {
-      Complex *ZetaL0=ZetaL-K;
-      unsigned int stop=min(K+s,D+1);
-      Vec Zeta=Ninv*LOAD(ZetaH+K/s);
-      Vec X=UNPACKL(Zeta,Zeta);
-      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-      Complex *fm=F+m;
-      Complex *fpc1=F+c1;
-      Complex *fmc1=fm-c1;
-      Complex *upc1=U+c1;
-      for(unsigned int k=max(even+1,K); k < stop; ++k) {
-        Vec zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
-        Vec Zetak=ZMULTC(zetak,Zetac1);
-          
-        Vec F0=LOAD(F+k)*Ninv;
-        Vec F1=ZMULTC(zetak,LOAD(fmc1+k));
-        Vec F2=ZMULT(zetak,LOAD(U+k));
-        Vec S=F1+F2;
-        F2=CONJ(F0+Mhalf*S)-HSqrt3*FLIP(F1-F2);
-            
-        Vec FA=LOAD(fpc1-k)*Ninv;
-        Vec FB=ZMULTC(Zetak,LOAD(fm-k));
-        Vec FC=ZMULT(Zetak,LOAD(upc1-k));
-        Vec T=FB+FC;
-            
-        STORE(F+k,F0+S);
-        STORE(fpc1-k,FA+T);
-        STORE(fmc1+k,CONJ(FA+Mhalf*T)-HSqrt3*FLIP(FB-FC));
-        STORE(fm-k,F2);
-      }  
-    }
-    );
-
-  
-  if(d == D+1) {
-    unsigned int a=d/s;
-    Vec Zeta=Ninv*LOAD(ZetaH+a);
-    Vec X=UNPACKL(Zeta,Zeta);
-    Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-    Vec Zetak=ZMULT(X,Y,LOAD(ZetaL+d-s*a));
-    Vec F0=LOAD(F+d)*Ninv;
-    Vec F1=ZMULTC(Zetak,LOAD(d == 1 && even ? &w : F+m-d));
-    Vec F2=ZMULT(Zetak,LOAD(U+d));
-    Vec S=F1+F2;
-    STORE(F+d,F0+S);
-    STORE(F+m-d,CONJ(F0+Mhalf*S)-HSqrt3*FLIP(F1-F2));
-  }
+  return 2*acos((Real) -1.0);
 }
 
-void ImplicitHConvolution::convolve(Complex **F, realmultiplier *pmult,
-                                    unsigned int i, unsigned int offset)
+// Build zeta table, returning the floor of the square root of m.
+template<class C>
+unsigned int BuildZeta(typename RealOf<C>::type arg, unsigned int m,
+                       C *&ZetaH, C *&ZetaL, unsigned int threads)
 {
-  if(indexsize >= 1) index[indexsize-1]=i;
-  
-  // Set problem-size variables and pointers:
-  unsigned int C=max(A,B);
-
-  Complex *C0[C], *C1[C], *C2[C]; // inputs to complex2real FFTs
-  double  *D0[C], *D1[C], *D2[C]; // outputs of complex2real FFTs
-  Complex **c0=C0, **c1=C1, **c2=C2;
-  double **d0=D0, **d1=D1, **d2=D2;
-
-  unsigned int start=m-1-c; // c-1 (c) for m=even (odd)
-  for(unsigned int a=0; a < C; ++a) {
-    Complex *f=F[a]+offset;
-    c0[a]=f;
-    c1[a]=f+start;
-  }
-    
-  if(A != B) { 
-    for(unsigned int a=0; a < C-1; ++a) {
-      d0[a]=(double *) c0[a+1];
-      d1[a]=(double *) c1[a+1];
-    }
-    if(A > B) {
-      d0[A-1]=(double *) U[A-1];
-      d1[A-1]=(double *) U[A-1];
-      d2=(double **) U;
-      for(unsigned int b=0; b < B; ++b)
-        c2[b]=U[b+1];
-    } else {
-      d0[B-1]=(double *) U[0];
-      d1[B-1]=(double *) U[0];
-      for(unsigned int b=0; b < B-1; ++b)
-        c2[b]=U[b+1];
-      c2[B-1]=U[0];
-      for(unsigned int b=0; b < B; ++b)
-        d2[b]=(double *) c2[b];
-    }
-  } else {
-    c2=U;
-    d0=(double **) c0;
-    d1=(double **) c1;
-    d2=(double **) c2;
-  }
-
-  // Complex-to-real FFTs and pmults:
-  
-  double Re[B],Im[B];
-
-  // r=-1 (backwards):
-  if(A >= B) {
-    for(unsigned int a=0; a < A-1; ++a) {
-      pretransform(c0[a],w+a,U[A-1]);
-      cro->fft(U[A-1],U[a]);
-    }
-    pretransform(c0[A-1],w+A-1,U[A-1]);
-    cr->fft(U[A-1]);
-    (*pmult)((double **) U,m,indexsize,index,-1,threads);
-  } else {
-    for(unsigned int a=A; a-- > 0;) {// Loop from A-1 to 0.
-      pretransform(c0[a],w+a,U[a]);
-      cro->fft(U[a],d2[a]);
-    }
-  }
-
-  // r=0:
-  double T[A];
-  for(unsigned int a=A; a-- > 0;) { // Loop from A-1 to 0.
-    Complex *c0a=c0[a];
-    T[a]=c0a[0].re; // r=0, k=0
-    if(!compact)
-      c0a[0].re += 2.0*c0a[m].re; // Nyquist
-    crO->fft(c0a,d0[a]);
-  }
-  (*pmult)(d0,m,indexsize,index,0,threads);
-    
-  for(unsigned int b=0; b < B; ++b) {
-    Complex *c0b=c0[b];
-    rcO->fft(d0[b],c0b);
-    if(!compact) c0b[m]=0.0; // Zero Nyquist mode, for Hermitian symmetry.
-    Complex z=c0[b][start];  // r=0, k=start
-    Re[b]=z.re;
-    Im[b]=z.im;
-  }
-  
-  if(even) {
-    for(unsigned int a=C; a-- > 0;) { // Loop from C-1 to 0.
-      Complex *c1a=c1[a];
-      Complex tmp=w[a];
-      w[a].re=c1a[1].re; // r=0, k=c
-      c1a[1]=tmp;          // r=1, k=1
-    }
-  }
+  typedef typename RealOf<C>::type Real;
+  unsigned int s=(int) sqrt((double) m);
+  unsigned int t=m/s;
+  if(s*t < m) ++t;
+  ZetaH=ComplexAlign<C>(t);
   
-  // r=1:
-  for(unsigned int a=A; a-- > 0;) { // Loop from A-1 to 0.
-    Complex *c1a=c1[a];
-    c1a[0]=compact ? T[a] : T[a]-c1a[c+1].re; // r=1, k=0 with Nyquist
-    crO->fft(c1[a],d1[a]);
-  }
-  (*pmult)(d1,m,indexsize,index,1,threads);
-
-  for(unsigned int b=0; b < B; ++b) {
-    Complex *c1b=c1[b];
-    rcO->fft(d1[b],c1b); // r=1
-    if(even) {
-      double tmp=w[b].re;
-      w[b]=c1b[1]; // r=1, k=1
-      c1b[1]=tmp;    // r=0, k=c
-    }
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif    
+  for(unsigned int a=0; a < t; ++a) {
+    Real theta=s*a*arg;
+    ZetaH[a]=C(cos(theta),sin(theta));
   }
-  
-  const double ninv=1.0/(3.0*m);
-  
-  // r=-1 (forwards):
-  if(A > B) {
-    for(unsigned int b=0; b < B; ++b) {
-      rco->fft(d2[b],U[A-1]);
-      double R=c1[b][0].re;
-      c0[b][start]=Complex(Re[b],Im[b]); // r=0, k=c-1 (c) for m=even (odd)
-      c0[b][0]=(c0[b][0].re+R+U[A-1][0].re)*ninv;
-      posttransform(c0[b],w[b],U[A-1]);
-    }
-  } else {
-    if(A < B)
-      (*pmult)(d2,m,indexsize,index,-1,threads);
-
-    rc->fft(c2[0]);
-    double R=c1[0][0].re;
-    c0[0][start]=Complex(Re[0],Im[0]); // r=0, k=c-1 (c) for m=even (odd)
-    c0[0][0]=(c0[0][0].re+R+c2[0][0].re)*ninv;
-    posttransform(c0[0],w[0],c2[0]);
-
-    for(unsigned int b=1; b < B; ++b) {
-      rco->fft(d2[b],c2[0]);
-      double R=c1[b][0].re;
-      c0[b][start]=Complex(Re[b],Im[b]); // r=0, k=c-1 (c) for m=even (odd)
-      c0[b][0]=(c0[b][0].re+R+c2[0][0].re)*ninv;
-      posttransform(c0[b],w[b],c2[0]);
-    }
+  ZetaL=ComplexAlign<C>(s);
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif    
+  for(unsigned int b=0; b < s; ++b) {
+    Real theta=b*arg;
+    ZetaL[b]=C(cos(theta),sin(theta));
   }
+  return s;
 }
 
-void fftpad::expand(Complex *f, Complex *u)
+template<class C>
+unsigned int BuildZeta(unsigned int n, unsigned int m,
+                       C *&ZetaH, C *&ZetaL, unsigned int threads)
 {
-  PARALLEL(
-    for(unsigned int K=0; K < m; K += s) {
-      Complex *ZetaL0=ZetaL-K;
-      unsigned int stop=min(K+s,m);
-      Vec H=LOAD(ZetaH+K/s);
-      for(unsigned int k=K; k < stop; ++k) {
-        Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
-        Vec X=UNPACKL(Zetak,Zetak);
-        Vec Y=UNPACKH(CONJ(Zetak),Zetak);
-        unsigned int kstride=k*stride;
-        Complex *fk=f+kstride;
-        Complex *uk=u+kstride;
-        for(unsigned int i=0; i < M; ++i)
-          STORE(uk+i,ZMULT(X,Y,LOAD(fk+i)));
-      }
-    }
-    );
+  return BuildZeta(Twopi<typename RealOf<C>::type>()/n,m,ZetaH,ZetaL,
+                   threads);
 }
-  
-void fftpad::backwards(Complex *f, Complex *u)
+
+// The shared zeta tables, keyed by (n,r,m).
+template<class C>
+struct ZetaTables {
+  C *ZetaH,*ZetaL;
+  unsigned int s;
+  unsigned int users;
+};
+
+typedef pair<pair<unsigned int,unsigned int>,unsigned int> ZetaKey;
+
+// The cache of the tables of the complex type C. It is never destroyed, so
+// that static convolution objects may release their tables at exit.
+template<class C>
+static map<ZetaKey,ZetaTables<C> >& ZetaCache()
 {
-  expand(f,u);
-  Backwards->fft(f);
-  Backwards->fft(u);
+  static map<ZetaKey,ZetaTables<C> > *cache=new map<ZetaKey,ZetaTables<C> >;
+  return *cache;
 }
 
-void fftpad::reduce(Complex *f, Complex *u)
+template<class C>
+unsigned int ShareZeta(unsigned int n, unsigned int r, unsigned int m,
+                       C *&ZetaH, C *&ZetaL, unsigned int threads)
 {
-  double ninv=0.5/m;
-  Vec Ninv=LOAD(ninv);
-  PARALLEL(
-    for(unsigned int K=0; K < m; K += s) {
-      Complex *ZetaL0=ZetaL-K;
-      unsigned int stop=min(K+s,m);
-      Vec H=Ninv*LOAD(ZetaH+K/s);
-      for(unsigned int k=K; k < stop; ++k) {
-        Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
-        Vec X=UNPACKL(Zetak,Zetak);
-        Vec Y=UNPACKH(Zetak,CONJ(Zetak));
-        unsigned int kstride=k*stride;
-        Complex *uk=u+kstride;
-        Complex *fk=f+kstride;
-        for(unsigned int i=0; i < M; ++i)
-          STORE(fk+i,LOAD(fk+i)*Ninv+ZMULT(X,Y,LOAD(uk+i)));
-      }
-    }
-    );
+  typedef typename RealOf<C>::type Real;
+  Planlock lock;
+  ZetaTables<C>& z=
+    ZetaCache<C>()[ZetaKey(pair<unsigned int,unsigned int>(n,r),m)];
+  if(z.users == 0)
+    z.s=BuildZeta(r*Twopi<Real>()/n,m,z.ZetaH,z.ZetaL,threads);
+  ++z.users;
+  ZetaH=z.ZetaH;
+  ZetaL=z.ZetaL;
+  return z.s;
 }
 
-void fftpad::forwards(Complex *f, Complex *u)
+template<class C>
+unsigned int ShareZeta(unsigned int n, unsigned int m,
+                       C *&ZetaH, C *&ZetaL, unsigned int threads)
 {
-  Forwards->fft(f);
-  Forwards->fft(u);
-  reduce(f,u);
+  return ShareZeta(n,1,m,ZetaH,ZetaL,threads);
 }
 
-void fft0pad::expand(Complex *f, Complex *u)
+template<class C>
+void ReleaseZeta(C *ZetaH)
 {
-  Complex *fm1stride=f+(m-1)*stride;
-  for(unsigned int i=0; i < M; ++i)
-    u[i]=fm1stride[i];
-    
-  Vec Mhalf=LOAD(-0.5);
-  Vec Mhsqrt3=LOAD(-hsqrt3);
-  unsigned int stop=s;
-  
-  for(unsigned int K=0; K < m; K += s) {
-    Complex *ZetaL0=ZetaL-K;
-    Vec H=LOAD(ZetaH+K/s);
-    for(unsigned int k=max(1,K); k < stop; ++k) {
-      Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
-      Vec X=UNPACKL(Zetak,Zetak);
-      Vec Y=UNPACKH(CONJ(Zetak),Zetak);
-      unsigned int kstride=k*stride;
-      Complex *uk=u+kstride;
-      Complex *fk=f+kstride;
-      Complex *fmk=fm1stride+kstride;
-      for(unsigned int i=0; i < M; ++i) {
-        Vec A=LOAD(fmk+i);
-        Vec B=LOAD(f+i);
-        Vec Z=B*Mhalf+A;
-        STORE(f+i,LOAD(fk+i));
-        STORE(fk+i,B+A);
-        B *= Mhsqrt3;
-        A=ZMULT(X,Y,UNPACKL(Z,B));
-        B=ZMULTI(X,Y,UNPACKH(Z,B));
-        STORE(fmk+i,A+B);
-        STORE(uk+i,CONJ(A-B));
+  typedef map<ZetaKey,ZetaTables<C> > ZetaMap;
+  Planlock lock;
+  ZetaMap& cache=ZetaCache<C>();
+  for(typename ZetaMap::iterator p=cache.begin(); p != cache.end(); ++p) {
+    ZetaTables<C>& z=p->second;
+    if(z.ZetaH == ZetaH) {
+      if(--z.users == 0) {
+        deleteAlign(z.ZetaL);
+        deleteAlign(z.ZetaH);
+        cache.erase(p);
       }
+      return;
     }
-    stop=min(stop+s,m);
   }
 }
 
-void fft0pad::Backwards1(Complex *f, Complex *u)
-{
-  Complex *umstride=u+m*stride;
-  Complex *fm1stride=f+(m-1)*stride;
-  for(unsigned int i=0; i < M; ++i) {
-    umstride[i]=fm1stride[i]; // Store extra value here.
-    fm1stride[i]=u[i];
-  }
-  Backwards->fft(fm1stride);
-}
+// Instantiate the zeta tables of each precision.
+#define FFTWPP_ZETA(C)                                                  \
+  template unsigned int BuildZeta(RealOf<C>::type arg, unsigned int m,  \
+                                  C *&ZetaH, C *&ZetaL,                 \
+                                  unsigned int threads);                \
+  template unsigned int BuildZeta(unsigned int n, unsigned int m,       \
+                                  C *&ZetaH, C *&ZetaL,                 \
+                                  unsigned int threads);                \
+  template unsigned int ShareZeta(unsigned int n, unsigned int r,       \
+                                  unsigned int m, C *&ZetaH, C *&ZetaL, \
+                                  unsigned int threads);                \
+  template unsigned int ShareZeta(unsigned int n, unsigned int m,       \
+                                  C *&ZetaH, C *&ZetaL,                 \
+                                  unsigned int threads);                \
+  template void ReleaseZeta(C *ZetaH);
 
-void fft0pad::backwards(Complex *f, Complex *u)
+FFTWPP_ZETA(Complex)
+FFTWPP_ZETA(std::complex<float>)
+FFTWPP_ZETA(std::complex<long double>)
+
+void fftpadpq::expand(Complex *f, Complex *u, unsigned int r)
 {
-  expand(f,u);
-  Backwards->fft(f);
-  Backwards1(f,u);
-  Backwards->fft(u);
+  Selected<double>()->fftpadpqexpand(f,u,m,c,M,stride,s,ZetaH[r],ZetaL[r],
+                                     threads);
 }
 
-void fft0pad::reduce(Complex *f, Complex *u)
+void fftpadpq::reduce(Complex *u, Complex *f, unsigned int r)
 {
-  Complex *umstride=u+m*stride;
-  double ninv=1.0/(3.0*m);
-  for(unsigned int i=0; i < M; ++i)
-    umstride[i]=(umstride[i]+f[i]+u[i])*ninv;
-
-  Vec Ninv=LOAD(ninv);
-  Vec Mhalf=LOAD(-0.5);
-  Vec HSqrt3=LOAD(hsqrt3);
-  Complex *fm1stride=f+(m-1)*stride;
-  
-  unsigned int stop=s;
-  for(unsigned int K=0; K < m; K += s) {
-    Complex *ZetaL0=ZetaL-K;
-    Vec H=LOAD(ZetaH+K/s)*Ninv;
-    for(unsigned int k=max(1,K); k < stop; ++k) {
-      Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
-      Vec X=UNPACKL(Zetak,Zetak);
-      Vec Y=UNPACKH(CONJ(Zetak),Zetak);
-      unsigned int kstride=k*stride;
-      Complex *fk=f+kstride;
-      Complex *fm1k=fm1stride+kstride;
-      Complex *uk=u+kstride;
-      for(unsigned int i=0; i < M; ++i) {
-        Vec F0=LOAD(fk+i)*Ninv;
-        Vec F1=ZMULT(X,-Y,LOAD(fm1k+i));
-        Vec F2=ZMULT(X,Y,LOAD(uk+i));
-        Vec S=F1+F2;
-        STORE(fk+i-stride,F0+Mhalf*S+HSqrt3*ZMULTI(F1-F2));
-        STORE(fm1k+i,F0+S);
-      }
-    }
-    stop=min(stop+s,m);
-  }
-    
-  for(unsigned int i=0; i < M; ++i)
-    fm1stride[i]=umstride[i];
+  Selected<double>()->fftpadpqreduce(u,f,m,c,M,stride,s,ZetaH[r],ZetaL[r],
+                                     1.0/(p*c),r == 0,threads);
 }
 
-void fft0pad::Forwards0(Complex *f)
+void fftpadpq::backwards(Complex *f, Complex *u, unsigned int r)
 {
-  Forwards->fft(f+(m-1)*stride);
+  expand(f,u,r);
+  Backwards->fft(u);
 }
-  
-void fft0pad::Forwards1(Complex *f, Complex *u)
+
+void fftpadpq::forwards(Complex *u, Complex *f, unsigned int r)
 {
-  Complex *umstride=u+m*stride;
-  unsigned int m1stride=(m-1)*stride;
-  Complex *fm1stride=f+m1stride;
-  for(unsigned int i=0; i < M; ++i) {
-    Complex temp=umstride[i];
-    umstride[i]=fm1stride[i];
-    fm1stride[i]=temp;
-  }
+  Forwards->fft(u);
+  reduce(u,f,r);
 }
-  
-void fft0pad::forwards(Complex *f, Complex *u)
+
+void ImplicitPQConvolution::convolve(Complex **F, multiplier *pmult,
+                                     unsigned int i, unsigned int offset)
 {
-  Forwards0(f);  
-  Forwards1(f,u);  
-  Forwards->fft(f);
-  Forwards->fft(u);
-  reduce(f,u);
+  convolve<multiplier *>(F,pmult,i,offset);
 }
 
-void fft1pad::expand(Complex *f, Complex *u)
+void dctpad::expand(double *f, double *u)
 {
-  Complex *fmstride=f+m*stride;
-  for(unsigned int i=0; i < M; ++i) {
-    Complex Nyquist=f[i];
-    f[i]=fmstride[i]+2.0*Nyquist;
-    u[i]=fmstride[i] -= Nyquist;
-  }
-    
-  Vec Mhalf=LOAD(-0.5);
-  Vec Mhsqrt3=LOAD(-hsqrt3);
-  unsigned int inc=s;
+  unsigned int stop=(m-1)*stride;
   PARALLEL(
-    for(unsigned int K=0; K < m; K += inc) {
-      Complex *ZetaL0=ZetaL-K;
-      unsigned int stop=min(K+s,m);
-      Vec Zeta=LOAD(ZetaH+K/s);
-      Vec X=UNPACKL(Zeta,Zeta);
-      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-      for(unsigned int k=max(1,K); k < stop; ++k) {
-        Vec zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
-        unsigned int kstride=k*stride;
-        Complex *uk=u+kstride;
-        Complex *fk=f+kstride;
-        Complex *fmk=fmstride+kstride;
-        for(unsigned int i=0; i < M; ++i) {
-          Vec Fa=LOAD(fk+i);
-          Vec Fb=LOAD(fmk+i);
-        
-          Vec B=Fa*Mhalf+Fb;
-          STORE(fk+i,Fa+Fb);
-          Fa *= Mhsqrt3;
-          Vec A=ZMULT(zetak,UNPACKL(B,Fa));
-          B=ZMULTI(zetak,UNPACKH(B,Fa));
-          STORE(fmk+i,A+B);
-          STORE(uk+i,CONJ(A-B));
-        }
-      }
+    for(unsigned int k=stride; k < stop; k += stride) {
+      double *fk=f+k;
+      for(unsigned int i=0; i < M; ++i)
+        fk[i] *= 0.5;
+    }
+    );
+  PARALLEL(
+    for(unsigned int k=0; k < stop; k += stride) {
+      double *fk=f+k;
+      double *uk=u+k;
+      for(unsigned int i=0; i < M; ++i)
+        uk[i]=fk[i];
     }
     );
 }
 
-void fft1pad::Backwards1(Complex *f, Complex *u)
+void dctpad::backwards(double *f, double *u)
 {
-  Backwards->fft(f+m*stride);
+  expand(f,u);
+  Even->fft(f);
+  Backwards->fft(u);
 }
 
-void fft1pad::reduce(Complex *f, Complex *u)
+void dctpad::reduce(double *f, double *u)
 {
-  Complex *fmstride=f+m*stride;
-
-  double ninv=1.0/(3.0*m);
-  for(unsigned int i=0; i < M; ++i) {
-    Complex f0=f[i];
-    Complex f1=fmstride[i];
-    Complex f2=u[i];
-    f[i]=0.0; // Zero Nyquist mode, for Hermitian symmetry.
-    fmstride[i]=(f0+f1+f2)*ninv;
-  }
-  Vec Ninv=LOAD(ninv);
-  Vec Mhalf=LOAD(-0.5);
-  Vec HSqrt3=LOAD(hsqrt3);
-  
-  unsigned int inc=s;
+  double ninv=0.5/(m-1);
+  for(unsigned int i=0; i < M; ++i)
+    f[i]=(f[i]+u[i])*0.5*ninv;
+  unsigned int stop=(m-1)*stride;
   PARALLEL(
-    for(unsigned int K=0; K < m; K += inc) {
-      Complex *ZetaL0=ZetaL-K;
-      unsigned int stop=min(K+s,m);
-      Vec Zeta=Ninv*LOAD(ZetaH+K/s);
-      Vec X=UNPACKL(Zeta,Zeta);
-      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
-      for(unsigned int k=max(1,K); k < stop; ++k) {
-        Vec zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
-        unsigned int kstride=k*stride;
-        Complex *fk=f+kstride;
-        Complex *fmk=fmstride+kstride;
-        Complex *uk=u+kstride;
-        for(unsigned int i=0; i < M; ++i) {
-          Vec F0=LOAD(fk+i)*Ninv;
-          Vec F1=ZMULTC(zetak,LOAD(fmk+i));
-          Vec F2=ZMULT(zetak,LOAD(uk+i));
-          Vec S=F1+F2;
-          STORE(fk+i,F0+Mhalf*S+HSqrt3*ZMULTI(F1-F2));
-          STORE(fmk+i,F0+S);
-        }
-      }
+    for(unsigned int k=stride; k < stop; k += stride) {
+      double *fk=f+k;
+      double *uk=u+k;
+      for(unsigned int i=0; i < M; ++i)
+        fk[i]=(fk[i]+uk[i])*ninv;
     }
     );
+  double *fm=f+stop;
+  for(unsigned int i=0; i < M; ++i)
+    fm[i] *= ninv;
 }
 
-void fft1pad::Forwards0(Complex *f)
+void dctpad::forwards(double *f, double *u)
 {
-  Forwards->fft(f+m*stride);
+  Even->fft(f);
+  Forwards->fft(u);
+  reduce(f,u);
 }
 
-void fft1pad::Forwards1(Complex *f, Complex *u)
+void ImplicitCosineConvolution::convolve(double **F, realmultiplier *pmult,
+                                         unsigned int i)
 {
-}
+  if(indexsize >= 1) index[indexsize-1]=i;
 
-void fft1pad::forwards(Complex *f, Complex *u)
-{
-  Forwards->fft(f);
-  Forwards->fft(f+m*stride);
-  Forwards->fft(u);
-  reduce(f,u);
+  for(unsigned int a=0; a < A; ++a)
+    dct->backwards(F[a],U[a]);
+
+  (*pmult)(F,m,indexsize,index,0,threads); // multiply even points
+  (*pmult)(U,m-1,indexsize,index,1,threads); // multiply odd points
+
+  for(unsigned int b=0; b < B; ++b)
+    dct->forwards(F[b],U[b]);
 }
 
 // a[0][k]=sum_i a[i][k]*b[i][k]*c[i][k]
@@ -1242,369 +788,33 @@ void fft0bipad::forwards(Complex *f, Complex *u)
     );
 }
 
-// This multiplication routine is for binary convolutions and takes two inputs
-// of size m.
-// F[0][j] *= conj(F[0][j]);
-void multautocorrelation(Complex **F, unsigned int m,
-                         const unsigned int indexsize,
-                         const unsigned int *index,
-                         unsigned int r, unsigned int threads)
-{
-  Complex* F0=F[0];
-  
-#ifdef __SSE2__
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j) {
-      Complex *p=F0+j;
-      STORE(p,ZMULT(LOAD(p),CONJ(LOAD(p))));
-    }
-    );
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j] *= conj(F0[j]);
-    );
-#endif
-}
-
-void multcorrelation(Complex **F, unsigned int m,
-                     const unsigned int indexsize,
-                     const unsigned int *index,
-                     unsigned int r, unsigned int threads)
-{
-  Complex* F0=F[0];
-  Complex* F1=F[1];
-  
-#ifdef __SSE2__
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j) {
-      Complex *p=F0+j;
-      Complex *q=F1+j;
-      STORE(p,ZMULT(LOAD(p),CONJ(LOAD(q))));
-    }
-    );
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j] *= conj(F1[j]);
-    );
-#endif
-}
-
-// Unscramble indices, returning spatial index for remainder r at position j.
-inline unsigned innerindex(unsigned j, int r) {return 2*j+r;}
-  
-// This multiplication routine is for binary convolutions and takes two inputs
-// of size m.
-// F[0][j] *= F[1][j];
-void multbinary(Complex **F, unsigned int m,
-                const unsigned int indexsize,
-                const unsigned int *index,
-                unsigned int r, unsigned int threads)
-{
-  Complex* F0=F[0];
-  Complex* F1=F[1];
-  
-#if 0 // Spatial indices are available, if needed.
-  size_t n=indexsize;
-  for(unsigned int j=0; j < m; ++j) {
-    for(unsigned int d=0; d < n; ++d)
-      cout << index[d] << ",";
-    cout << innerindex(j,r) << endl;
+// Define the multipliers of precision Real, which call the selected kernels.
+#define FFTWPP_MULTIPLIER(Real,T,name,kernel)                           \
+  void name(T **F, unsigned int m, const unsigned int indexsize,        \
+            const unsigned int *index, unsigned int r,                  \
+            unsigned int threads)                                       \
+  {                                                                     \
+    Selected<Real>()->kernel(F,m,indexsize,index,r,threads);            \
   }
-#endif  
-      
-#ifdef __SSE2__
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j) {
-      Complex *p=F0+j;
-      STORE(p,ZMULT(LOAD(p),LOAD(F1+j)));
-    }
-    );
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j] *= F1[j];
-    );
-#endif
-}
 
-// F[0][j] *= F[0][j];
-void multautoconvolution(Complex **F, unsigned int m,
-                         const unsigned int indexsize,
-                         const unsigned int *index,
-                         unsigned int r, unsigned int threads)
-{
-  Complex* F0=F[0];
-  
-#ifdef __SSE2__
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j) {
-      Complex *p=F0+j;
-      STORE(p,ZMULT(LOAD(p),LOAD(p)));
-    }
-    );
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j] *= F0[j];
-    );
-#endif
-}
-
-// Unscramble indices, returning spatial index for remainder r at position j.
-inline unsigned innerindex(unsigned j, int r, unsigned int m) {
-  int x=3*j+r;
-  return x >= 0 ? x : 3*m-1;
-}
-  
-// This multiplication routine is for binary Hermitian convolutions and takes
-// two inputs.
-// F[0][j] *= F[1][j];
-void multbinary(double **F, unsigned int m,
-                const unsigned int indexsize,
-                const unsigned int *index,
-                unsigned int r, unsigned int threads)
-{
-  double* F0=F[0];
-  double* F1=F[1];
-  
-#if 0 // Spatial indices are available, if needed.
-  //size_t n=index.size();
-  size_t n=indexsize;
-  for(unsigned int j=0; j < m; ++j) {
-    for(unsigned int d=0; d < n; ++d)
-      cout << index[d] << ",";
-    cout << innerindex(j,r,m) << endl;
-  }
-#endif
-      
-#ifdef __SSE2__
-  unsigned int m1=m-1;
-  PARALLEL(
-    for(unsigned int j=0; j < m1; j += 2) {
-      double *p=F0+j;
-      STORE(p,LOAD(p)*LOAD(F1+j));
-    }
-    if(m % 2)
-      F0[m1] *= F1[m1];
-    );
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j] *= F1[j];
-    );
-#endif
-}
-
-// F[0][j]=F[0][j]*F[2][j]+F[1][j]*F[3][j]
-void multbinary2(Complex **F, unsigned int m,
-                 const unsigned int indexsize,
-                 const unsigned int *index,
-                 unsigned int r, unsigned int threads)
-{
-  Complex* F0=F[0];
-  Complex* F1=F[1];
-  Complex* F2=F[2];
-  Complex* F3=F[3];
-  
-#ifdef __SSE2__
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j) {
-      Complex *F0j=F0+j;
-      STORE(F0j,ZMULT(LOAD(F0j),LOAD(F2+j))
-            +ZMULT(LOAD(F1+j),LOAD(F3+j)));
-    }
-    );
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j]=F0[j]*F2[j]+F1[j]*F3[j];
-    );
-#endif
-}
-
-// F[0][j]=F[0][j]*F[2][j]+F[1][j]*F[3][j]
-void multbinary2(double **F, unsigned int m,
-                 const unsigned int indexsize,
-                 const unsigned int *index,
-                 unsigned int r, unsigned int threads)
-{
-  double* F0=F[0];
-  double* F1=F[1];
-  double* F2=F[2];
-  double* F3=F[3];
-  
-#ifdef __SSE2__
-  unsigned int m1=m-1;
-  PARALLEL(
-    for(unsigned int j=0; j < m1; j += 2) {
-      double *F0j=F0+j;
-      STORE(F0j,LOAD(F0j)*LOAD(F2+j)+LOAD(F1+j)*LOAD(F3+j));
-    }
-    );
-  if(m % 2)
-    F0[m1]=F0[m1]*F2[m1]+F1[m1]*F3[m1];
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j]=F0[j]*F2[j]+F1[j]*F3[j];
-    );
-#endif
-}
-
-// F[0][j]=F[0][j]*F[3][j]+F[1][j]*F[4][j]+F[2][j]*F[5][j];
-void multbinary3(Complex **F, unsigned int m,
-                 const unsigned int indexsize,
-                 const unsigned int *index,
-                 unsigned int r, unsigned int threads)
-{
-  Complex* F0=F[0];
-  Complex* F1=F[1];
-  Complex* F2=F[2];
-  Complex* F3=F[3];
-  Complex* F4=F[4];
-  Complex* F5=F[5];
-  
-#ifdef __SSE2__
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j) {
-      Complex *F0j=F0+j;
-      STORE(F0j,ZMULT(LOAD(F0j),LOAD(F3+j))
-            +ZMULT(LOAD(F1+j),LOAD(F4+j))
-            +ZMULT(LOAD(F2+j),LOAD(F5+j))
-        );
-    }
-    );
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j]=F0[j]*F3[j]+F1[j]*F4[j]+F2[j]*F5[j];
-    );
-
-#endif
-}
-
-// F[0][j]=F[0][j]*F[4][j]+F[1][j]*F[5][j]+F[2][j]*F[6][j]+F[3][j]*F[7][j];
-void multbinary4(Complex **F, unsigned int m,
-                 const unsigned int indexsize,           
-                 const unsigned int *index,
-                 unsigned int r, unsigned int threads)
-{
-  Complex* F0=F[0];
-  Complex* F1=F[1];
-  Complex* F2=F[2];
-  Complex* F3=F[3];
-  Complex* F4=F[4];
-  Complex* F5=F[5];
-  Complex* F6=F[6];
-  Complex* F7=F[7];
-  
-#ifdef __SSE2__
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j) {
-      Complex *F0j=F0+j;
-      STORE(F0j,ZMULT(LOAD(F0j),LOAD(F4+j))
-            +ZMULT(LOAD(F1+j),LOAD(F5+j))
-            +ZMULT(LOAD(F2+j),LOAD(F6+j))
-            +ZMULT(LOAD(F3+j),LOAD(F7+j))
-        );
-    }
-    );
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j]=F0[j]*F4[j]+F1[j]*F5[j]+F2[j]*F6[j]+F3[j]*F7[j];
-    );
-
-#endif
-}
-
-// F[0][j]=F[0][j]*F[8][j]+F[1][j]*F[9][j]+F[2][j]*F[10][j]+F[3][j]*F[11][j]+
-//         F[4][j]*F[12][j]+F[5][j]*F[13][j]+F[6][j]*F[14][j]+F[7][j]*F[15][j];
-void multbinary8(Complex **F, unsigned int m,
-                 const unsigned int indexsize,
-                 const unsigned int *index,
-                 unsigned int r, unsigned int threads)
-{
-  Complex* F0=F[0];
-  Complex* F1=F[1];
-  Complex* F2=F[2];
-  Complex* F3=F[3];
-  Complex* F4=F[4];
-  Complex* F5=F[5];
-  Complex* F6=F[6];
-  Complex* F7=F[7];
-  Complex* F8=F[8];
-  Complex* F9=F[9];
-  Complex* F10=F[10];
-  Complex* F11=F[11];
-  Complex* F12=F[12];
-  Complex* F13=F[13];
-  Complex* F14=F[14];
-  Complex* F15=F[15];
-    
-#ifdef __SSE2__
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j) {
-      Complex *F0j=F0+j;
-      STORE(F0j,
-            ZMULT(LOAD(F0j),LOAD(F8+j))
-            +ZMULT(LOAD(F1+j),LOAD(F9+j))
-            +ZMULT(LOAD(F2+j),LOAD(F10+j))
-            +ZMULT(LOAD(F3+j),LOAD(F11+j))
-            +ZMULT(LOAD(F4+j),LOAD(F12+j))
-            +ZMULT(LOAD(F5+j),LOAD(F13+j))
-            +ZMULT(LOAD(F6+j),LOAD(F14+j))
-            +ZMULT(LOAD(F7+j),LOAD(F15+j))
-        );
-    }
-    );
-#else
-  PARALLEL(
-    for(unsigned int j=0; j < m; ++j)
-      F0[j]=F0[j]*F8[j]+F1[j]*F9[j]+F2[j]*F10[j]+F3[j]*F11[j]
-        +F4[j]*F12[j]+F5[j]*F13[j]+F6[j]*F14[j]+F7[j]*F15[j];
-    );
-#endif
-}
-
-// This 2D version of the scheme of Basdevant, J. Comp. Phys, 50, 1983
-// requires only 4 FFTs per stage.
-void multadvection2(double **F, unsigned int m,
-                    const unsigned int indexsize,
-                    const unsigned int *index,
-                    unsigned int r, unsigned int threads)
-{
-  double* F0=F[0];
-  double* F1=F[1];
-  
-#ifdef __SSE2__
-  unsigned int m1=m-1;
-  PARALLEL(
-    for(unsigned int j=0; j < m1; j += 2) {
-      double *F0j=F0+j;
-      double *F1j=F1+j;
-      Vec u=LOAD(F0j);
-      Vec v=LOAD(F1j);
-      STORE(F0j,v*v-u*u);
-      STORE(F1j,u*v);
-    }
-    );
-  if(m % 2) {
-    double u=F0[m1];
-    double v=F1[m1];
-    F0[m1]=v*v-u*u;
-    F1[m1]=u*v;
-  }
-#else
-  for(unsigned int j=0; j < m; ++j) {
-    double u=F0[j];
-    double v=F1[j];
-    F0[j]=v*v-u*u;
-    F1[j]=u*v;
-  }
-#endif  
-}
+#define FFTWPP_MULTIPLIER_DEFINITIONS(Real)                             \
+  FFTWPP_MULTIPLIER(Real,MultiplierT<Real>::Complex,multautocorrelation, \
+                    multautocorrelation)                                \
+  FFTWPP_MULTIPLIER(Real,MultiplierT<Real>::Complex,multcorrelation,    \
+                    multcorrelation)                                    \
+  FFTWPP_MULTIPLIER(Real,MultiplierT<Real>::Complex,multbinary,multbinary) \
+  FFTWPP_MULTIPLIER(Real,MultiplierT<Real>::Complex,multautoconvolution, \
+                    multautoconvolution)                                \
+  FFTWPP_MULTIPLIER(Real,MultiplierT<Real>::Complex,multbinary2,multbinary2) \
+  FFTWPP_MULTIPLIER(Real,MultiplierT<Real>::Complex,multbinary3,multbinary3) \
+  FFTWPP_MULTIPLIER(Real,MultiplierT<Real>::Complex,multbinary4,multbinary4) \
+  FFTWPP_MULTIPLIER(Real,MultiplierT<Real>::Complex,multbinary8,multbinary8) \
+  FFTWPP_MULTIPLIER(Real,Real,multbinary,realmultbinary)                \
+  FFTWPP_MULTIPLIER(Real,Real,multbinary2,realmultbinary2)              \
+  FFTWPP_MULTIPLIER(Real,Real,multadvection2,multadvection2)
+
+FFTWPP_MULTIPLIER_DEFINITIONS(double)
+FFTWPP_MULTIPLIER_DEFINITIONS(float)
+FFTWPP_MULTIPLIER_DEFINITIONS(long double)
 
 } // namespace fftwpp
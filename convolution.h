@@ -20,6 +20,16 @@
 #include "cmult-sse2.h"
 #include "transposeoptions.h"
     
+// The implicitly dealiased complex and Hermitian convolutions in 1D, 2D,
+// and 3D, along with the padded transforms fftpad, fft0pad, and fft1pad on
+// which they are built, are templates on the floating-point type Real, like
+// the transform classes of fftw++.h: ImplicitConvolution is
+// ImplicitConvolutionT<double>, ImplicitConvolutionf is
+// ImplicitConvolutionT<float>, and ImplicitConvolutionl is
+// ImplicitConvolutionT<long double>. The SIMD kernels are compiled for
+// double; float and long double use scalar kernels. The other convolution
+// classes operate on double precision Complex data only.
+
 namespace fftwpp {
 
 #ifndef __convolution_h__
@@ -44,65 +54,315 @@ inline unsigned int max(unsigned int a, unsigned int b)
   return (a > b) ? a : b;
 }
 
-// Build the factored zeta tables.
-unsigned int BuildZeta(double arg, unsigned int m,
-                       Complex *&ZetaH, Complex *&ZetaL,
-                       unsigned int threads=1);
+// The real type of the complex type C.
+template<class C>
+struct RealOf {typedef double type;};
+
+template<class T>
+struct RealOf<std::complex<T> > {typedef T type;};
 
+// Build the factored zeta tables of the complex type C, which is Complex,
+// std::complex<float>, or std::complex<long double>.
+template<class C>
+unsigned int BuildZeta(typename RealOf<C>::type arg, unsigned int m,
+                       C *&ZetaH, C *&ZetaL, unsigned int threads=1);
+
+template<class C>
 unsigned int BuildZeta(unsigned int n, unsigned int m,
-                       Complex *&ZetaH, Complex *&ZetaL,
-                       unsigned int threads=1);
+                       C *&ZetaH, C *&ZetaL, unsigned int threads=1);
+
+// Return the tables built by BuildZeta(n,m,...), shared read-only by all
+// callers with the same n, m, and complex type. Each call must be matched
+// by a call to ReleaseZeta(ZetaH); the tables are freed with their last
+// user.
+template<class C>
+unsigned int ShareZeta(unsigned int n, unsigned int m,
+                       C *&ZetaH, C *&ZetaL, unsigned int threads=1);
+
+// As above, for the tables of the powers of exp(2*pi*i*r/n).
+template<class C>
+unsigned int ShareZeta(unsigned int n, unsigned int r, unsigned int m,
+                       C *&ZetaH, C *&ZetaL, unsigned int threads=1);
+
+template<class C>
+void ReleaseZeta(C *ZetaH);
 
 struct convolveOptions {
   unsigned int nx,ny,nz;           // |
   unsigned int stride2,stride3;    // | Used internally by the MPI interface.
   utils::mpiOptions mpi;           // |
   bool toplevel;
+  bool borrow; // Borrow allocated work arrays from the Workspace per call
+               // instead of holding them for the lifetime of the object
 
   convolveOptions(unsigned int nx, unsigned int ny, unsigned int nz,
                   unsigned int stride2, unsigned int stride3) :
     nx(nx), ny(ny), nz(nz), stride2(stride2), stride3(stride3),
-    toplevel(true) {}
+    toplevel(true), borrow(false) {}
 
   convolveOptions(unsigned int nx, unsigned int ny, unsigned int stride2,
                   utils::mpiOptions mpi, bool toplevel=true) :
-    nx(nx), ny(ny), stride2(stride2), mpi(mpi), toplevel(toplevel) {}
+    nx(nx), ny(ny), stride2(stride2), mpi(mpi), toplevel(toplevel),
+    borrow(false) {}
     
   convolveOptions(unsigned int ny, unsigned int nz,
                   unsigned int stride2, unsigned int stride3,
                   utils::mpiOptions mpi, bool toplevel=true) :
     ny(ny), nz(nz), stride2(stride2), stride3(stride3), mpi(mpi),
-    toplevel(toplevel) {}
+    toplevel(toplevel), borrow(false) {}
   
-  convolveOptions(bool toplevel=true) : nx(0), ny(0), nz(0),
-                                        toplevel(toplevel) {}
+  convolveOptions(bool toplevel=true, bool borrow=false) :
+    nx(0), ny(0), nz(0), toplevel(toplevel), borrow(borrow) {}
 };
     
 static const convolveOptions defaultconvolveOptions;
 
-typedef void multiplier(Complex **, unsigned int m,
-                        const unsigned int indexsize,
-                        const unsigned int *index,
-                        unsigned int r, unsigned int threads); 
-typedef void realmultiplier(double **, unsigned int m,
-                            const unsigned int indexsize,
-                            const unsigned int *index,
-                            unsigned int r, unsigned int threads); 
-  
-// Multipliers for binary convolutions.
-
-multiplier multautoconvolution;
-multiplier multautocorrelation;
-multiplier multbinary;
-multiplier multcorrelation;
-multiplier multbinary2;
-multiplier multbinary3;
-multiplier multbinary4;
-multiplier multbinary8;
-
-realmultiplier multbinary;
-realmultiplier multbinary2;
-realmultiplier multadvection2;
+// The multiplier functions of the complex and Hermitian convolutions of
+// precision Real.
+template<class Real>
+struct MultiplierT {
+  typedef typename fftwTraits<Real>::Complex Complex;
+  typedef void multiplier(Complex **, unsigned int m,
+                          const unsigned int indexsize,
+                          const unsigned int *index,
+                          unsigned int r, unsigned int threads); 
+  typedef void realmultiplier(Real **, unsigned int m,
+                              const unsigned int indexsize,
+                              const unsigned int *index,
+                              unsigned int r, unsigned int threads); 
+};
+
+typedef MultiplierT<double>::multiplier multiplier;
+typedef MultiplierT<double>::realmultiplier realmultiplier;
+typedef MultiplierT<float>::multiplier multiplierf;
+typedef MultiplierT<float>::realmultiplier realmultiplierf;
+typedef MultiplierT<long double>::multiplier multiplierl;
+typedef MultiplierT<long double>::realmultiplier realmultiplierl;
+  
+// Multipliers for binary convolutions, overloaded on precision.
+#define FFTWPP_MULTIPLIERS(Real)                                \
+  MultiplierT<Real>::multiplier multautoconvolution;            \
+  MultiplierT<Real>::multiplier multautocorrelation;            \
+  MultiplierT<Real>::multiplier multbinary;                     \
+  MultiplierT<Real>::multiplier multcorrelation;                \
+  MultiplierT<Real>::multiplier multbinary2;                    \
+  MultiplierT<Real>::multiplier multbinary3;                    \
+  MultiplierT<Real>::multiplier multbinary4;                    \
+  MultiplierT<Real>::multiplier multbinary8;                    \
+                                                                \
+  MultiplierT<Real>::realmultiplier multbinary;                 \
+  MultiplierT<Real>::realmultiplier multbinary2;                \
+  MultiplierT<Real>::realmultiplier multadvection2;
+
+FFTWPP_MULTIPLIERS(double)
+FFTWPP_MULTIPLIERS(float)
+FFTWPP_MULTIPLIERS(long double)
+
+// The precision-dependent types used by the convolution classes.
+#define FFTWPP_CONVOLUTION_TYPES(Real)                                  \
+  FFTWPP_TYPES(Real)                                                    \
+  typedef typename MultiplierT<Real>::multiplier multiplier;            \
+  typedef typename MultiplierT<Real>::realmultiplier realmultiplier;
+
+// A multiplier object for the templated convolve routines, which expand it
+// inline. It calls op(F,k) for k=0,...,m-1 to combine the values F[a][k]
+// of the A inputs into the B outputs, where op is a function object with
+//   void operator()(T **F, unsigned int k) const;
+// and T is Complex for the complex and double for the Hermitian
+// convolutions. The loop can then be vectorized by the compiler.
+// For example, for a binary convolution:
+//
+//   struct product {
+//     void operator()(Complex **F, unsigned int k) const {
+//       F[0][k] *= F[1][k];
+//     }
+//   };
+//   C.convolve(F,pointwise<product>());
+//
+template<class Op>
+class pointwise {
+  Op op;
+public:
+  pointwise(const Op& op=Op()) : op(op) {}
+  
+  template<class T>
+  void operator()(T **F, unsigned int m, const unsigned int indexsize,
+                  const unsigned int *index, unsigned int r,
+                  unsigned int threads) const {
+    PARALLEL(
+      for(unsigned int k=0; k < m; ++k)
+        op(F,k);
+      );
+  }
+};
+
+// The coordinates, in [0,2pi), of the points passed to one multiplier call.
+// Along the outer dimensions these are fixed: x[0] is the x coordinate in
+// 2D and 3D, and x[1] is the y coordinate in 3D. Along the last dimension,
+// point k lies at P(k)=origin+k*step. For Hermitian convolutions the first
+// point of the residue r=-1 lies at origin=-step/3, which is equivalent to
+// 2pi-step/3.
+struct position {
+  double x[2];
+  double origin;
+  double step;
+  
+  double operator()(unsigned int k) const {return origin+(int) k*step;}
+};
+
+// The implicitly padded grid of a complex or Hermitian convolution,
+// which maps the index and residue arguments of a multiplier to the
+// coordinates of its points. The implicitly padded grid has 2m points
+// along each dimension of size m of a complex convolution, and 3m points
+// along each dimension of a Hermitian convolution, where m is the number
+// of independent values.
+//
+//   grid g(hermitian,mx,my);
+//
+// Notes:
+//   mx and my are the sizes of the outer dimensions: mx for 2D, and
+//   mx and my for 3D convolutions; both are ignored in 1D.
+//
+class grid {
+  unsigned int p; // The padding factor: 2 (complex) or 3 (Hermitian).
+  double h[2]; // The spacings of the outer dimensions.
+public:
+  grid(bool hermitian, unsigned int mx=1, unsigned int my=1) :
+    p(hermitian ? 3 : 2) {
+    h[0]=twopi/(p*mx);
+    h[1]=twopi/(p*my);
+  }
+  
+  // Return the coordinates of the m points of a multiplier call.
+  position operator()(unsigned int m, unsigned int indexsize,
+                      const unsigned int *index, unsigned int r) const {
+    position P;
+    for(unsigned int d=0; d < 2; ++d)
+      P.x[d]=d < indexsize ? index[d]*h[d] : 0.0;
+    P.step=twopi/m;
+    P.origin=(int) r*P.step/p;
+    return P;
+  }
+};
+
+// A multiplier object, like pointwise, that also passes the coordinates
+// of the points on the grid g: it calls op(F,k,P) for k=0,...,m-1, where
+// op is a function object with
+//   void operator()(T **F, unsigned int k, const position& P) const;
+// The coordinates are computed once per call; P(k) is affine in k, so
+// that the loop can still be vectorized. For example,
+//
+//   struct forcing {
+//     void operator()(Complex **F, unsigned int k, const position& P) const {
+//       F[0][k] *= F[1][k]*cos(P.x[0])*sin(P(k));
+//     }
+//   };
+//   ImplicitConvolution2 C(mx,my);
+//   C.convolve(F,positional<forcing>(grid(false,mx)));
+//
+template<class Op>
+class positional {
+  grid g;
+  Op op;
+public:
+  positional(const grid& g, const Op& op=Op()) : g(g), op(op) {}
+  
+  template<class T>
+  void operator()(T **F, unsigned int m, const unsigned int indexsize,
+                  const unsigned int *index, unsigned int r,
+                  unsigned int threads) const {
+    position P=g(m,indexsize,index,r);
+    PARALLEL(
+      for(unsigned int k=0; k < m; ++k)
+        op(F,k,P);
+      );
+  }
+};
+
+// Instruction sets for which the multipliers and the pre- and
+// post-transforms of the implicit convolutions are compiled: SSE2 (one
+// complex value per instruction), AVX2 with FMA (two), and AVX-512 (four).
+// With GCC on x86, all three are built into the same binary; other
+// compilers build only those enabled by their flags.
+enum ISA {SSE2,AVX2,AVX512};
+extern const char *ISAName[]; // "sse2", "avx2", "avx512"
+
+// Return whether the kernels for isa are built and supported by this CPU.
+bool AvailableISA(ISA isa);
+
+// Return the instruction set in use. Unless changed by SelectISA, this is
+// the one named by the environment variable FFTWPP_ISA, if available, or
+// else the best available one, as determined on the first call.
+ISA CurrentISA();
+
+// Use the kernels for isa from now on, if available. This should not be
+// called while a convolution is in progress.
+bool SelectISA(ISA isa);
+
+// The kernels of the multipliers and of the pre- and post-transforms of
+// precision Real, compiled for one instruction set.
+template<class Real>
+struct KernelsT {
+  typedef typename fftwTraits<Real>::Complex Complex;
+  typedef typename MultiplierT<Real>::multiplier multiplier;
+  typedef typename MultiplierT<Real>::realmultiplier realmultiplier;
+  
+  multiplier *multautocorrelation;
+  multiplier *multcorrelation;
+  multiplier *multbinary;
+  multiplier *multautoconvolution;
+  multiplier *multbinary2;
+  multiplier *multbinary3;
+  multiplier *multbinary4;
+  multiplier *multbinary8;
+  realmultiplier *realmultbinary;
+  realmultiplier *realmultbinary2;
+  realmultiplier *multadvection2;
+  void (*pretransform)(Complex **F, unsigned int A, unsigned int m,
+                       unsigned int s, Complex *ZetaH, Complex *ZetaL,
+                       unsigned int threads);
+  void (*posttransform)(Complex *f, Complex *u, unsigned int m,
+                        unsigned int s, Complex *ZetaH, Complex *ZetaL,
+                        unsigned int threads);
+  void (*pretransformH)(Complex *F, Complex *f1c, Complex *U, unsigned int m,
+                        unsigned int c, bool compact, bool even,
+                        unsigned int s, Complex *ZetaH, Complex *ZetaL,
+                        unsigned int threads);
+  void (*posttransformH)(Complex *F, const Complex& w, Complex *U,
+                         unsigned int m, unsigned int c, bool even,
+                         unsigned int s, Complex *ZetaH, Complex *ZetaL,
+                         unsigned int threads);
+  typedef void pad(Complex *f, Complex *u, unsigned int m, unsigned int M,
+                   unsigned int stride, unsigned int s, Complex *ZetaH,
+                   Complex *ZetaL, unsigned int threads);
+  pad *fftpadexpand;
+  pad *fftpadreduce;
+  pad *fft0padexpand;
+  pad *fft0padreduce;
+  pad *fft1padexpand;
+  pad *fft1padreduce;
+  void (*fftpadpqexpand)(Complex *f, Complex *u, unsigned int m,
+                         unsigned int c, unsigned int M, unsigned int stride,
+                         unsigned int s, Complex *ZetaH, Complex *ZetaL,
+                         unsigned int threads);
+  void (*fftpadpqreduce)(Complex *u, Complex *f, unsigned int m,
+                         unsigned int c, unsigned int M, unsigned int stride,
+                         unsigned int s, Complex *ZetaH, Complex *ZetaL,
+                         Real ninv, bool first, unsigned int threads);
+};
+
+// Return the kernels in use for precision Real: those of the current
+// instruction set for double, and the scalar kernels for float and long
+// double.
+template<class Real>
+const KernelsT<Real> *Selected();
+
+template<>
+const KernelsT<double> *Selected<double>();
+template<>
+const KernelsT<float> *Selected<float>();
+template<>
+const KernelsT<long double> *Selected<long double>();
 
 struct general {};
 struct pretransform1 {};
@@ -112,7 +372,10 @@ struct pretransform4 {};
 
 // In-place implicitly dealiased 1D complex convolution using
 // function pointers for multiplication
-class ImplicitConvolution : public ThreadBase {
+template<class Real>
+class ImplicitConvolutionT : public ThreadBase {
+public:
+  FFTWPP_CONVOLUTION_TYPES(Real)
 private:
   unsigned int m;
   Complex **U;
@@ -121,10 +384,11 @@ private:
   Complex *u;
   unsigned int s;
   Complex *ZetaH, *ZetaL;
-  fft1d *BackwardsO,*ForwardsO;
-  fft1d *Backwards,*Forwards;
+  fft1dT<Real> *BackwardsO,*ForwardsO;
+  fft1dT<Real> *Backwards,*Forwards;
   bool pointers;
   bool allocated;
+  bool ownplans; // The plans were not borrowed from another convolution.
   unsigned int indexsize;
 public:
   unsigned int *index;
@@ -141,6 +405,14 @@ public:
     delete [] U;
   }
 
+  // Use the work array u of C*m Complex values instead of the current one.
+  void rebind(Complex *u) {
+    unsigned int C=max(A,B);
+    for(unsigned int a=0; a < C; ++a) 
+      U[a]=u+a*m;
+    this->u=u;
+  }
+
   void allocateindex(unsigned int n, unsigned int *i) {
     indexsize=n;
     index=i;
@@ -148,35 +420,37 @@ public:
   
   void init() {
     indexsize=0;
+    ownplans=true;
     
     Complex* U0=U[0];
-    Complex* U1=A == 1 ? utils::ComplexAlign(m) : U[1];
+    Complex* U1=A == 1 ? utils::ComplexAlign<Complex>(m) : U[1];
     
-    BackwardsO=new fft1d(m,1,U0,U1);
-    ForwardsO=new fft1d(m,-1,U0,U1);
+    BackwardsO=new fft1dT<Real>(m,1,U0,U1);
+    ForwardsO=new fft1dT<Real>(m,-1,U0,U1);
     threads=std::min(threads,max(BackwardsO->Threads(),ForwardsO->Threads()));
     
+    Backwards=Forwards=NULL;
     if(A == B) {
-      Backwards=new fft1d(m,1,U0);
+      Backwards=new fft1dT<Real>(m,1,U0);
       threads=std::min(threads,Backwards->Threads());
     }
     if(A <= B) {
-      Forwards=new fft1d(m,-1,U0);
+      Forwards=new fft1dT<Real>(m,-1,U0);
       threads=std::min(threads,Forwards->Threads());
     }
     
     if(A == 1) utils::deleteAlign(U1);
 
-    s=BuildZeta(2*m,m,ZetaH,ZetaL,threads);
+    s=ShareZeta(2*m,m,ZetaH,ZetaL,threads);
   }
   
   // m is the number of Complex data values.
   // U is an array of C distinct work arrays each of size m, where C=max(A,B)
   // A is the number of inputs.
   // B is the number of outputs.
-  ImplicitConvolution(unsigned int m, Complex **U, unsigned int A=2,
-                      unsigned int B=1,
-                      unsigned int threads=fftw::maxthreads)
+  ImplicitConvolutionT(unsigned int m, Complex **U, unsigned int A=2,
+                       unsigned int B=1,
+                       unsigned int threads=fftw::maxthreads)
     : ThreadBase(threads), m(m), U(U), A(A), B(B), pointers(false),
       allocated(false) {
     init();
@@ -186,9 +460,9 @@ public:
   // u is a work array of C*m Complex values.
   // A is the number of inputs.
   // B is the number of outputs.
-  ImplicitConvolution(unsigned int m, Complex *u,
-                      unsigned int A=2, unsigned int B=1,
-                      unsigned int threads=fftw::maxthreads)
+  ImplicitConvolutionT(unsigned int m, Complex *u,
+                       unsigned int A=2, unsigned int B=1,
+                       unsigned int threads=fftw::maxthreads)
     : ThreadBase(threads), m(m), A(A), B(B), u(u), allocated(false) {
     initpointers(U,u);
     init();
@@ -197,34 +471,74 @@ public:
   // m is the number of Complex data values.
   // A is the number of inputs.
   // B is the number of outputs.
-  ImplicitConvolution(unsigned int m,
-                      unsigned int A=2, unsigned int B=1,
-                      unsigned int threads=fftw::maxthreads)
+  ImplicitConvolutionT(unsigned int m,
+                       unsigned int A=2, unsigned int B=1,
+                       unsigned int threads=fftw::maxthreads)
     : ThreadBase(threads), m(m), A(A), B(B), allocated(true) {
-    u=utils::ComplexAlign(max(A,B)*m);
+    u=utils::ComplexAlign<Complex>(max(A,B)*m);
     initpointers(U,u);
     init();
   }
  
-  ~ImplicitConvolution() {
-    utils::deleteAlign(ZetaH);
-    utils::deleteAlign(ZetaL);
+  // Execute the plans of convolution, which must outlive this object, on
+  // the work array u of C*m Complex values, where C=max(A,B). Convolutions
+  // sharing plans may run concurrently; plans upgraded in the background
+  // are then switched in only by update().
+  ImplicitConvolutionT(ImplicitConvolutionT& convolution, Complex *u)
+    : ThreadBase(convolution.threads), m(convolution.m), A(convolution.A),
+      B(convolution.B), u(u), s(convolution.s), 
+      BackwardsO(convolution.BackwardsO), ForwardsO(convolution.ForwardsO),
+      Backwards(convolution.Backwards), Forwards(convolution.Forwards),
+      allocated(false), ownplans(false), indexsize(0) {
+    initpointers(U,u);
+    ShareZeta(2*m,m,ZetaH,ZetaL,threads);
+    convolution.share();
+  }
+  
+  ~ImplicitConvolutionT() {
+    ReleaseZeta(ZetaH);
     
     if(pointers) deletepointers(U);
     if(allocated) utils::deleteAlign(u);
     
-    if(A == B)
-      delete Backwards;
-    if(A <= B)
-      delete Forwards;
+    if(ownplans) {
+      if(A == B)
+        delete Backwards;
+      if(A <= B)
+        delete Forwards;
     
-    delete ForwardsO;
-    delete BackwardsO;    
+      delete ForwardsO;
+      delete BackwardsO;
+    }
+  }
+
+  // Allow several threads to execute the plans at once.
+  void share() {
+    BackwardsO->Share();
+    ForwardsO->Share();
+    if(A == B) Backwards->Share();
+    if(A <= B) Forwards->Share();
+  }
+  
+  // Switch in any plans upgraded in the background.
+  void update() {
+    BackwardsO->Update();
+    ForwardsO->Update();
+    if(A == B) Backwards->Update();
+    if(A <= B) Forwards->Update();
   }
 
   // F is an array of A pointers to distinct data blocks each of size m,
   // shifted by offset (contents not preserved).
   void convolve(Complex **F, multiplier *pmult, unsigned int i=0,
+                unsigned int offset=0) {
+    convolve<multiplier *>(F,pmult,i,offset);
+  }
+  
+  // As above, with a multiplier object mult called like a multiplier
+  // function, which is expanded inline (see pointwise).
+  template<class Mult>
+  void convolve(Complex **F, Mult mult, unsigned int i=0,
                 unsigned int offset=0);
   
   void autoconvolve(Complex *f) {
@@ -249,17 +563,118 @@ public:
     convolve(F,multcorrelation);
   }
     
-  template<class T>
-  inline void pretransform(Complex **F, unsigned int k, Vec& Zetak);
-
-  template<class T>
-  void pretransform(Complex **F);
+  // multiply by root of unity to prepare for inverse FFT for odd modes
+  void pretransform(Complex **F) {
+    Selected<Real>()->pretransform(F,A,m,s,ZetaH,ZetaL,threads);
+  }
   
-  void posttransform(Complex *f, Complex *u);
+  // multiply by root of unity to prepare and add for inverse FFT for odd
+  // modes
+  void posttransform(Complex *f, Complex *u) {
+    Selected<Real>()->posttransform(f,u,m,s,ZetaH,ZetaL,threads);
+  }
 };
 
+template<class Real>
+template<class Mult>
+void ImplicitConvolutionT<Real>::convolve(Complex **F, Mult mult,
+                                          unsigned int i,
+                                          unsigned int offset)
+{
+  if(indexsize >= 1) index[indexsize-1]=i;
+  
+  unsigned int C=max(A,B);
+  Complex *P[C];
+  for(unsigned int a=0; a < C; ++a)
+    P[a]=F[a]+offset;
+  
+  // Backwards FFT (even indices):
+  for(unsigned int a=0; a < A; ++a) {
+    BackwardsO->fft(P[a],U[a]);
+  }
+  
+  if(A >= B)
+    mult(U,m,indexsize,index,0,threads); // multiply even indices
+
+  pretransform(P);
+
+  if(A > B) { // U[A-1] is free
+    Complex *W[A];
+    W[A-1]=U[A-1];
+    for(unsigned int a=1; a < A; ++a) 
+      W[a-1]=P[a];
+
+    for(unsigned int a=A; a-- > 0;) // Loop from A-1 to 0.
+      BackwardsO->fft(P[a],W[a]);
+    
+    mult(W,m,indexsize,index,1,threads); // multiply odd indices
+    
+    // Return to original space
+    Complex *lastW=W[A-1];
+    for(unsigned int b=0; b < B; ++b) {
+      Complex *Pb=P[b];
+      ForwardsO->fft(W[b],Pb);
+      ForwardsO->fft(U[b],lastW);
+      posttransform(Pb,lastW);
+    }
+    
+  } else if(A < B) { // U[B-1] is free
+    Complex *W[B];
+    W[B-1]=U[B-1];
+    for(unsigned int b=1; b < B; ++b) 
+      W[b-1]=P[b];
+
+    for(unsigned int a=A; a-- > 0;) // Loop from A-1 to 0.
+      BackwardsO->fft(P[a],W[a]);
+    
+    mult(W,m,indexsize,index,1,threads); // multiply odd indices
+    
+    // Return to original space
+    for(unsigned int b=0; b < B; ++b)
+      ForwardsO->fft(W[b],P[b]);
+    
+    mult(U,m,indexsize,index,0,threads); // multiply even indices
+    
+    Complex *f0=P[0];
+    Complex *u0=U[0];
+    Forwards->fft(u0);
+    posttransform(f0,u0);
+    for(unsigned int b=1; b < B; ++b) {
+      Complex *fb=P[b];
+      Complex *ub=U[b];
+      Complex *u0=U[0];
+      ForwardsO->fft(ub,u0);
+      posttransform(fb,u0);
+    }
+    
+  } else { // A == B
+    // Backwards FFT (odd indices):
+    for(unsigned int a=0; a < A; ++a)
+      Backwards->fft(P[a]);
+    mult(P,m,indexsize,index,1,threads); //multiply odd indices
+
+    // Return to original space:
+    Complex *f0=P[0];
+    Complex *u0=U[0];
+    Forwards->fft(f0);
+    Forwards->fft(u0);
+    posttransform(f0,u0);
+    for(unsigned int b=1; b < B; ++b) {
+      Complex *fb=P[b];
+      Complex *ub=U[b];
+      Complex *u0=U[0];
+      Forwards->fft(fb);
+      ForwardsO->fft(ub,u0);
+      posttransform(fb,u0);
+    }
+  }
+}
+
 // In-place implicitly dealiased 1D Hermitian convolution.
-class ImplicitHConvolution : public ThreadBase {
+template<class Real>
+class ImplicitHConvolutionT : public ThreadBase {
+public:
+  FFTWPP_CONVOLUTION_TYPES(Real)
 protected:
   unsigned int m;
   unsigned int c;
@@ -270,11 +685,12 @@ protected:
   Complex *u;
   unsigned int s;
   Complex *ZetaH,*ZetaL;
-  rcfft1d *rc,*rco,*rcO;
-  crfft1d *cr,*cro,*crO;
+  rcfft1dT<Real> *rc,*rco,*rcO;
+  crfft1dT<Real> *cr,*cro,*crO;
   Complex *w; // Work array of size max(A,B) to hold f[c] in even case.
   bool pointers;
   bool allocated;
+  bool ownplans; // The plans were not borrowed from another convolution.
   bool even;
   unsigned int indexsize;
 public:
@@ -293,6 +709,17 @@ public:
     delete [] U;
   }
   
+  // Use the work array u of C*(c+1) Complex values instead of the current
+  // one.
+  void rebind(Complex *u) {
+    unsigned int C=max(A,B);
+    unsigned stride=c+1;
+    for(unsigned int a=0; a < C; ++a) 
+      U[a]=u+a*stride;
+    if(!even) w=u;
+    this->u=u;
+  }
+  
   void allocateindex(unsigned int n, unsigned int *i) {
     indexsize=n;
     index=i;
@@ -301,14 +728,15 @@ public:
   void init() {
     even=m == 2*c;
     indexsize=0;
+    ownplans=true;
     Complex* U0=U[0];
     
-    rc=new rcfft1d(m,U0);
-    cr=new crfft1d(m,U0);
+    rc=new rcfft1dT<Real>(m,U0);
+    cr=new crfft1dT<Real>(m,U0);
 
-    Complex* U1=A == 1 ? utils::ComplexAlign(m) : U[1];
-    rco=new rcfft1d(m,(double *) U0,U1);
-    cro=new crfft1d(m,U1,(double *) U0);
+    Complex* U1=A == 1 ? utils::ComplexAlign<Complex>(m) : U[1];
+    rco=new rcfft1dT<Real>(m,(Real *) U0,U1);
+    cro=new crfft1dT<Real>(m,U1,(Real *) U0);
     if(A == 1) utils::deleteAlign(U1);
     
     if(A != B) {
@@ -320,24 +748,24 @@ public:
     }
     
     threads=std::min(threads,std::max(rco->Threads(),cro->Threads()));
-    s=BuildZeta(3*m,c+2,ZetaH,ZetaL,threads);
-    w=even ? utils::ComplexAlign(max(A,B)) : u;
+    s=ShareZeta(3*m,c+2,ZetaH,ZetaL,threads);
+    w=even ? utils::ComplexAlign<Complex>(max(A,B)) : u;
   }
   
   // m is the number of independent data values
   // U is an array of max(A,B) distinct work arrays of size c+1, where c=m/2
   // A is the number of inputs.
   // B is the number of outputs.
-  ImplicitHConvolution(unsigned int m, Complex **U, unsigned int A=2,
-                       unsigned int B=1, unsigned int threads=fftw::maxthreads)
+  ImplicitHConvolutionT(unsigned int m, Complex **U, unsigned int A=2,
+                        unsigned int B=1, unsigned int threads=fftw::maxthreads)
     : ThreadBase(threads), m(m), c(m/2), compact(true), U(U), A(A), B(B),
       pointers(false), allocated(false) {
     init();
   }
 
-  ImplicitHConvolution(unsigned int m, bool compact, Complex **U,
-                       unsigned int A=2, unsigned int B=1,
-                       unsigned int threads=fftw::maxthreads)
+  ImplicitHConvolutionT(unsigned int m, bool compact, Complex **U,
+                        unsigned int A=2, unsigned int B=1,
+                        unsigned int threads=fftw::maxthreads)
     : ThreadBase(threads), m(m), c(m/2), compact(compact), U(U), A(A), B(B),
       pointers(false), allocated(false) {
     init();
@@ -347,18 +775,18 @@ public:
   // u is a work array of max(A,B)*(c+1) Complex values, where c=m/2
   // A is the number of inputs.
   // B is the number of outputs.
-  ImplicitHConvolution(unsigned int m, Complex *u,
-                       unsigned int A=2, unsigned int B=1,
-                       unsigned int threads=fftw::maxthreads)
+  ImplicitHConvolutionT(unsigned int m, Complex *u,
+                        unsigned int A=2, unsigned int B=1,
+                        unsigned int threads=fftw::maxthreads)
     : ThreadBase(threads), m(m), c(m/2), compact(true), A(A), B(B), u(u),
       allocated(false) {
     initpointers(U,u);
     init();
   }
 
-  ImplicitHConvolution(unsigned int m, bool compact, Complex *u,
-                       unsigned int A=2, unsigned int B=1,
-                       unsigned int threads=fftw::maxthreads)
+  ImplicitHConvolutionT(unsigned int m, bool compact, Complex *u,
+                        unsigned int A=2, unsigned int B=1,
+                        unsigned int threads=fftw::maxthreads)
     : ThreadBase(threads), m(m), c(m/2), compact(compact), A(A), B(B), u(u), 
       allocated(false) {
     initpointers(U,u);
@@ -369,38 +797,86 @@ public:
   // u is a work array of max(A,B)*(c+1) Complex values, where c=m/2
   // A is the number of inputs.
   // B is the number of outputs.
-  ImplicitHConvolution(unsigned int m, bool compact=true, unsigned int A=2,
-                       unsigned int B=1, unsigned int threads=fftw::maxthreads)
+  ImplicitHConvolutionT(unsigned int m, bool compact=true, unsigned int A=2,
+                        unsigned int B=1, unsigned int threads=fftw::maxthreads)
     : ThreadBase(threads), m(m), c(m/2), compact(compact), A(A), B(B),
-      u(utils::ComplexAlign(max(A,B)*(c+1))), allocated(true) {
+      u(utils::ComplexAlign<Complex>(max(A,B)*(c+1))), allocated(true) {
     initpointers(U,u);
     init();
   }
 
-  virtual ~ImplicitHConvolution() {
+  // Execute the plans of convolution, which must outlive this object, on
+  // the work array u of max(A,B)*(c+1) Complex values. Convolutions sharing
+  // plans may run concurrently; plans upgraded in the background are then
+  // switched in only by update().
+  ImplicitHConvolutionT(ImplicitHConvolutionT& convolution, Complex *u)
+    : ThreadBase(convolution.threads), m(convolution.m), c(convolution.c),
+      compact(convolution.compact), A(convolution.A), B(convolution.B),
+      u(u), s(convolution.s), rc(convolution.rc), rco(convolution.rco),
+      rcO(convolution.rcO), cr(convolution.cr), cro(convolution.cro),
+      crO(convolution.crO), allocated(false), ownplans(false),
+      even(convolution.even), indexsize(0) {
+    initpointers(U,u);
+    ShareZeta(3*m,c+2,ZetaH,ZetaL,threads);
+    w=even ? utils::ComplexAlign<Complex>(max(A,B)) : u;
+    convolution.share();
+  }
+
+  virtual ~ImplicitHConvolutionT() {
     if(even) utils::deleteAlign(w);
-    utils::deleteAlign(ZetaH);
-    utils::deleteAlign(ZetaL);
+    ReleaseZeta(ZetaH);
     
     if(pointers) deletepointers(U);
     if(allocated) utils::deleteAlign(u);
 
-    if(A != B) {
-      delete cro;
-      delete rco;
-    }
+    if(ownplans) {
+      if(A != B) {
+        delete cro;
+        delete rco;
+      }
     
-    delete cr;
-    delete rc;
+      delete cr;
+      delete rc;
+    }
+  }
+  
+  // Allow several threads to execute the plans at once.
+  void share() {
+    rc->Share();
+    cr->Share();
+    rco->Share();
+    cro->Share();
+  }
+  
+  // Switch in any plans upgraded in the background.
+  void update() {
+    rc->Update();
+    cr->Update();
+    rco->Update();
+    cro->Update();
   }
   
   // F is an array of A pointers to distinct data blocks each of size m,
   // shifted by offset (contents not preserved).
   void convolve(Complex **F, realmultiplier *pmult, unsigned int i=0,         
+                unsigned int offset=0) {
+    convolve<realmultiplier *>(F,pmult,i,offset);
+  }
+  
+  // As above, with a multiplier object mult called like a realmultiplier
+  // function, which is expanded inline (see pointwise).
+  template<class Mult>
+  void convolve(Complex **F, Mult mult, unsigned int i=0,
                 unsigned int offset=0);
 
-  void pretransform(Complex *F, Complex *f1c, Complex *U);
-  void posttransform(Complex *F, const Complex& f1c, Complex *U);
+  void pretransform(Complex *F, Complex *f1c, Complex *U) {
+    Selected<Real>()->pretransformH(F,f1c,U,m,c,compact,even,s,ZetaH,ZetaL,
+                                    threads);
+  }
+  
+  void posttransform(Complex *F, const Complex& w, Complex *U) {
+    Selected<Real>()->posttransformH(F,w,U,m,c,even,s,ZetaH,ZetaL,threads);
+  }
 
   // Binary convolution:
   void convolve(Complex *f, Complex *g) {
@@ -408,7 +884,154 @@ public:
     convolve(F,multbinary);
   }
 };
+
+template<class Real>
+template<class Mult>
+void ImplicitHConvolutionT<Real>::convolve(Complex **F, Mult mult,
+                                           unsigned int i,
+                                           unsigned int offset)
+{
+  if(indexsize >= 1) index[indexsize-1]=i;
+  
+  // Set problem-size variables and pointers:
+  unsigned int C=max(A,B);
+
+  Complex *C0[C], *C1[C], *C2[C]; // inputs to complex2real FFTs
+  Real    *D0[C], *D1[C], *D2[C]; // outputs of complex2real FFTs
+  Complex **c0=C0, **c1=C1, **c2=C2;
+  Real **d0=D0, **d1=D1, **d2=D2;
+
+  unsigned int start=m-1-c; // c-1 (c) for m=even (odd)
+  for(unsigned int a=0; a < C; ++a) {
+    Complex *f=F[a]+offset;
+    c0[a]=f;
+    c1[a]=f+start;
+  }
+    
+  if(A != B) { 
+    for(unsigned int a=0; a < C-1; ++a) {
+      d0[a]=(Real *) c0[a+1];
+      d1[a]=(Real *) c1[a+1];
+    }
+    if(A > B) {
+      d0[A-1]=(Real *) U[A-1];
+      d1[A-1]=(Real *) U[A-1];
+      d2=(Real **) U;
+      for(unsigned int b=0; b < B; ++b)
+        c2[b]=U[b+1];
+    } else {
+      d0[B-1]=(Real *) U[0];
+      d1[B-1]=(Real *) U[0];
+      for(unsigned int b=0; b < B-1; ++b)
+        c2[b]=U[b+1];
+      c2[B-1]=U[0];
+      for(unsigned int b=0; b < B; ++b)
+        d2[b]=(Real *) c2[b];
+    }
+  } else {
+    c2=U;
+    d0=(Real **) c0;
+    d1=(Real **) c1;
+    d2=(Real **) c2;
+  }
+
+  // Complex-to-real FFTs and pmults:
+  
+  Real Re[B],Im[B];
+
+  // r=-1 (backwards):
+  if(A >= B) {
+    for(unsigned int a=0; a < A-1; ++a) {
+      pretransform(c0[a],w+a,U[A-1]);
+      cro->fft(U[A-1],U[a]);
+    }
+    pretransform(c0[A-1],w+A-1,U[A-1]);
+    cr->fft(U[A-1]);
+    mult((Real **) U,m,indexsize,index,-1,threads);
+  } else {
+    for(unsigned int a=A; a-- > 0;) {// Loop from A-1 to 0.
+      pretransform(c0[a],w+a,U[a]);
+      cro->fft(U[a],d2[a]);
+    }
+  }
+
+  // r=0:
+  Real T[A];
+  for(unsigned int a=A; a-- > 0;) { // Loop from A-1 to 0.
+    Complex *c0a=c0[a];
+    T[a]=c0a[0].real(); // r=0, k=0
+    if(!compact) // Nyquist
+      c0a[0]=Complex(c0a[0].real()+2.0*c0a[m].real(),c0a[0].imag());
+    crO->fft(c0a,d0[a]);
+  }
+  mult(d0,m,indexsize,index,0,threads);
+    
+  for(unsigned int b=0; b < B; ++b) {
+    Complex *c0b=c0[b];
+    rcO->fft(d0[b],c0b);
+    if(!compact) c0b[m]=0.0; // Zero Nyquist mode, for Hermitian symmetry.
+    Complex z=c0[b][start];  // r=0, k=start
+    Re[b]=z.real();
+    Im[b]=z.imag();
+  }
+  
+  if(even) {
+    for(unsigned int a=C; a-- > 0;) { // Loop from C-1 to 0.
+      Complex *c1a=c1[a];
+      Complex tmp=w[a];
+      w[a]=Complex(c1a[1].real(),tmp.imag()); // r=0, k=c
+      c1a[1]=tmp;          // r=1, k=1
+    }
+  }
+  
+  // r=1:
+  for(unsigned int a=A; a-- > 0;) { // Loop from A-1 to 0.
+    Complex *c1a=c1[a];
+    c1a[0]=compact ? T[a] : T[a]-c1a[c+1].real(); // r=1, k=0 with Nyquist
+    crO->fft(c1[a],d1[a]);
+  }
+  mult(d1,m,indexsize,index,1,threads);
+
+  for(unsigned int b=0; b < B; ++b) {
+    Complex *c1b=c1[b];
+    rcO->fft(d1[b],c1b); // r=1
+    if(even) {
+      Real tmp=w[b].real();
+      w[b]=c1b[1]; // r=1, k=1
+      c1b[1]=tmp;    // r=0, k=c
+    }
+  }
+  
+  const Real ninv=1.0/(3.0*(Real) m);
   
+  // r=-1 (forwards):
+  if(A > B) {
+    for(unsigned int b=0; b < B; ++b) {
+      rco->fft(d2[b],U[A-1]);
+      Real R=c1[b][0].real();
+      c0[b][start]=Complex(Re[b],Im[b]); // r=0, k=c-1 (c) for m=even (odd)
+      c0[b][0]=(c0[b][0].real()+R+U[A-1][0].real())*ninv;
+      posttransform(c0[b],w[b],U[A-1]);
+    }
+  } else {
+    if(A < B)
+      mult(d2,m,indexsize,index,-1,threads);
+
+    rc->fft(c2[0]);
+    Real R=c1[0][0].real();
+    c0[0][start]=Complex(Re[0],Im[0]); // r=0, k=c-1 (c) for m=even (odd)
+    c0[0][0]=(c0[0][0].real()+R+c2[0][0].real())*ninv;
+    posttransform(c0[0],w[0],c2[0]);
+
+    for(unsigned int b=1; b < B; ++b) {
+      rco->fft(d2[b],c2[0]);
+      Real R=c1[b][0].real();
+      c0[b][start]=Complex(Re[b],Im[b]); // r=0, k=c-1 (c) for m=even (odd)
+      c0[b][0]=(c0[b][0].real()+R+c2[0][0].real())*ninv;
+      posttransform(c0[b],w[b],c2[0]);
+    }
+  }
+}
 
 // Compute the scrambled implicitly m-padded complex Fourier transform of M
 // complex vectors, each of length m.
@@ -422,7 +1045,11 @@ public:
 // Notes:
 //   stride is the spacing between the elements of each Complex vector.
 //
-class fftpad {
+template<class Real>
+class fftpadT {
+public:
+  FFTWPP_TYPES(Real)
+private:
   unsigned int m;
   unsigned int M;
   unsigned int stride;
@@ -431,33 +1058,58 @@ class fftpad {
   Complex *ZetaH, *ZetaL;
   unsigned int threads;
 public:  
-  mfft1d *Backwards; 
-  mfft1d *Forwards;
+  mfft1dT<Real> *Backwards; 
+  mfft1dT<Real> *Forwards;
   
-  fftpad(unsigned int m, unsigned int M,
-         unsigned int stride, Complex *u=NULL,
-         unsigned int Threads=fftw::maxthreads)
+  fftpadT(unsigned int m, unsigned int M,
+          unsigned int stride, Complex *u=NULL,
+          unsigned int Threads=fftw::maxthreads)
     : m(m), M(M), stride(stride), threads(Threads) {
-    Backwards=new mfft1d(m,1,M,stride,1,u,NULL,threads);
-    Forwards=new mfft1d(m,-1,M,stride,1,u,NULL,threads);
+    Backwards=new mfft1dT<Real>(m,1,M,stride,1,u,NULL,threads);
+    Forwards=new mfft1dT<Real>(m,-1,M,stride,1,u,NULL,threads);
     
     threads=std::max(Backwards->Threads(),Forwards->Threads());
     
-    s=BuildZeta(2*m,m,ZetaH,ZetaL,threads);
+    s=ShareZeta(2*m,m,ZetaH,ZetaL,threads);
   }
   
-  ~fftpad() {
-    utils::deleteAlign(ZetaL);
-    utils::deleteAlign(ZetaH);
+  ~fftpadT() {
+    ReleaseZeta(ZetaH);
     delete Forwards;
     delete Backwards;
   }
   
-  void expand(Complex *f, Complex *u);
-  void reduce(Complex *f, Complex *u);
+  // Allow several threads to execute the plans at once.
+  void share() {
+    Backwards->Share();
+    Forwards->Share();
+  }
   
-  void backwards(Complex *f, Complex *u);
-  void forwards(Complex *f, Complex *u);
+  // Switch in any plans upgraded in the background.
+  void update() {
+    Backwards->Update();
+    Forwards->Update();
+  }
+  
+  void expand(Complex *f, Complex *u) {
+    Selected<Real>()->fftpadexpand(f,u,m,M,stride,s,ZetaH,ZetaL,threads);
+  }
+  
+  void reduce(Complex *f, Complex *u) {
+    Selected<Real>()->fftpadreduce(f,u,m,M,stride,s,ZetaH,ZetaL,threads);
+  }
+  
+  void backwards(Complex *f, Complex *u) {
+    expand(f,u);
+    Backwards->fft(f);
+    Backwards->fft(u);
+  }
+  
+  void forwards(Complex *f, Complex *u) {
+    Forwards->fft(f);
+    Forwards->fft(u);
+    reduce(f,u);
+  }
 };
   
 // Compute the scrambled implicitly m-padded complex Fourier transform of M
@@ -473,7 +1125,10 @@ public:
 // Notes:
 //   stride is the spacing between the elements of each Complex vector.
 //
-class fft0pad {
+template<class Real>
+class fft0padT {
+public:
+  FFTWPP_TYPES(Real)
 protected:  
   unsigned int m;
   unsigned int M;
@@ -482,25 +1137,36 @@ protected:
   Complex *ZetaH, *ZetaL;
   unsigned int threads;
 public:  
-  mfft1d *Forwards;
-  mfft1d *Backwards;
+  mfft1dT<Real> *Forwards;
+  mfft1dT<Real> *Backwards;
   
-  fft0pad(unsigned int m, unsigned int M, unsigned int stride, Complex *u=NULL,
-          unsigned int Threads=fftw::maxthreads)
+  fft0padT(unsigned int m, unsigned int M, unsigned int stride, Complex *u=NULL,
+           unsigned int Threads=fftw::maxthreads)
     : m(m), M(M), stride(stride), threads(Threads) {
-    Backwards=new mfft1d(m,1,M,stride,1,u,NULL,threads);
-    Forwards=new mfft1d(m,-1,M,stride,1,u,NULL,threads);
+    Backwards=new mfft1dT<Real>(m,1,M,stride,1,u,NULL,threads);
+    Forwards=new mfft1dT<Real>(m,-1,M,stride,1,u,NULL,threads);
     
-    s=BuildZeta(3*m,m,ZetaH,ZetaL);
+    s=ShareZeta(3*m,m,ZetaH,ZetaL);
   }
   
-  virtual ~fft0pad() {
-    utils::deleteAlign(ZetaL);
-    utils::deleteAlign(ZetaH);
+  virtual ~fft0padT() {
+    ReleaseZeta(ZetaH);
     delete Forwards;
     delete Backwards;
   }
   
+  // Allow several threads to execute the plans at once.
+  void share() {
+    Backwards->Share();
+    Forwards->Share();
+  }
+  
+  // Switch in any plans upgraded in the background.
+  void update() {
+    Backwards->Update();
+    Forwards->Update();
+  }
+  
   // Unscramble indices, returning spatial index stored at position i
   inline static unsigned findex(unsigned i, unsigned int m) {
     return i < m-1 ? 3*i : 3*i+4-3*m; // for i >= m-1: j=3*(i-(m-1))+1
@@ -510,15 +1176,53 @@ public:
     return i > 0 ? (i < m ? 3*i-1 : 3*m-3) : 3*m-1;
   }
 
-  virtual void expand(Complex *f, Complex *u);
-  virtual void reduce(Complex *f, Complex *u);
+  virtual void expand(Complex *f, Complex *u) {
+    Selected<Real>()->fft0padexpand(f,u,m,M,stride,s,ZetaH,ZetaL,threads);
+  }
   
-  void backwards(Complex *f, Complex *u);
-  virtual void forwards(Complex *f, Complex *u);
+  virtual void reduce(Complex *f, Complex *u) {
+    Selected<Real>()->fft0padreduce(f,u,m,M,stride,s,ZetaH,ZetaL,threads);
+  }
+  
+  void backwards(Complex *f, Complex *u) {
+    expand(f,u);
+    Backwards->fft(f);
+    Backwards1(f,u);
+    Backwards->fft(u);
+  }
+  
+  virtual void forwards(Complex *f, Complex *u) {
+    Forwards0(f);  
+    Forwards1(f,u);  
+    Forwards->fft(f);
+    Forwards->fft(u);
+    reduce(f,u);
+  }
+  
+  virtual void Backwards1(Complex *f, Complex *u) {
+    Complex *umstride=u+m*stride;
+    Complex *fm1stride=f+(m-1)*stride;
+    for(unsigned int i=0; i < M; ++i) {
+      umstride[i]=fm1stride[i]; // Store extra value here.
+      fm1stride[i]=u[i];
+    }
+    Backwards->fft(fm1stride);
+  }
+  
+  virtual void Forwards0(Complex *f) {
+    Forwards->fft(f+(m-1)*stride);
+  }
   
-  virtual void Backwards1(Complex *f, Complex *u);
-  virtual void Forwards0(Complex *f);
-  virtual void Forwards1(Complex *f, Complex *u);
+  virtual void Forwards1(Complex *f, Complex *u) {
+    Complex *umstride=u+m*stride;
+    unsigned int m1stride=(m-1)*stride;
+    Complex *fm1stride=f+m1stride;
+    for(unsigned int i=0; i < M; ++i) {
+      Complex temp=umstride[i];
+      umstride[i]=fm1stride[i];
+      fm1stride[i]=temp;
+    }
+  }
 };
   
 // Compute the scrambled implicitly m-padded complex Fourier transform of M
@@ -534,11 +1238,14 @@ public:
 // Notes:
 //   stride is the spacing between the elements of each Complex vector.
 //
-class fft1pad : public fft0pad {
+template<class Real>
+class fft1padT : public fft0padT<Real> {
 public:  
-  fft1pad(unsigned int m, unsigned int M, unsigned int stride,
-              Complex *u=NULL, unsigned int threads=fftw::maxthreads) :
-    fft0pad(m,M,stride,u,threads) {}
+  FFTWPP_TYPES(Real)
+  
+  fft1padT(unsigned int m, unsigned int M, unsigned int stride,
+           Complex *u=NULL, unsigned int threads=fftw::maxthreads) :
+    fft0padT<Real>(m,M,stride,u,threads) {}
 
   // Unscramble indices, returning spatial index stored at position i
   inline static unsigned findex(unsigned i, unsigned int m) {
@@ -549,115 +1256,333 @@ public:
     return i > 0 ? 3*i-1 : 3*m-1;
   }
   
-  void expand(Complex *f, Complex *u);
-  void reduce(Complex *f, Complex *u);
-  
-  void forwards(Complex *f, Complex *u);
+  void expand(Complex *f, Complex *u) {
+    Selected<Real>()->fft1padexpand(f,u,this->m,this->M,this->stride,this->s,
+                                    this->ZetaH,this->ZetaL,this->threads);
+  }
   
-  void Backwards1(Complex *f, Complex *u);
-  void Forwards0(Complex *f);
-  void Forwards1(Complex *f, Complex *u);
-};
+  void reduce(Complex *f, Complex *u) {
+    Selected<Real>()->fft1padreduce(f,u,this->m,this->M,this->stride,this->s,
+                                    this->ZetaH,this->ZetaL,this->threads);
+  }
   
-// In-place implicitly dealiased 2D complex convolution.
-class ImplicitConvolution2 : public ThreadBase {
-protected:
-  unsigned int mx,my;
-  Complex *u1;
-  Complex *u2;
-  unsigned int A,B;
-  fftpad *xfftpad;
-  ImplicitConvolution **yconvolve;
-  Complex **U2;
-  bool allocated;
-  unsigned int indexsize;
-  bool toplevel;
-public:  
-  unsigned int *index;
-
-  void initpointers2(Complex **&U2, Complex *u2, unsigned int stride) {
-    U2=new Complex *[A];
-    for(unsigned int a=0; a < A; ++a)
-      U2[a]=u2+a*stride;
-    
-    if(toplevel) allocateindex(1,new unsigned int[1]);
+  void forwards(Complex *f, Complex *u) {
+    this->Forwards->fft(f);
+    this->Forwards->fft(f+this->m*this->stride);
+    this->Forwards->fft(u);
+    reduce(f,u);
   }
   
-  void deletepointers2(Complex **&U2) {
-    if(toplevel) {
-      delete [] index;
-      
-      for(unsigned int t=1; t < threads; ++t)
-        delete [] yconvolve[t]->index;
-    }
-
-    delete [] U2;
+  void Backwards1(Complex *f, Complex *u) {
+    this->Backwards->fft(f+this->m*this->stride);
   }
   
-  void allocateindex(unsigned int n, unsigned int *i) {
-    indexsize=n;
-    index=i;
-    yconvolve[0]->allocateindex(n,i);
-    for(unsigned int t=1; t < threads; ++t)
-      yconvolve[t]->allocateindex(n,new unsigned int[n]);
+  void Forwards0(Complex *f) {
+    this->Forwards->fft(f+this->m*this->stride);
   }
   
-  void init(const convolveOptions& options) {
-    toplevel=options.toplevel;
-    xfftpad=new fftpad(mx,options.ny,options.ny,u2,threads);
-    unsigned int C=max(A,B);
-    yconvolve=new ImplicitConvolution*[threads];
-    for(unsigned int t=0; t < threads; ++t)
-      yconvolve[t]=new ImplicitConvolution(my,u1+t*my*C,A,B,innerthreads);
-    initpointers2(U2,u2,options.stride2);
+  void Forwards1(Complex *f, Complex *u) {
   }
+};
   
-  void set(convolveOptions& options) {
-    if(options.nx == 0) options.nx=mx;
-    if(options.ny == 0) {
-      options.ny=my;
-      options.stride2=mx*my;
+// Compute the implicitly padded cosine transform of M real vectors, each
+// containing the m coefficients of a cosine series
+// f(x)=sum_{k=0}^{m-1} f[k]*cos(kx),
+// to the 2m-1 points x=pi*l/(2m-2), l=0,...,2m-2, and back, for m > 1.
+// The even-numbered points are returned in f and the odd-numbered points
+// in u. The arrays f and u must be allocated as double[M*m] and
+// double[M*(m-1)].
+//
+//   dctpad dct(m,M,stride);
+//   dct.backwards(f,u);
+//   dct.forwards(f,u);
+//
+// Notes:
+//   stride is the spacing between the elements of each vector;
+//   forwards returns the first m cosine coefficients of the function
+//   sampled on the padded grid; these are exact for the product of two
+//   m-term cosine series.
+//
+class dctpad {
+  unsigned int m;
+  unsigned int M;
+  unsigned int stride;
+  unsigned int threads;
+public:  
+  mr2r1d *Even;      // DCT-I on the even points
+  mr2r1d *Backwards; // DCT-III to the odd points
+  mr2r1d *Forwards;  // DCT-II from the odd points
+  
+  dctpad(unsigned int m, unsigned int M, unsigned int stride,
+         double *u=NULL, unsigned int Threads=fftw::maxthreads)
+    : m(m), M(M), stride(stride), threads(Threads) {
+    if(m < 2) {
+      std::cerr << "dctpad requires m > 1" << std::endl;
+      exit(1);
     }
+    Even=new mr2r1d(m,FFTW_REDFT00,M,stride,1,NULL,NULL,threads);
+    Backwards=new mr2r1d(m-1,FFTW_REDFT01,M,stride,1,u,NULL,threads);
+    Forwards=new mr2r1d(m-1,FFTW_REDFT10,M,stride,1,u,NULL,threads);
+    
+    threads=std::max(Even->Threads(),
+                     std::max(Backwards->Threads(),Forwards->Threads()));
   }
   
-  // u1 is a temporary array of size my*C*threads.
-  // u2 is a temporary array of size mx*my*C.
+  ~dctpad() {
+    delete Forwards;
+    delete Backwards;
+    delete Even;
+  }
+  
+  void expand(double *f, double *u);
+  void reduce(double *f, double *u);
+  
+  void backwards(double *f, double *u);
+  void forwards(double *f, double *u);
+};
+
+// In-place implicitly dealiased 1D convolution of cosine series, using
+// function pointers for multiplication. Each input contains the m
+// coefficients of a cosine series f(x)=sum_{k=0}^{m-1} f[k]*cos(kx); the
+// first m cosine coefficients of the product are returned in F[0].
+class ImplicitCosineConvolution : public ThreadBase {
+protected:
+  unsigned int m;
+  double **U;
+  unsigned int A;
+  unsigned int B;
+  double *u;
+  dctpad *dct;
+  bool pointers;
+  bool allocated;
+  unsigned int indexsize;
+public:
+  unsigned int *index;
+
+  // Keep each work array aligned to sizeof(Complex).
+  unsigned int ustride() {return m+m % 2;}
+  
+  void initpointers(double **&U, double *u) {
+    unsigned int C=max(A,B);
+    U=new double *[C];
+    unsigned int stride=ustride();
+    for(unsigned int a=0; a < C; ++a)
+      U[a]=u+a*stride;
+    pointers=true;
+  }
+  
+  void deletepointers(double **&U) {
+    delete [] U;
+  }
+  
+  void allocateindex(unsigned int n, unsigned int *i) {
+    indexsize=n;
+    index=i;
+  }
+  
+  void init() {
+    indexsize=0;
+    dct=new dctpad(m,1,1,U[0],threads);
+  }
+  
+  // m is the number of cosine coefficients
+  // U is an array of max(A,B) distinct work arrays of size m-1
+  // A is the number of inputs.
+  // B is the number of outputs.
+  ImplicitCosineConvolution(unsigned int m, double **U, unsigned int A=2,
+                            unsigned int B=1,
+                            unsigned int threads=fftw::maxthreads)
+    : ThreadBase(threads), m(m), U(U), A(A), B(B), pointers(false),
+      allocated(false) {
+    init();
+  }
+
+  // m is the number of cosine coefficients
+  // A is the number of inputs.
+  // B is the number of outputs.
+  ImplicitCosineConvolution(unsigned int m, unsigned int A=2,
+                            unsigned int B=1,
+                            unsigned int threads=fftw::maxthreads)
+    : ThreadBase(threads), m(m), A(A), B(B),
+      u(utils::doubleAlign(max(A,B)*ustride())), allocated(true) {
+    initpointers(U,u);
+    init();
+  }
+
+  virtual ~ImplicitCosineConvolution() {
+    delete dct;
+    if(pointers) deletepointers(U);
+    if(allocated) utils::deleteAlign(u);
+  }
+  
+  // F is an array of A pointers to distinct data blocks each of size m
+  // (contents not preserved).
+  void convolve(double **F, realmultiplier *pmult, unsigned int i=0);
+
+  // Binary convolution:
+  void convolve(double *f, double *g) {
+    double *F[]={f,g};
+    convolve(F,multbinary);
+  }
+};
+  
+// In-place implicitly dealiased 2D complex convolution.
+template<class Real>
+class ImplicitConvolution2T : public ThreadBase {
+public:
+  FFTWPP_CONVOLUTION_TYPES(Real)
+protected:
+  unsigned int mx,my;
+  Complex *u1;
+  Complex *u2;
+  unsigned int A,B;
+  fftpadT<Real> *xfftpad;
+  ImplicitConvolutionT<Real> **yconvolve;
+  Complex **U2;
+  bool allocated;
+  bool shared; // The work arrays are borrowed from the Workspace per call.
+  unsigned int size1,size2; // The sizes of u1 and u2
+  unsigned int stride2;
+  unsigned int indexsize;
+  bool toplevel;
+  bool ownplans; // The plans were not borrowed from another convolution.
+  bool sharedplans; // Other convolutions may execute the plans concurrently.
+public:  
+  unsigned int *index;
+
+  void initpointers2(Complex **&U2, Complex *u2, unsigned int stride) {
+    U2=new Complex *[A];
+    for(unsigned int a=0; a < A; ++a)
+      U2[a]=u2+a*stride;
+    
+    if(toplevel) allocateindex(1,new unsigned int[1]);
+  }
+  
+  void deletepointers2(Complex **&U2) {
+    if(toplevel) {
+      delete [] index;
+      
+      for(unsigned int t=1; t < threads; ++t)
+        delete [] yconvolve[t]->index;
+    }
+
+    delete [] U2;
+  }
+  
+  // Use the work arrays u1 and u2 instead of the current ones.
+  void rebind(Complex *u1, Complex *u2) {
+    unsigned int C=max(A,B);
+    for(unsigned int a=0; a < A; ++a)
+      U2[a]=u2+a*stride2;
+    for(unsigned int t=0; t < threads; ++t)
+      yconvolve[t]->rebind(u1+t*my*C);
+    this->u1=u1;
+    this->u2=u2;
+  }
+
+  void borrow() {
+    Complex *u=Workspace::borrow<Complex>(size1+size2);
+    rebind(u,u+size1);
+  }
+
+  void allocateindex(unsigned int n, unsigned int *i) {
+    indexsize=n;
+    index=i;
+    yconvolve[0]->allocateindex(n,i);
+    for(unsigned int t=1; t < threads; ++t)
+      yconvolve[t]->allocateindex(n,new unsigned int[n]);
+  }
+  
+  void init(const convolveOptions& options) {
+    toplevel=options.toplevel;
+    stride2=options.stride2;
+    ownplans=true;
+    sharedplans=false;
+    xfftpad=new fftpadT<Real>(mx,options.ny,options.ny,u2,threads);
+    unsigned int C=max(A,B);
+    yconvolve=new ImplicitConvolutionT<Real>*[threads];
+    yconvolve[0]=new ImplicitConvolutionT<Real>(my,u1,A,B,innerthreads);
+    for(unsigned int t=1; t < threads; ++t)
+      yconvolve[t]=new ImplicitConvolutionT<Real>(*yconvolve[0],u1+t*my*C);
+    initpointers2(U2,u2,options.stride2);
+  }
+  
+  void set(convolveOptions& options) {
+    if(options.nx == 0) options.nx=mx;
+    if(options.ny == 0) {
+      options.ny=my;
+      options.stride2=mx*my;
+    }
+  }
+  
+  // u1 is a temporary array of size my*C*threads.
+  // u2 is a temporary array of size mx*my*C.
   // A is the number of inputs.
   // B is the number of outputs.
   // Here C=max(A,B).
-  ImplicitConvolution2(unsigned int mx, unsigned int my,
-                       Complex *u1, Complex *u2,
-                       unsigned int A=2, unsigned int B=1,
-                       unsigned int threads=fftw::maxthreads,
-                       convolveOptions options=defaultconvolveOptions) :
+  ImplicitConvolution2T(unsigned int mx, unsigned int my,
+                        Complex *u1, Complex *u2,
+                        unsigned int A=2, unsigned int B=1,
+                        unsigned int threads=fftw::maxthreads,
+                        convolveOptions options=defaultconvolveOptions) :
     ThreadBase(threads), mx(mx), my(my), u1(u1), u2(u2), A(A), B(B),
-    allocated(false) {
+    allocated(false), shared(false) {
     set(options);
     multithread(options.nx);
     init(options);
   }
   
-  ImplicitConvolution2(unsigned int mx, unsigned int my,
-                       unsigned int A=2, unsigned int B=1,
-                       unsigned int threads=fftw::maxthreads,
-                       convolveOptions options=defaultconvolveOptions) :
-    ThreadBase(threads), mx(mx), my(my), A(A), B(B), allocated(true) {
+  ImplicitConvolution2T(unsigned int mx, unsigned int my,
+                        unsigned int A=2, unsigned int B=1,
+                        unsigned int threads=fftw::maxthreads,
+                        convolveOptions options=defaultconvolveOptions) :
+    ThreadBase(threads), mx(mx), my(my), A(A), B(B),
+    allocated(!options.borrow), shared(options.borrow) {
     set(options);
     multithread(options.nx);
     unsigned int C=max(A,B);
-    u1=utils::ComplexAlign(my*C*threads);
-    u2=utils::ComplexAlign(options.stride2*C);
+    size1=my*C*threads;
+    size2=options.stride2*C;
+    if(shared) {
+      u1=Workspace::borrow<Complex>(size1+size2);
+      u2=u1+size1;
+    } else {
+      u1=utils::ComplexAlign<Complex>(size1);
+      u2=utils::ComplexAlign<Complex>(size2);
+    }
     init(options);
+    if(shared) Workspace::putback(u1);
+  }
+  
+  // Execute the plans of convolution, which must outlive this object, with
+  // the work arrays u1 and u2. Convolutions sharing plans may run
+  // concurrently; plans upgraded in the background are then switched in
+  // only by update().
+  ImplicitConvolution2T(ImplicitConvolution2T& convolution,
+                        Complex *u1, Complex *u2) :
+    ThreadBase(convolution.threads), mx(convolution.mx), my(convolution.my),
+    u1(u1), u2(u2), A(convolution.A), B(convolution.B),
+    xfftpad(convolution.xfftpad), allocated(false), shared(false),
+    stride2(convolution.stride2), toplevel(convolution.toplevel),
+    ownplans(false), sharedplans(true) {
+    innerthreads=convolution.innerthreads;
+    unsigned int C=max(A,B);
+    yconvolve=new ImplicitConvolutionT<Real>*[threads];
+    for(unsigned int t=0; t < threads; ++t)
+      yconvolve[t]=new ImplicitConvolutionT<Real>(*convolution.yconvolve[0],
+                                                  u1+t*my*C);
+    initpointers2(U2,u2,stride2);
+    convolution.share();
   }
   
-  virtual ~ImplicitConvolution2() {
+  virtual ~ImplicitConvolution2T() {
     deletepointers2(U2);
     
     for(unsigned int t=0; t < threads; ++t)
       delete yconvolve[t];
     delete [] yconvolve;
     
-    delete xfftpad;
+    if(ownplans) delete xfftpad;
     
     if(allocated) {
       utils::deleteAlign(u2);
@@ -665,24 +1590,39 @@ public:
     }
   }
   
+  // Allow several threads to execute the plans at once.
+  void share() {
+    sharedplans=true;
+    xfftpad->share();
+    yconvolve[0]->share();
+  }
+  
+  // Switch in any plans upgraded in the background.
+  void update() {
+    xfftpad->update();
+    yconvolve[0]->update();
+  }
+  
   void backwards(Complex **F, Complex **U2, unsigned int offset) {
     for(unsigned int a=0; a < A; ++a)
       xfftpad->backwards(F[a]+offset,U2[a]);
   }
 
-  void subconvolution(Complex **F, multiplier *pmult, 
+  template<class Mult>
+  void subconvolution(Complex **F, Mult mult, 
                       unsigned int r, unsigned int M, unsigned int stride,
                       unsigned int offset=0) {
     if(threads > 1) {
+      if(!sharedplans) yconvolve[0]->update();
 #ifndef FFTWPP_SINGLE_THREAD
 #pragma omp parallel for num_threads(threads)
 #endif    
       for(unsigned int i=0; i < M; ++i)
-        yconvolve[get_thread_num()]->convolve(F,pmult,2*i+r,offset+i*stride);
+        yconvolve[get_thread_num()]->convolve(F,mult,2*i+r,offset+i*stride);
     } else {
-      ImplicitConvolution *yconvolve0=yconvolve[0];
+      ImplicitConvolutionT<Real> *yconvolve0=yconvolve[0];
       for(unsigned int i=0; i < M; ++i)
-        yconvolve0->convolve(F,pmult,2*i+r,offset+i*stride);
+        yconvolve0->convolve(F,mult,2*i+r,offset+i*stride);
     }
   }
   
@@ -695,6 +1635,13 @@ public:
   // shifted by offset (contents not preserved).
   virtual void convolve(Complex **F, multiplier *pmult, unsigned int i=0,
                         unsigned int offset=0) {
+    convolve<multiplier *>(F,pmult,i,offset);
+  }
+
+  // As above, with a multiplier object mult (see pointwise).
+  template<class Mult>
+  void convolve(Complex **F, Mult mult, unsigned int i=0,
+                unsigned int offset=0) {
     if(!toplevel) {
       index[indexsize-2]=i;
       if(threads > 1) {
@@ -705,10 +1652,12 @@ public:
         }
       }
     }
+    if(shared) borrow();
     backwards(F,U2,offset);
-    subconvolution(F,pmult,0,mx,my,offset);
-    subconvolution(U2,pmult,1,mx,my);
+    subconvolution(F,mult,0,mx,my,offset);
+    subconvolution(U2,mult,1,mx,my);
     forwards(F,U2,offset);
+    if(shared) Workspace::putback(u1);
   }
   
   // Binary convolution:
@@ -734,21 +1683,23 @@ public:
   }
 };
 
+template<class C>
 inline void HermitianSymmetrizeX(unsigned int mx, unsigned int my,
-                                 unsigned int xorigin, Complex *f)
+                                 unsigned int xorigin, C *f)
 {
   unsigned int offset=xorigin*my;
   unsigned int stop=mx*my;
-  f[offset].im=0.0;
+  f[offset]=f[offset].real();
   for(unsigned int i=my; i < stop; i += my)
     f[offset-i]=conj(f[offset+i]);
 }
 
 // Enforce 3D Hermiticity using specified (x,y > 0,z=0) and (x >= 0,y=0,z=0)
 // data.
+template<class C>
 inline void HermitianSymmetrizeXY(unsigned int mx, unsigned int my,
                                   unsigned int mz, unsigned int xorigin,
-                                  unsigned int yorigin, Complex *f,
+                                  unsigned int yorigin, C *f,
                                   unsigned int threads=fftw::maxthreads)
 {
   int stride=(yorigin+my)*mz;
@@ -756,7 +1707,7 @@ inline void HermitianSymmetrizeXY(unsigned int mx, unsigned int my,
   unsigned int myz=my*mz;
   unsigned int origin=xorigin*stride+yorigin*mz;
   
-  f[origin].im=0.0;
+  f[origin]=f[origin].real();
 
   for(int i=stride; i < mxstride; i += stride)
     f[origin-i]=conj(f[origin+i]);
@@ -773,19 +1724,27 @@ inline void HermitianSymmetrizeXY(unsigned int mx, unsigned int my,
 
 typedef unsigned int IndexFunction(unsigned int, unsigned int m);
 
-class ImplicitHConvolution2 : public ThreadBase {
+template<class Real>
+class ImplicitHConvolution2T : public ThreadBase {
+public:
+  FFTWPP_CONVOLUTION_TYPES(Real)
 protected:
   unsigned int mx,my;
   bool xcompact,ycompact;
   Complex *u1;
   Complex *u2;
   unsigned int A,B;
-  fft0pad *xfftpad;
-  ImplicitHConvolution **yconvolve;
+  fft0padT<Real> *xfftpad;
+  ImplicitHConvolutionT<Real> **yconvolve;
   Complex **U2;
   bool allocated;
+  bool shared; // The work arrays are borrowed from the Workspace per call.
+  unsigned int size1,size2; // The sizes of u1 and u2
+  unsigned int stride2;
   unsigned int indexsize;
   bool toplevel;
+  bool ownplans; // The plans were not borrowed from another convolution.
+  bool sharedplans; // Other convolutions may execute the plans concurrently.
 public:
   unsigned int *index;
 
@@ -810,6 +1769,22 @@ public:
     delete [] U2;
   }
   
+  // Use the work arrays u1 and u2 instead of the current ones.
+  void rebind(Complex *u1, Complex *u2) {
+    unsigned int C=max(A,B);
+    for(unsigned int a=0; a < C; ++a)
+      U2[a]=u2+a*stride2;
+    for(unsigned int t=0; t < threads; ++t)
+      yconvolve[t]->rebind(u1+t*(my/2+1)*C);
+    this->u1=u1;
+    this->u2=u2;
+  }
+
+  void borrow() {
+    Complex *u=Workspace::borrow<Complex>(size1+size2);
+    rebind(u,u+size1);
+  }
+
   void allocateindex(unsigned int n, unsigned int *i) {
     indexsize=n;
     index=i;
@@ -821,13 +1796,18 @@ public:
   void init(const convolveOptions& options) {
     unsigned int C=max(A,B);
     toplevel=options.toplevel;
-    xfftpad=xcompact ? new fft0pad(mx,options.ny,options.ny,u2) :
-      new fft1pad(mx,options.ny,options.ny,u2);
-    
-    yconvolve=new ImplicitHConvolution*[threads];
-    for(unsigned int t=0; t < threads; ++t)
-      yconvolve[t]=new ImplicitHConvolution(my,ycompact,u1+t*(my/2+1)*C,A,B,
-                                            innerthreads);
+    stride2=options.stride2;
+    ownplans=true;
+    sharedplans=false;
+    xfftpad=xcompact ? new fft0padT<Real>(mx,options.ny,options.ny,u2) :
+      new fft1padT<Real>(mx,options.ny,options.ny,u2);
+    
+    yconvolve=new ImplicitHConvolutionT<Real>*[threads];
+    yconvolve[0]=new ImplicitHConvolutionT<Real>(my,ycompact,u1,A,B,
+                                                 innerthreads);
+    for(unsigned int t=1; t < threads; ++t)
+      yconvolve[t]=new ImplicitHConvolutionT<Real>(*yconvolve[0],
+                                                   u1+t*(my/2+1)*C);
     initpointers2(U2,u2,options.stride2);
   }
 
@@ -844,55 +1824,87 @@ public:
   // A is the number of inputs.
   // B is the number of outputs.
   // Here C=max(A,B).
-  ImplicitHConvolution2(unsigned int mx, unsigned int my,
-                        Complex *u1, Complex *u2,
-                        unsigned int A=2, unsigned int B=1,
-                        unsigned int threads=fftw::maxthreads,
-                        convolveOptions options=defaultconvolveOptions) :
+  ImplicitHConvolution2T(unsigned int mx, unsigned int my,
+                         Complex *u1, Complex *u2,
+                         unsigned int A=2, unsigned int B=1,
+                         unsigned int threads=fftw::maxthreads,
+                         convolveOptions options=defaultconvolveOptions) :
     ThreadBase(threads), mx(mx), my(my), xcompact(true), ycompact(true),
-    u1(u1), u2(u2), A(A), B(B), allocated(false) {
+    u1(u1), u2(u2), A(A), B(B), allocated(false), shared(false) {
     set(options);
     multithread(options.nx);
     init(options);
   }
   
-  ImplicitHConvolution2(unsigned int mx, unsigned int my,
-                        bool xcompact, bool ycompact,
-                        Complex *u1, Complex *u2,
-                        unsigned int A=2, unsigned int B=1,
-                        unsigned int threads=fftw::maxthreads,
-                        convolveOptions options=defaultconvolveOptions) :
+  ImplicitHConvolution2T(unsigned int mx, unsigned int my,
+                         bool xcompact, bool ycompact,
+                         Complex *u1, Complex *u2,
+                         unsigned int A=2, unsigned int B=1,
+                         unsigned int threads=fftw::maxthreads,
+                         convolveOptions options=defaultconvolveOptions) :
     ThreadBase(threads), mx(mx), my(my), 
     xcompact(xcompact), ycompact(ycompact), u1(u1), u2(u2), A(A), B(B),
-    allocated(false) {
+    allocated(false), shared(false) {
     set(options);
     multithread(options.nx);
     init(options);
   }
   
-  ImplicitHConvolution2(unsigned int mx, unsigned int my,
-                        bool xcompact=true, bool ycompact=true,
-                        unsigned int A=2, unsigned int B=1,
-                        unsigned int threads=fftw::maxthreads,
-                        convolveOptions options=defaultconvolveOptions) :
+  ImplicitHConvolution2T(unsigned int mx, unsigned int my,
+                         bool xcompact=true, bool ycompact=true,
+                         unsigned int A=2, unsigned int B=1,
+                         unsigned int threads=fftw::maxthreads,
+                         convolveOptions options=defaultconvolveOptions) :
     ThreadBase(threads), mx(mx), my(my),
-    xcompact(xcompact), ycompact(ycompact), A(A), B(B), allocated(true) {
+    xcompact(xcompact), ycompact(ycompact), A(A), B(B),
+    allocated(!options.borrow), shared(options.borrow) {
     set(options);
     multithread(options.nx);
     unsigned int C=max(A,B);
-    u1=utils::ComplexAlign((my/2+1)*C*threads);
-    u2=utils::ComplexAlign(options.stride2*C);
+    size1=(my/2+1)*C*threads;
+    size2=options.stride2*C;
+    if(shared) {
+      u1=Workspace::borrow<Complex>(size1+size2);
+      u2=u1+size1;
+    } else {
+      u1=utils::ComplexAlign<Complex>(size1);
+      u2=utils::ComplexAlign<Complex>(size2);
+    }
     init(options);
+    if(shared) Workspace::putback(u1);
+  }
+  
+  // Execute the plans of convolution, which must outlive this object, with
+  // the work arrays u1 and u2. Convolutions sharing plans may run
+  // concurrently; plans upgraded in the background are then switched in
+  // only by update().
+  ImplicitHConvolution2T(ImplicitHConvolution2T& convolution,
+                         Complex *u1, Complex *u2) :
+    ThreadBase(convolution.threads), mx(convolution.mx), my(convolution.my),
+    xcompact(convolution.xcompact), ycompact(convolution.ycompact),
+    u1(u1), u2(u2), A(convolution.A), B(convolution.B),
+    xfftpad(convolution.xfftpad), allocated(false), shared(false),
+    stride2(convolution.stride2), toplevel(convolution.toplevel),
+    ownplans(false), sharedplans(true) {
+    innerthreads=convolution.innerthreads;
+    unsigned int C=max(A,B);
+    yconvolve=new ImplicitHConvolutionT<Real>*[threads];
+    for(unsigned int t=0; t < threads; ++t)
+      yconvolve[t]=
+        new ImplicitHConvolutionT<Real>(*convolution.yconvolve[0],
+                                        u1+t*(my/2+1)*C);
+    initpointers2(U2,u2,stride2);
+    convolution.share();
   }
   
-  virtual ~ImplicitHConvolution2() {
+  virtual ~ImplicitHConvolution2T() {
     deletepointers2(U2);
     
     for(unsigned int t=0; t < threads; ++t)
       delete yconvolve[t];
     delete [] yconvolve;
     
-    delete xfftpad;
+    if(ownplans) delete xfftpad;
     
     if(allocated) {
       utils::deleteAlign(u2);
@@ -900,6 +1912,19 @@ public:
     }
   }
 
+  // Allow several threads to execute the plans at once.
+  void share() {
+    sharedplans=true;
+    xfftpad->share();
+    yconvolve[0]->share();
+  }
+  
+  // Switch in any plans upgraded in the background.
+  void update() {
+    xfftpad->update();
+    yconvolve[0]->update();
+  }
+  
   void backwards(Complex **F, Complex **U2, unsigned int ny,
                  bool symmetrize, unsigned int offset) {
     for(unsigned int a=0; a < A; ++a) {
@@ -910,21 +1935,23 @@ public:
     }
   }
 
-  void subconvolution(Complex **F, realmultiplier *pmult,
+  template<class Mult>
+  void subconvolution(Complex **F, Mult mult,
                       IndexFunction indexfunction,
                       unsigned int M, unsigned int stride,
                       unsigned int offset=0) {
     if(threads > 1) {
+      if(!sharedplans) yconvolve[0]->update();
 #ifndef FFTWPP_SINGLE_THREAD
 #pragma omp parallel for num_threads(threads)
 #endif    
       for(unsigned int i=0; i < M; ++i)
-        yconvolve[get_thread_num()]->convolve(F,pmult,indexfunction(i,mx),
+        yconvolve[get_thread_num()]->convolve(F,mult,indexfunction(i,mx),
                                               offset+i*stride);
     } else {
-      ImplicitHConvolution *yconvolve0=yconvolve[0];
+      ImplicitHConvolutionT<Real> *yconvolve0=yconvolve[0];
       for(unsigned int i=0; i < M; ++i)
-        yconvolve0->convolve(F,pmult,indexfunction(i,mx),offset+i*stride);
+        yconvolve0->convolve(F,mult,indexfunction(i,mx),offset+i*stride);
     }
   }  
   
@@ -938,6 +1965,13 @@ public:
   virtual void convolve(Complex **F, realmultiplier *pmult,
                         bool symmetrize=true, unsigned int i=0,
                         unsigned int offset=0) {
+    convolve<realmultiplier *>(F,pmult,symmetrize,i,offset);
+  }
+
+  // As above, with a multiplier object mult (see pointwise).
+  template<class Mult>
+  void convolve(Complex **F, Mult mult, bool symmetrize=true,
+                unsigned int i=0, unsigned int offset=0) {
     if(!toplevel) {
       index[indexsize-2]=i;
       if(threads > 1) {
@@ -948,11 +1982,13 @@ public:
         }
       }
     }
+    if(shared) borrow();
     unsigned stride=my+!ycompact;
     backwards(F,U2,stride,symmetrize,offset);
-    subconvolution(F,pmult,xfftpad->findex,2*mx-xcompact,stride,offset);
-    subconvolution(U2,pmult,xfftpad->uindex,mx+xcompact,stride);
+    subconvolution(F,mult,xfftpad->findex,2*mx-xcompact,stride,offset);
+    subconvolution(U2,mult,xfftpad->uindex,mx+xcompact,stride);
     forwards(F,U2,offset);
+    if(shared) Workspace::putback(u1);
   }
   
   // Binary convolution:
@@ -963,17 +1999,23 @@ public:
 };
   
 // In-place implicitly dealiased 3D complex convolution.
-class ImplicitConvolution3 : public ThreadBase {
+template<class Real>
+class ImplicitConvolution3T : public ThreadBase {
+public:
+  FFTWPP_CONVOLUTION_TYPES(Real)
 protected:
   unsigned int mx,my,mz;
   Complex *u1;
   Complex *u2;
   Complex *u3;
   unsigned int A,B;
-  fftpad *xfftpad;
-  ImplicitConvolution2 **yzconvolve;
+  fftpadT<Real> *xfftpad;
+  ImplicitConvolution2T<Real> **yzconvolve;
   Complex **U3;
   bool allocated;
+  bool shared; // The work arrays are borrowed from the Workspace per call.
+  unsigned int size1,size2,size3; // The sizes of u1, u2, and u3
+  unsigned int stride2,stride3;
   unsigned int indexsize;
   bool toplevel;
 public:  
@@ -999,6 +2041,25 @@ public:
     delete [] U3;
   }
   
+  // Use the work arrays u1, u2, and u3 instead of the current ones.
+  void rebind(Complex *u1, Complex *u2, Complex *u3) {
+    if(yzconvolve) {
+      unsigned int C=max(A,B);
+      for(unsigned int a=0; a < C; ++a)
+        U3[a]=u3+a*stride3;
+      for(unsigned int t=0; t < threads; ++t)
+        yzconvolve[t]->rebind(u1+t*mz*C*innerthreads,u2+t*stride2*C);
+    }
+    this->u1=u1;
+    this->u2=u2;
+    this->u3=u3;
+  }
+
+  void borrow() {
+    Complex *u=Workspace::borrow<Complex>(size1+size2+size3);
+    rebind(u,u+size1,u+size1+size2);
+  }
+
   void allocateindex(unsigned int n, unsigned int *i) {
     indexsize=n;
     index=i;
@@ -1009,16 +2070,20 @@ public:
   
   void init(const convolveOptions& options) {
     toplevel=options.toplevel;
+    stride2=options.stride2;
+    stride3=options.stride3;
     unsigned int nyz=options.ny*options.nz;
-    xfftpad=new fftpad(mx,nyz,nyz,u3,threads);
+    xfftpad=new fftpadT<Real>(mx,nyz,nyz,u3,threads);
     
     if(options.nz == mz) {
       unsigned int C=max(A,B);
-      yzconvolve=new ImplicitConvolution2*[threads];
-      for(unsigned int t=0; t < threads; ++t)
-        yzconvolve[t]=new ImplicitConvolution2(my,mz,u1+t*mz*C*innerthreads,
-                                               u2+t*options.stride2*C,A,B,
-                                               innerthreads,false);
+      yzconvolve=new ImplicitConvolution2T<Real>*[threads];
+      yzconvolve[0]=new ImplicitConvolution2T<Real>(my,mz,u1,u2,A,B,
+                                                    innerthreads,false);
+      for(unsigned int t=1; t < threads; ++t)
+        yzconvolve[t]=new ImplicitConvolution2T<Real>(*yzconvolve[0],
+                                                      u1+t*mz*C*innerthreads,
+                                                      u2+t*options.stride2*C);
       initpointers3(U3,u3,options.stride3);
     } else yzconvolve=NULL;
   }
@@ -1039,34 +2104,44 @@ public:
   // A is the number of inputs.
   // B is the number of outputs.
   // Here C=max(A,B).
-  ImplicitConvolution3(unsigned int mx, unsigned int my, unsigned int mz,
-                       Complex *u1, Complex *u2, Complex *u3,
-                       unsigned int A=2, unsigned int B=1, 
-                       unsigned int threads=fftw::maxthreads,
-                       convolveOptions options=defaultconvolveOptions) :
+  ImplicitConvolution3T(unsigned int mx, unsigned int my, unsigned int mz,
+                        Complex *u1, Complex *u2, Complex *u3,
+                        unsigned int A=2, unsigned int B=1, 
+                        unsigned int threads=fftw::maxthreads,
+                        convolveOptions options=defaultconvolveOptions) :
     ThreadBase(threads), mx(mx), my(my), mz(mz),
-    u1(u1), u2(u2), u3(u3), A(A), B(B), allocated(false) {
+    u1(u1), u2(u2), u3(u3), A(A), B(B), allocated(false), shared(false) {
     set(options);
     multithread(mx);
     init(options);
   }
 
-  ImplicitConvolution3(unsigned int mx, unsigned int my, unsigned int mz,
-                       unsigned int A=2, unsigned int B=1, 
-                       unsigned int threads=fftw::maxthreads,
-                       convolveOptions options=defaultconvolveOptions) :
+  ImplicitConvolution3T(unsigned int mx, unsigned int my, unsigned int mz,
+                        unsigned int A=2, unsigned int B=1, 
+                        unsigned int threads=fftw::maxthreads,
+                        convolveOptions options=defaultconvolveOptions) :
     ThreadBase(threads), mx(mx), my(my), mz(mz), A(A), B(B),
-    allocated(true) {
+    allocated(!options.borrow), shared(options.borrow) {
     set(options);
     multithread(mx);
     unsigned int C=max(A,B);
-    u1=utils::ComplexAlign(mz*C*threads*innerthreads);
-    u2=utils::ComplexAlign(options.stride2*C*threads);
-    u3=utils::ComplexAlign(options.stride3*C);
+    size1=mz*C*threads*innerthreads;
+    size2=options.stride2*C*threads;
+    size3=options.stride3*C;
+    if(shared) {
+      u1=Workspace::borrow<Complex>(size1+size2+size3);
+      u2=u1+size1;
+      u3=u2+size2;
+    } else {
+      u1=utils::ComplexAlign<Complex>(size1);
+      u2=utils::ComplexAlign<Complex>(size2);
+      u3=utils::ComplexAlign<Complex>(size3);
+    }
     init(options);
+    if(shared) Workspace::putback(u1);
   }
   
-  virtual ~ImplicitConvolution3() {
+  virtual ~ImplicitConvolution3T() {
     if(yzconvolve) {
       deletepointers3(U3);
 
@@ -1089,19 +2164,21 @@ public:
       xfftpad->backwards(F[a]+offset,U3[a]);
   }
 
-  void subconvolution(Complex **F, multiplier *pmult, 
+  template<class Mult>
+  void subconvolution(Complex **F, Mult mult, 
                       unsigned int r, unsigned int M, unsigned int stride,
                       unsigned int offset=0) {
     if(threads > 1) {
+      yzconvolve[0]->update();
 #ifndef FFTWPP_SINGLE_THREAD
 #pragma omp parallel for num_threads(threads)
 #endif    
       for(unsigned int i=0; i < M; ++i)
-        yzconvolve[get_thread_num()]->convolve(F,pmult,2*i+r,offset+i*stride);
+        yzconvolve[get_thread_num()]->convolve(F,mult,2*i+r,offset+i*stride);
     } else {
-      ImplicitConvolution2 *yzconvolve0=yzconvolve[0];
+      ImplicitConvolution2T<Real> *yzconvolve0=yzconvolve[0];
       for(unsigned int i=0; i < M; ++i) {
-        yzconvolve0->convolve(F,pmult,2*i+r,offset+i*stride);
+        yzconvolve0->convolve(F,mult,2*i+r,offset+i*stride);
       }
     }
   }
@@ -1114,8 +2191,14 @@ public:
   // F is a pointer to A distinct data blocks each of size mx*my*mz,
   // shifted by offset
   virtual void convolve(Complex **F, multiplier *pmult, unsigned int i=0,
-                        unsigned int offset=0)
-  {
+                        unsigned int offset=0) {
+    convolve<multiplier *>(F,pmult,i,offset);
+  }
+
+  // As above, with a multiplier object mult (see pointwise).
+  template<class Mult>
+  void convolve(Complex **F, Mult mult, unsigned int i=0,
+                unsigned int offset=0) {
     if(!toplevel) {
       index[indexsize-3]=i;
       if(threads > 1) {
@@ -1126,11 +2209,13 @@ public:
         }
       }
     }
+    if(shared) borrow();
     unsigned int stride=my*mz;
     backwards(F,U3,offset);
-    subconvolution(F,pmult,0,mx,stride,offset);
-    subconvolution(U3,pmult,1,mx,stride);
+    subconvolution(F,mult,0,mx,stride,offset);
+    subconvolution(U3,mult,1,mx,stride);
     forwards(F,U3,offset);
+    if(shared) Workspace::putback(u1);
   }
   
   // Binary convolution:
@@ -1157,7 +2242,10 @@ public:
 };
 
 // In-place implicitly dealiased 3D Hermitian convolution.
-class ImplicitHConvolution3 : public ThreadBase {
+template<class Real>
+class ImplicitHConvolution3T : public ThreadBase {
+public:
+  FFTWPP_CONVOLUTION_TYPES(Real)
 protected:
   unsigned int mx,my,mz;
   bool xcompact,ycompact,zcompact;
@@ -1165,10 +2253,13 @@ protected:
   Complex *u2;
   Complex *u3;
   unsigned int A,B;
-  fft0pad *xfftpad;
-  ImplicitHConvolution2 **yzconvolve;
+  fft0padT<Real> *xfftpad;
+  ImplicitHConvolution2T<Real> **yzconvolve;
   Complex **U3;
   bool allocated;
+  bool shared; // The work arrays are borrowed from the Workspace per call.
+  unsigned int size1,size2,size3; // The sizes of u1, u2, and u3
+  unsigned int stride2,stride3;
   unsigned int indexsize;
   bool toplevel;
 public:     
@@ -1194,6 +2285,25 @@ public:
     delete [] U3;
   }
     
+  // Use the work arrays u1, u2, and u3 instead of the current ones.
+  void rebind(Complex *u1, Complex *u2, Complex *u3) {
+    if(yzconvolve) {
+      unsigned int C=max(A,B);
+      for(unsigned int a=0; a < C; ++a)
+        U3[a]=u3+a*stride3;
+      for(unsigned int t=0; t < threads; ++t)
+        yzconvolve[t]->rebind(u1+t*(mz/2+1)*C*innerthreads,u2+t*stride2*C);
+    }
+    this->u1=u1;
+    this->u2=u2;
+    this->u3=u3;
+  }
+
+  void borrow() {
+    Complex *u=Workspace::borrow<Complex>(size1+size2+size3);
+    rebind(u,u+size1,u+size1+size2);
+  }
+
   void allocateindex(unsigned int n, unsigned int *i) {
     indexsize=n;
     index=i;
@@ -1204,19 +2314,23 @@ public:
   
   void init(const convolveOptions& options) {
     toplevel=options.toplevel;
+    stride2=options.stride2;
+    stride3=options.stride3;
     unsigned int nyz=options.ny*options.nz;
-    xfftpad=xcompact ? new fft0pad(mx,nyz,nyz,u3) :
-      new fft1pad(mx,nyz,nyz,u3);
+    xfftpad=xcompact ? new fft0padT<Real>(mx,nyz,nyz,u3) :
+      new fft1padT<Real>(mx,nyz,nyz,u3);
 
       if(options.nz == mz+!zcompact) {
       unsigned int C=max(A,B);
-      yzconvolve=new ImplicitHConvolution2*[threads];
-      for(unsigned int t=0; t < threads; ++t)
-        yzconvolve[t]=new ImplicitHConvolution2(my,mz,
-                                                ycompact,zcompact,
-                                                u1+t*(mz/2+1)*C*innerthreads,
-                                                u2+t*options.stride2*C,
-                                                A,B,innerthreads,false);
+      yzconvolve=new ImplicitHConvolution2T<Real>*[threads];
+      yzconvolve[0]=new ImplicitHConvolution2T<Real>(my,mz,ycompact,zcompact,
+                                                     u1,u2,A,B,innerthreads,
+                                                     false);
+      for(unsigned int t=1; t < threads; ++t)
+        yzconvolve[t]=
+          new ImplicitHConvolution2T<Real>(*yzconvolve[0],
+                                           u1+t*(mz/2+1)*C*innerthreads,
+                                           u2+t*options.stride2*C);
       initpointers3(U3,u3,options.stride3);
     } else yzconvolve=NULL;
   }
@@ -1237,53 +2351,63 @@ public:
   // A is the number of inputs.
   // B is the number of outputs.
   // Here C=max(A,B).
-  ImplicitHConvolution3(unsigned int mx, unsigned int my, unsigned int mz,
-                        Complex *u1, Complex *u2, Complex *u3,
-                        unsigned int A=2, unsigned int B=1,
-                        unsigned int threads=fftw::maxthreads,
-                        convolveOptions options=defaultconvolveOptions) :
+  ImplicitHConvolution3T(unsigned int mx, unsigned int my, unsigned int mz,
+                         Complex *u1, Complex *u2, Complex *u3,
+                         unsigned int A=2, unsigned int B=1,
+                         unsigned int threads=fftw::maxthreads,
+                         convolveOptions options=defaultconvolveOptions) :
     ThreadBase(threads), mx(mx), my(my), mz(mz),
     xcompact(true), ycompact(true), zcompact(true), u1(u1), u2(u2), u3(u3),
     A(A), B(B),
-    allocated(false) {
+    allocated(false), shared(false) {
     set(options);
     multithread(mx);
     init(options);
   }
   
-  ImplicitHConvolution3(unsigned int mx, unsigned int my, unsigned int mz,
-                        bool xcompact, bool ycompact, bool zcompact,
-                        Complex *u1, Complex *u2, Complex *u3,
-                        unsigned int A=2, unsigned int B=1,
-                        unsigned int threads=fftw::maxthreads,
-                        convolveOptions options=defaultconvolveOptions) :
+  ImplicitHConvolution3T(unsigned int mx, unsigned int my, unsigned int mz,
+                         bool xcompact, bool ycompact, bool zcompact,
+                         Complex *u1, Complex *u2, Complex *u3,
+                         unsigned int A=2, unsigned int B=1,
+                         unsigned int threads=fftw::maxthreads,
+                         convolveOptions options=defaultconvolveOptions) :
     ThreadBase(threads), mx(mx), my(my), mz(mz),
     xcompact(xcompact), ycompact(ycompact), zcompact(zcompact), 
-    u1(u1), u2(u2), u3(u3), A(A), B(B), allocated(false) {
+    u1(u1), u2(u2), u3(u3), A(A), B(B), allocated(false), shared(false) {
     set(options);
     multithread(mx);
     init(options);
   }
   
-  ImplicitHConvolution3(unsigned int mx, unsigned int my, unsigned int mz,
-                        bool xcompact=true, bool ycompact=true,
-                        bool zcompact=true,
-                        unsigned int A=2, unsigned int B=1,
-                        unsigned int threads=fftw::maxthreads,
-                        convolveOptions options=defaultconvolveOptions) :
+  ImplicitHConvolution3T(unsigned int mx, unsigned int my, unsigned int mz,
+                         bool xcompact=true, bool ycompact=true,
+                         bool zcompact=true,
+                         unsigned int A=2, unsigned int B=1,
+                         unsigned int threads=fftw::maxthreads,
+                         convolveOptions options=defaultconvolveOptions) :
     ThreadBase(threads), mx(mx), my(my), mz(mz),
     xcompact(xcompact), ycompact(ycompact), zcompact(zcompact), A(A), B(B),
-    allocated(true) {
+    allocated(!options.borrow), shared(options.borrow) {
     set(options);
     multithread(mx);
     unsigned int C=max(A,B);
-    u1=utils::ComplexAlign((mz/2+1)*C*threads*innerthreads);
-    u2=utils::ComplexAlign(options.stride2*C*threads);
-    u3=utils::ComplexAlign(options.stride3*C);
+    size1=(mz/2+1)*C*threads*innerthreads;
+    size2=options.stride2*C*threads;
+    size3=options.stride3*C;
+    if(shared) {
+      u1=Workspace::borrow<Complex>(size1+size2+size3);
+      u2=u1+size1;
+      u3=u2+size2;
+    } else {
+      u1=utils::ComplexAlign<Complex>(size1);
+      u2=utils::ComplexAlign<Complex>(size2);
+      u3=utils::ComplexAlign<Complex>(size3);
+    }
     init(options);
+    if(shared) Workspace::putback(u1);
   }
   
-  virtual ~ImplicitHConvolution3() {
+  virtual ~ImplicitHConvolution3T() {
     if(yzconvolve) {
       deletepointers3(U3);
       
@@ -1318,22 +2442,24 @@ public:
     }
   }
 
-  void subconvolution(Complex **F, realmultiplier *pmult,
+  template<class Mult>
+  void subconvolution(Complex **F, Mult mult,
                       IndexFunction indexfunction,
                       unsigned int M, unsigned int stride,
                       unsigned int offset=0) {
     if(threads > 1) {
+      yzconvolve[0]->update();
 #ifndef FFTWPP_SINGLE_THREAD
 #pragma omp parallel for num_threads(threads)
 #endif    
       for(unsigned int i=0; i < M; ++i)
-        yzconvolve[get_thread_num()]->convolve(F,pmult,false,
+        yzconvolve[get_thread_num()]->convolve(F,mult,false,
                                                indexfunction(i,mx),
                                                offset+i*stride);
     } else {
-      ImplicitHConvolution2 *yzconvolve0=yzconvolve[0];
+      ImplicitHConvolution2T<Real> *yzconvolve0=yzconvolve[0];
       for(unsigned int i=0; i < M; ++i)
-        yzconvolve0->convolve(F,pmult,false,indexfunction(i,mx),
+        yzconvolve0->convolve(F,mult,false,indexfunction(i,mx),
                               offset+i*stride);
     }
   }
@@ -1349,6 +2475,13 @@ public:
   virtual void convolve(Complex **F, realmultiplier *pmult,
                         bool symmetrize=true, unsigned int i=0,
                         unsigned int offset=0) {
+    convolve<realmultiplier *>(F,pmult,symmetrize,i,offset);
+  }
+
+  // As above, with a multiplier object mult (see pointwise).
+  template<class Mult>
+  void convolve(Complex **F, Mult mult, bool symmetrize=true,
+                unsigned int i=0, unsigned int offset=0) {
     if(!toplevel) {
       index[indexsize-3]=i;
       if(threads > 1) {
@@ -1359,11 +2492,13 @@ public:
         }
       }
     }    
+    if(shared) borrow();
     unsigned int stride=(2*my-ycompact)*(mz+!zcompact);
     backwards(F,U3,symmetrize,offset);
-    subconvolution(F,pmult,xfftpad->findex,2*mx-xcompact,stride,offset);
-    subconvolution(U3,pmult,xfftpad->uindex,mx+xcompact,stride);
+    subconvolution(F,mult,xfftpad->findex,2*mx-xcompact,stride,offset);
+    subconvolution(U3,mult,xfftpad->uindex,mx+xcompact,stride);
     forwards(F,U3,offset);
+    if(shared) Workspace::putback(u1);
   }
     
   // Binary convolution:
@@ -1373,6 +2508,538 @@ public:
   }
 };
 
+FFTWPP_PRECISIONS(fftpad)
+FFTWPP_PRECISIONS(fft0pad)
+FFTWPP_PRECISIONS(fft1pad)
+FFTWPP_PRECISIONS(ImplicitConvolution)
+FFTWPP_PRECISIONS(ImplicitHConvolution)
+FFTWPP_PRECISIONS(ImplicitConvolution2)
+FFTWPP_PRECISIONS(ImplicitHConvolution2)
+FFTWPP_PRECISIONS(ImplicitConvolution3)
+FFTWPP_PRECISIONS(ImplicitHConvolution3)
+
+// Compute the scrambled implicitly padded complex Fourier transform of M
+// complex vectors, each of length m, to the length N=p*c, where c=ceil(m/q),
+// one residue r=0,...,p-1 at a time: backwards(in,u,r) returns in u the c
+// transformed values at the points p*j+r of the padded grid, folding the
+// input when q > 1, and forwards(u,out,r) adds their contribution to the m
+// modes of out (overwriting out when r=0). The array in must be allocated
+// as Complex[M*m], u as Complex[M*c], and out, which must be distinct from
+// in until the last residue has been transformed backwards, as
+// Complex[M*m].
+//
+//   fftpadpq fft(m,p,q,M,stride,u);
+//   for(unsigned int r=0; r < fft.residues(); ++r) {
+//     fft.backwards(in,u,r);
+//     fft.forwards(u,out,r);
+//   }
+//
+// Notes:
+//   stride is the spacing between the elements of each Complex vector.
+//
+class fftpadpq {
+  unsigned int m;
+  unsigned int p;
+  unsigned int c;
+  unsigned int M;
+  unsigned int stride;
+  unsigned int s;
+  Complex **ZetaH, **ZetaL; // The shared twiddle factors of each residue.
+  unsigned int threads;
+public:
+  mfft1d *Backwards;
+  mfft1d *Forwards;
+  
+  fftpadpq(unsigned int m, unsigned int p, unsigned int q, unsigned int M,
+           unsigned int stride, Complex *u=NULL,
+           unsigned int Threads=fftw::maxthreads)
+    : m(m), p(p), c(utils::ceilquotient(m,q)), M(M), stride(stride),
+      threads(Threads) {
+    if(p*c < m) {
+      std::cerr << "fftpadpq requires p*ceil(m/q) >= m" << std::endl;
+      exit(1);
+    }
+    Backwards=new mfft1d(c,1,M,stride,1,u,NULL,threads);
+    Forwards=new mfft1d(c,-1,M,stride,1,u,NULL,threads);
+    
+    threads=std::max(Backwards->Threads(),Forwards->Threads());
+    
+    ZetaH=new Complex*[p];
+    ZetaL=new Complex*[p];
+    for(unsigned int r=0; r < p; ++r)
+      s=ShareZeta(p*c,r,m,ZetaH[r],ZetaL[r],threads);
+  }
+  
+  ~fftpadpq() {
+    for(unsigned int r=0; r < p; ++r)
+      ReleaseZeta(ZetaH[r]);
+    delete [] ZetaL;
+    delete [] ZetaH;
+    delete Forwards;
+    delete Backwards;
+  }
+  
+  unsigned int Threads() {return threads;}
+  
+  // The number of rows c of u.
+  unsigned int size() {return c;}
+  
+  // The number of residues p.
+  unsigned int residues() {return p;}
+  
+  // The length N=p*c of the padded transform.
+  unsigned int length() {return p*c;}
+  
+  // Allow several threads to execute the plans at once.
+  void share() {
+    Backwards->Share();
+    Forwards->Share();
+  }
+  
+  // Switch in any plans upgraded in the background.
+  void update() {
+    Backwards->Update();
+    Forwards->Update();
+  }
+  
+  void expand(Complex *f, Complex *u, unsigned int r);
+  void reduce(Complex *u, Complex *f, unsigned int r);
+  
+  void backwards(Complex *f, Complex *u, unsigned int r);
+  void forwards(Complex *u, Complex *f, unsigned int r);
+};
+
+// In-place implicitly dealiased 1D complex convolution with the padding
+// ratio p/q: the data are implicitly padded to the length N=p*ceil(m/q)
+// and transformed one residue at a time, with FFTs of size ceil(m/q).
+// The product of A inputs is dealiased only when N >= A*(m-1)+1, so the
+// constructors reject smaller ratios: p=2, q=1 suffices for binary
+// products, p=3, q=1 for ternary products, and ratios such as 9/4 give
+// smaller padded grids. The multiplier is called once for each
+// residue r=0,...,p-1, on the c=ceil(m/q) points p*j+r of the padded grid.
+class ImplicitPQConvolution : public ThreadBase {
+protected:
+  unsigned int m;
+  unsigned int A;
+  unsigned int B;
+  fftpadpq *fft;
+  Complex *u;
+  Complex **U; // C=max(A,B) arrays of size c for the transformed residue.
+  Complex **W; // B arrays of size m accumulating the outputs.
+  bool ownplans; // The plans were not borrowed from another convolution.
+  unsigned int indexsize;
+public:
+  unsigned int *index;
+  
+  void initpointers() {
+    unsigned int C=max(A,B);
+    unsigned int c=fft->size();
+    U=new Complex *[C];
+    for(unsigned int a=0; a < C; ++a)
+      U[a]=u+a*c;
+    W=new Complex *[B];
+    for(unsigned int b=0; b < B; ++b)
+      W[b]=u+C*c+b*m;
+    indexsize=0;
+  }
+  
+  void allocateindex(unsigned int n, unsigned int *i) {
+    indexsize=n;
+    index=i;
+  }
+  
+  // The size of the work array.
+  unsigned int worksize(unsigned int c) {
+    return max(A,B)*c+B*m;
+  }
+  
+  // Return whether the padding ratio p/q dealiases the product of A inputs
+  // of length m.
+  static bool dealiased(unsigned int m, unsigned int p, unsigned int q,
+                        unsigned int A) {
+    return p*utils::ceilquotient(m,q) >= A*(m-1)+1;
+  }
+  
+  static void check(unsigned int m, unsigned int p, unsigned int q,
+                    unsigned int A) {
+    if(!dealiased(m,p,q,A)) {
+      std::cerr << "The padding ratio " << p << "/" << q
+                << " does not dealias the product of " << A
+                << " inputs of length " << m << std::endl;
+      exit(1);
+    }
+  }
+  
+  // m is the number of Complex data values.
+  // p/q is the padding ratio.
+  // A is the number of inputs.
+  // B is the number of outputs.
+  ImplicitPQConvolution(unsigned int m, unsigned int p, unsigned int q,
+                        unsigned int A=2, unsigned int B=1,
+                        unsigned int threads=fftw::maxthreads)
+    : ThreadBase(threads), m(m), A(A), B(B), ownplans(true) {
+    check(m,p,q,A);
+    u=utils::ComplexAlign(worksize(utils::ceilquotient(m,q)));
+    fft=new fftpadpq(m,p,q,1,1,u,threads);
+    this->threads=fft->Threads();
+    initpointers();
+  }
+  
+  // Execute the plans of convolution, which must outlive this object, on
+  // a work array of its own. Convolutions sharing plans may run
+  // concurrently; plans upgraded in the background are then switched in
+  // only by update().
+  ImplicitPQConvolution(ImplicitPQConvolution& convolution)
+    : ThreadBase(convolution.threads), m(convolution.m), A(convolution.A),
+      B(convolution.B), fft(convolution.fft), ownplans(false) {
+    u=utils::ComplexAlign(worksize(fft->size()));
+    initpointers();
+    fft->share();
+  }
+  
+  ~ImplicitPQConvolution() {
+    delete [] W;
+    delete [] U;
+    utils::deleteAlign(u);
+    if(ownplans) delete fft;
+  }
+  
+  // Switch in any plans upgraded in the background.
+  void update() {
+    fft->update();
+  }
+  
+  // F is an array of C=max(A,B) pointers to distinct data blocks each of
+  // size m, shifted by offset (contents not preserved).
+  void convolve(Complex **F, multiplier *pmult, unsigned int i=0,
+                unsigned int offset=0);
+  
+  // As above, with a multiplier object mult (see pointwise).
+  template<class Mult>
+  void convolve(Complex **F, Mult mult, unsigned int i=0,
+                unsigned int offset=0);
+  
+  // Binary convolution:
+  void convolve(Complex *f, Complex *g) {
+    Complex *F[]={f,g};
+    convolve(F,multbinary);
+  }
+};
+
+template<class Mult>
+void ImplicitPQConvolution::convolve(Complex **F, Mult mult, unsigned int i,
+                                     unsigned int offset)
+{
+  if(indexsize >= 1) index[indexsize-1]=i;
+  
+  unsigned int C=max(A,B);
+  Complex *P[C];
+  for(unsigned int a=0; a < C; ++a)
+    P[a]=F[a]+offset;
+  
+  unsigned int c=fft->size();
+  unsigned int p=fft->residues();
+  for(unsigned int r=0; r < p; ++r) {
+    for(unsigned int a=0; a < A; ++a)
+      fft->backwards(P[a],U[a],r);
+    mult(U,c,indexsize,index,r,threads);
+    for(unsigned int b=0; b < B; ++b)
+      fft->forwards(U[b],W[b],r);
+  }
+  
+  for(unsigned int b=0; b < B; ++b) {
+    Complex *Pb=P[b];
+    Complex *Wb=W[b];
+    PARALLEL(
+      for(unsigned int k=0; k < m; ++k)
+        Pb[k]=Wb[k];
+      );
+  }
+}
+
+// In-place implicitly dealiased 2D complex convolution with the padding
+// ratio p/q along both dimensions (see ImplicitPQConvolution). The
+// multiplier is called with index[indexsize-1] set to the index p*i+r of
+// the point on the padded x grid, where r is the x residue.
+class ImplicitPQConvolution2 : public ThreadBase {
+protected:
+  unsigned int mx,my;
+  unsigned int A;
+  unsigned int B;
+  fftpadpq *xfft;
+  ImplicitPQConvolution **yconvolve;
+  Complex *u;
+  Complex **U; // C=max(A,B) arrays of size c*my, where c=ceil(mx/q).
+  Complex **W; // B arrays of size mx*my accumulating the outputs.
+  bool toplevel;
+  bool ownplans; // The plans were not borrowed from another convolution.
+  unsigned int indexsize;
+public:
+  unsigned int *index;
+  
+  void initpointers() {
+    unsigned int C=max(A,B);
+    unsigned int c=xfft->size();
+    U=new Complex *[C];
+    for(unsigned int a=0; a < C; ++a)
+      U[a]=u+a*c*my;
+    W=new Complex *[B];
+    for(unsigned int b=0; b < B; ++b)
+      W[b]=u+C*c*my+b*mx*my;
+  }
+  
+  void allocateindex(unsigned int n, unsigned int *i) {
+    indexsize=n;
+    index=i;
+    yconvolve[0]->allocateindex(n,i);
+    for(unsigned int t=1; t < threads; ++t)
+      yconvolve[t]->allocateindex(n,new unsigned int[n]);
+  }
+  
+  // The size of the work array.
+  unsigned int worksize(unsigned int c) {
+    return max(A,B)*c*my+B*mx*my;
+  }
+  
+  // mx and my are the number of Complex data values in each dimension.
+  // p/q is the padding ratio.
+  // A is the number of inputs.
+  // B is the number of outputs.
+  // toplevel is false when called from a 3D convolution.
+  ImplicitPQConvolution2(unsigned int mx, unsigned int my,
+                         unsigned int p, unsigned int q,
+                         unsigned int A=2, unsigned int B=1,
+                         unsigned int threads=fftw::maxthreads,
+                         bool toplevel=true)
+    : ThreadBase(threads), mx(mx), my(my), A(A), B(B), toplevel(toplevel),
+      ownplans(true) {
+    ImplicitPQConvolution::check(mx,p,q,A);
+    u=utils::ComplexAlign(worksize(utils::ceilquotient(mx,q)));
+    xfft=new fftpadpq(mx,p,q,my,my,u,threads);
+    initpointers();
+    
+    yconvolve=new ImplicitPQConvolution*[threads];
+    yconvolve[0]=new ImplicitPQConvolution(my,p,q,A,B,1);
+    for(unsigned int t=1; t < threads; ++t)
+      yconvolve[t]=new ImplicitPQConvolution(*yconvolve[0]);
+    if(toplevel) allocateindex(1,new unsigned int[1]);
+  }
+  
+  // Execute the plans of convolution, which must outlive this object, on
+  // work arrays of its own. Convolutions sharing plans may run
+  // concurrently; plans upgraded in the background are then switched in
+  // only by update().
+  ImplicitPQConvolution2(ImplicitPQConvolution2& convolution)
+    : ThreadBase(convolution.threads), mx(convolution.mx),
+      my(convolution.my), A(convolution.A), B(convolution.B),
+      xfft(convolution.xfft), toplevel(convolution.toplevel),
+      ownplans(false) {
+    u=utils::ComplexAlign(worksize(xfft->size()));
+    initpointers();
+    
+    yconvolve=new ImplicitPQConvolution*[threads];
+    for(unsigned int t=0; t < threads; ++t)
+      yconvolve[t]=new ImplicitPQConvolution(*convolution.yconvolve[0]);
+    if(toplevel) allocateindex(1,new unsigned int[1]);
+    xfft->share();
+  }
+  
+  virtual ~ImplicitPQConvolution2() {
+    if(toplevel) {
+      delete [] index;
+      for(unsigned int t=1; t < threads; ++t)
+        delete [] yconvolve[t]->index;
+    }
+    for(unsigned int t=threads; t-- > 0;)
+      delete yconvolve[t];
+    delete [] yconvolve;
+    delete [] W;
+    delete [] U;
+    if(ownplans) delete xfft;
+    utils::deleteAlign(u);
+  }
+  
+  // Switch in any plans upgraded in the background.
+  void update() {
+    xfft->update();
+    yconvolve[0]->update();
+  }
+  
+  // F is an array of C=max(A,B) pointers to distinct data blocks each of
+  // size mx*my, shifted by offset (contents not preserved).
+  virtual void convolve(Complex **F, multiplier *pmult, unsigned int i=0,
+                        unsigned int offset=0) {
+    convolve<multiplier *>(F,pmult,i,offset);
+  }
+  
+  // As above, with a multiplier object mult (see pointwise).
+  template<class Mult>
+  void convolve(Complex **F, Mult mult, unsigned int i=0,
+                unsigned int offset=0) {
+    if(!toplevel) {
+      index[indexsize-2]=i;
+      for(unsigned int t=1; t < threads; ++t) {
+        unsigned int *Index=yconvolve[t]->index;
+        for(unsigned int i=0; i < indexsize; ++i)
+          Index[i]=index[i];
+      }
+    }
+    
+    unsigned int C=max(A,B);
+    Complex *P[C];
+    for(unsigned int a=0; a < C; ++a)
+      P[a]=F[a]+offset;
+    
+    unsigned int c=xfft->size();
+    unsigned int p=xfft->residues();
+    if(threads > 1) update();
+    for(unsigned int r=0; r < p; ++r) {
+      for(unsigned int a=0; a < A; ++a)
+        xfft->backwards(P[a],U[a],r);
+      if(threads > 1) {
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif    
+        for(unsigned int j=0; j < c; ++j)
+          yconvolve[get_thread_num()]->convolve(U,mult,p*j+r,j*my);
+      } else {
+        ImplicitPQConvolution *yconvolve0=yconvolve[0];
+        for(unsigned int j=0; j < c; ++j)
+          yconvolve0->convolve(U,mult,p*j+r,j*my);
+      }
+      for(unsigned int b=0; b < B; ++b)
+        xfft->forwards(U[b],W[b],r);
+    }
+    
+    unsigned int mxy=mx*my;
+    for(unsigned int b=0; b < B; ++b) {
+      Complex *Pb=P[b];
+      Complex *Wb=W[b];
+      PARALLEL(
+        for(unsigned int k=0; k < mxy; ++k)
+          Pb[k]=Wb[k];
+        );
+    }
+  }
+  
+  // Binary convolution:
+  void convolve(Complex *f, Complex *g) {
+    Complex *F[]={f,g};
+    convolve(F,multbinary);
+  }
+};
+
+// In-place implicitly dealiased 3D complex convolution with the padding
+// ratio p/q along all three dimensions (see ImplicitPQConvolution). The
+// multiplier is called with index[0] and index[1] set to the indices of
+// the point on the padded x and y grids.
+class ImplicitPQConvolution3 : public ThreadBase {
+protected:
+  unsigned int mx,my,mz;
+  unsigned int A;
+  unsigned int B;
+  fftpadpq *xfft;
+  ImplicitPQConvolution2 **yzconvolve;
+  Complex *u;
+  Complex **U; // C=max(A,B) arrays of size c*my*mz, where c=ceil(mx/q).
+  Complex **W; // B arrays of size mx*my*mz accumulating the outputs.
+public:
+  unsigned int *index;
+  
+  // mx, my, and mz are the number of Complex data values in each dimension.
+  // p/q is the padding ratio.
+  // A is the number of inputs.
+  // B is the number of outputs.
+  ImplicitPQConvolution3(unsigned int mx, unsigned int my, unsigned int mz,
+                         unsigned int p, unsigned int q,
+                         unsigned int A=2, unsigned int B=1,
+                         unsigned int threads=fftw::maxthreads)
+    : ThreadBase(threads), mx(mx), my(my), mz(mz), A(A), B(B) {
+    ImplicitPQConvolution::check(mx,p,q,A);
+    unsigned int C=max(A,B);
+    unsigned int c=utils::ceilquotient(mx,q);
+    unsigned int myz=my*mz;
+    u=utils::ComplexAlign(C*c*myz+B*mx*myz);
+    xfft=new fftpadpq(mx,p,q,myz,myz,u,threads);
+    U=new Complex *[C];
+    for(unsigned int a=0; a < C; ++a)
+      U[a]=u+a*c*myz;
+    W=new Complex *[B];
+    for(unsigned int b=0; b < B; ++b)
+      W[b]=u+C*c*myz+b*mx*myz;
+    
+    yzconvolve=new ImplicitPQConvolution2*[threads];
+    yzconvolve[0]=new ImplicitPQConvolution2(my,mz,p,q,A,B,1,false);
+    for(unsigned int t=1; t < threads; ++t)
+      yzconvolve[t]=new ImplicitPQConvolution2(*yzconvolve[0]);
+    index=new unsigned int[2];
+    yzconvolve[0]->allocateindex(2,index);
+    for(unsigned int t=1; t < threads; ++t)
+      yzconvolve[t]->allocateindex(2,new unsigned int[2]);
+  }
+  
+  virtual ~ImplicitPQConvolution3() {
+    for(unsigned int t=1; t < threads; ++t)
+      delete [] yzconvolve[t]->index;
+    delete [] index;
+    for(unsigned int t=threads; t-- > 0;)
+      delete yzconvolve[t];
+    delete [] yzconvolve;
+    delete [] W;
+    delete [] U;
+    delete xfft;
+    utils::deleteAlign(u);
+  }
+  
+  // F is an array of C=max(A,B) pointers to distinct data blocks each of
+  // size mx*my*mz (contents not preserved).
+  virtual void convolve(Complex **F, multiplier *pmult) {
+    convolve<multiplier *>(F,pmult);
+  }
+  
+  // As above, with a multiplier object mult (see pointwise).
+  template<class Mult>
+  void convolve(Complex **F, Mult mult) {
+    unsigned int c=xfft->size();
+    unsigned int p=xfft->residues();
+    unsigned int myz=my*mz;
+    if(threads > 1) yzconvolve[0]->update();
+    for(unsigned int r=0; r < p; ++r) {
+      for(unsigned int a=0; a < A; ++a)
+        xfft->backwards(F[a],U[a],r);
+      if(threads > 1) {
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif    
+        for(unsigned int j=0; j < c; ++j)
+          yzconvolve[get_thread_num()]->convolve(U,mult,p*j+r,j*myz);
+      } else {
+        ImplicitPQConvolution2 *yzconvolve0=yzconvolve[0];
+        for(unsigned int j=0; j < c; ++j)
+          yzconvolve0->convolve(U,mult,p*j+r,j*myz);
+      }
+      for(unsigned int b=0; b < B; ++b)
+        xfft->forwards(U[b],W[b],r);
+    }
+    
+    unsigned int n=mx*myz;
+    for(unsigned int b=0; b < B; ++b) {
+      Complex *Fb=F[b];
+      Complex *Wb=W[b];
+      PARALLEL(
+        for(unsigned int k=0; k < n; ++k)
+          Fb[k]=Wb[k];
+        );
+    }
+  }
+  
+  // Binary convolution:
+  void convolve(Complex *f, Complex *g) {
+    Complex *F[]={f,g};
+    convolve(F,multbinary);
+  }
+};
+
 // In-place implicitly dealiased Hermitian ternary convolution.
 class ImplicitHTConvolution : public ThreadBase {
 protected:
@@ -1411,7 +3078,7 @@ public:
     
     threads=std::min(threads,std::max(rco->Threads(),cro->Threads()));
     
-    s=BuildZeta(4*m,m,ZetaH,ZetaL,threads);
+    s=ShareZeta(4*m,m,ZetaH,ZetaL,threads);
     
     initpointers(W,w);
   }
@@ -1437,8 +3104,7 @@ public:
       utils::deleteAlign(v);
       utils::deleteAlign(u);
     }
-    utils::deleteAlign(ZetaL);
-    utils::deleteAlign(ZetaH);
+    ReleaseZeta(ZetaH);
     delete cro;
     delete rco;
     delete cr;
@@ -1490,7 +3156,7 @@ public:
     
     threads=std::min(threads,std::max(rco->Threads(),cro->Threads()));
     
-    s=BuildZeta(4*m,m,ZetaH,ZetaL,threads);
+    s=ShareZeta(4*m,m,ZetaH,ZetaL,threads);
   }
   
   // u and v are distinct temporary arrays each of size m+1.
@@ -1510,8 +3176,7 @@ public:
       utils::deleteAlign(v);
       utils::deleteAlign(u);
     }
-    utils::deleteAlign(ZetaL);
-    utils::deleteAlign(ZetaH);
+    ReleaseZeta(ZetaH);
     delete cro;
     delete rco;
     delete cr;
@@ -1554,7 +3219,7 @@ public:
     
     threads=std::min(threads,std::max(rc->Threads(),cr->Threads()));
     
-    s=BuildZeta(4*m,m,ZetaH,ZetaL,threads);
+    s=ShareZeta(4*m,m,ZetaH,ZetaL,threads);
   }
   
   // u is a distinct temporary array of size m+1.
@@ -1572,8 +3237,7 @@ public:
     if(allocated)
       utils::deleteAlign(u);
     
-    utils::deleteAlign(ZetaL);
-    utils::deleteAlign(ZetaH);
+    ReleaseZeta(ZetaH);
     delete cr;
     delete rc;
   }
@@ -1618,12 +3282,11 @@ public:
     threads=std::min(threads,
                      std::max(Backwards->Threads(),Forwards->Threads()));
     
-    s=BuildZeta(4*m,twom,ZetaH,ZetaL,threads);
+    s=ShareZeta(4*m,twom,ZetaH,ZetaL,threads);
   }
   
   ~fft0bipad() {
-    utils::deleteAlign(ZetaL);
-    utils::deleteAlign(ZetaH);
+    ReleaseZeta(ZetaH);
     delete Forwards;
     delete Backwards;
   }
@@ -5,40 +5,37 @@ namespace fftwpp {
 
 void DirectConvolution::convolve(Complex *h, Complex *f, Complex *g)
 {
-#if (!defined FFTWPP_SINGLE_THREAD) && defined _OPENMP
-#pragma omp parallel for
-#endif
-  for(unsigned int i=0; i < m; ++i) {
-    Complex sum=0.0;
-    for(unsigned int j=0; j <= i; ++j) sum += f[j]*g[i-j];
-    h[i]=sum;
-  }
+  PARALLEL(
+    for(unsigned int i=0; i < m; ++i) {
+      Complex sum=0.0;
+      for(unsigned int j=0; j <= i; ++j) sum += f[j]*g[i-j];
+      h[i]=sum;
+    }
+    );
 }
 
 void DirectConvolution::autoconvolve(Complex *h, Complex *f)
 {
-#if (!defined FFTWPP_SINGLE_THREAD) && defined _OPENMP
-#pragma omp parallel for
-#endif
-  for(unsigned int i=0; i < m; ++i) {
-    Complex sum=0.0;
-    for(unsigned int j=0; j <= i; ++j) sum += f[j]*f[i-j];
-    h[i]=sum;
-  }
+  PARALLEL(
+    for(unsigned int i=0; i < m; ++i) {
+      Complex sum=0.0;
+      for(unsigned int j=0; j <= i; ++j) sum += f[j]*f[i-j];
+      h[i]=sum;
+    }
+    );
 }
 
 void DirectHConvolution::convolve(Complex *h, Complex *f, Complex *g)
 {
-#if (!defined FFTWPP_SINGLE_THREAD) && defined _OPENMP
-#pragma omp parallel for
-#endif
-  for(unsigned int i=0; i < m; ++i) {
-    Complex sum=0.0;
-    for(unsigned int j=0; j <= i; ++j) sum += f[j]*g[i-j];
-    for(unsigned int j=i+1; j < m; ++j) sum += f[j]*conj(g[j-i]);
-    for(unsigned int j=1; j < m-i; ++j) sum += conj(f[j])*g[i+j];
-    h[i]=sum;
-  }
+  PARALLEL(
+    for(unsigned int i=0; i < m; ++i) {
+      Complex sum=0.0;
+      for(unsigned int j=0; j <= i; ++j) sum += f[j]*g[i-j];
+      for(unsigned int j=i+1; j < m; ++j) sum += f[j]*conj(g[j-i]);
+      for(unsigned int j=1; j < m-i; ++j) sum += conj(f[j])*g[i+j];
+      h[i]=sum;
+    }
+    );
 }       
 
 void DirectConvolution2::convolve(Complex *h, Complex *f, Complex *g)
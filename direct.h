@@ -4,22 +4,24 @@ namespace fftwpp {
 #define __direct_h__ 1
 
 // Out-of-place direct 1D complex convolution.
-class DirectConvolution {
+class DirectConvolution : public ThreadBase {
 protected:
   unsigned int m;
 public:  
-  DirectConvolution(unsigned int m) : m(m) {}
+  DirectConvolution(unsigned int m, unsigned int threads=fftw::maxthreads) :
+    ThreadBase(threads), m(m) {}
   
   void convolve(Complex *h, Complex *f, Complex *g);
   void autoconvolve(Complex *h, Complex *f);
 };
 
 // Out-of-place direct 1D Hermitian convolution.
-class DirectHConvolution {
+class DirectHConvolution : public ThreadBase {
 protected:
   unsigned int m;
 public:  
-  DirectHConvolution(unsigned int m) : m(m) {}
+  DirectHConvolution(unsigned int m, unsigned int threads=fftw::maxthreads) :
+    ThreadBase(threads), m(m) {}
   
 // Compute h= f (*) g via direct convolution, where f and g contain the m
 // non-negative Fourier components of real functions (contents
@@ -11,10 +11,11 @@ protected:
 public:  
   
   // u is a temporary array of size n.
-  ExplicitConvolution(unsigned int n, unsigned int m, Complex *u) :
+  ExplicitConvolution(unsigned int n, unsigned int m, Complex *u,
+                      unsigned int threads=fftw::maxthreads) :
     n(n), m(m) {
-    Backwards=new fft1d(n,1,u);
-    Forwards=new fft1d(n,-1,u);
+    Backwards=new fft1d(n,1,u,NULL,threads);
+    Forwards=new fft1d(n,-1,u,NULL,threads);
 
     threads=Forwards->Threads();
   }
@@ -42,10 +43,11 @@ protected:
   unsigned int threads;
 public:
   // u is a temporary array of size n.
-  ExplicitHConvolution(unsigned int n, unsigned int m, Complex *u) :
+  ExplicitHConvolution(unsigned int n, unsigned int m, Complex *u,
+                       unsigned int threads=fftw::maxthreads) :
     n(n), m(m) {
-    rc=new rcfft1d(n,u);
-    cr=new crfft1d(n,u);
+    rc=new rcfft1d(n,u,threads);
+    cr=new crfft1d(n,u,(double *) u,threads);
 
     threads=cr->Threads();
   }
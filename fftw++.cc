@@ -1,72 +1,723 @@
 #include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <cerrno>
 #include <sstream>
+#include <deque>
+#include <map>
+#include <algorithm>
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#include <dirent.h>
+#endif
 #include "fftw++.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 using namespace std;
 
 namespace fftwpp {
 
-const double fftw::twopi=2.0*acos(-1.0);
+const double fftwbase::twopi=2.0*acos(-1.0);
 
 // User settings:
-unsigned int fftw::effort=FFTW_MEASURE;
-const char *fftw::WisdomName="wisdom3.txt";
-unsigned int fftw::maxthreads=1;
-double fftw::testseconds=0.2; // Time limit for threading efficiency tests
+unsigned int fftwbase::effort=FFTW_MEASURE;
+bool fftwbase::upgrade=false; // Plan with FFTW_ESTIMATE, then upgrade to effort
+const char *fftwbase::WisdomName="wisdom3.txt";
+const char *fftwbase::ThreadtableName="threadtable3.txt";
+unsigned int fftwbase::maxthreads=1;
+double fftwbase::testseconds=0.2; // Time limit for threading efficiency tests
+unsigned int fftwbase::wisdombatch=16; // Save after this many new entries
 
-fftw_plan (*fftw::planner)(fftw *f, Complex *in, Complex *out)=Planner;
-
-const char *fftw::oddshift="Shift is not implemented for odd nx";
+const char *fftwbase::oddshift="Shift is not implemented for odd nx";
 const char *inout=
   "constructor and call must be both in place or both out of place";
 
-fft1d::Table fft1d::threadtable;
-mfft1d::Table mfft1d::threadtable;
-rcfft1d::Table rcfft1d::threadtable;
-crfft1d::Table crfft1d::threadtable;
-mrcfft1d::Table mrcfft1d::threadtable;
-mcrfft1d::Table mcrfft1d::threadtable;
-fft2d::Table fft2d::threadtable;
+// A recursive mutex.
+class Mutex {
+#ifdef _WIN32
+  CRITICAL_SECTION mutex;
+public:
+  Mutex() {InitializeCriticalSection(&mutex);}
+  void lock() {EnterCriticalSection(&mutex);}
+  void unlock() {LeaveCriticalSection(&mutex);}
+#else
+  pthread_mutex_t mutex;
+public:
+  Mutex() {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex,&attr);
+    pthread_mutexattr_destroy(&attr);
+  }
+  void lock() {pthread_mutex_lock(&mutex);}
+  void unlock() {pthread_mutex_unlock(&mutex);}
+#endif
+};
 
-void LoadWisdom()
+// Serialize planning across application threads.
+static Mutex& PlanMutex()
 {
-  static bool Wise=false;
-  if(!Wise) {
-    ifstream ifWisdom;
-    ifWisdom.open(fftw::WisdomName);
-    ostringstream wisdom;
-    wisdom << ifWisdom.rdbuf();
-    ifWisdom.close();
-    const string& s=wisdom.str();
-    fftw_import_wisdom_from_string(s.c_str());
-    Wise=true;
+  static Mutex mutex;
+  return mutex;
+}
+
+Planlock::Planlock() {PlanMutex().lock();}
+Planlock::~Planlock() {PlanMutex().unlock();}
+
+// Serialize calls into the FFTW planner.
+static Mutex& PlannerMutex()
+{
+  static Mutex mutex;
+  return mutex;
+}
+
+Plannerlock::Plannerlock() {PlannerMutex().lock();}
+Plannerlock::~Plannerlock() {PlannerMutex().unlock();}
+
+void LockPlanner() {PlannerMutex().lock();}
+void UnlockPlanner() {PlannerMutex().unlock();}
+
+static Mutex& WorkspaceMutex()
+{
+  static Mutex mutex;
+  return mutex;
+}
+
+// The idle workspace arrays, keyed by size, and the sizes of those in use.
+static multimap<size_t,char *> Idle;
+static map<void *,size_t> Borrowed;
+
+void *Workspace::borrowbytes(size_t bytes)
+{
+  WorkspaceMutex().lock();
+  char *u;
+  multimap<size_t,char *>::iterator p=Idle.lower_bound(bytes);
+  if(p != Idle.end()) {
+    u=p->second;
+    bytes=p->first;
+    Idle.erase(p);
+  } else {
+    // Every idle array is too small.
+    for(p=Idle.begin(); p != Idle.end(); ++p)
+      utils::deleteAlign(p->second);
+    Idle.clear();
+    Array::newAlign(u,bytes,sizeof(Complex));
   }
+  Borrowed[u]=bytes;
+  WorkspaceMutex().unlock();
+  return u;
+}
+
+void Workspace::putback(void *u)
+{
+  WorkspaceMutex().lock();
+  map<void *,size_t>::iterator p=Borrowed.find(u);
+  if(p != Borrowed.end()) {
+    Idle.insert(pair<size_t,char *>(p->second,(char *) u));
+    Borrowed.erase(p);
+  }
+  WorkspaceMutex().unlock();
+}
+
+void Workspace::release()
+{
+  WorkspaceMutex().lock();
+  for(multimap<size_t,char *>::iterator p=Idle.begin(); p != Idle.end(); ++p)
+    utils::deleteAlign(p->second);
+  Idle.clear();
+  WorkspaceMutex().unlock();
+}
+
+// Return the CPU model, or an empty string if it is unknown.
+static string CPUmodel()
+{
+  string cpu;
+  ifstream cpuinfo("/proc/cpuinfo");
+  string line;
+  while(getline(cpuinfo,line)) {
+    if(line.compare(0,10,"model name") == 0) {
+      size_t colon=line.find(':');
+      if(colon != string::npos) {
+        size_t start=line.find_first_not_of(" \t",colon+1);
+        if(start != string::npos) cpu=line.substr(start);
+      }
+      break;
+    }
+  }
+  return cpu;
+}
+
+// Return a whitespace-free identifier for this host and its CPU model.
+string Hostname()
+{
+  string host;
+#ifdef _WIN32
+  const char *name=getenv("COMPUTERNAME");
+  if(name) host=name;
+#else
+  char name[256];
+  if(gethostname(name,sizeof(name)) == 0) {
+    name[sizeof(name)-1]=0;
+    host=name;
+  }
+#endif
+  
+  string s=host+":"+CPUmodel();
+  for(size_t i=0; i < s.size(); ++i)
+    if(isspace(s[i])) s[i]='_';
+  return s;
+}
+
+// Return fftw::WisdomName with the precision suffix and the CPU model
+// inserted before the extension, so that wisdom from a different processor
+// type is never imported.
+static string WisdomFile(const char *suffix)
+{
+  static string cpu;
+  static bool initialized=false;
+  if(!initialized) {
+    cpu=CPUmodel();
+    for(size_t i=0; i < cpu.size(); ++i)
+      if(!isalnum(cpu[i]) && cpu[i] != '-') cpu[i]='_';
+    initialized=true;
+  }
+  string name=fftwbase::WisdomName;
+  string tag=suffix;
+  if(!cpu.empty()) tag += "-"+cpu;
+  size_t dot=name.rfind('.');
+  if(dot == string::npos || name.find('/',dot) != string::npos)
+    return name+tag;
+  return name.substr(0,dot)+tag+name.substr(dot);
+}
+
+static string ReadFile(const string& name)
+{
+  ifstream in(name.c_str());
+  ostringstream s;
+  s << in.rdbuf();
+  return s.str();
+}
+
+// Replace the contents of a file atomically by writing a temporary file
+// and renaming it.
+static void ReplaceFile(const string& name, const string& contents)
+{
+  ostringstream tmp;
+  tmp << name << ".tmp";
+#ifndef _WIN32
+  tmp << getpid();
+#endif
+  const string& tmpname=tmp.str();
+  ofstream out(tmpname.c_str());
+  out << contents;
+  out.close();
+  if(!out) {
+    cerr << "Cannot write " << tmpname << endl;
+    remove(tmpname.c_str());
+    return;
+  }
+#ifdef _WIN32
+  remove(name.c_str());
+#endif
+  if(rename(tmpname.c_str(),name.c_str()) != 0) {
+    cerr << "Cannot rename " << tmpname << " to " << name << endl;
+    remove(tmpname.c_str());
+  }
+}
+
+// Hold an exclusive advisory lock on the file name.lock while in scope,
+// removing the lock file afterwards. A process that was waiting on a lock
+// file removed meanwhile retries with the new one.
+class Filelock {
+  int fd;
+  string lockname;
+public:
+  Filelock(const string& name) : lockname(name+".lock") {
+#ifndef _WIN32
+    for(;;) {
+      fd=open(lockname.c_str(),O_RDWR | O_CREAT,0666);
+      if(fd < 0) return;
+      struct flock lock;
+      memset(&lock,0,sizeof(lock));
+      lock.l_type=F_WRLCK;
+      lock.l_whence=SEEK_SET;
+      while(fcntl(fd,F_SETLKW,&lock) == -1 && errno == EINTR)
+        ;
+      struct stat locked,current;
+      if(fstat(fd,&locked) == 0 && stat(lockname.c_str(),&current) == 0 &&
+         locked.st_dev == current.st_dev && locked.st_ino == current.st_ino)
+        return;
+      close(fd);
+    }
+#endif
+  }
+  
+  ~Filelock() {
+#ifndef _WIN32
+    if(fd >= 0) {
+      unlink(lockname.c_str());
+      close(fd);
+    }
+#endif
+  }
+};
+
+void LoadWisdom(wisdomdata& wisdom)
+{
+  Planlock lock;
+  Plannerlock plannerlock;
+  if(!wisdom.loaded) {
+    wisdom.importer(ReadFile(WisdomFile(wisdom.suffix)).c_str());
+    wisdom.loaded=true;
+  }
+}
+
+// Merge our wisdom with that on disk and save the result.
+void SaveWisdom(wisdomdata& wisdom)
+{
+  Planlock lock;
+  Plannerlock plannerlock;
+  const string& name=WisdomFile(wisdom.suffix);
+  Filelock filelock(name);
+  wisdom.importer(ReadFile(name).c_str());
+  char *s=wisdom.exporter();
+  ReplaceFile(name,s);
+  wisdom.free(s);
+  wisdom.unsaved=0;
+}
+
+// The precisions for which new plans have been learned.
+static vector<wisdomdata *> Learned;
+
+static void SaveUnsavedWisdom()
+{
+  for(size_t i=0; i < Learned.size(); ++i)
+    if(Learned[i]->unsaved > 0) SaveWisdom(*Learned[i]);
+}
+
+// Record that a new plan was learned. Wisdom is saved after
+// fftw::wisdombatch new plans and at exit.
+void UpdateWisdom(wisdomdata& wisdom)
+{
+  Planlock lock;
+  if(Learned.empty()) atexit(SaveUnsavedWisdom);
+  if(find(Learned.begin(),Learned.end(),&wisdom) == Learned.end())
+    Learned.push_back(&wisdom);
+  if(++wisdom.unsaved >= fftwbase::wisdombatch) SaveWisdom(wisdom);
+}
+
+void LoadWisdom()
+{
+  LoadWisdom(fftwTraits<double>::wisdom());
 }
 
 void SaveWisdom()
 {
-  ofstream ofWisdom;
-  ofWisdom.open(fftw::WisdomName);
-  char *wisdom=fftw_export_wisdom_to_string();
-  ofWisdom << wisdom;
-  fftw_free(wisdom);
-  ofWisdom.close();
+  SaveWisdom(fftwTraits<double>::wisdom());
+}
+
+void UpdateWisdom()
+{
+  UpdateWisdom(fftwTraits<double>::wisdom());
+}
+
+// Thread table entries recorded on other hosts or for tables that this
+// program does not use.
+static vector<string> Otherentries;
+
+// Number of thread table entries measured since the last save.
+static unsigned int Unsavedentries=0;
+
+// Read thread table entries, keeping existing entries for this host.
+static void ReadThreadtables(istream& in)
+{
+  static const string host=Hostname();
+  vector<ThreadtableBase *>& tables=ThreadtableBase::Tables();
+  Otherentries.clear();
+  string line;
+  while(getline(in,line)) {
+    istringstream s(line);
+    string h,name;
+    s >> h >> name;
+    size_t i=0;
+    if(h == host) {
+      for(; i < tables.size(); ++i) {
+        if(name == tables[i]->name) {
+          tables[i]->read(s);
+          break;
+        }
+      }
+    }
+    if(h != host || i == tables.size())
+      Otherentries.push_back(line);
+  }
+}
+
+void LoadThreadtables()
+{
+  Planlock lock;
+  static bool Loaded=false;
+  if(!Loaded) {
+    ifstream ifTable(fftwbase::ThreadtableName);
+    ReadThreadtables(ifTable);
+    Loaded=true;
+  }
+}
+
+// Merge our thread tables with those on disk and save the result.
+void SaveThreadtables()
+{
+  Planlock lock;
+  const string name=fftwbase::ThreadtableName;
+  Filelock filelock(name);
+  istringstream in(ReadFile(name));
+  ReadThreadtables(in);
+  
+  ostringstream out;
+  for(size_t i=0; i < Otherentries.size(); ++i)
+    out << Otherentries[i] << endl;
+  static const string host=Hostname();
+  vector<ThreadtableBase *>& tables=ThreadtableBase::Tables();
+  for(size_t i=0; i < tables.size(); ++i)
+    tables[i]->write(out,host);
+  ReplaceFile(name,out.str());
+  Unsavedentries=0;
+}
+
+static void SaveUnsavedThreadtables()
+{
+  if(Unsavedentries > 0) SaveThreadtables();
+}
+
+// Record that a new thread table entry was measured. Like wisdom, the
+// tables are saved after fftw::wisdombatch new entries and at exit.
+void UpdateThreadtables()
+{
+  Planlock lock;
+  static bool registered=false;
+  if(!registered) {
+    atexit(SaveUnsavedThreadtables);
+    registered=true;
+  }
+  if(++Unsavedentries >= fftwbase::wisdombatch) SaveThreadtables();
 }
 
 fftw_plan Planner(fftw *F, Complex *in, Complex *out)
 {
-  LoadWisdom();
-  fftw::effort |= FFTW_WISDOM_ONLY;
-  fftw_plan plan=F->Plan(in,out);
-  fftw::effort &= !FFTW_WISDOM_ONLY;
-  if(!plan) {
-    plan=F->Plan(in,out);
-    SaveWisdom();
+  return Planner<double>(F,in,out);
+}
+
+// Requested upgrades of objects not yet used. These are not queued until
+// the object is fully constructed.
+static map<const void *,Upgradetask *>& Pending()
+{
+  static map<const void *,Upgradetask *> *pending=
+    new map<const void *,Upgradetask *>;
+  return *pending;
+}
+
+// Finished upgrades.
+static map<const void *,Upgradetask *>& Upgraded()
+{
+  static map<const void *,Upgradetask *> *upgraded=
+    new map<const void *,Upgradetask *>;
+  return *upgraded;
+}
+
+// Tasks awaiting destruction by the upgrade thread.
+static vector<Upgradetask *>& Retired()
+{
+  static vector<Upgradetask *> *retired=new vector<Upgradetask *>;
+  return *retired;
+}
+
+#ifdef _WIN32
+// Without pthreads, upgrades are built synchronously under the Planlock.
+class Upgradelock : public Planlock {};
+
+static void StartUpgrade(Upgradetask *task)
+{
+  task->build();
+  Upgraded()[task->owner]=task;
+}
+
+static void Retire(Upgradetask *task)
+{
+  delete task;
+}
+#else
+static pthread_mutex_t Upgrademutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Upgradecond=PTHREAD_COND_INITIALIZER;
+
+class Upgradelock {
+public:
+  Upgradelock() {pthread_mutex_lock(&Upgrademutex);}
+  ~Upgradelock() {pthread_mutex_unlock(&Upgrademutex);}
+};
+
+static deque<Upgradetask *>& Upgradequeue()
+{
+  static deque<Upgradetask *> *queue=new deque<Upgradetask *>;
+  return *queue;
+}
+
+static void Retire(Upgradetask *task);
+
+static const void *Current=NULL; // The object whose plan is being built
+static bool Cancelled=false;     // Whether Current no longer wants it
+static bool Stopping=false;
+
+static void StopUpgrades()
+{
+  Upgradelock lock;
+  Stopping=true;
+  pthread_cond_broadcast(&Upgradecond);
+}
+
+// Build queued plans one at a time and destroy retired tasks. Plans are
+// built without the Planlock, so that only calls into the FFTW planner
+// itself wait for them.
+static void *Upgrader(void *)
+{
+  for(;;) {
+    Upgradetask *task=NULL;
+    vector<Upgradetask *> retired;
+    pthread_mutex_lock(&Upgrademutex);
+    deque<Upgradetask *>& queue=Upgradequeue();
+    while(!Stopping && queue.empty() && Retired().empty())
+      pthread_cond_wait(&Upgradecond,&Upgrademutex);
+    if(Stopping) {
+      pthread_mutex_unlock(&Upgrademutex);
+      return NULL;
+    }
+    retired.swap(Retired());
+    if(!queue.empty()) {
+      task=queue.front();
+      queue.pop_front();
+      Current=task->owner;
+    }
+    pthread_mutex_unlock(&Upgrademutex);
+
+    {
+      Plannerlock lock;
+      for(size_t i=0; i < retired.size(); ++i)
+        delete retired[i];
+    }
+    if(task) task->build();
+
+    if(task) {
+      Upgradelock lock;
+      if(Cancelled) Retire(task);
+      else Upgraded()[task->owner]=task;
+      Current=NULL;
+      Cancelled=false;
+    }
+  }
+}
+
+// Queue task for the upgrade thread. Call with an Upgradelock held.
+static void StartUpgrade(Upgradetask *task)
+{
+  static bool started=false;
+  if(!started) {
+    pthread_t thread;
+    if(pthread_create(&thread,NULL,Upgrader,NULL) != 0) {
+      cerr << "Cannot create plan upgrade thread" << endl;
+      exit(1);
+    }
+    pthread_detach(thread);
+    atexit(StopUpgrades);
+    started=true;
   }
-  return plan;
+  Upgradequeue().push_back(task);
+  pthread_cond_broadcast(&Upgradecond);
 }
 
-ThreadBase::ThreadBase() {threads=fftw::maxthreads;}
+// Hand task to the upgrade thread for destruction. Call with an
+// Upgradelock held.
+static void Retire(Upgradetask *task)
+{
+  Retired().push_back(task);
+  pthread_cond_broadcast(&Upgradecond);
+}
+#endif
+
+// Request that task be built in the background once its owner is first
+// used.
+void QueueUpgrade(Upgradetask *task)
+{
+  Upgradelock lock;
+  Pending()[task->owner]=task;
+}
+
+// Start building the background plan for owner on its first use. Once
+// that task is finished, return it; the caller should then take its plan
+// and retire it.
+Upgradetask *FinishUpgrade(const void *owner)
+{
+  Upgradelock lock;
+  map<const void *,Upgradetask *>::iterator q=Pending().find(owner);
+  if(q != Pending().end()) {
+    StartUpgrade(q->second);
+    Pending().erase(q);
+  }
+  map<const void *,Upgradetask *>::iterator p=Upgraded().find(owner);
+  if(p == Upgraded().end()) return NULL;
+  Upgradetask *task=p->second;
+  Upgraded().erase(p);
+  return task;
+}
+
+// Destroy a finished task, along with any plan it holds.
+void RetireUpgrade(Upgradetask *task)
+{
+  Upgradelock lock;
+  Retire(task);
+}
+
+// Discard any background plan for owner. A plan in progress is discarded
+// once it is built.
+void CancelUpgrade(const void *owner)
+{
+  Upgradelock lock;
+  map<const void *,Upgradetask *>::iterator q=Pending().find(owner);
+  if(q != Pending().end()) {
+    delete q->second; // Holds no plan
+    Pending().erase(q);
+  }
+#ifndef _WIN32
+  deque<Upgradetask *>& queue=Upgradequeue();
+  for(deque<Upgradetask *>::iterator p=queue.begin(); p != queue.end();) {
+    if((*p)->owner == owner) {
+      delete *p;
+      p=queue.erase(p);
+    } else ++p;
+  }
+  if(Current == owner) Cancelled=true;
+#endif
+  map<const void *,Upgradetask *>::iterator p=Upgraded().find(owner);
+  if(p != Upgraded().end()) {
+    Retire(p->second);
+    Upgraded().erase(p);
+  }
+}
+
+ThreadBase::ThreadBase() {threads=fftwbase::maxthreads;}
+
+#ifdef __linux__
+// Parse a list of CPU ranges, such as 0-3,8-11.
+static vector<int> CPUlist(const string& s)
+{
+  vector<int> cpus;
+  istringstream in(s);
+  string range;
+  while(getline(in,range,',')) {
+    int first,last;
+    if(sscanf(range.c_str(),"%d-%d",&first,&last) == 1) last=first;
+    else if(sscanf(range.c_str(),"%d",&first) != 1) continue;
+    for(int c=first; c <= last; ++c)
+      cpus.push_back(c);
+  }
+  return cpus;
+}
+
+// Return the CPUs initially allowed to this process, grouped by NUMA node.
+static const vector<vector<int> >& NodeCPUs()
+{
+  static vector<vector<int> > nodes;
+  static bool initialized=false;
+  if(initialized) return nodes;
+  initialized=true;
+  cpu_set_t allowed;
+  if(sched_getaffinity(0,sizeof(allowed),&allowed) != 0) return nodes;
+
+  const string dirname="/sys/devices/system/node";
+  vector<int> ids;
+  DIR *dir=opendir(dirname.c_str());
+  if(dir) {
+    struct dirent *entry;
+    while((entry=readdir(dir)) != NULL) {
+      int id;
+      if(sscanf(entry->d_name,"node%d",&id) == 1) ids.push_back(id);
+    }
+    closedir(dir);
+  }
+  sort(ids.begin(),ids.end());
+
+  for(size_t i=0; i < ids.size(); ++i) {
+    ostringstream name;
+    name << dirname << "/node" << ids[i] << "/cpulist";
+    ifstream in(name.str().c_str());
+    string list;
+    getline(in,list);
+    vector<int> cpus=CPUlist(list);
+    vector<int> node;
+    for(size_t j=0; j < cpus.size(); ++j)
+      if(cpus[j] < CPU_SETSIZE && CPU_ISSET(cpus[j],&allowed))
+        node.push_back(cpus[j]);
+    if(!node.empty()) nodes.push_back(node);
+  }
+
+  if(nodes.empty()) { // No NUMA information: use a single node.
+    vector<int> node;
+    for(int c=0; c < CPU_SETSIZE; ++c)
+      if(CPU_ISSET(c,&allowed)) node.push_back(c);
+    if(!node.empty()) nodes.push_back(node);
+  }
+  return nodes;
+}
+#endif
+
+bool BindThreads(unsigned int threads, bool spread)
+{
+#if defined(__linux__) && !defined(FFTWPP_SINGLE_THREAD)
+  Planlock lock;
+  const vector<vector<int> >& nodes=NodeCPUs();
+  if(nodes.empty() || threads == 0) return false;
+
+  size_t N=nodes.size();
+  size_t width=0;
+  for(size_t n=0; n < N; ++n)
+    width=max(width,nodes[n].size());
+
+  // The CPU of each thread, repeated cyclically if there are more threads
+  // than CPUs.
+  vector<int> cpu;
+  if(spread) {
+    for(size_t k=0; k < width; ++k)
+      for(size_t n=0; n < N; ++n)
+        if(k < nodes[n].size()) cpu.push_back(nodes[n][k]);
+  } else {
+    for(size_t n=0; n < N; ++n)
+      cpu.insert(cpu.end(),nodes[n].begin(),nodes[n].end());
+  }
+
+  bool bound=true;
+#pragma omp parallel num_threads(threads)
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu[get_thread_num() % cpu.size()],&set);
+    if(sched_setaffinity(0,sizeof(set),&set) != 0) {
+#pragma omp critical
+      bound=false;
+    }
+  }
+  return bound;
+#else
+  return false;
+#endif
+}
 
 }
 
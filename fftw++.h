@@ -27,7 +27,10 @@
 #include <iostream>
 #include <fftw3.h>
 #include <cerrno>
+#include <cstring>
 #include <map>
+#include <string>
+#include <vector>
 
 #ifndef _OPENMP
 #ifndef FFTWPP_SINGLE_THREAD
@@ -39,6 +42,10 @@
 #include <omp.h>
 #endif
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 inline int get_thread_num() 
 {
 #ifdef FFTWPP_SINGLE_THREAD
@@ -88,11 +95,369 @@ namespace fftwpp {
 #define FFTWdouble doubleAlign
 #define FFTWdelete deleteAlign
 
-class fftw;
+// The transform classes are templates on the floating-point type Real
+// (double, float, or long double), backed by the fftw, fftwf, or fftwl
+// library, respectively. For example, fft1d is fft1dT<double>, fft1df is
+// fft1dT<float>, and fft1dl is fft1dT<long double>.
+template<class Real> class fftwT;
+typedef fftwT<double> fftw;
 
 extern "C" fftw_plan Planner(fftw *F, Complex *in, Complex *out);
+
+// The wisdom of one FFTW precision, which is saved to its own file.
+struct wisdomdata {
+  const char *suffix; // Appended to the name of the wisdom file
+  int (*importer)(const char *);
+  char *(*exporter)();
+  void (*free)(void *);
+  unsigned int unsaved; // Number of plans learned since the last save
+  bool loaded;
+};
+
+void LoadWisdom(wisdomdata& wisdom);
+void SaveWisdom(wisdomdata& wisdom);
+void UpdateWisdom(wisdomdata& wisdom);
+
+// Double precision wisdom:
 void LoadWisdom();
 void SaveWisdom();
+void UpdateWisdom();
+
+void LoadThreadtables();
+void SaveThreadtables();
+void UpdateThreadtables();
+
+// Pin thread t of every OpenMP team of up to threads threads to its own
+// CPU, so that the static partition of each parallel loop, and the pages
+// first touched under Array::FirstTouchThreads(), stay on the same cores.
+// With spread=true, consecutive threads are dealt round robin to the NUMA
+// nodes; otherwise each node is filled before the next. Only the CPUs
+// allowed to the process are used. Returns false if threads cannot be
+// pinned on this system.
+bool BindThreads(unsigned int threads, bool spread=true);
+
+// FFTW planning and plan destruction are not thread safe. A Planlock
+// serializes them, along with access to the wisdom, the thread table, and
+// the shared zeta tables, across all application threads while it is in
+// scope. The lock is recursive.
+class Planlock {
+public:
+  Planlock();
+  ~Planlock();
+};
+
+// Calls into the FFTW planner itself (plan creation and destruction, the
+// thread count of new plans, and wisdom import and export) are further
+// serialized by a Plannerlock, so that plans can be built in the background
+// (see fftw::upgrade) without holding the Planlock. Once a precision has
+// background upgrades, FFTW takes this lock around each plan creation and
+// destruction. The lock is recursive; take any Planlock first.
+class Plannerlock {
+public:
+  Plannerlock();
+  ~Plannerlock();
+};
+
+// The FFTW planner hooks that take and release the Plannerlock.
+void LockPlanner();
+void UnlockPlanner();
+
+// The arguments of a planner call, converted to the FFTW advanced
+// interface, so that the plan can be rebuilt later with another effort.
+struct plancall {
+  enum calltype {NONE,DFT,R2C,C2R,R2R};
+  calltype type; // NONE if the call cannot be recorded
+  int rank;
+  int n[3];
+  int howmany;
+  int istride,idist;
+  int ostride,odist;
+  int sign;
+  int kind[3];
+};
+
+// A pool of aligned scratch arrays. Objects that borrow their work arrays
+// for each call, rather than holding them for their whole lifetime, share
+// them through this pool, so that a process holds only the scratch space of
+// the calls in progress. An array too small for a request is freed when a
+// larger one is allocated. The pool is thread safe.
+class Workspace {
+  static void *borrowbytes(size_t bytes);
+public:
+  // Return an array of at least n elements, aligned to sizeof(Complex).
+  template<class T>
+  static T *borrow(size_t n) {return (T *) borrowbytes(n*sizeof(T));}
+  // Return an array obtained from borrow to the pool.
+  static void putback(void *u);
+  // Free the arrays that are not in use.
+  static void release();
+};
+
+template<class Real> struct fftwTraits;
+
+// Define fftwTraits<Real>, which maps the FFTW interface with prefix X
+// and the complex type C onto a common set of names.
+#define FFTWPP_TRAITS(Real,C,X,Suffix)                                  \
+  template<>                                                            \
+  struct fftwTraits<Real> {                                             \
+    typedef C Complex;                                                  \
+    typedef X##plan plan;                                               \
+    typedef X##complex complex;                                         \
+    typedef X##iodim iodim;                                             \
+                                                                        \
+    static std::string name(const char *s) {                            \
+      return std::string(s)+Suffix;                                     \
+    }                                                                   \
+    static wisdomdata& wisdom() {                                       \
+      static wisdomdata w={Suffix,X##import_wisdom_from_string,         \
+                           X##export_wisdom_to_string,X##free,0,false}; \
+      return w;                                                         \
+    }                                                                   \
+                                                                        \
+    static void init_threads() {X##init_threads();}                     \
+    static void set_planner_hooks(void (*before)(), void (*after)()) {  \
+      X##set_planner_hooks(before,after);                               \
+    }                                                                   \
+    static void plan_with_nthreads(int n) {X##plan_with_nthreads(n);}   \
+    static void *malloc(size_t n) {return X##malloc(n);}                \
+    static void free(void *p) {X##free(p);}                             \
+    static int alignment_of(Real *p) {return X##alignment_of(p);}       \
+    static void destroy_plan(plan p) {X##destroy_plan(p);}              \
+                                                                        \
+    /* While recording() is set, the planner calls below store their */ \
+    /* arguments there.                                              */ \
+    static plancall *&recording() {                                     \
+      static plancall *call=NULL;                                       \
+      return call;                                                      \
+    }                                                                   \
+    static void record(plancall::calltype type, int rank, const int *n, \
+                       int howmany,                                     \
+                       int istride, int idist, int ostride, int odist,  \
+                       int sign=0, const X##r2r_kind *kind=NULL,        \
+                       bool embedded=false) {                           \
+      plancall *c=recording();                                          \
+      if(!c) return;                                                    \
+      c->type=embedded || rank > 3 ? plancall::NONE : type;             \
+      if(c->type == plancall::NONE) return;                             \
+      c->rank=rank;                                                     \
+      for(int i=0; i < rank; ++i) {                                     \
+        c->n[i]=n[i];                                                   \
+        c->kind[i]=kind ? kind[i] : 0;                                  \
+      }                                                                 \
+      c->howmany=howmany;                                               \
+      c->istride=istride;                                               \
+      c->idist=idist;                                                   \
+      c->ostride=ostride;                                               \
+      c->odist=odist;                                                   \
+      c->sign=sign;                                                     \
+    }                                                                   \
+    /* Rebuild the plan of a recorded call with the given flags. */     \
+    static plan plan_call(const plancall& c, Real *in, Real *out,       \
+                          unsigned int flags) {                         \
+      X##r2r_kind kind[3];                                              \
+      switch(c.type) {                                                  \
+        case plancall::DFT:                                             \
+          return X##plan_many_dft(c.rank,c.n,c.howmany,(complex *) in,  \
+                                  NULL,c.istride,c.idist,               \
+                                  (complex *) out,NULL,c.ostride,       \
+                                  c.odist,c.sign,flags);                \
+        case plancall::R2C:                                             \
+          return X##plan_many_dft_r2c(c.rank,c.n,c.howmany,in,NULL,     \
+                                      c.istride,c.idist,                \
+                                      (complex *) out,NULL,c.ostride,   \
+                                      c.odist,flags);                   \
+        case plancall::C2R:                                             \
+          return X##plan_many_dft_c2r(c.rank,c.n,c.howmany,             \
+                                      (complex *) in,NULL,c.istride,    \
+                                      c.idist,out,NULL,c.ostride,       \
+                                      c.odist,flags);                   \
+        case plancall::R2R:                                             \
+          for(int i=0; i < c.rank; ++i)                                 \
+            kind[i]=(X##r2r_kind) c.kind[i];                            \
+          return X##plan_many_r2r(c.rank,c.n,c.howmany,in,NULL,         \
+                                  c.istride,c.idist,out,NULL,c.ostride, \
+                                  c.odist,kind,flags);                  \
+        default:                                                        \
+          return NULL;                                                  \
+      }                                                                 \
+    }                                                                   \
+                                                                        \
+    static plan plan_dft_1d(int nx, complex *in, complex *out,          \
+                            int sign, unsigned int flags) {             \
+      record(plancall::DFT,1,&nx,1,1,0,1,0,sign);                       \
+      return X##plan_dft_1d(nx,in,out,sign,flags);                      \
+    }                                                                   \
+    static plan plan_dft_r2c_1d(int nx, Real *in, complex *out,         \
+                                unsigned int flags) {                   \
+      record(plancall::R2C,1,&nx,1,1,0,1,0);                            \
+      return X##plan_dft_r2c_1d(nx,in,out,flags);                       \
+    }                                                                   \
+    static plan plan_dft_c2r_1d(int nx, complex *in, Real *out,         \
+                                unsigned int flags) {                   \
+      record(plancall::C2R,1,&nx,1,1,0,1,0);                            \
+      return X##plan_dft_c2r_1d(nx,in,out,flags);                       \
+    }                                                                   \
+    static plan plan_dft_2d(int nx, int ny, complex *in, complex *out,  \
+                            int sign, unsigned int flags) {             \
+      int n[]={nx,ny};                                                  \
+      record(plancall::DFT,2,n,1,1,0,1,0,sign);                         \
+      return X##plan_dft_2d(nx,ny,in,out,sign,flags);                   \
+    }                                                                   \
+    static plan plan_dft_r2c_2d(int nx, int ny, Real *in, complex *out, \
+                                unsigned int flags) {                   \
+      int n[]={nx,ny};                                                  \
+      record(plancall::R2C,2,n,1,1,0,1,0);                              \
+      return X##plan_dft_r2c_2d(nx,ny,in,out,flags);                    \
+    }                                                                   \
+    static plan plan_dft_c2r_2d(int nx, int ny, complex *in, Real *out, \
+                                unsigned int flags) {                   \
+      int n[]={nx,ny};                                                  \
+      record(plancall::C2R,2,n,1,1,0,1,0);                              \
+      return X##plan_dft_c2r_2d(nx,ny,in,out,flags);                    \
+    }                                                                   \
+    static plan plan_dft_3d(int nx, int ny, int nz, complex *in,        \
+                            complex *out, int sign, unsigned int flags) { \
+      int n[]={nx,ny,nz};                                               \
+      record(plancall::DFT,3,n,1,1,0,1,0,sign);                         \
+      return X##plan_dft_3d(nx,ny,nz,in,out,sign,flags);                \
+    }                                                                   \
+    static plan plan_dft_r2c_3d(int nx, int ny, int nz, Real *in,       \
+                                complex *out, unsigned int flags) {     \
+      int n[]={nx,ny,nz};                                               \
+      record(plancall::R2C,3,n,1,1,0,1,0);                              \
+      return X##plan_dft_r2c_3d(nx,ny,nz,in,out,flags);                 \
+    }                                                                   \
+    static plan plan_dft_c2r_3d(int nx, int ny, int nz, complex *in,    \
+                                Real *out, unsigned int flags) {        \
+      int n[]={nx,ny,nz};                                               \
+      record(plancall::C2R,3,n,1,1,0,1,0);                              \
+      return X##plan_dft_c2r_3d(nx,ny,nz,in,out,flags);                 \
+    }                                                                   \
+    static plan plan_many_dft(int rank, const int *n, int howmany,      \
+                              complex *in, const int *inembed,          \
+                              int istride, int idist,                   \
+                              complex *out, const int *onembed,         \
+                              int ostride, int odist,                   \
+                              int sign, unsigned int flags) {           \
+      record(plancall::DFT,rank,n,howmany,istride,idist,ostride,odist,  \
+             sign,NULL,inembed || onembed);                             \
+      return X##plan_many_dft(rank,n,howmany,in,inembed,istride,idist,  \
+                              out,onembed,ostride,odist,sign,flags);    \
+    }                                                                   \
+    static plan plan_many_dft_r2c(int rank, const int *n, int howmany,  \
+                                  Real *in, const int *inembed,         \
+                                  int istride, int idist,               \
+                                  complex *out, const int *onembed,     \
+                                  int ostride, int odist,               \
+                                  unsigned int flags) {                 \
+      record(plancall::R2C,rank,n,howmany,istride,idist,ostride,odist,  \
+             0,NULL,inembed || onembed);                                \
+      return X##plan_many_dft_r2c(rank,n,howmany,in,inembed,istride,    \
+                                  idist,out,onembed,ostride,odist,      \
+                                  flags);                               \
+    }                                                                   \
+    static plan plan_many_dft_c2r(int rank, const int *n, int howmany,  \
+                                  complex *in, const int *inembed,      \
+                                  int istride, int idist,               \
+                                  Real *out, const int *onembed,        \
+                                  int ostride, int odist,               \
+                                  unsigned int flags) {                 \
+      record(plancall::C2R,rank,n,howmany,istride,idist,ostride,odist,  \
+             0,NULL,inembed || onembed);                                \
+      return X##plan_many_dft_c2r(rank,n,howmany,in,inembed,istride,    \
+                                  idist,out,onembed,ostride,odist,      \
+                                  flags);                               \
+    }                                                                   \
+    static plan plan_r2r_1d(int nx, Real *in, Real *out,                \
+                            fftw_r2r_kind kind, unsigned int flags) {   \
+      record(plancall::R2R,1,&nx,1,1,0,1,0,0,&kind);                    \
+      return X##plan_r2r_1d(nx,in,out,kind,flags);                      \
+    }                                                                   \
+    static plan plan_r2r_2d(int nx, int ny, Real *in, Real *out,        \
+                            fftw_r2r_kind kindx, fftw_r2r_kind kindy,   \
+                            unsigned int flags) {                       \
+      int n[]={nx,ny};                                                  \
+      X##r2r_kind kind[]={kindx,kindy};                                 \
+      record(plancall::R2R,2,n,1,1,0,1,0,0,kind);                       \
+      return X##plan_r2r_2d(nx,ny,in,out,kindx,kindy,flags);            \
+    }                                                                   \
+    static plan plan_r2r_3d(int nx, int ny, int nz, Real *in, Real *out, \
+                            fftw_r2r_kind kindx, fftw_r2r_kind kindy,   \
+                            fftw_r2r_kind kindz, unsigned int flags) {  \
+      int n[]={nx,ny,nz};                                               \
+      X##r2r_kind kind[]={kindx,kindy,kindz};                           \
+      record(plancall::R2R,3,n,1,1,0,1,0,0,kind);                       \
+      return X##plan_r2r_3d(nx,ny,nz,in,out,kindx,kindy,kindz,flags);   \
+    }                                                                   \
+    static plan plan_many_r2r(int rank, const int *n, int howmany,      \
+                              Real *in, const int *inembed,             \
+                              int istride, int idist,                   \
+                              Real *out, const int *onembed,            \
+                              int ostride, int odist,                   \
+                              const fftw_r2r_kind *kind,                \
+                              unsigned int flags) {                     \
+      record(plancall::R2R,rank,n,howmany,istride,idist,ostride,odist,  \
+             0,kind,inembed || onembed);                                \
+      return X##plan_many_r2r(rank,n,howmany,in,inembed,istride,idist,  \
+                              out,onembed,ostride,odist,kind,flags);    \
+    }                                                                   \
+    static plan plan_guru_r2r(int rank, const iodim *dims,              \
+                              int howmany_rank, const iodim *howmany_dims, \
+                              Real *in, Real *out,                      \
+                              const X##r2r_kind *kind,                  \
+                              unsigned int flags) {                     \
+      record(plancall::NONE,0,NULL,0,0,0,0,0);                          \
+      return X##plan_guru_r2r(rank,dims,howmany_rank,howmany_dims,in,   \
+                              out,kind,flags);                          \
+    }                                                                   \
+                                                                        \
+    static void execute_dft(plan p, complex *in, complex *out) {        \
+      X##execute_dft(p,in,out);                                         \
+    }                                                                   \
+    static void execute_dft_r2c(plan p, Real *in, complex *out) {       \
+      X##execute_dft_r2c(p,in,out);                                     \
+    }                                                                   \
+    static void execute_dft_c2r(plan p, complex *in, Real *out) {       \
+      X##execute_dft_c2r(p,in,out);                                     \
+    }                                                                   \
+    static void execute_r2r(plan p, Real *in, Real *out) {              \
+      X##execute_r2r(p,in,out);                                         \
+    }                                                                   \
+  };                                                                    \
+                                                                        \
+  inline void DestroyPlan(X##plan plan)                                 \
+  {                                                                     \
+    Planlock lock;                                                      \
+    X##destroy_plan(plan);                                              \
+  }
+
+FFTWPP_TRAITS(double,::Complex,fftw_,"")
+FFTWPP_TRAITS(float,std::complex<float>,fftwf_,"f")
+FFTWPP_TRAITS(long double,std::complex<long double>,fftwl_,"l")
+
+// The precision-dependent types used by the transform classes.
+#define FFTWPP_TYPES(Real)                      \
+  typedef fftwTraits<Real> Traits;              \
+  typedef typename Traits::Complex Complex;     \
+  typedef typename Traits::plan fftwplan;       \
+  typedef typename Traits::complex fftwcomplex;
+
+// A plan of effort fftw::effort, to be built in the background to replace
+// an FFTW_ESTIMATE plan of owner (see fftw::upgrade). A task never refers
+// to its owner, which may be destroyed while the plan is being built.
+class Upgradetask {
+public:
+  const void *owner;
+  Upgradetask(const void *owner) : owner(owner) {}
+  virtual ~Upgradetask() {}
+  // Build the plan. Called without a Planlock held.
+  virtual void build()=0;
+};
+
+void QueueUpgrade(Upgradetask *task);
+Upgradetask *FinishUpgrade(const void *owner);
+void RetireUpgrade(Upgradetask *task);
+void CancelUpgrade(const void *owner);
 
 extern const char *inout;
 
@@ -105,19 +470,27 @@ struct threaddata {
     threads(threads), mean(mean), stdev(stdev) {}
 };
 
-class fftw;
+inline std::ostream& operator << (std::ostream& s, const threaddata& data)
+{
+  return s << data.threads << " " << data.mean << " " << data.stdev;
+}
+
+inline std::istream& operator >> (std::istream& s, threaddata& data)
+{
+  return s >> data.threads >> data.mean >> data.stdev;
+}
 
 class ThreadBase
 {
 protected:
   unsigned int threads;
   unsigned int innerthreads;
-public:  
+public:
   ThreadBase();
   ThreadBase(unsigned int threads) : threads(threads) {}
   void Threads(unsigned int nthreads) {threads=nthreads;}
   unsigned int Threads() {return threads;}
-  
+
   void multithread(unsigned int nx) {
     if(nx >= threads) {
       innerthreads=1;
@@ -128,63 +501,97 @@ public:
   }
 };
 
-inline unsigned int realsize(unsigned int n, Complex *in, Complex *out=NULL)
-{
-  return (!out || in == out) ? 2*(n/2+1) : n;
-}
-  
-inline unsigned int realsize(unsigned int n, Complex *in, double *out)
+template<class I>
+inline unsigned int realsize(unsigned int n, I *in)
 {
- return realsize(n,in,(Complex *) out);
+  return 2*(n/2+1);
 }
-  
-inline unsigned int realsize(unsigned int n, double *in, Complex *out)
+
+template<class I, class O>
+inline unsigned int realsize(unsigned int n, I *in, O *out)
 {
- return realsize(n,(Complex *) in,out);
+  return (!out || (void *) in == (void *) out) ? 2*(n/2+1) : n;
 }
-  
-// Base clase for fft routines
-//
-class fftw : public ThreadBase {
-protected:
-  unsigned int doubles; // number of double precision values in dataset
-  int sign;
-  unsigned int threads;
-  double norm;
 
-  fftw_plan plan;
-  bool inplace;
-  
-  unsigned int Dist(unsigned int n, size_t stride, size_t dist) {
+// Settings shared by the transforms of every precision.
+class fftwbase : public ThreadBase {
+protected:
+  static unsigned int Dist(unsigned int n, size_t stride, size_t dist) {
     return dist ? dist : ((stride == 1) ? n : 1);
   }
-  
+
   static const double twopi;
-  
+
+  // The logical size of a real-to-real transform of n values, which
+  // determines its normalization.
+  static unsigned int r2rsize(unsigned int n, fftw_r2r_kind kind) {
+    switch(kind) {
+      case FFTW_R2HC:
+      case FFTW_HC2R:
+      case FFTW_DHT:
+        return n;
+      case FFTW_REDFT00:
+        return 2*(n-1);
+      case FFTW_RODFT00:
+        return 2*(n+1);
+      default:
+        return 2*n;
+    }
+  }
+
 public:
   static unsigned int effort;
+  static bool upgrade;
   static unsigned int maxthreads;
   static double testseconds;
+  static unsigned int wisdombatch;
   static const char *WisdomName;
-  static fftw_plan (*planner)(fftw *f, Complex *in, Complex *out);
-  
-  virtual unsigned int Threads() {return threads;}
-  
+  static const char *ThreadtableName;
+
   static const char *oddshift;
-  
+};
+
+// Base clase for fft routines
+//
+template<class Real>
+class fftwT : public fftwbase {
+public:
+  FFTWPP_TYPES(Real)
+
+protected:
+  unsigned int doubles; // number of Real values in dataset
+  int sign;
+  unsigned int threads;
+  Real norm;
+
+  fftwplan plan;
+  bool inplace;
+  bool upgrading; // A measured plan is being built in the background
+  bool shared; // Several threads may execute the plan at once
+
+public:
+  static fftwplan (*planner)(fftwT *f, Complex *in, Complex *out);
+
+  virtual unsigned int Threads() {return threads;}
+
+  // The shifts below optionally multiply the data by scale, folding the
+  // normalization of a transform into the same pass. Without scaling only
+  // the negated rows are visited.
+
   // Inplace shift of Fourier origin to (nx/2,0) for even nx.
   static void Shift(Complex *data, unsigned int nx, unsigned int ny,
-                    unsigned int threads) {
+                    unsigned int threads, Real scale=1.0) {
     unsigned int nyp=ny/2+1;
-    unsigned int stop=nx*nyp;
     if(nx % 2 == 0) {
-      unsigned int inc=2*nyp;
+      unsigned int start=scale == 1.0;
+      unsigned int inc=start+1;
 #ifndef FFTWPP_SINGLE_THREAD
 #pragma omp parallel for num_threads(threads)
 #endif
-      for(unsigned int i=nyp; i < stop; i += inc) {
-        Complex *p=data+i;
-        for(unsigned int j=0; j < nyp; j++) p[j]=-p[j];
+      for(unsigned int i=start; i < nx; i += inc) {
+        Complex *p=data+i*nyp;
+        Real s=i % 2 ? -scale : scale;
+        for(unsigned int j=0; j < nyp; j++) p[j] *= s;
       }
     } else {
       std::cerr << oddshift << std::endl;
@@ -193,17 +600,18 @@ public:
   }
 
   // Out-of-place shift of Fourier origin to (nx/2,0) for even nx.
-  static void Shift(double *data, unsigned int nx, unsigned int ny,
-                    unsigned int threads) {
+  static void Shift(Real *data, unsigned int nx, unsigned int ny,
+                    unsigned int threads, Real scale=1.0) {
     if(nx % 2 == 0) {
-      unsigned int stop=nx*ny;
-      unsigned int inc=2*ny;
+      unsigned int start=scale == 1.0;
+      unsigned int inc=start+1;
 #ifndef FFTWPP_SINGLE_THREAD
 #pragma omp parallel for num_threads(threads)
 #endif
-      for(unsigned int i=ny; i < stop; i += inc) {
-        double *p=data+i;
-        for(unsigned int j=0; j < ny; j++) p[j]=-p[j];
+      for(unsigned int i=start; i < nx; i += inc) {
+        Real *p=data+i*ny;
+        Real s=i % 2 ? -scale : scale;
+        for(unsigned int j=0; j < ny; j++) p[j] *= s;
       }
     } else {
       std::cerr << oddshift << std::endl;
@@ -213,19 +621,22 @@ public:
 
   // Inplace shift of Fourier origin to (nx/2,ny/2,0) for even nx and ny.
   static void Shift(Complex *data, unsigned int nx, unsigned int ny,
-                    unsigned int nz, unsigned int threads) {
+                    unsigned int nz, unsigned int threads, Real scale=1.0) {
     unsigned int nzp=nz/2+1;
     unsigned int nyzp=ny*nzp;
     if(nx % 2 == 0 && ny % 2 == 0) {
-      unsigned int pinc=2*nzp;
+      bool all=scale != 1.0;
+      unsigned int pinc=all ? nzp : 2*nzp;
 #ifndef FFTWPP_SINGLE_THREAD
 #pragma omp parallel for num_threads(threads)
 #endif
       for(unsigned int i=0; i < nx; i++) {
         Complex *pstart=data+i*nyzp;
         Complex *pstop=pstart+nyzp;
-        for(Complex *p=pstart+(1-(i % 2))*nzp; p < pstop; p += pinc) {
-          for(unsigned int k=0; k < nzp; k++) p[k]=-p[k];
+        Real s=all && i % 2 == 0 ? scale : -scale;
+        for(Complex *p=pstart+(all ? 0 : 1-(i % 2))*nzp; p < pstop;
+            p += pinc, s=all ? -s : s) {
+          for(unsigned int k=0; k < nzp; k++) p[k] *= s;
         }
       }
     } else {
@@ -235,19 +646,22 @@ public:
   }
 
   // Out-of-place shift of Fourier origin to (nx/2,ny/2,0) for even nx and ny.
-  static void Shift(double *data, unsigned int nx, unsigned int ny,
-                    unsigned int nz, unsigned int threads) {
+  static void Shift(Real *data, unsigned int nx, unsigned int ny,
+                    unsigned int nz, unsigned int threads, Real scale=1.0) {
     unsigned int nyz=ny*nz;
     if(nx % 2 == 0 && ny % 2 == 0) {
-      unsigned int pinc=2*nz;
+      bool all=scale != 1.0;
+      unsigned int pinc=all ? nz : 2*nz;
 #ifndef FFTWPP_SINGLE_THREAD
 #pragma omp parallel for num_threads(threads)
 #endif
       for(unsigned int i=0; i < nx; i++) {
-        double *pstart=data+i*nyz;
-        double *pstop=pstart+nyz;
-        for(double *p=pstart+(1-(i % 2))*nz; p < pstop; p += pinc) {
-          for(unsigned int k=0; k < nz; k++) p[k]=-p[k];
+        Real *pstart=data+i*nyz;
+        Real *pstop=pstart+nyz;
+        Real s=all && i % 2 == 0 ? scale : -scale;
+        for(Real *p=pstart+(all ? 0 : 1-(i % 2))*nz; p < pstop;
+            p += pinc, s=all ? -s : s) {
+          for(unsigned int k=0; k < nz; k++) p[k] *= s;
         }
       }
     } else {
@@ -255,47 +669,106 @@ public:
       exit(1);
     }
   }
-  
-  fftw() : plan(NULL) {}
-  fftw(unsigned int doubles, int sign, unsigned int threads,
-       unsigned int n=0) :
-    doubles(doubles), sign(sign), threads(threads), 
-    norm(1.0/(n ? n : doubles/2)), plan(NULL) {
+
+  static unsigned int gcd(unsigned int a, unsigned int b) {
+    while(b) {
+      unsigned int r=a % b;
+      a=b;
+      b=r;
+    }
+    return a;
+  }
+
+  // Inplace translation of the nx x ny grid of rows, each of m Complex
+  // values, so that row (i,j) moves to ((i+cx) mod nx,(j+cy) mod ny), with
+  // optional scaling. This shifts the Fourier origin when nx or ny is odd.
+  // Each permutation cycle is followed separately on blocks of columns,
+  // which the threads share.
+  static void Translate(Complex *data, unsigned int nx, unsigned int ny,
+                        unsigned int m, unsigned int cx, unsigned int cy,
+                        unsigned int threads, Real scale=1.0) {
+    // The cycles start at (i,j) for i < dx and j < dy.
+    unsigned int dx=gcd(nx,cx);
+    unsigned int Lx=nx/dx;
+    unsigned int dy=gcd(ny,(Lx*cy) % ny);
+    unsigned int length=Lx*(ny/dy);
+    unsigned int Cx=nx-cx;
+    unsigned int Cy=ny-cy;
+    const unsigned int block=8;
+    unsigned int blocks=(m+block-1)/block;
 #ifndef FFTWPP_SINGLE_THREAD
-    fftw_init_threads();
-#endif      
+#pragma omp parallel for num_threads(threads)
+#endif
+    for(unsigned int b=0; b < blocks; ++b) {
+      unsigned int k0=b*block;
+      unsigned int w=std::min(block,m-k0);
+      Complex temp[block];
+      for(unsigned int i0=0; i0 < dx; ++i0) {
+        for(unsigned int j0=0; j0 < dy; ++j0) {
+          unsigned int i=i0, j=j0;
+          Complex *p=data+(i*ny+j)*m+k0;
+          for(unsigned int k=0; k < w; ++k) temp[k]=p[k];
+          for(unsigned int t=1; t < length; ++t) {
+            i += Cx;
+            if(i >= nx) i -= nx;
+            j += Cy;
+            if(j >= ny) j -= ny;
+            Complex *q=data+(i*ny+j)*m+k0;
+            for(unsigned int k=0; k < w; ++k) p[k]=q[k]*scale;
+            p=q;
+          }
+          for(unsigned int k=0; k < w; ++k) p[k]=temp[k]*scale;
+        }
+      }
+    }
   }
-  
-  virtual ~fftw() {
-    if(plan) fftw_destroy_plan(plan);
+
+  fftwT() : plan(NULL), upgrading(false), shared(false) {}
+  fftwT(unsigned int doubles, int sign, unsigned int threads,
+        unsigned int n=0) :
+    doubles(doubles), sign(sign), threads(threads),
+    norm(1.0/(n ? n : doubles/2)), plan(NULL), upgrading(false),
+    shared(false) {
+#ifndef FFTWPP_SINGLE_THREAD
+    Planlock lock;
+    Plannerlock plannerlock;
+    Traits::init_threads();
+#endif
   }
-  
-  virtual fftw_plan Plan(Complex *in, Complex *out) {return NULL;};
-  
+
+  virtual ~fftwT() {
+    if(upgrading) CancelUpgrade(this);
+    if(plan) DestroyPlan(plan);
+  }
+
+  virtual fftwplan Plan(Complex *in, Complex *out) {return NULL;};
+
   inline void CheckAlign(Complex *p, const char *s) {
     if((size_t) p % sizeof(Complex) == 0) return;
-    std::cerr << "WARNING: " << s << " array is not " << sizeof(Complex) 
+    std::cerr << "WARNING: " << s << " array is not " << sizeof(Complex)
               << "-byte aligned: address " << p << std::endl;
   }
-  
+
   void noplan() {
     std::cerr << "Unable to construct FFTW plan" << std::endl;
     exit(1);
   }
-  
+
   static void planThreads(unsigned int threads) {
 #ifndef FFTWPP_SINGLE_THREAD
     omp_set_num_threads(threads);
-    fftw_plan_with_nthreads(threads);
-#endif    
+    Traits::plan_with_nthreads(threads);
+#endif
   }
-  
-  threaddata time(fftw_plan plan1, fftw_plan planT, Complex *in, Complex *out,
-                  unsigned int Threads) {
+
+  // Time plan0 using threads0 threads against planT using Threads threads,
+  // keeping the faster plan and destroying the other one.
+  threaddata time(fftwplan plan0, unsigned int threads0, fftwplan planT,
+                  Complex *in, Complex *out, unsigned int Threads) {
     utils::statistics S,ST;
     double stop=utils::totalseconds()+testseconds;
-    threads=1;
-    plan=plan1;
+    threads=threads0;
+    plan=plan0;
     fft(in,out);
     threads=Threads;
     plan=planT;
@@ -303,8 +776,8 @@ public:
     unsigned int N=1;
     for(;;) {
       double t0=utils::totalseconds();
-      threads=1;
-      plan=plan1;
+      threads=threads0;
+      plan=plan0;
       for(unsigned int i=0; i < N; ++i)
         fft(in,out);
       double t1=utils::totalseconds();
@@ -320,83 +793,110 @@ public:
         double error=S.stdev();
         double diff=ST.mean()-S.mean();
         if(diff >= 0.0 || t > stop) {
-          threads=1;
-          plan=plan1;
-          fftw_destroy_plan(planT);
-          break;
+          threads=threads0;
+          plan=plan0;
+          DestroyPlan(planT);
+          return threaddata(threads,S.mean(),S.stdev());
         }
         if(diff < -error) {
           threads=Threads;
-          fftw_destroy_plan(plan1);
-          break;
+          DestroyPlan(plan0);
+          return threaddata(threads,ST.mean(),ST.stdev());
         }
       }
     }
-    return threaddata(threads,S.mean(),S.stdev());
   }
-  
+
   virtual threaddata lookup(bool inplace, unsigned int threads) {
     return threaddata();
   }
-  virtual void store(bool inplace, const threaddata& data) {}
-  
+  virtual void store(bool inplace, unsigned int threads,
+                     const threaddata& data) {}
+
   inline Complex *CheckAlign(Complex *in, Complex *out, bool constructor=true)
   {
-#ifndef NO_CHECK_ALIGN    
+#ifndef NO_CHECK_ALIGN
     CheckAlign(in,constructor ? "constructor input" : "input");
     if(out) CheckAlign(out,constructor ? "constructor output" : "output");
     else out=in;
 #else
     if(!out) out=in;
-#endif    
+#endif
     return out;
   }
-  
+
+  // Return a plan from wisdom if there is one. Otherwise return an
+  // FFTW_ESTIMATE plan and queue a plan of the requested effort to be
+  // built in the background.
+  fftwplan Estimate(Complex *in, Complex *out);
+
   threaddata Setup(Complex *in, Complex *out=NULL) {
+    Planlock lock;
+    Plannerlock plannerlock;
     bool alloc=!in;
-    if(alloc) in=utils::ComplexAlign((doubles+1)/2);
+    if(alloc) Array::newAlign(in,(doubles+1)/2,sizeof(Complex));
     out=CheckAlign(in,out);
     inplace=(out==in);
-    
+
     threaddata data;
     unsigned int Threads=threads;
     if(threads > 1) data=lookup(inplace,threads);
-    threads=data.threads > 0 ? data.threads : 1;
+
+    // Timing estimated plans is meaningless, so when upgrading use the
+    // tabulated thread count, or else the requested one.
+    bool estimate=upgrade && !(effort & FFTW_ESTIMATE);
+    threads=data.threads > 0 ? data.threads : (estimate ? Threads : 1);
     planThreads(threads);
-    plan=(*planner)(this,in,out);
+    plan=estimate ? Estimate(in,out) : (*planner)(this,in,out);
     if(!plan) noplan();
-    
-    fftw_plan planT;
-    if(fftw::maxthreads > 1) {
-      threads=Threads;
-      planThreads(threads);
-      planT=(*planner)(this,in,out);
-    
-      if(data.threads == 0) {
-        if(planT)
-          data=time(plan,planT,in,out,threads);
-        else noplan();
-        store(inplace,threaddata(threads,data.mean,data.stdev));
+
+    if(Threads > 1 && data.threads == 0 && !estimate) {
+      // Search the thread counts 2,4,8,...,Threads, stopping at the first
+      // one that fails to improve on the fastest plan found so far.
+      unsigned int best=1;
+      for(unsigned int T=2;; T=std::min(2*T,Threads)) {
+        threads=T;
+        planThreads(threads);
+        fftwplan planT=(*planner)(this,in,out);
+        if(!planT) noplan();
+        data=time(plan,best,planT,in,out,T);
+        if(data.threads != T || T == Threads) break;
+        best=T;
       }
+      store(inplace,Threads,data);
     }
-    
+
     if(alloc) Array::deleteAlign(in,(doubles+1)/2);
     return data;
   }
-  
-  threaddata Setup(Complex *in, double *out) {
+
+  threaddata Setup(Complex *in, Real *out) {
     return Setup(in,(Complex *) out);
   }
 
-  threaddata Setup(double *in, Complex *out=NULL) {
+  threaddata Setup(Real *in, Complex *out=NULL) {
     return Setup((Complex *) in,out);
   }
-  
+
+  threaddata Setup(Real *in, Real *out) {
+    return Setup((Complex *) in,(Complex *) out);
+  }
+
   virtual void Execute(Complex *in, Complex *out, bool=false) {
-    fftw_execute_dft(plan,(fftw_complex *) in,(fftw_complex *) out);
+    Traits::execute_dft(plan,(fftwcomplex *) in,(fftwcomplex *) out);
   }
-    
+
+  // Switch to the background plan once it is ready.
+  void Upgrade();
+
+  // Allow several threads to execute the plan at once, on distinct arrays.
+  // A background plan is then switched in only by Update(), which must not
+  // be called while the plan is executing.
+  void Share() {shared=true;}
+  void Update() {if(upgrading) Upgrade();}
+
   Complex *Setout(Complex *in, Complex *out) {
+    if(upgrading && !shared) Upgrade();
     out=CheckAlign(in,out,false);
     if(inplace ^ (out == in)) {
       std::cerr << "ERROR: fft " << inout << std::endl;
@@ -404,33 +904,37 @@ public:
     }
     return out;
   }
-  
+
   void fft(Complex *in, Complex *out=NULL) {
     out=Setout(in,out);
     Execute(in,out);
   }
-    
-  void fft(double *in, Complex *out=NULL) {
+
+  void fft(Real *in, Complex *out=NULL) {
     fft((Complex *) in,out);
   }
-  
-  void fft(Complex *in, double *out) {
+
+  void fft(Complex *in, Real *out) {
     fft(in,(Complex *) out);
   }
-  
+
+  void fft(Real *in, Real *out) {
+    fft((Complex *) in,(Complex *) out);
+  }
+
   void fft0(Complex *in, Complex *out=NULL) {
     out=Setout(in,out);
     Execute(in,out,true);
   }
-    
-  void fft0(double *in, Complex *out=NULL) {
+
+  void fft0(Real *in, Complex *out=NULL) {
     fft0((Complex *) in,out);
   }
-  
-  void fft0(Complex *in, double *out) {
+
+  void fft0(Complex *in, Real *out) {
     fft0(in,(Complex *) out);
   }
-  
+
   void Normalize(Complex *out) {
     unsigned int stop=doubles/2;
 #ifndef FFTWPP_SINGLE_THREAD
@@ -439,35 +943,41 @@ public:
     for(unsigned int i=0; i < stop; i++) out[i] *= norm;
   }
 
-  void Normalize(double *out) {
+  void Normalize(Real *out) {
 #ifndef FFTWPP_SINGLE_THREAD
 #pragma omp parallel for num_threads(threads)
 #endif
     for(unsigned int i=0; i < doubles; i++) out[i] *= norm;
   }
-  
-  virtual void fftNormalized(Complex *in, Complex *out=NULL, bool shift=false) 
+
+  virtual void fftNormalized(Complex *in, Complex *out=NULL, bool shift=false)
   {
     out=Setout(in,out);
     Execute(in,out,shift);
     Normalize(out);
   }
-  
-  virtual void fftNormalized(Complex *in, double *out, bool shift=false) {
-    out=(double *) Setout(in,(Complex *) out);
+
+  virtual void fftNormalized(Complex *in, Real *out, bool shift=false) {
+    out=(Real *) Setout(in,(Complex *) out);
     Execute(in,(Complex *) out,shift);
     Normalize(out);
   }
-  
-  virtual void fftNormalized(double *in, Complex *out, bool shift=false) {
+
+  virtual void fftNormalized(Real *in, Complex *out, bool shift=false) {
     fftNormalized((Complex *) in,out,shift);
   }
-  
+
+  void fftNormalized(Real *in, Real *out=NULL) {
+    out=(Real *) Setout((Complex *) in,(Complex *) out);
+    Execute((Complex *) in,(Complex *) out);
+    Normalize(out);
+  }
+
   template<class I, class O>
   void fft0Normalized(I in, O out) {
     fftNormalized(in,out,true);
   }
-  
+
   template<class O>
   void Normalize(unsigned int nx, unsigned int M, size_t ostride,
                  size_t odist, O *out) {
@@ -483,7 +993,7 @@ public:
       }
     }
   }
-  
+
   template<class I, class O>
   void fftNormalized(unsigned int nx, unsigned int M, size_t ostride,
                      size_t odist, I *in, O *out=NULL, bool shift=false) {
@@ -492,11 +1002,147 @@ public:
     Normalize(nx,M,ostride,odist,out);
   }
 
-}; // class fftw
+}; // class fftwT
+
+// Rebuild a recorded planner call with the given effort against scratch
+// arrays with the same alignment as those it was first made with.
+template<class Real>
+class UpgradetaskT : public Upgradetask {
+public:
+  FFTWPP_TYPES(Real)
+
+private:
+  plancall call;
+  unsigned int threads;
+  unsigned int effort;
+  size_t size;
+  bool inplace;
+  int ialign,oalign;
+  fftwplan plan;
+
+public:
+  UpgradetaskT(const void *owner, const plancall& call, unsigned int threads,
+               size_t size, bool inplace, int ialign, int oalign) :
+    Upgradetask(owner), call(call), threads(threads),
+    effort(fftwbase::effort), size(size), inplace(inplace), ialign(ialign),
+    oalign(oalign), plan(NULL) {}
+
+  ~UpgradetaskT() {
+    if(plan) Traits::destroy_plan(plan);
+  }
+
+  void build() {
+    size_t bytes=(size+4)*sizeof(Complex);
+    char *ibase=(char *) Traits::malloc(bytes);
+    char *obase=inplace ? ibase : (char *) Traits::malloc(bytes);
+    Real *in=(Real *) (ibase+ialign);
+    Real *out=inplace ? in : (Real *) (obase+oalign);
+
+    {
+      Plannerlock lock;
+      fftwT<Real>::planThreads(threads);
+      plan=Traits::plan_call(call,in,out,effort);
+    }
+    if(plan) UpdateWisdom(Traits::wisdom());
+
+    if(obase != ibase) Traits::free(obase);
+    Traits::free(ibase);
+  }
+
+  // Exchange p with the new plan, if it could be built.
+  void swap(fftwplan& p) {
+    if(plan) std::swap(p,plan);
+  }
+};
+
+template<class Real>
+typename fftwT<Real>::fftwplan fftwT<Real>::Estimate(Complex *in,
+                                                     Complex *out)
+{
+  LoadWisdom(Traits::wisdom());
+  unsigned int Effort=effort;
+  effort |= FFTW_WISDOM_ONLY;
+  fftwplan p=Plan(in,out);
+  effort=Effort;
+  if(!p) {
+    // Record the last planner call, which makes the returned plan.
+    plancall call;
+    call.type=plancall::NONE;
+    Traits::recording()=&call;
+    effort=FFTW_ESTIMATE;
+    p=Plan(in,out);
+    effort=Effort;
+    Traits::recording()=NULL;
+    if(p && call.type != plancall::NONE) {
+      static bool hooked=false;
+      if(!hooked) {
+        Traits::set_planner_hooks(LockPlanner,UnlockPlanner);
+        hooked=true;
+      }
+      QueueUpgrade(new UpgradetaskT<Real>(this,call,threads,(doubles+1)/2,
+                                          in == out,
+                                          Traits::alignment_of((Real *) in),
+                                          Traits::alignment_of((Real *) out)));
+      upgrading=true;
+    }
+  }
+  return p;
+}
+
+template<class Real>
+void fftwT<Real>::Upgrade()
+{
+  Upgradetask *task=FinishUpgrade(this);
+  if(task) {
+    static_cast<UpgradetaskT<Real> *>(task)->swap(plan);
+    RetireUpgrade(task); // Destroys the superseded plan
+    upgrading=false;
+  }
+}
+
+template<class Real>
+typename fftwT<Real>::fftwplan Planner(fftwT<Real> *F,
+                                       typename fftwT<Real>::Complex *in,
+                                       typename fftwT<Real>::Complex *out)
+{
+  typedef fftwTraits<Real> Traits;
+  Planlock lock;
+  LoadWisdom(Traits::wisdom());
+  unsigned int effort=fftwbase::effort;
+  fftwbase::effort |= FFTW_WISDOM_ONLY;
+  typename Traits::plan plan=F->Plan(in,out);
+  fftwbase::effort=effort;
+  if(!plan) {
+    plan=F->Plan(in,out);
+    if(plan) UpdateWisdom(Traits::wisdom());
+  }
+  return plan;
+}
+
+template<class Real>
+typename fftwT<Real>::fftwplan
+(*fftwT<Real>::planner)(fftwT<Real> *f, Complex *in, Complex *out)=
+  Planner<Real>;
 
-class Transpose {
-  fftw_plan plan;
-  fftw_plan plan2;
+typedef fftwT<float> fftwf;
+typedef fftwT<long double> fftwl;
+
+// Transpose a rows x cols matrix of elements of length Real values (or
+// of length elements of type T), in place or out of place.
+//
+// Out of place, a cache-blocked transpose, whose square tiles are shared
+// among all of the threads, is timed at construction against the FFTW
+// plan, and the faster one is used. Elements of 8 or 16 bytes are moved
+// through SSE2 registers in 2 x 2 tiles, optionally with non-temporal
+// stores.
+//
+// In place, a native transpose, which needs storage for only O(rows+cols)
+// elements per thread, is likewise timed against the FFTW plan.
+template<class Real>
+class TransposeT {
+  FFTWPP_TYPES(Real)
+  fftwplan plan;
+  fftwplan plan2;
   unsigned int a,b;
   unsigned int nlength,mlength;
   unsigned int ilast,jlast;
@@ -504,48 +1150,61 @@ class Transpose {
   unsigned int threads;
   bool inplace;
   unsigned int size;
+  unsigned int length;
+  unsigned int block; // Width of the tiles, in elements
 public:
+  enum Engine {FFTW,BLOCKED,STREAMED,INPLACE};
+  Engine engine;
+
   template<class T>
-  Transpose(unsigned int rows, unsigned int cols, unsigned int length,
-            T *in, T *out=NULL, unsigned int threads=fftw::maxthreads) :
-    rows(rows), cols(cols), threads(threads) {
+  TransposeT(unsigned int rows, unsigned int cols, unsigned int length,
+             T *in, T *out=NULL, unsigned int threads=fftwbase::maxthreads) :
+    rows(rows), cols(cols), threads(threads), engine(FFTW) {
     size=sizeof(T);
-    if(size % sizeof(double) != 0) {
-      std::cerr << "ERROR: Transpose is not implemented for type of size " 
+    if(size % sizeof(Real) != 0) {
+      std::cerr << "ERROR: Transpose is not implemented for type of size "
                 << size;
       exit(1);
     }
     plan=plan2=NULL;
     if(rows == 0 || cols == 0) return;
-    size /= sizeof(double);
+    Planlock lock;
+    Plannerlock plannerlock;
+    size /= sizeof(Real);
     length *= size;
+    this->length=length;
+
+    // Two tiles of block x block elements should fit in a 32KB L1 cache.
+    block=(unsigned int) sqrt(16384.0/(length*sizeof(Real)));
+    if(block > 1) block &= ~1U;
+    else block=1;
 
     if(!out) out=in;
     inplace=(out==in);
     if(inplace) {
-      fftw::planThreads(threads);
+      fftwT<Real>::planThreads(threads);
       threads=1;
-    } else fftw::planThreads(1);
-    
-    fftw_iodim dims[3];
+    } else fftwT<Real>::planThreads(1);
+
+    typename Traits::iodim dims[3];
 
     a=std::min(rows,threads);
     b=std::min(cols,threads/a);
 
     unsigned int n=utils::ceilquotient(rows,a);
     unsigned int m=utils::ceilquotient(cols,b);
-    
+
     // If rows <= threads then a=rows and n=1.
     // If rows >= threads then b=1 and m=cols.
-    
+
     nlength=n*length;
     mlength=m*length;
-    
-    dims[0].n=n; 
+
+    dims[0].n=n;
     dims[0].is=cols*length;
     dims[0].os=length;
-    
-    dims[1].n=m; 
+
+    dims[1].n=m;
     dims[1].is=length;
     dims[1].os=rows*length;
 
@@ -554,33 +1213,62 @@ public:
     dims[2].os=1;
 
     // A plan with rank=0 is a transpose.
-    plan=fftw_plan_guru_r2r(0,NULL,3,dims,(double *) in,(double *) out,
-                            NULL,fftw::effort);
+    plan=Traits::plan_guru_r2r(0,NULL,3,dims,(Real *) in,(Real *) out,
+                               NULL,fftwbase::effort);
     ilast=a;
     jlast=b;
-    
+
     if(n*a > rows) { // Only happens when rows > threads.
       a=utils::ceilquotient(rows,n);
       ilast=a-1;
       dims[0].n=rows-n*ilast;
-      plan2=fftw_plan_guru_r2r(0,NULL,3,dims,(double *) in,(double *) out,
-                               NULL,fftw::effort);
+      plan2=Traits::plan_guru_r2r(0,NULL,3,dims,(Real *) in,(Real *) out,
+                                  NULL,fftwbase::effort);
     } else { // Only happens when rows < threads.
       if(m*b > cols) {
         b=utils::ceilquotient(cols,m);
         jlast=b-1;
         dims[1].n=cols-m*jlast;
-        plan2=fftw_plan_guru_r2r(0,NULL,3,dims,(double *) in,(double *) out,
-                                 NULL,fftw::effort);
+        plan2=Traits::plan_guru_r2r(0,NULL,3,dims,(Real *) in,(Real *) out,
+                                    NULL,fftwbase::effort);
       }
     }
+
+    Engine native=inplace ? INPLACE : BLOCKED;
+    if((fftwbase::effort & FFTW_ESTIMATE) || fftwbase::upgrade)
+      engine=native;
+    else {
+      double t=time(FFTW,in,out);
+      double tb=time(native,in,out);
+      Engine best=tb < t ? native : FFTW;
+      if(!inplace && length*sizeof(Real) == 16 &&
+         time(STREAMED,in,out) < std::min(t,tb))
+        best=STREAMED;
+      engine=best;
+    }
   }
 
-  ~Transpose() {
-    if(plan) fftw_destroy_plan(plan);
-    if(plan2) fftw_destroy_plan(plan2);
+  ~TransposeT() {
+    if(plan) DestroyPlan(plan);
+    if(plan2) DestroyPlan(plan2);
   }
-  
+
+  // Return the mean time of a transpose with engine e.
+  template<class T>
+  double time(Engine e, T *in, T *out) {
+    engine=e;
+    transpose(in,out);
+    double stop=utils::totalseconds()+0.05*fftwbase::testseconds;
+    unsigned int N=0;
+    double t0=utils::totalseconds();
+    double t;
+    do {
+      transpose(in,out);
+      ++N;
+    } while((t=utils::totalseconds()) < stop && N < 1000);
+    return (t-t0)/N;
+  }
+
   template<class T>
   void transpose(T *in, T *out=NULL) {
     if(rows == 0 || cols == 0) return;
@@ -589,84 +1277,383 @@ public:
       std::cerr << "ERROR: Transpose " << inout << std::endl;
       exit(1);
     }
+    if(engine != FFTW) {
+      if(inplace) Inplace((Real *) in);
+      else Blocked((Real *) in,(Real *) out);
+      return;
+    }
 #ifndef FFTWPP_SINGLE_THREAD
-    if(a > 1) {
-      if(b > 1) {
-        int A=a, B=b;
-#pragma omp parallel for num_threads(A)
-        for(unsigned int i=0; i < a; ++i) {
-          unsigned int I=i*nlength;
-#pragma omp parallel for num_threads(B)
-          for(unsigned int j=0; j < b; ++j) {
-            unsigned int J=j*mlength;
-            fftw_execute_r2r((i < ilast && j < jlast) ? plan : plan2,
-                             (double *) in+cols*I+J,
-                             (double *) out+rows*J+I);
-          }
-        }
-      } else {
-        int A=a;
-#pragma omp parallel for num_threads(A)
-        for(unsigned int i=0; i < a; ++i) {
-          unsigned int I=i*nlength;
-          fftw_execute_r2r(i < ilast ? plan : plan2,
-                           (double *) in+cols*I,(double *) out+I);
-        }
-      }
-    } else if(b > 1) {
-      int B=b;
-#pragma omp parallel for num_threads(B)
-      for(unsigned int j=0; j < b; ++j) {
+    unsigned int ab=a*b;
+    if(ab > 1) {
+      // Share all a x b blocks among the threads without nested
+      // parallelism.
+      int AB=ab;
+#pragma omp parallel for num_threads(AB)
+      for(unsigned int t=0; t < ab; ++t) {
+        unsigned int i=t/b;
+        unsigned int j=t-i*b;
+        unsigned int I=i*nlength;
         unsigned int J=j*mlength;
-        fftw_execute_r2r(j < jlast ? plan : plan2,
-                         (double *) in+J,(double *) out+rows*J);
+        Traits::execute_r2r((i < ilast && j < jlast) ? plan : plan2,
+                            (Real *) in+cols*I+J,(Real *) out+rows*J+I);
       }
     } else
 #endif
-      fftw_execute_r2r(plan,(double *) in,(double*) out);
+      Traits::execute_r2r(plan,(Real *) in,(Real*) out);
   }
-};
-
-template<class T, class L>
-class Threadtable {
-public:
-  typedef std::map<T,threaddata,L> Table;
 
-  threaddata Lookup(Table& table, T key) {
-    typename Table::iterator p=table.find(key);
-    return p == table.end() ? threaddata() : p->second;
-  }
-  
-  void Store(Table& threadtable, T key, const threaddata& data) {
-    threadtable[key]=data;
+  void Blocked(Real *in, Real *out) {
+    unsigned int m=utils::ceilquotient(rows,block);
+    unsigned int n=utils::ceilquotient(cols,block);
+    unsigned int tiles=m*n;
+#ifdef __SSE2__
+    bool aligned=((size_t) in | (size_t) out) % 16 == 0;
+    bool stream=engine == STREAMED && aligned;
+#endif
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif
+    for(unsigned int t=0; t < tiles; ++t) {
+      unsigned int i0=(t/n)*block;
+      unsigned int j0=(t % n)*block;
+      unsigned int i1=std::min(i0+block,rows);
+      unsigned int j1=std::min(j0+block,cols);
+#ifdef __SSE2__
+      if(length*sizeof(Real) == 16 && aligned)
+        Tile16((double *) in,(double *) out,i0,i1,j0,j1,stream);
+      else if(length*sizeof(Real) == 8)
+        Tile8((double *) in,(double *) out,i0,i1,j0,j1);
+      else
+#endif
+        Tile(in,out,i0,i1,j0,j1);
+    }
   }
-};
 
-struct keytype1 {
-  unsigned int nx;
-  unsigned int threads;
-  bool inplace;
-  keytype1(unsigned int nx, unsigned int threads, bool inplace) : 
-    nx(nx), threads(threads), inplace(inplace) {}
-};
-  
-struct keyless1 {
-  bool operator()(const keytype1& a, const keytype1& b) const {
-    return a.nx < b.nx || (a.nx == b.nx &&
-                           (a.threads < b.threads || (a.threads == b.threads &&
-                                                      a.inplace < b.inplace)));
-  }
-};
+  // Transpose in place using the decomposition of Catanzaro, Keller, and
+  // Garland (2014) into independent permutations of the rows and of the
+  // columns: with c=gcd(rows,cols), column j is first rotated down by
+  // j/(cols/c) rows, the elements of each row are then moved to their final
+  // columns, and those of each column to their final rows. The threads
+  // share the rows and the blocks of w adjacent columns, each using a
+  // buffer of max(cols,w*rows) elements. Square matrices are transposed
+  // by swapping tiles.
+  void Inplace(Real *data) {
+    if(rows == 1 || cols == 1) return;
+    if(rows == cols) {
+      Swap(data);
+      return;
+    }
+    unsigned int m=rows;
+    unsigned int n=cols;
+    unsigned int c=fftwT<Real>::gcd(m,n);
+    unsigned int b=n/c;
+    // Move enough adjacent columns together to fill a 64-byte cache line.
+    unsigned int w=std::min(std::max(64/(unsigned int) (length*sizeof(Real)),
+                                     1U),n);
+    unsigned int blocks=utils::ceilquotient(n,w);
+    size_t scratch=(size_t) std::max(n,m*w)*length;
+    Real *work;
+    Array::newAlign(work,threads*scratch,sizeof(Complex));
 
-struct keytype2 {
-  unsigned int nx;
-  unsigned int ny;
-  unsigned int threads;
-  bool inplace;
+    if(c > 1) {
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif
+      for(unsigned int k=0; k < blocks; ++k) {
+        Real *temp=work+get_thread_num()*scratch;
+        unsigned int j0=k*w;
+        unsigned int j1=std::min(j0+w,n);
+        for(unsigned int i=0; i < m; ++i) {
+          for(unsigned int j=j0; j < j1; ++j) {
+            unsigned int q=j/b;
+            unsigned int I=i >= q ? i-q : i+m-q;
+            Move(temp+(i*w+j-j0)*length,data+((size_t) I*n+j)*length);
+          }
+        }
+        Store(data,temp,j0,j1,w);
+      }
+    }
+
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif
+    for(unsigned int i=0; i < m; ++i) {
+      Real *temp=work+get_thread_num()*scratch;
+      Real *row=data+(size_t) i*n*length;
+      for(unsigned int j=0; j < n; ++j) {
+        unsigned int q=j/b;
+        unsigned int I=i >= q ? i-q : i+m-q;
+        Move(temp+(((size_t) j*m+I) % n)*length,row+j*length);
+      }
+      Move(row,temp,n);
+    }
+
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif
+    for(unsigned int k=0; k < blocks; ++k) {
+      Real *temp=work+get_thread_num()*scratch;
+      unsigned int j0=k*w;
+      unsigned int j1=std::min(j0+w,n);
+      for(unsigned int i=0; i < m; ++i) {
+        for(unsigned int j=j0; j < j1; ++j) {
+          // Element i*n+j of the result comes from element (I,J) of the
+          // input, which now lies in row (I+J/b) mod m.
+          size_t p=(size_t) i*n+j;
+          size_t J=p/m;
+          unsigned int I=p-J*m;
+          Move(temp+(i*w+j-j0)*length,
+               data+((size_t) ((I+J/b) % m)*n+j)*length);
+        }
+      }
+      Store(data,temp,j0,j1,w);
+    }
+
+    Array::deleteAlign(work,threads*scratch);
+  }
+
+  // Copy count elements from p to q.
+  void Move(Real *q, Real *p, unsigned int count=1) {
+    size_t stop=(size_t) count*length;
+    for(size_t k=0; k < stop; ++k)
+      q[k]=p[k];
+  }
+
+  // Store columns j0 to j1-1 from the buffer temp, of rows of w elements.
+  void Store(Real *data, Real *temp, unsigned int j0, unsigned int j1,
+             unsigned int w) {
+    for(unsigned int i=0; i < rows; ++i)
+      Move(data+((size_t) i*cols+j0)*length,temp+i*w*length,j1-j0);
+  }
+
+  // Transpose a square matrix in place by swapping the tiles above the
+  // diagonal with those below it.
+  void Swap(Real *data) {
+    unsigned int n=utils::ceilquotient(rows,block);
+    unsigned int tiles=n*n;
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif
+    for(unsigned int t=0; t < tiles; ++t) {
+      unsigned int I=t/n;
+      unsigned int J=t % n;
+      if(I > J) continue;
+      unsigned int i0=I*block;
+      unsigned int j0=J*block;
+      unsigned int i1=std::min(i0+block,rows);
+      unsigned int j1=std::min(j0+block,cols);
+      for(unsigned int i=i0; i < i1; ++i) {
+        for(unsigned int j=std::max(j0,i+1); j < j1; ++j) {
+          Real *p=data+((size_t) i*cols+j)*length;
+          Real *q=data+((size_t) j*rows+i)*length;
+          for(unsigned int k=0; k < length; ++k)
+            std::swap(p[k],q[k]);
+        }
+      }
+    }
+  }
+
+  // Transpose element (i,j).
+  void Copy(Real *in, Real *out, size_t i, size_t j) {
+    Real *p=in+(i*cols+j)*length;
+    Real *q=out+(j*rows+i)*length;
+    for(unsigned int k=0; k < length; ++k)
+      q[k]=p[k];
+  }
+
+  // Transpose rows i0 to i1-1 and columns j0 to j1-1.
+  void Tile(Real *in, Real *out, unsigned int i0, unsigned int i1,
+            unsigned int j0, unsigned int j1) {
+    for(unsigned int j=j0; j < j1; ++j)
+      for(unsigned int i=i0; i < i1; ++i)
+        Copy(in,out,i,j);
+  }
+
+#ifdef __SSE2__
+  // Transpose a tile of aligned 16-byte elements.
+  void Tile16(double *in, double *out, unsigned int i0, unsigned int i1,
+              unsigned int j0, unsigned int j1, bool stream) {
+    size_t is=2*cols, os=2*rows;
+    unsigned int i2=i0+((i1-i0) & ~1U);
+    unsigned int j2=j0+((j1-j0) & ~1U);
+    for(unsigned int j=j0; j < j2; j += 2) {
+      for(unsigned int i=i0; i < i2; i += 2) {
+        double *p=in+i*is+2*j;
+        double *q=out+j*os+2*i;
+        __m128d a0=_mm_load_pd(p);
+        __m128d a1=_mm_load_pd(p+2);
+        __m128d b0=_mm_load_pd(p+is);
+        __m128d b1=_mm_load_pd(p+is+2);
+        if(stream) {
+          _mm_stream_pd(q,a0);
+          _mm_stream_pd(q+2,b0);
+          _mm_stream_pd(q+os,a1);
+          _mm_stream_pd(q+os+2,b1);
+        } else {
+          _mm_store_pd(q,a0);
+          _mm_store_pd(q+2,b0);
+          _mm_store_pd(q+os,a1);
+          _mm_store_pd(q+os+2,b1);
+        }
+      }
+    }
+    if(stream) _mm_sfence();
+    Edges((Real *) in,(Real *) out,i0,i1,j0,j1,i2,j2);
+  }
+
+  // Transpose a tile of 8-byte elements.
+  void Tile8(double *in, double *out, unsigned int i0, unsigned int i1,
+             unsigned int j0, unsigned int j1) {
+    unsigned int i2=i0+((i1-i0) & ~1U);
+    unsigned int j2=j0+((j1-j0) & ~1U);
+    for(unsigned int j=j0; j < j2; j += 2) {
+      for(unsigned int i=i0; i < i2; i += 2) {
+        double *p=in+(size_t) i*cols+j;
+        double *q=out+(size_t) j*rows+i;
+        __m128d x=_mm_loadu_pd(p);
+        __m128d y=_mm_loadu_pd(p+cols);
+        _mm_storeu_pd(q,_mm_unpacklo_pd(x,y));
+        _mm_storeu_pd(q+rows,_mm_unpackhi_pd(x,y));
+      }
+    }
+    Edges((Real *) in,(Real *) out,i0,i1,j0,j1,i2,j2);
+  }
+#endif
+
+  // Transpose the last row and column of a tile with an odd number of rows
+  // or columns.
+  void Edges(Real *in, Real *out, unsigned int i0, unsigned int i1,
+             unsigned int j0, unsigned int j1, unsigned int i2,
+             unsigned int j2) {
+    if(i2 < i1)
+      for(unsigned int j=j0; j < j1; ++j)
+        Copy(in,out,i2,j);
+    if(j2 < j1)
+      for(unsigned int i=i0; i < i2; ++i)
+        Copy(in,out,i,j2);
+  }
+};
+
+typedef TransposeT<double> Transpose;
+typedef TransposeT<float> Transposef;
+typedef TransposeT<long double> Transposel;
+
+// The Transpose type that moves elements of type T: the double precision
+// Transpose, unless sizeof(T) is not a multiple of sizeof(double).
+template<class T, bool Double=(sizeof(T) % sizeof(double) == 0)>
+struct TransposeOf {
+  typedef Transpose type;
+};
+
+template<class T>
+struct TransposeOf<T,false> {
+  typedef Transposef type;
+};
+
+// Base class for the thread tables, which are saved to the file
+// fftw::ThreadtableName so that later runs on the same host can skip the
+// threading efficiency tests.
+class ThreadtableBase {
+public:
+  std::string name;
+
+  ThreadtableBase(const std::string& name) : name(name) {
+    Tables().push_back(this);
+  }
+  virtual ~ThreadtableBase() {}
+
+  static std::vector<ThreadtableBase *>& Tables() {
+    static std::vector<ThreadtableBase *> tables;
+    return tables;
+  }
+
+  // Read a single entry, keeping any existing entry with the same key.
+  virtual void read(std::istream& s)=0;
+  // Write all entries, each prefixed by host.
+  virtual void write(std::ostream& s, const std::string& host)=0;
+};
+
+template<class T, class L>
+class Threadtable {
+public:
+  class Table : public ThreadtableBase, public std::map<T,threaddata,L> {
+  public:
+    Table(const std::string& name) : ThreadtableBase(name) {}
+
+    void read(std::istream& s) {
+      T key;
+      threaddata data;
+      if(s >> key >> data) this->insert(std::make_pair(key,data));
+    }
+
+    void write(std::ostream& s, const std::string& host) {
+      for(typename Table::iterator p=this->begin(); p != this->end(); ++p)
+        s << host << " " << name << " " << p->first << " " << p->second
+          << std::endl;
+    }
+  };
+
+  threaddata Lookup(Table& table, T key) {
+    Planlock lock;
+    LoadThreadtables();
+    typename Table::iterator p=table.find(key);
+    return p == table.end() ? threaddata() : p->second;
+  }
+
+  void Store(Table& threadtable, T key, const threaddata& data) {
+    Planlock lock;
+    threadtable[key]=data;
+    UpdateThreadtables();
+  }
+};
+struct keytype1 {
+  unsigned int nx;
+  unsigned int threads;
+  bool inplace;
+  keytype1() {}
+  keytype1(unsigned int nx, unsigned int threads, bool inplace) : 
+    nx(nx), threads(threads), inplace(inplace) {}
+};
+
+inline std::ostream& operator << (std::ostream& s, const keytype1& key)
+{
+  return s << key.nx << " " << key.threads << " " << key.inplace;
+}
+  
+inline std::istream& operator >> (std::istream& s, keytype1& key)
+{
+  return s >> key.nx >> key.threads >> key.inplace;
+}
+  
+struct keyless1 {
+  bool operator()(const keytype1& a, const keytype1& b) const {
+    return a.nx < b.nx || (a.nx == b.nx &&
+                           (a.threads < b.threads || (a.threads == b.threads &&
+                                                      a.inplace < b.inplace)));
+  }
+};
+
+struct keytype2 {
+  unsigned int nx;
+  unsigned int ny;
+  unsigned int threads;
+  bool inplace;
+  keytype2() {}
   keytype2(unsigned int nx, unsigned int ny, unsigned int threads,
            bool inplace) : 
     nx(nx), ny(ny), threads(threads), inplace(inplace) {}
 };
+
+inline std::ostream& operator << (std::ostream& s, const keytype2& key)
+{
+  return s << key.nx << " " << key.ny << " " << key.threads << " "
+           << key.inplace;
+}
+  
+inline std::istream& operator >> (std::istream& s, keytype2& key)
+{
+  return s >> key.nx >> key.ny >> key.threads >> key.inplace;
+}
   
 struct keyless2 {
   bool operator()(const keytype2& a, const keytype2& b) const {
@@ -684,10 +1671,22 @@ struct keytype3 {
   unsigned int nz;
   unsigned int threads;
   bool inplace;
+  keytype3() {}
   keytype3(unsigned int nx, unsigned int ny, unsigned int nz,
            unsigned int threads, bool inplace) : 
     nx(nx), ny(ny), nz(nz), threads(threads), inplace(inplace) {}
 };
+
+inline std::ostream& operator << (std::ostream& s, const keytype3& key)
+{
+  return s << key.nx << " " << key.ny << " " << key.nz << " " << key.threads
+           << " " << key.inplace;
+}
+  
+inline std::istream& operator >> (std::istream& s, keytype3& key)
+{
+  return s >> key.nx >> key.ny >> key.nz >> key.threads >> key.inplace;
+}
   
 struct keyless3 {
   bool operator()(const keytype3& a, const keytype3& b) const {
@@ -701,11 +1700,88 @@ struct keyless3 {
   }
 };
 
+// Keys for batches of M=Q*T+R two- and three-dimensional transforms.
+struct keytype4 {
+  unsigned int nx;
+  unsigned int ny;
+  unsigned int Q;
+  unsigned int R;
+  unsigned int threads;
+  bool inplace;
+  keytype4() {}
+  keytype4(unsigned int nx, unsigned int ny, unsigned int Q, unsigned int R,
+           unsigned int threads, bool inplace) :
+    nx(nx), ny(ny), Q(Q), R(R), threads(threads), inplace(inplace) {}
+};
+
+inline std::ostream& operator << (std::ostream& s, const keytype4& key)
+{
+  return s << key.nx << " " << key.ny << " " << key.Q << " " << key.R << " "
+           << key.threads << " " << key.inplace;
+}
+
+inline std::istream& operator >> (std::istream& s, keytype4& key)
+{
+  return s >> key.nx >> key.ny >> key.Q >> key.R >> key.threads
+           >> key.inplace;
+}
+
+struct keyless4 {
+  bool operator()(const keytype4& a, const keytype4& b) const {
+    if(a.nx != b.nx) return a.nx < b.nx;
+    if(a.ny != b.ny) return a.ny < b.ny;
+    if(a.Q != b.Q) return a.Q < b.Q;
+    if(a.R != b.R) return a.R < b.R;
+    if(a.threads != b.threads) return a.threads < b.threads;
+    return a.inplace < b.inplace;
+  }
+};
+
+struct keytype5 {
+  unsigned int nx;
+  unsigned int ny;
+  unsigned int nz;
+  unsigned int Q;
+  unsigned int R;
+  unsigned int threads;
+  bool inplace;
+  keytype5() {}
+  keytype5(unsigned int nx, unsigned int ny, unsigned int nz,
+           unsigned int Q, unsigned int R, unsigned int threads,
+           bool inplace) :
+    nx(nx), ny(ny), nz(nz), Q(Q), R(R), threads(threads), inplace(inplace) {}
+};
+
+inline std::ostream& operator << (std::ostream& s, const keytype5& key)
+{
+  return s << key.nx << " " << key.ny << " " << key.nz << " " << key.Q << " "
+           << key.R << " " << key.threads << " " << key.inplace;
+}
+
+inline std::istream& operator >> (std::istream& s, keytype5& key)
+{
+  return s >> key.nx >> key.ny >> key.nz >> key.Q >> key.R >> key.threads
+           >> key.inplace;
+}
+
+struct keyless5 {
+  bool operator()(const keytype5& a, const keytype5& b) const {
+    if(a.nx != b.nx) return a.nx < b.nx;
+    if(a.ny != b.ny) return a.ny < b.ny;
+    if(a.nz != b.nz) return a.nz < b.nz;
+    if(a.Q != b.Q) return a.Q < b.Q;
+    if(a.R != b.R) return a.R < b.R;
+    if(a.threads != b.threads) return a.threads < b.threads;
+    return a.inplace < b.inplace;
+  }
+};
+
+
 // Compute the complex Fourier transform of n complex values.
 // Before calling fft(), the arrays in and out (which may coincide) must be
 // allocated as Complex[n].
 //
-// Out-of-place usage: 
+// Out-of-place usage:
 //
 //   fft1d Forward(n,-1,in,out);
 //   Forward.fft(in,out);
@@ -724,129 +1800,190 @@ struct keyless3 {
 //   fft1d Backward(n,1);
 //   Backward.fft(in);
 //
-class fft1d : public fftw, public Threadtable<keytype1,keyless1> {
+template<class Real>
+class fft1dT : public fftwT<Real>, public Threadtable<keytype1,keyless1> {
   unsigned int nx;
   static Table threadtable;
-public:  
-  fft1d(unsigned int nx, int sign, Complex *in=NULL, Complex *out=NULL,
-        unsigned int threads=maxthreads)
-    : fftw(2*nx,sign,threads), nx(nx) {Setup(in,out);} 
-  
+public:
+  FFTWPP_TYPES(Real)
+
+  fft1dT(unsigned int nx, int sign, Complex *in=NULL, Complex *out=NULL,
+         unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*nx,sign,threads), nx(nx) {this->Setup(in,out);}
+
 #ifdef __Array_h__
-  fft1d(int sign, const Array::array1<Complex>& in,
-        const Array::array1<Complex>& out=Array::NULL1,
-        unsigned int threads=maxthreads) 
-    : fftw(2*in.Nx(),sign,threads), nx(in.Nx()) {Setup(in,out);} 
-#endif  
-  
+  fft1dT(int sign, const Array::array1<Complex>& in,
+         const Array::array1<Complex>& out=Array::NULL1,
+         unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*in.Nx(),sign,threads), nx(in.Nx()) {this->Setup(in,out);}
+#endif
+
   threaddata lookup(bool inplace, unsigned int threads) {
     return this->Lookup(threadtable,keytype1(nx,threads,inplace));
   }
-  void store(bool inplace, const threaddata& data) {
-    this->Store(threadtable,keytype1(nx,data.threads,inplace),data);
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype1(nx,threads,inplace),data);
   }
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
-    return fftw_plan_dft_1d(nx,(fftw_complex *) in,(fftw_complex *) out,
-                            sign,effort);
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_dft_1d(nx,(fftwcomplex *) in,(fftwcomplex *) out,
+                               this->sign,this->effort);
   }
 };
-  
-template<class I, class O>
-class fftwblock : public virtual fftw {
+
+// Base class for batches of M transforms of rank 1, 2, or 3 and
+// dimensions n[0] x ... x n[rank-1].
+template<class Real, class I, class O>
+class fftwblock : public virtual fftwT<Real> {
 public:
+  FFTWPP_TYPES(Real)
+
   int nx;
+  int rank;
+  int n[3];
   unsigned int M;
   size_t istride,ostride;
   size_t idist,odist;
-  fftw_plan plan1,plan2;
+  fftw_r2r_kind kind[3]; // Used only by real-to-real transforms
+  fftwplan plan1,plan2;
   unsigned int T,Q,R;
   fftwblock(unsigned int nx, unsigned int M,
             size_t istride, size_t ostride, size_t idist, size_t odist,
+            Complex *in, Complex *out, unsigned int Threads,
+            fftw_r2r_kind Kind=FFTW_R2HC)
+    : fftwT<Real>(), nx(nx), rank(1), M(M), istride(istride),
+      ostride(ostride), idist(fftwbase::Dist(nx,istride,idist)),
+      odist(fftwbase::Dist(nx,ostride,odist)), plan1(NULL), plan2(NULL) {
+    n[0]=nx;
+    kind[0]=kind[1]=kind[2]=Kind;
+    Init(in,out,Threads);
+  }
+
+  fftwblock(int rank, unsigned int nx, unsigned int ny, unsigned int nz,
+            unsigned int M, size_t istride, size_t ostride,
+            size_t idist, size_t odist,
             Complex *in, Complex *out, unsigned int Threads)
-    : fftw(), nx(nx), M(M), istride(istride), ostride(ostride),
-      idist(Dist(nx,istride,idist)), odist(Dist(nx,ostride,odist)),
-      plan1(NULL), plan2(NULL) {
+    : fftwT<Real>(), nx(nx), rank(rank), M(M), istride(istride),
+      ostride(ostride), plan1(NULL), plan2(NULL) {
+    n[0]=nx;
+    n[1]=ny;
+    n[2]=nz;
+    kind[0]=kind[1]=kind[2]=FFTW_R2HC;
+    unsigned int size=Size(rank,nx,ny,nz);
+    this->idist=fftwbase::Dist(size,istride,idist);
+    this->odist=fftwbase::Dist(size,ostride,odist);
+    Init(in,out,Threads);
+  }
+
+  static unsigned int Size(int rank, unsigned int nx, unsigned int ny,
+                           unsigned int nz) {
+    return nx*(rank > 1 ? ny : 1)*(rank > 2 ? nz : 1);
+  }
+
+  // Number of Complex values in each Hermitian array of a real transform.
+  unsigned int ncomplex() {
+    return Size(rank-1,n[0],n[1],n[2])*(n[rank-1]/2+1);
+  }
+
+  // Number of Real values, including any in-place padding, in each real
+  // array.
+  unsigned int nreal() {
+    unsigned int last=n[rank-1];
+    return Size(rank-1,n[0],n[1],n[2])*(this->inplace ? 2*(last/2+1) : last);
+  }
+
+  void Init(Complex *in, Complex *out, unsigned int Threads) {
     T=1;
     Q=M;
     R=0;
-    
-    threaddata S1=Setup(in,out);
-    fftw_plan planT1=plan;
-    
-    if(fftw::maxthreads > 1) {
+
+    threaddata S1=this->Setup(in,out);
+    fftwplan planT1=this->plan;
+
+    if(fftwbase::maxthreads > 1 && !fftwbase::upgrade) {
       if(Threads > 1) {
         T=std::min(M,Threads);
         Q=T > 0 ? M/T : 0;
         R=M-Q*T;
-    
-        threads=Threads;
-        threaddata ST=Setup(in,out);
-        
-        if(R > 0 && threads == 1 && plan1 != plan2) {
-          fftw_destroy_plan(plan2);
+
+        this->threads=Threads;
+        threaddata ST=this->Setup(in,out);
+
+        if(R > 0 && this->threads == 1 && plan1 != plan2) {
+          DestroyPlan(plan2);
           plan2=plan1;
         }
 
         if(ST.mean > S1.mean-S1.stdev) { // Use FFTW's multi-threading
-          fftw_destroy_plan(plan);
+          DestroyPlan(this->plan);
           if(R > 0) {
-            fftw_destroy_plan(plan2);
+            DestroyPlan(plan2);
             plan2=NULL;
           }
           T=1;
           Q=M;
           R=0;
-          plan=planT1;
-          threads=S1.threads;
+          this->plan=planT1;
+          this->threads=S1.threads;
         } else {                         // Do the multi-threading ourselves
-          fftw_destroy_plan(planT1);
-          threads=ST.threads;
+          DestroyPlan(planT1);
+          this->threads=ST.threads;
         }
       } else
-        Setup(in,out); // Synchronize wisdom
+        this->Setup(in,out); // Synchronize wisdom
     }
-  }    
-  
-  fftw_plan Plan(int Q, fftw_complex *in, fftw_complex *out) {
-    return fftw_plan_many_dft(1,&nx,Q,in,NULL,istride,idist,
-                              out,NULL,ostride,odist,sign,effort);
   }
-  
-  fftw_plan Plan(int Q, double *in, fftw_complex *out) {
-    return fftw_plan_many_dft_r2c(1,&nx,Q,in,NULL,istride,idist,
-                                  out,NULL,ostride,odist,effort);
+
+  fftwplan Plan(int Q, fftwcomplex *in, fftwcomplex *out) {
+    return Traits::plan_many_dft(rank,n,Q,in,NULL,istride,idist,
+                                 out,NULL,ostride,odist,this->sign,
+                                 this->effort);
   }
-  
-  fftw_plan Plan(int Q, fftw_complex *in, double *out) {
-    return fftw_plan_many_dft_c2r(1,&nx,Q,in,NULL,istride,idist,
-                                  out,NULL,ostride,odist,effort);
+
+  fftwplan Plan(int Q, Real *in, fftwcomplex *out) {
+    return Traits::plan_many_dft_r2c(rank,n,Q,in,NULL,istride,idist,
+                                     out,NULL,ostride,odist,this->effort);
   }
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
+
+  fftwplan Plan(int Q, fftwcomplex *in, Real *out) {
+    return Traits::plan_many_dft_c2r(rank,n,Q,in,NULL,istride,idist,
+                                     out,NULL,ostride,odist,this->effort);
+  }
+
+  fftwplan Plan(int Q, Real *in, Real *out) {
+    return Traits::plan_many_r2r(rank,n,Q,in,NULL,istride,idist,
+                                 out,NULL,ostride,odist,kind,this->effort);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
     if(R > 0) {
       plan2=Plan(Q+1,(I *) in,(O *) out);
       if(!plan2) return NULL;
-      if(threads == 1) plan1=plan2;
+      if(this->threads == 1) plan1=plan2;
     }
     return Plan(Q,(I *) in,(O *) out);
   }
-    
-  void Execute(fftw_plan plan, fftw_complex *in, fftw_complex *out) {
-    fftw_execute_dft(plan,in,out);
+
+  void Execute(fftwplan plan, fftwcomplex *in, fftwcomplex *out) {
+    Traits::execute_dft(plan,in,out);
   }
-  
-  void Execute(fftw_plan plan, double *in, fftw_complex *out) {
-    fftw_execute_dft_r2c(plan,in,out);
+
+  void Execute(fftwplan plan, Real *in, fftwcomplex *out) {
+    Traits::execute_dft_r2c(plan,in,out);
+  }
+
+  void Execute(fftwplan plan, fftwcomplex *in, Real *out) {
+    Traits::execute_dft_c2r(plan,in,out);
   }
 
-  void Execute(fftw_plan plan, fftw_complex *in, double *out) {
-    fftw_execute_dft_c2r(plan,in,out);
+  void Execute(fftwplan plan, Real *in, Real *out) {
+    Traits::execute_r2r(plan,in,out);
   }
 
   void Execute(Complex *in, Complex *out, bool=false) {
     if(T == 1)
-      Execute(plan,(I *) in,(O *) out);
+      Execute(this->plan,(I *) in,(O *) out);
     else {
       unsigned int extra=T-R;
 #ifndef FFTWPP_SINGLE_THREAD
@@ -855,7 +1992,7 @@ public:
       for(unsigned int i=0; i < T; ++i) {
         unsigned int iQ=i*Q;
         if(i < extra)
-          Execute(plan,(I *) in+iQ*idist,(O *) out+iQ*odist);
+          Execute(this->plan,(I *) in+iQ*idist,(O *) out+iQ*odist);
         else {
           unsigned int offset=iQ+i-extra;
           Execute(plan2,(I *) in+offset*idist,(O *) out+offset*odist);
@@ -863,20 +2000,20 @@ public:
       }
     }
   }
-  
-  unsigned int Threads() {return std::max(T,threads);}
-  
+
+  unsigned int Threads() {return std::max(T,this->threads);}
+
   ~fftwblock() {
-    if(plan2) fftw_destroy_plan(plan2);
+    if(plan2) DestroyPlan(plan2);
   }
 };
-  
+
 // Compute the complex Fourier transform of M complex vectors, each of
 // length n.
 // Before calling fft(), the arrays in and out (which may coincide) must be
 // allocated as Complex[M*n].
 //
-// Out-of-place usage: 
+// Out-of-place usage:
 //
 //   mfft1d Forward(n,-1,M,stride,dist,in,out);
 //   Forward.fft(in,out);
@@ -891,86 +2028,349 @@ public:
 //   dist is the spacing between the first elements of the vectors.
 //
 //
-class mfft1d : public fftwblock<fftw_complex,fftw_complex>,
-               public Threadtable<keytype3,keyless3> {
+template<class Real>
+class mfft1dT : public fftwblock<Real,typename fftwTraits<Real>::complex,
+                                 typename fftwTraits<Real>::complex>,
+                public Threadtable<keytype3,keyless3> {
   static Table threadtable;
-public:  
-  mfft1d(unsigned int nx, int sign, unsigned int M=1, size_t stride=1,
-         size_t dist=0, Complex *in=NULL, Complex *out=NULL,
-         unsigned int threads=maxthreads) :
-    fftw(2*((nx-1)*stride+(M-1)*Dist(nx,stride,dist)+1),sign,threads,nx),
-    fftwblock<fftw_complex,fftw_complex>
-    (nx,M,stride,stride,dist,dist,in,out,threads) {} 
-  
-  mfft1d(unsigned int nx, int sign, unsigned int M,
-         size_t istride, size_t ostride, size_t idist, size_t odist,
-         Complex *in=NULL, Complex *out=NULL, unsigned int threads=maxthreads):
-    fftw(std::max(2*((nx-1)*istride+(M-1)*Dist(nx,istride,idist)+1),
-                  2*((nx-1)*ostride+(M-1)*Dist(nx,ostride,odist)+1)),sign,
-         threads, nx),
-    fftwblock<fftw_complex,fftw_complex>(nx,M,istride,ostride,idist,odist,in,
-                                         out,threads) {} 
-  
+public:
+  FFTWPP_TYPES(Real)
+
+  mfft1dT(unsigned int nx, int sign, unsigned int M=1, size_t stride=1,
+          size_t dist=0, Complex *in=NULL, Complex *out=NULL,
+          unsigned int threads=fftwbase::maxthreads) :
+    fftwT<Real>(2*((nx-1)*stride+(M-1)*fftwbase::Dist(nx,stride,dist)+1),
+                sign,threads,nx),
+    fftwblock<Real,fftwcomplex,fftwcomplex>
+    (nx,M,stride,stride,dist,dist,in,out,threads) {}
+
+  mfft1dT(unsigned int nx, int sign, unsigned int M,
+          size_t istride, size_t ostride, size_t idist, size_t odist,
+          Complex *in=NULL, Complex *out=NULL,
+          unsigned int threads=fftwbase::maxthreads):
+    fftwT<Real>(std::max(2*((nx-1)*istride+
+                            (M-1)*fftwbase::Dist(nx,istride,idist)+1),
+                         2*((nx-1)*ostride+
+                            (M-1)*fftwbase::Dist(nx,ostride,odist)+1)),sign,
+                threads, nx),
+    fftwblock<Real,fftwcomplex,fftwcomplex>(nx,M,istride,ostride,idist,odist,
+                                            in,out,threads) {}
+
   threaddata lookup(bool inplace, unsigned int threads) {
-    return Lookup(threadtable,keytype3(nx,Q,R,threads,inplace));
+    return Lookup(threadtable,keytype3(this->nx,this->Q,this->R,threads,
+                                       inplace));
   }
-  void store(bool inplace, const threaddata& data) {
-    Store(threadtable,keytype3(nx,Q,R,data.threads,inplace),data);
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype3(this->nx,this->Q,this->R,threads,inplace),
+          data);
   }
 };
-  
-// Compute the complex Fourier transform of n real values, using phase sign -1.
-// Before calling fft(), the array in must be allocated as double[n] and
-// the array out must be allocated as Complex[n/2+1]. The arrays in and out
-// may coincide, allocated as Complex[n/2+1].
+
+// Compute the complex Fourier transform of n=n1*n2 complex values by the
+// four-step algorithm, which, unlike a single transform of length n,
+// passes over the data in pieces that fit in cache: the input, viewed as
+// an n2 x n1 matrix, is transposed; the n1 rows of length n2 are
+// transformed in blocks, each row j being multiplied while still in cache
+// by the twiddle factors exp(sign*2*pi*i*j*k/n); and the n2 columns of
+// length n1 are then transformed in blocks of adjacent columns, which
+// leaves the result in natural order. The blocks are shared among the
+// threads. By default n1 is the largest factor of n not exceeding sqrt(n).
+//
+// The engine FOURSTEP or PLAIN (a single fft1d plan) is chosen by timing
+// them, unless FFTW_ESTIMATE or fftw::upgrade is set, in which case
+// FOURSTEP is used for arrays larger than 64MB. The engine may afterwards
+// be set to FOURSTEP, which has no effect when n is prime, or to PLAIN,
+// whose plan is then built on the next call to fft(). A factor n1 that does
+// not divide n is rejected. The steps are public, so that they may also be
+// applied to pieces of a distributed or out-of-core array.
 //
-// Out-of-place usage: 
+// Before calling fft(), the arrays in and out (which may coincide) must be
+// allocated as Complex[n]; an out-of-place transform preserves in.
 //
-//   rcfft1d Forward(n,in,out);
+//   fft1d4step Forward(n,-1,in,out);
 //   Forward.fft(in,out);
 //
-// In-place usage:
-//
-//   rcfft1d Forward(n);
-//   Forward.fft(out);
-// 
-// Notes:
-//   in contains the n real values stored as a Complex array;
-//   out contains the first n/2+1 Complex Fourier values.
-//
-class rcfft1d : public fftw, public Threadtable<keytype1,keyless1> {
-  unsigned int nx;
-  static Table threadtable;
-public:  
-  rcfft1d(unsigned int nx, Complex *out=NULL, unsigned int threads=maxthreads) 
-    : fftw(2*(nx/2+1),-1,threads,nx), nx(nx) {Setup(out,(double*) NULL);}
-  
-  rcfft1d(unsigned int nx, double *in, Complex *out=NULL,
-          unsigned int threads=maxthreads)  
-    : fftw(2*(nx/2+1),-1,threads,nx), nx(nx) {Setup(in,out);}
-  
-  threaddata lookup(bool inplace, unsigned int threads) {
-    return Lookup(threadtable,keytype1(nx,threads,inplace));
-  }
-  void store(bool inplace, const threaddata& data) {
-    Store(threadtable,keytype1(nx,data.threads,inplace),data);
+template<class Real>
+class fft1d4stepT {
+  FFTWPP_TYPES(Real)
+  unsigned int n,n1,n2;
+  int sign;
+  unsigned int threads;
+  bool inplace;
+  unsigned int R,B; // Rows and columns in each block.
+  unsigned int shift; // The twiddle factors are ZetaH[e >> shift]*
+  unsigned int mask;  // ZetaL[e & mask] for e=j*k < n.
+  Complex *ZetaH, *ZetaL;
+  fft1dT<Real> *Plain;
+  mfft1dT<Real> *Rows,*Rows2;
+  mfft1dT<Real> *Columns,*Columns2;
+  TransposeT<Real> *T;
+public:
+  enum Engine {PLAIN,FOURSTEP};
+  Engine engine;
+
+  fft1d4stepT(unsigned int n, int sign, Complex *in=NULL, Complex *out=NULL,
+              unsigned int n1=0, unsigned int threads=fftwbase::maxthreads)
+    : n(n), n1(n1), sign(sign), threads(threads), ZetaH(NULL), ZetaL(NULL),
+      Plain(NULL), Rows(NULL), Rows2(NULL), Columns(NULL), Columns2(NULL),
+      T(NULL) {
+    if(n1 > 0 && n % n1 != 0) {
+      std::cerr << "fft1d4step: n1=" << n1 << " does not divide n=" << n
+                << std::endl;
+      exit(1);
+    }
+    if(this->n1 == 0) {
+      this->n1=1;
+      for(unsigned int d=2; d*d <= n; ++d)
+        if(n % d == 0) this->n1=d;
+    }
+    n1=this->n1;
+    n2=n/n1;
+
+    bool alloc=!in;
+    if(alloc) Array::newAlign(in,n,sizeof(Complex));
+    if(!out) out=in;
+    inplace=(out == in);
+
+    bool estimate=(fftwbase::effort & FFTW_ESTIMATE) || fftwbase::upgrade;
+    bool fourstep=n1 > 1 && n1*n2 == n;
+    if(fourstep) Init(in,out);
+    if(!fourstep) engine=PLAIN;
+    else if(estimate)
+      engine=n*sizeof(Complex) > (1U << 26) ? FOURSTEP : PLAIN;
+    else engine=FOURSTEP;
+
+    if(engine == PLAIN || !estimate)
+      Plain=new fft1dT<Real>(n,sign,in,out,threads);
+    if(engine == FOURSTEP && !estimate) {
+      if(time(PLAIN,in,out) < time(FOURSTEP,in,out))
+        engine=PLAIN;
+      else {
+        delete Plain;
+        Plain=NULL;
+      }
+    }
+
+    if(alloc) Array::deleteAlign(in,n);
   }
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
-    return fftw_plan_dft_r2c_1d(nx,(double *) in,(fftw_complex *) out, effort);
+
+  ~fft1d4stepT() {
+    Clear();
+    delete Plain;
   }
-  
-  void Execute(Complex *in, Complex *out, bool=false) {
-    fftw_execute_dft_r2c(plan,(double *) in,(fftw_complex *) out);
+
+  unsigned int Threads() {return threads;}
+
+  // Build the plain plan on scratch arrays, so that planning cannot
+  // overwrite the data of a caller that selected PLAIN afterwards.
+  void MakePlain() {
+    Complex *in,*out;
+    Array::newAlign(in,n,sizeof(Complex));
+    if(inplace) out=in;
+    else Array::newAlign(out,n,sizeof(Complex));
+    Plain=new fft1dT<Real>(n,sign,in,out,threads);
+    if(!inplace) Array::deleteAlign(out,n);
+    Array::deleteAlign(in,n);
   }
-};
-  
+
+  void Init(Complex *in, Complex *out) {
+    // Keep a block of rows or columns within 256KB, with each block
+    // starting on a 64-byte boundary so that the plans stay valid.
+    const unsigned int cache=262144/sizeof(Complex);
+    const unsigned int align=std::max(64/(int) sizeof(Complex),1);
+    R=std::max(cache/n2,1U);
+    while((R*n2) % align) ++R;
+    R=std::min(R,n1);
+    B=std::max(cache/n1,align);
+    B -= B % align;
+    B=std::min(B,n2);
+
+    T=new TransposeT<Real>(n2,n1,1,in,out,threads);
+    Rows=new mfft1dT<Real>(n2,sign,R,1,n2,out,out,1);
+    if(n1 % R)
+      Rows2=new mfft1dT<Real>(n2,sign,n1 % R,1,n2,out,out,1);
+    Columns=new mfft1dT<Real>(n1,sign,B,n2,1,out,out,1);
+    if(n2 % B)
+      Columns2=new mfft1dT<Real>(n1,sign,n2 % B,n2,1,out,out,1);
+    Rows->Share();
+    Columns->Share();
+    if(Rows2) Rows2->Share();
+    if(Columns2) Columns2->Share();
+
+    shift=0;
+    while((1U << (2*shift)) < n) ++shift;
+    unsigned int s=1U << shift;
+    mask=s-1;
+    unsigned int h=(n+s-1) >> shift;
+    ZetaL=new Complex[s];
+    ZetaH=new Complex[h];
+    Real arg=sign*2*acos((Real) -1)/n;
+    for(unsigned int i=0; i < s; ++i)
+      ZetaL[i]=Complex(cos(arg*i),sin(arg*i));
+    for(unsigned int i=0; i < h; ++i) {
+      Real theta=arg*(Real) ((size_t) i << shift);
+      ZetaH[i]=Complex(cos(theta),sin(theta));
+    }
+  }
+
+  void Clear() {
+    delete T;
+    delete Columns2;
+    delete Columns;
+    delete Rows2;
+    delete Rows;
+    delete [] ZetaH;
+    delete [] ZetaL;
+    T=NULL;
+    Columns=Columns2=Rows=Rows2=NULL;
+    ZetaH=ZetaL=NULL;
+  }
+
+  // Return the mean time of a transform with engine e.
+  double time(Engine e, Complex *in, Complex *out) {
+    engine=e;
+    fft(in,out);
+    double stop=utils::totalseconds()+0.05*fftwbase::testseconds;
+    unsigned int N=0;
+    double t0=utils::totalseconds();
+    double t;
+    do {
+      fft(in,out);
+      ++N;
+    } while((t=utils::totalseconds()) < stop && N < 1000);
+    return (t-t0)/N;
+  }
+
+  // Step 1: transpose the n2 x n1 matrix in to the n1 x n2 matrix out.
+  void transpose(Complex *in, Complex *out) {
+    T->transpose(in,out);
+  }
+
+  // Steps 2 and 3: transform the n1 rows of out and apply the twiddle
+  // factors.
+  void rows(Complex *out) {
+    Rows->Update();
+    if(Rows2) Rows2->Update();
+    unsigned int blocks=utils::ceilquotient(n1,R);
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif
+    for(unsigned int b=0; b < blocks; ++b) {
+      unsigned int j0=b*R;
+      unsigned int j1=std::min(j0+R,n1);
+      Complex *p=out+j0*n2;
+      (j1-j0 == R ? Rows : Rows2)->fft(p);
+      for(unsigned int j=std::max(j0,1U); j < j1; ++j) {
+        Complex *q=out+j*n2;
+        unsigned int e=j;
+        for(unsigned int k=1; k < n2; ++k, e += j)
+          q[k] *= ZetaH[e >> shift]*ZetaL[e & mask];
+      }
+    }
+  }
+
+  // Step 4: transform the n2 columns of out.
+  void columns(Complex *out) {
+    Columns->Update();
+    if(Columns2) Columns2->Update();
+    unsigned int blocks=utils::ceilquotient(n2,B);
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif
+    for(unsigned int b=0; b < blocks; ++b) {
+      unsigned int k0=b*B;
+      (std::min(k0+B,n2)-k0 == B ? Columns : Columns2)->fft(out+k0);
+    }
+  }
+
+  void fft(Complex *in, Complex *out=NULL) {
+    if(!out) out=in;
+    if(inplace ^ (out == in)) {
+      std::cerr << "ERROR: fft " << inout << std::endl;
+      exit(1);
+    }
+    if(engine == PLAIN || !T) {
+      if(!Plain) MakePlain();
+      Plain->fft(in,out);
+      return;
+    }
+    transpose(in,out);
+    rows(out);
+    columns(out);
+  }
+
+  void fftNormalized(Complex *in, Complex *out=NULL) {
+    if(!out) out=in;
+    fft(in,out);
+    Real norm=1.0/n;
+#ifndef FFTWPP_SINGLE_THREAD
+#pragma omp parallel for num_threads(threads)
+#endif
+    for(unsigned int i=0; i < n; i++) out[i] *= norm;
+  }
+};
+
+// Compute the complex Fourier transform of n real values, using phase sign -1.
+// Before calling fft(), the array in must be allocated as double[n] and
+// the array out must be allocated as Complex[n/2+1]. The arrays in and out
+// may coincide, allocated as Complex[n/2+1].
+//
+// Out-of-place usage:
+//
+//   rcfft1d Forward(n,in,out);
+//   Forward.fft(in,out);
+//
+// In-place usage:
+//
+//   rcfft1d Forward(n);
+//   Forward.fft(out);
+//
+// Notes:
+//   in contains the n real values stored as a Complex array;
+//   out contains the first n/2+1 Complex Fourier values.
+//
+template<class Real>
+class rcfft1dT : public fftwT<Real>, public Threadtable<keytype1,keyless1> {
+  unsigned int nx;
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  rcfft1dT(unsigned int nx, Complex *out=NULL,
+           unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*(nx/2+1),-1,threads,nx), nx(nx) {
+    this->Setup(out,(Real*) NULL);
+  }
+
+  rcfft1dT(unsigned int nx, Real *in, Complex *out=NULL,
+           unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*(nx/2+1),-1,threads,nx), nx(nx) {this->Setup(in,out);}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return Lookup(threadtable,keytype1(nx,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype1(nx,threads,inplace),data);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_dft_r2c_1d(nx,(Real *) in,(fftwcomplex *) out,
+                                   this->effort);
+  }
+
+  void Execute(Complex *in, Complex *out, bool=false) {
+    Traits::execute_dft_r2c(this->plan,(Real *) in,(fftwcomplex *) out);
+  }
+};
+
 // Compute the real inverse Fourier transform of the n/2+1 Complex values
 // corresponding to the non-negative part of the frequency spectrum, using
 // phase sign +1.
 // Before calling fft(), the array in must be allocated as Complex[n/2+1]
 // and the array out must be allocated as double[n]. The arrays in and out
-// may coincide, allocated as Complex[n/2+1]. 
+// may coincide, allocated as Complex[n/2+1].
 //
 // Out-of-place usage (input destroyed):
 //
@@ -981,35 +2381,43 @@ public:
 //
 //   crfft1d Backward(n);
 //   Backward.fft(in);
-// 
+//
 // Notes:
 //   in contains the first n/2+1 Complex Fourier values.
 //   out contains the n real values stored as a Complex array;
 //
-class crfft1d : public fftw, public Threadtable<keytype1,keyless1> {
+template<class Real>
+class crfft1dT : public fftwT<Real>, public Threadtable<keytype1,keyless1> {
   unsigned int nx;
   static Table threadtable;
-public:  
-  crfft1d(unsigned int nx, double *out=NULL, unsigned int threads=maxthreads) 
-    : fftw(2*(nx/2+1),1,threads,nx), nx(nx) {Setup(out);} 
-  
-  crfft1d(unsigned int nx, Complex *in, double *out=NULL, 
-          unsigned int threads=maxthreads)
-    : fftw(realsize(nx,in,out),1,threads,nx), nx(nx) {Setup(in,out);} 
-  
+public:
+  FFTWPP_TYPES(Real)
+
+  crfft1dT(unsigned int nx, Real *out=NULL,
+           unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*(nx/2+1),1,threads,nx), nx(nx) {this->Setup(out);}
+
+  crfft1dT(unsigned int nx, Complex *in, Real *out=NULL,
+           unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(realsize(nx,in,out),1,threads,nx), nx(nx) {
+    this->Setup(in,out);
+  }
+
   threaddata lookup(bool inplace, unsigned int threads) {
     return Lookup(threadtable,keytype1(nx,threads,inplace));
   }
-  void store(bool inplace, const threaddata& data) {
-    Store(threadtable,keytype1(nx,data.threads,inplace),data);
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype1(nx,threads,inplace),data);
   }
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
-    return fftw_plan_dft_c2r_1d(nx,(fftw_complex *) in,(double *) out,effort);
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_dft_c2r_1d(nx,(fftwcomplex *) in,(Real *) out,
+                                   this->effort);
   }
-  
+
   void Execute(Complex *in, Complex *out, bool=false) {
-    fftw_execute_dft_c2r(plan,(fftw_complex *) in,(double *) out);
+    Traits::execute_dft_c2r(this->plan,(fftwcomplex *) in,(Real *) out);
   }
 };
 
@@ -1019,7 +2427,7 @@ public:
 // Complex[M*(n/2+1)]. The arrays in and out may coincide,
 // allocated as Complex[M*(n/2+1)].
 //
-// Out-of-place usage: 
+// Out-of-place usage:
 //
 //   mrcfft1d Forward(n,M,istride,ostride,idist,odist,in,out);
 //   Forward.fft(in,out);
@@ -1028,7 +2436,7 @@ public:
 //
 //   mrcfft1d Forward(n,M,istride,ostride,idist,odist);
 //   Forward.fft(out);
-// 
+//
 // Notes:
 //   istride is the spacing between the elements of each real vector;
 //   ostride is the spacing between the elements of each Complex vector;
@@ -1037,38 +2445,48 @@ public:
 //   in contains the n real values stored as a Complex array;
 //   out contains the first n/2+1 Complex Fourier values.
 //
-class mrcfft1d : public fftwblock<double,fftw_complex>,
-                 public Threadtable<keytype3,keyless3> {
+template<class Real>
+class mrcfft1dT : public fftwblock<Real,Real,
+                                   typename fftwTraits<Real>::complex>,
+                  public Threadtable<keytype3,keyless3> {
   static Table threadtable;
 public:
-  mrcfft1d(unsigned int nx, unsigned int M,
-           size_t istride, size_t ostride,
-           size_t idist, size_t odist,
-           double *in=NULL, Complex *out=NULL,
-           unsigned int threads=maxthreads) 
-    : fftw(std::max((realsize(nx,in,out)-2)*istride+(M-1)*idist+2,
-                    2*(nx/2*ostride+(M-1)*odist+1)),-1,threads,nx),
-      fftwblock<double,fftw_complex>
+  FFTWPP_TYPES(Real)
+
+  mrcfft1dT(unsigned int nx, unsigned int M,
+            size_t istride, size_t ostride,
+            size_t idist, size_t odist,
+            Real *in=NULL, Complex *out=NULL,
+            unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(std::max((realsize(nx,in,out)-2)*istride+(M-1)*idist+2,
+                           2*(nx/2*ostride+(M-1)*odist+1)),-1,threads,nx),
+      fftwblock<Real,Real,fftwcomplex>
     (nx,M,istride,ostride,idist,odist,(Complex *) in,out,threads) {}
-  
+
   threaddata lookup(bool inplace, unsigned int threads) {
-    return Lookup(threadtable,keytype3(nx,Q,R,threads,inplace));
+    return Lookup(threadtable,keytype3(this->nx,this->Q,this->R,threads,
+                                       inplace));
   }
-  
-  void store(bool inplace, const threaddata& data) {
-    Store(threadtable,keytype3(nx,Q,R,data.threads,inplace),data);
+
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype3(this->nx,this->Q,this->R,threads,inplace),
+          data);
   }
-  
+
   void Normalize(Complex *out) {
-    fftw::Normalize<Complex>(nx/2+1,M,ostride,odist,out);
+    fftwT<Real>::Normalize(this->nx/2+1,this->M,this->ostride,this->odist,
+                           out);
   }
-  
-  void fftNormalized(double *in, Complex *out=NULL, bool shift=false) {
-    fftw::fftNormalized<double,Complex>(nx/2+1,M,ostride,odist,in,out,false);
+
+  void fftNormalized(Real *in, Complex *out=NULL, bool shift=false) {
+    fftwT<Real>::fftNormalized(this->nx/2+1,this->M,this->ostride,
+                               this->odist,in,out,false);
   }
-  
-  void fft0Normalized(double *in, Complex *out=NULL) {
-    fftw::fftNormalized<double,Complex>(nx/2+1,M,ostride,odist,in,out,true);
+
+  void fft0Normalized(Real *in, Complex *out=NULL) {
+    fftwT<Real>::fftNormalized(this->nx/2+1,this->M,this->ostride,
+                               this->odist,in,out,true);
   }
 };
 
@@ -1077,7 +2495,7 @@ public:
 // spectra, using phase sign +1. Before calling fft(), the array in must be
 // allocated as Complex[M*(n/2+1)] and the array out must be allocated as
 // double[M*n]. The arrays in and out may coincide,
-// allocated as Complex[M*(n/2+1)].  
+// allocated as Complex[M*(n/2+1)].
 //
 // Out-of-place usage (input destroyed):
 //
@@ -1088,51 +2506,61 @@ public:
 //
 //   mcrfft1d Backward(n,M,istride,ostride,idist,odist);
 //   Backward.fft(out);
-// 
+//
 // Notes:
 //   stride is the spacing between the elements of each Complex vector;
 //   dist is the spacing between the first elements of the vectors;
 //   in contains the first n/2+1 Complex Fourier values;
 //   out contains the n real values stored as a Complex array.
 //
-class mcrfft1d : public fftwblock<fftw_complex,double>,
-                 public Threadtable<keytype3,keyless3> {
+template<class Real>
+class mcrfft1dT : public fftwblock<Real,typename fftwTraits<Real>::complex,
+                                   Real>,
+                  public Threadtable<keytype3,keyless3> {
   static Table threadtable;
 public:
-  mcrfft1d(unsigned int nx, unsigned int M, size_t istride, size_t ostride,
-           size_t idist, size_t odist, Complex *in=NULL, double *out=NULL,
-           unsigned int threads=maxthreads) 
-    : fftw(std::max(2*(nx/2*istride+(M-1)*idist+1),
-                    (realsize(nx,in,out)-2)*ostride+(M-1)*odist+2),1,threads,nx),
-      fftwblock<fftw_complex,double>
+  FFTWPP_TYPES(Real)
+
+  mcrfft1dT(unsigned int nx, unsigned int M, size_t istride, size_t ostride,
+            size_t idist, size_t odist, Complex *in=NULL, Real *out=NULL,
+            unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(std::max(2*(nx/2*istride+(M-1)*idist+1),
+                           (realsize(nx,in,out)-2)*ostride+(M-1)*odist+2),1,
+                  threads,nx),
+      fftwblock<Real,fftwcomplex,Real>
     (nx,M,istride,ostride,idist,odist,in,(Complex *) out,threads) {}
-  
+
   threaddata lookup(bool inplace, unsigned int threads) {
-    return Lookup(threadtable,keytype3(nx,Q,R,threads,inplace));
+    return Lookup(threadtable,keytype3(this->nx,this->Q,this->R,threads,
+                                       inplace));
   }
-  
-  void store(bool inplace, const threaddata& data) {
-    Store(threadtable,keytype3(nx,Q,R,data.threads,inplace),data);
+
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype3(this->nx,this->Q,this->R,threads,inplace),
+          data);
   }
-  
-  void Normalize(double *out) {
-    fftw::Normalize<double>(nx,M,ostride,odist,out);
+
+  void Normalize(Real *out) {
+    fftwT<Real>::Normalize(this->nx,this->M,this->ostride,this->odist,out);
   }
-  
-  void fftNormalized(Complex *in, double *out=NULL, bool shift=false) {
-    fftw::fftNormalized<Complex,double>(nx,M,ostride,odist,in,out,false);
+
+  void fftNormalized(Complex *in, Real *out=NULL, bool shift=false) {
+    fftwT<Real>::fftNormalized(this->nx,this->M,this->ostride,this->odist,
+                               in,out,false);
   }
-  
-  void fft0Normalized(Complex *in, double *out=NULL) {
-    fftw::fftNormalized<Complex,double>(nx,M,ostride,odist,in,out,true);
+
+  void fft0Normalized(Complex *in, Real *out=NULL) {
+    fftwT<Real>::fftNormalized(this->nx,this->M,this->ostride,this->odist,
+                               in,out,true);
   }
 };
-  
+
 // Compute the complex two-dimensional Fourier transform of nx times ny
 // complex values. Before calling fft(), the arrays in and out (which may
 // coincide) must be allocated as Complex[nx*ny].
 //
-// Out-of-place usage: 
+// Out-of-place usage:
 //
 //   fft2d Forward(nx,ny,-1,in,out);
 //   Forward.fft(in,out);
@@ -1154,38 +2582,44 @@ public:
 // Note:
 //   in[ny*i+j] contains the ny Complex values for each i=0,...,nx-1.
 //
-class fft2d : public fftw, public Threadtable<keytype2,keyless2> {
+template<class Real>
+class fft2dT : public fftwT<Real>, public Threadtable<keytype2,keyless2> {
   unsigned int nx;
   unsigned int ny;
   static Table threadtable;
-public:  
-  fft2d(unsigned int nx, unsigned int ny, int sign, Complex *in=NULL,
-        Complex *out=NULL, unsigned int threads=maxthreads) 
-    : fftw(2*nx*ny,sign,threads), nx(nx), ny(ny) {Setup(in,out);} 
-  
+public:
+  FFTWPP_TYPES(Real)
+
+  fft2dT(unsigned int nx, unsigned int ny, int sign, Complex *in=NULL,
+         Complex *out=NULL, unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*nx*ny,sign,threads), nx(nx), ny(ny) {
+    this->Setup(in,out);
+  }
+
 #ifdef __Array_h__
-  fft2d(int sign, const Array::array2<Complex>& in,
-        const Array::array2<Complex>& out=Array::NULL2, 
-        unsigned int threads=maxthreads) 
-    : fftw(2*in.Size(),sign,threads), nx(in.Nx()), ny(in.Ny()) {
-    Setup(in,out);
+  fft2dT(int sign, const Array::array2<Complex>& in,
+         const Array::array2<Complex>& out=Array::NULL2,
+         unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*in.Size(),sign,threads), nx(in.Nx()), ny(in.Ny()) {
+    this->Setup(in,out);
   }
-#endif  
-  
+#endif
+
   threaddata lookup(bool inplace, unsigned int threads) {
     return this->Lookup(threadtable,keytype2(nx,ny,threads,inplace));
   }
-  void store(bool inplace, const threaddata& data) {
-    this->Store(threadtable,keytype2(nx,ny,data.threads,inplace),data);
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype2(nx,ny,threads,inplace),data);
   }
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
-    return fftw_plan_dft_2d(nx,ny,(fftw_complex *) in,(fftw_complex *) out,
-                            sign,effort);
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_dft_2d(nx,ny,(fftwcomplex *) in,(fftwcomplex *) out,
+                               this->sign,this->effort);
   }
-  
+
   void Execute(Complex *in, Complex *out, bool=false) {
-    fftw_execute_dft(plan,(fftw_complex *) in,(fftw_complex *) out);
+    Traits::execute_dft(this->plan,(fftwcomplex *) in,(fftwcomplex *) out);
   }
 };
 
@@ -1193,9 +2627,9 @@ public:
 // values, using phase sign -1.
 // Before calling fft(), the array in must be allocated as double[nx*ny] and
 // the array out must be allocated as Complex[nx*(ny/2+1)]. The arrays in
-// and out may coincide, allocated as Complex[nx*(ny/2+1)]. 
+// and out may coincide, allocated as Complex[nx*(ny/2+1)].
 //
-// Out-of-place usage: 
+// Out-of-place usage:
 //
 //   rcfft2d Forward(nx,ny,in,out);
 //   Forward.fft(in,out);       // Origin of Fourier domain at (0,0)
@@ -1207,130 +2641,210 @@ public:
 //   rcfft2d Forward(nx,ny);
 //   Forward.fft(in);           // Origin of Fourier domain at (0,0)
 //   Forward.fft0(in);          // Origin of Fourier domain at (nx/2,0)
-// 
+//
 // Notes:
 //   in contains the nx*ny real values stored as a Complex array;
 //   out contains the upper-half portion (ky >= 0) of the Complex transform.
 //
-class rcfft2d : public fftw {
+template<class Real>
+class rcfft2dT : public fftwT<Real>, public Threadtable<keytype2,keyless2> {
   unsigned int nx;
   unsigned int ny;
-public:  
-  rcfft2d(unsigned int nx, unsigned int ny, Complex *out=NULL,
-          unsigned int threads=maxthreads) 
-    : fftw(2*nx*(ny/2+1),-1,threads,nx*ny), nx(nx), ny(ny) {Setup(out);} 
-  
-  rcfft2d(unsigned int nx, unsigned int ny, double *in, Complex *out=NULL,
-          unsigned int threads=maxthreads) 
-    : fftw(2*nx*(ny/2+1),-1,threads,nx*ny), nx(nx), ny(ny) {
-    Setup(in,out);
-  } 
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
-    return fftw_plan_dft_r2c_2d(nx,ny,(double *) in,(fftw_complex *) out,
-                                effort);
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  rcfft2dT(unsigned int nx, unsigned int ny, Complex *out=NULL,
+           unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*nx*(ny/2+1),-1,threads,nx*ny), nx(nx), ny(ny) {
+    this->Setup(out);
   }
-  
+
+  rcfft2dT(unsigned int nx, unsigned int ny, Real *in, Complex *out=NULL,
+           unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*nx*(ny/2+1),-1,threads,nx*ny), nx(nx), ny(ny) {
+    this->Setup(in,out);
+  }
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return this->Lookup(threadtable,keytype2(nx,ny,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype2(nx,ny,threads,inplace),data);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_dft_r2c_2d(nx,ny,(Real *) in,(fftwcomplex *) out,
+                                   this->effort);
+  }
+
   void Execute(Complex *in, Complex *out, bool shift=false) {
-    if(shift) {
-      if(inplace) Shift(in,nx,ny,threads);
-      else Shift((double *) in,nx,ny,threads);
+    if(shift) Execute0(in,out);
+    else Traits::execute_dft_r2c(this->plan,(Real *) in,(fftwcomplex *) out);
+  }
+
+  // Execute with the origin of the Fourier domain shifted, scaling the
+  // result. For even sizes the input is shifted by negating alternate rows;
+  // otherwise the rows of the output are translated.
+  void Execute0(Complex *in, Complex *out, Real scale=1.0) {
+    if(nx % 2 == 0) {
+      if(this->inplace) this->Shift(in,nx,ny,this->threads,scale);
+      else this->Shift((Real *) in,nx,ny,this->threads,scale);
+      Traits::execute_dft_r2c(this->plan,(Real *) in,(fftwcomplex *) out);
+    } else {
+      Traits::execute_dft_r2c(this->plan,(Real *) in,(fftwcomplex *) out);
+      this->Translate(out,nx,1,ny/2+1,nx/2,0,this->threads,scale);
     }
-    fftw_execute_dft_r2c(plan,(double *) in,(fftw_complex *) out);
   }
-  
+
+  using fftwT<Real>::fftNormalized;
+
+  // Fold the normalization into the shift.
+  void fftNormalized(Complex *in, Complex *out=NULL, bool shift=false) {
+    if(!shift) {
+      fftwT<Real>::fftNormalized(in,out);
+      return;
+    }
+    out=this->Setout(in,out);
+    Execute0(in,out,this->norm);
+  }
+
   // Set Nyquist modes of even shifted transforms to zero.
   void deNyquist(Complex *f) {
     unsigned int nyp=ny/2+1;
     if(nx % 2 == 0)
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int j=0; j < nyp; ++j)
         f[j]=0.0;
     if(ny % 2 == 0)
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int i=0; i < nx; ++i)
         f[(i+1)*nyp-1]=0.0;
   }
 };
-  
+
 // Compute the real two-dimensional inverse Fourier transform of the
 // nx*(ny/2+1) Complex values corresponding to the spectral values in the
 // half-plane ky >= 0, using phase sign +1.
 // Before calling fft(), the array in must be allocated as
 // Complex[nx*(ny/2+1)] and the array out must be allocated as
 // double[nx*ny]. The arrays in and out may coincide,
-// allocated as Complex[nx*(ny/2+1)]. 
+// allocated as Complex[nx*(ny/2+1)].
 //
 // Out-of-place usage (input destroyed):
 //
 //   crfft2d Backward(nx,ny,in,out);
 //   Backward.fft(in,out);      // Origin of Fourier domain at (0,0)
 //   Backward.fft0(in,out);     // Origin of Fourier domain at (nx/2,0)
+//   Backward.fft0Normalized(in,out); // Shifted and normalized in one pass
 //
 // In-place usage:
 //
 //   crfft2d Backward(nx,ny);
 //   Backward.fft(in);          // Origin of Fourier domain at (0,0)
 //   Backward.fft0(in);         // Origin of Fourier domain at (nx/2,0)
-// 
+//
 // Notes:
 //   in contains the upper-half portion (ky >= 0) of the Complex transform;
 //   out contains the nx*ny real values stored as a Complex array.
 //
-class crfft2d : public fftw {
+template<class Real>
+class crfft2dT : public fftwT<Real>, public Threadtable<keytype2,keyless2> {
   unsigned int nx;
   unsigned int ny;
-public:  
-  crfft2d(unsigned int nx, unsigned int ny, double *out=NULL,
-          unsigned int threads=maxthreads) :
-    fftw(2*nx*(ny/2+1),1,threads,nx*ny), nx(nx), ny(ny) {Setup(out);} 
-  
-  crfft2d(unsigned int nx, unsigned int ny, Complex *in, double *out=NULL,
-          unsigned int threads=maxthreads)
-    : fftw(nx*realsize(ny,in,out),1,threads,nx*ny), nx(nx), ny(ny) {
-    Setup(in,out);
-  } 
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
-    return fftw_plan_dft_c2r_2d(nx,ny,(fftw_complex *) in,(double *) out,
-                                effort);
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  crfft2dT(unsigned int nx, unsigned int ny, Real *out=NULL,
+           unsigned int threads=fftwbase::maxthreads) :
+    fftwT<Real>(2*nx*(ny/2+1),1,threads,nx*ny), nx(nx), ny(ny) {
+    this->Setup(out);
   }
-  
+
+  crfft2dT(unsigned int nx, unsigned int ny, Complex *in, Real *out=NULL,
+           unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(nx*realsize(ny,in,out),1,threads,nx*ny), nx(nx), ny(ny) {
+    this->Setup(in,out);
+  }
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return this->Lookup(threadtable,keytype2(nx,ny,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype2(nx,ny,threads,inplace),data);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_dft_c2r_2d(nx,ny,(fftwcomplex *) in,(Real *) out,
+                                   this->effort);
+  }
+
   void Execute(Complex *in, Complex *out, bool shift=false) {
-    fftw_execute_dft_c2r(plan,(fftw_complex *) in,(double *) out);
-    if(shift) {
-      if(inplace) Shift(out,nx,ny,threads);
-      else Shift((double *) out,nx,ny,threads);
+    if(shift) Execute0(in,out);
+    else Traits::execute_dft_c2r(this->plan,(fftwcomplex *) in,(Real *) out);
+  }
+
+  // Execute with the origin of the Fourier domain shifted, scaling the
+  // result. For even sizes alternate rows of the output are negated;
+  // otherwise the rows of the input are translated.
+  void Execute0(Complex *in, Complex *out, Real scale=1.0) {
+    if(nx % 2 == 0) {
+      Traits::execute_dft_c2r(this->plan,(fftwcomplex *) in,(Real *) out);
+      if(this->inplace) this->Shift(out,nx,ny,this->threads,scale);
+      else this->Shift((Real *) out,nx,ny,this->threads,scale);
+    } else {
+      this->Translate(in,nx,1,ny/2+1,nx-nx/2,0,this->threads,scale);
+      Traits::execute_dft_c2r(this->plan,(fftwcomplex *) in,(Real *) out);
     }
   }
-  
+
+  using fftwT<Real>::fftNormalized;
+
+  // Fold the normalization into the shift.
+  void fftNormalized(Complex *in, Complex *out=NULL, bool shift=false) {
+    if(!shift) {
+      fftwT<Real>::fftNormalized(in,out);
+      return;
+    }
+    out=this->Setout(in,out);
+    Execute0(in,out,this->norm);
+  }
+
+  void fftNormalized(Complex *in, Real *out, bool shift=false) {
+    if(shift) fftNormalized(in,(Complex *) out,true);
+    else fftwT<Real>::fftNormalized(in,out);
+  }
+
   // Set Nyquist modes of even shifted transforms to zero.
   void deNyquist(Complex *f) {
     unsigned int nyp=ny/2+1;
     if(nx % 2 == 0)
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int j=0; j < nyp; ++j)
         f[j]=0.0;
     if(ny % 2 == 0)
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int i=0; i < nx; ++i)
         f[(i+1)*nyp-1]=0.0;
   }
 };
 
-// Compute the complex three-dimensional Fourier transform of 
+// Compute the complex three-dimensional Fourier transform of
 // nx times ny times nz complex values. Before calling fft(), the arrays in
 // and out (which may coincide) must be allocated as Complex[nx*ny*nz].
 //
-// Out-of-place usage: 
+// Out-of-place usage:
 //
 //   fft3d Forward(nx,ny,nz,-1,in,out);
 //   Forward.fft(in,out);
@@ -1353,27 +2867,41 @@ public:
 //   in[nz*(ny*i+j)+k] contains the (i,j,k)th Complex value,
 //   indexed by i=0,...,nx-1, j=0,...,ny-1, and k=0,...,nz-1.
 //
-class fft3d : public fftw {
+template<class Real>
+class fft3dT : public fftwT<Real>, public Threadtable<keytype3,keyless3> {
   unsigned int nx;
   unsigned int ny;
   unsigned int nz;
-public:  
-  fft3d(unsigned int nx, unsigned int ny, unsigned int nz,
-        int sign, Complex *in=NULL, Complex *out=NULL,
-        unsigned int threads=maxthreads) 
-    : fftw(2*nx*ny*nz,sign,threads), nx(nx), ny(ny), nz(nz) {Setup(in,out);} 
-  
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  fft3dT(unsigned int nx, unsigned int ny, unsigned int nz,
+         int sign, Complex *in=NULL, Complex *out=NULL,
+         unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*nx*ny*nz,sign,threads), nx(nx), ny(ny), nz(nz) {
+    this->Setup(in,out);
+  }
+
 #ifdef __Array_h__
-  fft3d(int sign, const Array::array3<Complex>& in,
-        const Array::array3<Complex>& out=Array::NULL3,
-        unsigned int threads=maxthreads) 
-    : fftw(2*in.Size(),sign,threads), nx(in.Nx()), ny(in.Ny()), nz(in.Nz()) 
-  {Setup(in,out);}
-#endif  
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
-    return fftw_plan_dft_3d(nx,ny,nz,(fftw_complex *) in,
-                            (fftw_complex *) out, sign, effort);
+  fft3dT(int sign, const Array::array3<Complex>& in,
+         const Array::array3<Complex>& out=Array::NULL3,
+         unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*in.Size(),sign,threads), nx(in.Nx()), ny(in.Ny()),
+      nz(in.Nz()) {this->Setup(in,out);}
+#endif
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return this->Lookup(threadtable,keytype3(nx,ny,nz,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype3(nx,ny,nz,threads,inplace),data);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_dft_3d(nx,ny,nz,(fftwcomplex *) in,
+                               (fftwcomplex *) out,this->sign,this->effort);
   }
 };
 
@@ -1381,9 +2909,9 @@ public:
 // nx times ny times nz real values, using phase sign -1.
 // Before calling fft(), the array in must be allocated as double[nx*ny*nz]
 // and the array out must be allocated as Complex[nx*ny*(nz/2+1)]. The
-// arrays in and out may coincide, allocated as Complex[nx*ny*(nz/2+1)]. 
+// arrays in and out may coincide, allocated as Complex[nx*ny*(nz/2+1)].
 //
-// Out-of-place usage: 
+// Out-of-place usage:
 //
 //   rcfft3d Forward(nx,ny,nz,in,out);
 //   Forward.fft(in,out);       // Origin of Fourier domain at (0,0)
@@ -1394,55 +2922,91 @@ public:
 //   rcfft3d Forward(nx,ny,nz);
 //   Forward.fft(in);           // Origin of Fourier domain at (0,0)
 //   Forward.fft0(in);          // Origin of Fourier domain at (nx/2,ny/2,0)
-// 
+//
 // Notes:
 //   in contains the nx*ny*nz real values stored as a Complex array;
 //   out contains the upper-half portion (kz >= 0) of the Complex transform.
 //
-class rcfft3d : public fftw {
+template<class Real>
+class rcfft3dT : public fftwT<Real>, public Threadtable<keytype3,keyless3> {
   unsigned int nx;
   unsigned int ny;
   unsigned int nz;
-public:  
-  rcfft3d(unsigned int nx, unsigned int ny, unsigned int nz, Complex *out=NULL,
-          unsigned int threads=maxthreads)
-    : fftw(2*nx*ny*(nz/2+1),-1,threads,nx*ny*nz), nx(nx), ny(ny), nz(nz) {
-    Setup(out);
-  } 
-  
-  rcfft3d(unsigned int nx, unsigned int ny, unsigned int nz, double *in,
-          Complex *out=NULL, unsigned int threads=maxthreads) 
-    : fftw(2*nx*ny*(nz/2+1),-1,threads,nx*ny*nz),
-      nx(nx), ny(ny), nz(nz) {Setup(in,out);} 
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
-    return fftw_plan_dft_r2c_3d(nx,ny,nz,(double *) in,(fftw_complex *) out,
-                                effort);
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  rcfft3dT(unsigned int nx, unsigned int ny, unsigned int nz,
+           Complex *out=NULL, unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*nx*ny*(nz/2+1),-1,threads,nx*ny*nz), nx(nx), ny(ny),
+      nz(nz) {
+    this->Setup(out);
   }
-  
+
+  rcfft3dT(unsigned int nx, unsigned int ny, unsigned int nz, Real *in,
+           Complex *out=NULL, unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*nx*ny*(nz/2+1),-1,threads,nx*ny*nz),
+      nx(nx), ny(ny), nz(nz) {this->Setup(in,out);}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return this->Lookup(threadtable,keytype3(nx,ny,nz,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype3(nx,ny,nz,threads,inplace),data);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_dft_r2c_3d(nx,ny,nz,(Real *) in,(fftwcomplex *) out,
+                                   this->effort);
+  }
+
   void Execute(Complex *in, Complex *out, bool shift=false) {
-    if(shift) {
-      if(inplace) Shift(in,nx,ny,nz,threads);
-      else Shift((double *) in,nx,ny,nz,threads);
+    if(shift) Execute0(in,out);
+    else Traits::execute_dft_r2c(this->plan,(Real *) in,(fftwcomplex *) out);
+  }
+
+  // Execute with the origin of the Fourier domain shifted, scaling the
+  // result. For even sizes the input is shifted by negating alternate rows;
+  // otherwise the rows of the output are translated.
+  void Execute0(Complex *in, Complex *out, Real scale=1.0) {
+    if(nx % 2 == 0 && ny % 2 == 0) {
+      if(this->inplace) this->Shift(in,nx,ny,nz,this->threads,scale);
+      else this->Shift((Real *) in,nx,ny,nz,this->threads,scale);
+      Traits::execute_dft_r2c(this->plan,(Real *) in,(fftwcomplex *) out);
+    } else {
+      Traits::execute_dft_r2c(this->plan,(Real *) in,(fftwcomplex *) out);
+      this->Translate(out,nx,ny,nz/2+1,nx/2,ny/2,this->threads,scale);
     }
-    fftw_execute_dft_r2c(plan,(double *) in,(fftw_complex *) out);
   }
-  
+
+  using fftwT<Real>::fftNormalized;
+
+  // Fold the normalization into the shift.
+  void fftNormalized(Complex *in, Complex *out=NULL, bool shift=false) {
+    if(!shift) {
+      fftwT<Real>::fftNormalized(in,out);
+      return;
+    }
+    out=this->Setout(in,out);
+    Execute0(in,out,this->norm);
+  }
+
   // Set Nyquist modes of even shifted transforms to zero.
   void deNyquist(Complex *f) {
     unsigned int nzp=nz/2+1;
     unsigned int yz=ny*nzp;
     if(nx % 2 == 0) {
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int k=0; k < yz; ++k)
         f[k]=0.0;
     }
-    
+
     if(ny % 2 == 0) {
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int i=0; i < nx; ++i) {
         unsigned int iyz=i*yz;
@@ -1450,84 +3014,125 @@ public:
           f[iyz+k]=0.0;
       }
     }
-        
+
     if(nz % 2 == 0)
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int i=0; i < nx; ++i)
         for(unsigned int j=0; j < ny; ++j)
           f[i*yz+(j+1)*nzp-1]=0.0;
   }
 };
-  
+
 // Compute the real two-dimensional inverse Fourier transform of the
 // nx*ny*(nz/2+1) Complex values corresponding to the spectral values in the
 // half-plane kz >= 0, using phase sign +1.
 // Before calling fft(), the array in must be allocated as
 // Complex[nx*ny*(nz+1)/2] and the array out must be allocated as
 // double[nx*ny*nz]. The arrays in and out may coincide,
-// allocated as Complex[nx*ny*(nz/2+1)]. 
+// allocated as Complex[nx*ny*(nz/2+1)].
 //
 // Out-of-place usage (input destroyed):
 //
 //   crfft3d Backward(nx,ny,nz,in,out);
 //   Backward.fft(in,out);      // Origin of Fourier domain at (0,0)
 //   Backward.fft0(in,out);     // Origin of Fourier domain at (nx/2,ny/2,0)
+//   Backward.fft0Normalized(in,out); // Shifted and normalized in one pass
 //
 // In-place usage:
 //
 //   crfft3d Backward(nx,ny,nz);
 //   Backward.fft(in);          // Origin of Fourier domain at (0,0)
 //   Backward.fft0(in);         // Origin of Fourier domain at (nx/2,ny/2,0)
-// 
+//
 // Notes:
 //   in contains the upper-half portion (kz >= 0) of the Complex transform;
 //   out contains the nx*ny*nz real values stored as a Complex array.
 //
-class crfft3d : public fftw {
+template<class Real>
+class crfft3dT : public fftwT<Real>, public Threadtable<keytype3,keyless3> {
   unsigned int nx;
   unsigned int ny;
   unsigned int nz;
-public:  
-  crfft3d(unsigned int nx, unsigned int ny, unsigned int nz, double *out=NULL,
-          unsigned int threads=maxthreads) 
-    : fftw(2*nx*ny*(nz/2+1),1,threads,nx*ny*nz), nx(nx), ny(ny), nz(nz)
-  {Setup(out);} 
-  
-  crfft3d(unsigned int nx, unsigned int ny, unsigned int nz, Complex *in,
-          double *out=NULL, unsigned int threads=maxthreads) 
-    : fftw(nx*ny*(realsize(nz,in,out)),1,threads,nx*ny*nz), nx(nx), ny(ny),
-      nz(nz) {Setup(in,out);} 
-  
-  fftw_plan Plan(Complex *in, Complex *out) {
-    return fftw_plan_dft_c2r_3d(nx,ny,nz,(fftw_complex *) in,(double *) out,
-                                effort);
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  crfft3dT(unsigned int nx, unsigned int ny, unsigned int nz, Real *out=NULL,
+           unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(2*nx*ny*(nz/2+1),1,threads,nx*ny*nz), nx(nx), ny(ny),
+      nz(nz) {this->Setup(out);}
+
+  crfft3dT(unsigned int nx, unsigned int ny, unsigned int nz, Complex *in,
+           Real *out=NULL, unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(nx*ny*(realsize(nz,in,out)),1,threads,nx*ny*nz), nx(nx),
+      ny(ny), nz(nz) {this->Setup(in,out);}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return this->Lookup(threadtable,keytype3(nx,ny,nz,threads,inplace));
   }
-  
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype3(nx,ny,nz,threads,inplace),data);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_dft_c2r_3d(nx,ny,nz,(fftwcomplex *) in,(Real *) out,
+                                   this->effort);
+  }
+
   void Execute(Complex *in, Complex *out, bool shift=false) {
-    fftw_execute_dft_c2r(plan,(fftw_complex *) in,(double *) out);
-    if(shift) {
-      if(inplace) Shift(out,nx,ny,nz,threads);
-      else Shift((double *) out,nx,ny,nz,threads);
-    }
+    if(shift) Execute0(in,out);
+    else Traits::execute_dft_c2r(this->plan,(fftwcomplex *) in,(Real *) out);
   }
-  
+
+  // Execute with the origin of the Fourier domain shifted, scaling the
+  // result. For even sizes alternate rows of the output are negated;
+  // otherwise the rows of the input are translated.
+  void Execute0(Complex *in, Complex *out, Real scale=1.0) {
+    if(nx % 2 == 0 && ny % 2 == 0) {
+      Traits::execute_dft_c2r(this->plan,(fftwcomplex *) in,(Real *) out);
+      if(this->inplace) this->Shift(out,nx,ny,nz,this->threads,scale);
+      else this->Shift((Real *) out,nx,ny,nz,this->threads,scale);
+    } else {
+      this->Translate(in,nx,ny,nz/2+1,nx-nx/2,ny-ny/2,this->threads,scale);
+      Traits::execute_dft_c2r(this->plan,(fftwcomplex *) in,(Real *) out);
+    }
+  }
+
+  using fftwT<Real>::fftNormalized;
+
+  // Fold the normalization into the shift.
+  void fftNormalized(Complex *in, Complex *out=NULL, bool shift=false) {
+    if(!shift) {
+      fftwT<Real>::fftNormalized(in,out);
+      return;
+    }
+    out=this->Setout(in,out);
+    Execute0(in,out,this->norm);
+  }
+
+  void fftNormalized(Complex *in, Real *out, bool shift=false) {
+    if(shift) fftNormalized(in,(Complex *) out,true);
+    else fftwT<Real>::fftNormalized(in,out);
+  }
+
   // Set Nyquist modes of even shifted transforms to zero.
   void deNyquist(Complex *f) {
     unsigned int nzp=nz/2+1;
     unsigned int yz=ny*nzp;
     if(nx % 2 == 0) {
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int k=0; k < yz; ++k)
         f[k]=0.0;
     }
-    
+
     if(ny % 2 == 0) {
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int i=0; i < nx; ++i) {
         unsigned int iyz=i*yz;
@@ -1535,10 +3140,10 @@ public:
           f[iyz+k]=0.0;
       }
     }
-        
+
     if(nz % 2 == 0)
 #ifndef FFTWPP_SINGLE_THREAD
-#pragma omp parallel for num_threads(threads)
+#pragma omp parallel for num_threads(this->threads)
 #endif
       for(unsigned int i=0; i < nx; ++i)
         for(unsigned int j=0; j < ny; ++j)
@@ -1546,6 +3151,685 @@ public:
   }
 };
 
+// Compute the complex two-dimensional Fourier transforms of M arrays, each
+// of nx times ny complex values.
+// Before calling fft(), the arrays in and out (which may coincide) must be
+// allocated as Complex[M*nx*ny] (for unit stride and the default dist).
+//
+// Out-of-place usage:
+//
+//   mfft2d Forward(nx,ny,-1,M,stride,dist,in,out);
+//   Forward.fft(in,out);
+//
+// In-place usage:
+//
+//   mfft2d Forward(nx,ny,-1,M,stride,dist);
+//   Forward.fft(in);
+//
+// Notes:
+//   stride is the spacing between the elements of each Complex array;
+//   dist is the spacing between the first elements of the arrays;
+//   element (i,j) of array m is stored in in[m*dist+(ny*i+j)*stride].
+//
+template<class Real>
+class mfft2dT : public fftwblock<Real,typename fftwTraits<Real>::complex,
+                                 typename fftwTraits<Real>::complex>,
+                public Threadtable<keytype4,keyless4> {
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  mfft2dT(unsigned int nx, unsigned int ny, int sign, unsigned int M=1,
+          size_t stride=1, size_t dist=0, Complex *in=NULL,
+          Complex *out=NULL, unsigned int threads=fftwbase::maxthreads) :
+    fftwT<Real>(2*((nx*ny-1)*stride+
+                   (M-1)*fftwbase::Dist(nx*ny,stride,dist)+1),
+                sign,threads,nx*ny),
+    fftwblock<Real,fftwcomplex,fftwcomplex>
+    (2,nx,ny,1,M,stride,stride,dist,dist,in,out,threads) {}
+
+  mfft2dT(unsigned int nx, unsigned int ny, int sign, unsigned int M,
+          size_t istride, size_t ostride, size_t idist, size_t odist,
+          Complex *in=NULL, Complex *out=NULL,
+          unsigned int threads=fftwbase::maxthreads):
+    fftwT<Real>(std::max(2*((nx*ny-1)*istride+
+                            (M-1)*fftwbase::Dist(nx*ny,istride,idist)+1),
+                         2*((nx*ny-1)*ostride+
+                            (M-1)*fftwbase::Dist(nx*ny,ostride,odist)+1)),
+                sign,threads,nx*ny),
+    fftwblock<Real,fftwcomplex,fftwcomplex>(2,nx,ny,1,M,istride,ostride,
+                                            idist,odist,in,out,threads) {}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return Lookup(threadtable,keytype4(this->n[0],this->n[1],this->Q,this->R,
+                                       threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype4(this->n[0],this->n[1],this->Q,this->R,threads,
+                               inplace),data);
+  }
+};
+
+// Compute the complex three-dimensional Fourier transforms of M arrays,
+// each of nx times ny times nz complex values.
+// Before calling fft(), the arrays in and out (which may coincide) must be
+// allocated as Complex[M*nx*ny*nz] (for unit stride and the default dist).
+//
+// Out-of-place usage:
+//
+//   mfft3d Forward(nx,ny,nz,-1,M,stride,dist,in,out);
+//   Forward.fft(in,out);
+//
+// In-place usage:
+//
+//   mfft3d Forward(nx,ny,nz,-1,M,stride,dist);
+//   Forward.fft(in);
+//
+// Notes:
+//   stride is the spacing between the elements of each Complex array;
+//   dist is the spacing between the first elements of the arrays;
+//   element (i,j,k) of array m is stored in in[m*dist+(nz*(ny*i+j)+k)*stride].
+//
+template<class Real>
+class mfft3dT : public fftwblock<Real,typename fftwTraits<Real>::complex,
+                                 typename fftwTraits<Real>::complex>,
+                public Threadtable<keytype5,keyless5> {
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  mfft3dT(unsigned int nx, unsigned int ny, unsigned int nz, int sign,
+          unsigned int M=1, size_t stride=1, size_t dist=0,
+          Complex *in=NULL, Complex *out=NULL,
+          unsigned int threads=fftwbase::maxthreads) :
+    fftwT<Real>(2*((nx*ny*nz-1)*stride+
+                   (M-1)*fftwbase::Dist(nx*ny*nz,stride,dist)+1),
+                sign,threads,nx*ny*nz),
+    fftwblock<Real,fftwcomplex,fftwcomplex>
+    (3,nx,ny,nz,M,stride,stride,dist,dist,in,out,threads) {}
+
+  mfft3dT(unsigned int nx, unsigned int ny, unsigned int nz, int sign,
+          unsigned int M, size_t istride, size_t ostride,
+          size_t idist, size_t odist, Complex *in=NULL, Complex *out=NULL,
+          unsigned int threads=fftwbase::maxthreads):
+    fftwT<Real>(std::max(2*((nx*ny*nz-1)*istride+
+                            (M-1)*fftwbase::Dist(nx*ny*nz,istride,idist)+1),
+                         2*((nx*ny*nz-1)*ostride+
+                            (M-1)*fftwbase::Dist(nx*ny*nz,ostride,odist)+1)),
+                sign,threads,nx*ny*nz),
+    fftwblock<Real,fftwcomplex,fftwcomplex>(3,nx,ny,nz,M,istride,ostride,
+                                            idist,odist,in,out,threads) {}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return Lookup(threadtable,keytype5(this->n[0],this->n[1],this->n[2],
+                                       this->Q,this->R,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype5(this->n[0],this->n[1],this->n[2],
+                               this->Q,this->R,threads,inplace),data);
+  }
+};
+
+// Compute the two-dimensional real Fourier transforms of M real arrays,
+// each of nx times ny values, using phase sign -1.
+// Before calling fft(), the array in must be allocated as double[M*nx*ny]
+// and the array out must be allocated as Complex[M*nx*(ny/2+1)] (for unit
+// strides and dists nx*ny and nx*(ny/2+1)). The arrays in and out may
+// coincide, allocated as Complex[M*nx*(ny/2+1)], in which case each row of
+// the real input is padded to 2*(ny/2+1) values.
+//
+// Out-of-place usage:
+//
+//   mrcfft2d Forward(nx,ny,M,istride,ostride,idist,odist,in,out);
+//   Forward.fft(in,out);
+//
+// In-place usage:
+//
+//   mrcfft2d Forward(nx,ny,M,istride,ostride,idist,odist);
+//   Forward.fft(out);
+//
+// Notes:
+//   istride is the spacing between the elements of each real array;
+//   ostride is the spacing between the elements of each Complex array;
+//   idist is the spacing between the first elements of the real arrays;
+//   odist is the spacing between the first elements of the Complex arrays;
+//   out contains the upper-half portion (ky >= 0) of each Complex transform.
+//
+template<class Real>
+class mrcfft2dT : public fftwblock<Real,Real,
+                                   typename fftwTraits<Real>::complex>,
+                  public Threadtable<keytype4,keyless4> {
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  mrcfft2dT(unsigned int nx, unsigned int ny, unsigned int M,
+            size_t istride, size_t ostride, size_t idist, size_t odist,
+            Real *in=NULL, Complex *out=NULL,
+            unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(std::max((nx*realsize(ny,in,out)-2)*istride+(M-1)*idist+2,
+                           2*((nx*(ny/2+1)-1)*ostride+(M-1)*odist+1)),-1,
+                  threads,nx*ny),
+      fftwblock<Real,Real,fftwcomplex>
+    (2,nx,ny,1,M,istride,ostride,idist,odist,(Complex *) in,out,threads) {}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return Lookup(threadtable,keytype4(this->n[0],this->n[1],this->Q,this->R,
+                                       threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype4(this->n[0],this->n[1],this->Q,this->R,threads,
+                               inplace),data);
+  }
+
+  void Normalize(Complex *out) {
+    fftwT<Real>::Normalize(this->ncomplex(),this->M,this->ostride,this->odist,
+                           out);
+  }
+
+  void fftNormalized(Real *in, Complex *out=NULL, bool shift=false) {
+    fftwT<Real>::fftNormalized(this->ncomplex(),this->M,this->ostride,
+                               this->odist,in,out,false);
+  }
+};
+
+// Compute the two-dimensional real inverse Fourier transforms of M Complex
+// arrays, each of nx times ny/2+1 values corresponding to the half-plane
+// ky >= 0, using phase sign +1.
+// Before calling fft(), the array in must be allocated as
+// Complex[M*nx*(ny/2+1)] and the array out must be allocated as
+// double[M*nx*ny] (for unit strides and dists nx*(ny/2+1) and nx*ny). The
+// arrays in and out may coincide, allocated as Complex[M*nx*(ny/2+1)], in
+// which case each row of the real output is padded to 2*(ny/2+1) values.
+//
+// Out-of-place usage (input destroyed):
+//
+//   mcrfft2d Backward(nx,ny,M,istride,ostride,idist,odist,in,out);
+//   Backward.fft(in,out);
+//
+// In-place usage:
+//
+//   mcrfft2d Backward(nx,ny,M,istride,ostride,idist,odist);
+//   Backward.fft(out);
+//
+// Notes:
+//   istride is the spacing between the elements of each Complex array;
+//   ostride is the spacing between the elements of each real array;
+//   idist is the spacing between the first elements of the Complex arrays;
+//   odist is the spacing between the first elements of the real arrays.
+//
+template<class Real>
+class mcrfft2dT : public fftwblock<Real,typename fftwTraits<Real>::complex,
+                                   Real>,
+                  public Threadtable<keytype4,keyless4> {
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  mcrfft2dT(unsigned int nx, unsigned int ny, unsigned int M,
+            size_t istride, size_t ostride, size_t idist, size_t odist,
+            Complex *in=NULL, Real *out=NULL,
+            unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(std::max(2*((nx*(ny/2+1)-1)*istride+(M-1)*idist+1),
+                           (nx*realsize(ny,in,out)-2)*ostride+(M-1)*odist+2),
+                  1,threads,nx*ny),
+      fftwblock<Real,fftwcomplex,Real>
+    (2,nx,ny,1,M,istride,ostride,idist,odist,in,(Complex *) out,threads) {}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return Lookup(threadtable,keytype4(this->n[0],this->n[1],this->Q,this->R,
+                                       threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype4(this->n[0],this->n[1],this->Q,this->R,threads,
+                               inplace),data);
+  }
+
+  void Normalize(Real *out) {
+    fftwT<Real>::Normalize(this->nreal(),this->M,this->ostride,this->odist,
+                           out);
+  }
+
+  void fftNormalized(Complex *in, Real *out=NULL, bool shift=false) {
+    fftwT<Real>::fftNormalized(this->nreal(),this->M,this->ostride,
+                               this->odist,in,out,false);
+  }
+};
+
+// Compute the three-dimensional real Fourier transforms of M real arrays,
+// each of nx times ny times nz values, using phase sign -1.
+// Before calling fft(), the array in must be allocated as
+// double[M*nx*ny*nz] and the array out must be allocated as
+// Complex[M*nx*ny*(nz/2+1)] (for unit strides and dists nx*ny*nz and
+// nx*ny*(nz/2+1)). The arrays in and out may coincide, allocated as
+// Complex[M*nx*ny*(nz/2+1)], in which case each row of the real input is
+// padded to 2*(nz/2+1) values.
+//
+// Out-of-place usage:
+//
+//   mrcfft3d Forward(nx,ny,nz,M,istride,ostride,idist,odist,in,out);
+//   Forward.fft(in,out);
+//
+// In-place usage:
+//
+//   mrcfft3d Forward(nx,ny,nz,M,istride,ostride,idist,odist);
+//   Forward.fft(out);
+//
+// Notes:
+//   istride is the spacing between the elements of each real array;
+//   ostride is the spacing between the elements of each Complex array;
+//   idist is the spacing between the first elements of the real arrays;
+//   odist is the spacing between the first elements of the Complex arrays;
+//   out contains the upper-half portion (kz >= 0) of each Complex transform.
+//
+template<class Real>
+class mrcfft3dT : public fftwblock<Real,Real,
+                                   typename fftwTraits<Real>::complex>,
+                  public Threadtable<keytype5,keyless5> {
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  mrcfft3dT(unsigned int nx, unsigned int ny, unsigned int nz,
+            unsigned int M, size_t istride, size_t ostride,
+            size_t idist, size_t odist, Real *in=NULL, Complex *out=NULL,
+            unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(std::max((nx*ny*realsize(nz,in,out)-2)*istride+
+                           (M-1)*idist+2,
+                           2*((nx*ny*(nz/2+1)-1)*ostride+(M-1)*odist+1)),-1,
+                  threads,nx*ny*nz),
+      fftwblock<Real,Real,fftwcomplex>
+    (3,nx,ny,nz,M,istride,ostride,idist,odist,(Complex *) in,out,threads) {}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return Lookup(threadtable,keytype5(this->n[0],this->n[1],this->n[2],
+                                       this->Q,this->R,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype5(this->n[0],this->n[1],this->n[2],
+                               this->Q,this->R,threads,inplace),data);
+  }
+
+  void Normalize(Complex *out) {
+    fftwT<Real>::Normalize(this->ncomplex(),this->M,this->ostride,this->odist,
+                           out);
+  }
+
+  void fftNormalized(Real *in, Complex *out=NULL, bool shift=false) {
+    fftwT<Real>::fftNormalized(this->ncomplex(),this->M,this->ostride,
+                               this->odist,in,out,false);
+  }
+};
+
+// Compute the three-dimensional real inverse Fourier transforms of M
+// Complex arrays, each of nx times ny times nz/2+1 values corresponding to
+// the half-space kz >= 0, using phase sign +1.
+// Before calling fft(), the array in must be allocated as
+// Complex[M*nx*ny*(nz/2+1)] and the array out must be allocated as
+// double[M*nx*ny*nz] (for unit strides and dists nx*ny*(nz/2+1) and
+// nx*ny*nz). The arrays in and out may coincide, allocated as
+// Complex[M*nx*ny*(nz/2+1)], in which case each row of the real output is
+// padded to 2*(nz/2+1) values.
+//
+// Out-of-place usage (input destroyed):
+//
+//   mcrfft3d Backward(nx,ny,nz,M,istride,ostride,idist,odist,in,out);
+//   Backward.fft(in,out);
+//
+// In-place usage:
+//
+//   mcrfft3d Backward(nx,ny,nz,M,istride,ostride,idist,odist);
+//   Backward.fft(out);
+//
+// Notes:
+//   istride is the spacing between the elements of each Complex array;
+//   ostride is the spacing between the elements of each real array;
+//   idist is the spacing between the first elements of the Complex arrays;
+//   odist is the spacing between the first elements of the real arrays.
+//
+template<class Real>
+class mcrfft3dT : public fftwblock<Real,typename fftwTraits<Real>::complex,
+                                   Real>,
+                  public Threadtable<keytype5,keyless5> {
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  mcrfft3dT(unsigned int nx, unsigned int ny, unsigned int nz,
+            unsigned int M, size_t istride, size_t ostride,
+            size_t idist, size_t odist, Complex *in=NULL, Real *out=NULL,
+            unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(std::max(2*((nx*ny*(nz/2+1)-1)*istride+(M-1)*idist+1),
+                           (nx*ny*realsize(nz,in,out)-2)*ostride+
+                           (M-1)*odist+2),1,threads,nx*ny*nz),
+      fftwblock<Real,fftwcomplex,Real>
+    (3,nx,ny,nz,M,istride,ostride,idist,odist,in,(Complex *) out,threads) {}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return Lookup(threadtable,keytype5(this->n[0],this->n[1],this->n[2],
+                                       this->Q,this->R,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype5(this->n[0],this->n[1],this->n[2],
+                               this->Q,this->R,threads,inplace),data);
+  }
+
+  void Normalize(Real *out) {
+    fftwT<Real>::Normalize(this->nreal(),this->M,this->ostride,this->odist,
+                           out);
+  }
+
+  void fftNormalized(Complex *in, Real *out=NULL, bool shift=false) {
+    fftwT<Real>::fftNormalized(this->nreal(),this->M,this->ostride,
+                               this->odist,in,out,false);
+  }
+};
+
+// Compute the real-to-real transform of n real values, of the type kind
+// (FFTW_REDFT00, FFTW_REDFT10, FFTW_RODFT11, etc.) described in the FFTW
+// documentation.
+// Before calling fft(), the arrays in and out (which may coincide) must be
+// allocated as double[n].
+//
+// Out-of-place usage:
+//
+//   r2r1d Forward(n,FFTW_REDFT10,in,out);
+//   Forward.fft(in,out);
+//
+//   r2r1d Backward(n,FFTW_REDFT01,in,out);
+//   Backward.fftNormalized(in,out); // True inverse of Forward.fft(out,in);
+//
+// In-place usage:
+//
+//   r2r1d Forward(n,FFTW_REDFT00);
+//   Forward.fft(in);
+//
+// Notes:
+//   fftNormalized divides by the logical size N of the transform:
+//   N=2(n-1) for FFTW_REDFT00, N=2(n+1) for FFTW_RODFT00, N=n for
+//   FFTW_R2HC, FFTW_HC2R, and FFTW_DHT, and N=2n otherwise.
+//
+template<class Real>
+class r2r1dT : public fftwT<Real>, public Threadtable<keytype1,keyless1> {
+  unsigned int nx;
+  fftw_r2r_kind kind;
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  r2r1dT(unsigned int nx, fftw_r2r_kind kind, Real *in=NULL, Real *out=NULL,
+         unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(nx,0,threads,fftwbase::r2rsize(nx,kind)), nx(nx),
+      kind(kind) {this->Setup(in,out);}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return this->Lookup(threadtable,keytype1(nx,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype1(nx,threads,inplace),data);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_r2r_1d(nx,(Real *) in,(Real *) out,kind,
+                               this->effort);
+  }
+
+  void Execute(Complex *in, Complex *out, bool=false) {
+    Traits::execute_r2r(this->plan,(Real *) in,(Real *) out);
+  }
+};
+
+// Compute the real-to-real transforms of M real vectors, each of length n,
+// of the type kind.
+// Before calling fft(), the arrays in and out (which may coincide) must be
+// allocated as double[M*n].
+//
+// Out-of-place usage:
+//
+//   mr2r1d Forward(n,FFTW_REDFT10,M,stride,dist,in,out);
+//   Forward.fft(in,out);
+//
+// In-place usage:
+//
+//   mr2r1d Forward(n,FFTW_REDFT10,M,stride,dist);
+//   Forward.fft(in);
+//
+// Notes:
+//   stride is the spacing between the elements of each vector;
+//   dist is the spacing between the first elements of the vectors;
+//   fftNormalized divides by the logical size of the transform (see r2r1d).
+//
+template<class Real>
+class mr2r1dT : public fftwblock<Real,Real,Real>,
+                public Threadtable<keytype3,keyless3> {
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  mr2r1dT(unsigned int nx, fftw_r2r_kind kind, unsigned int M=1,
+          size_t stride=1, size_t dist=0, Real *in=NULL, Real *out=NULL,
+          unsigned int threads=fftwbase::maxthreads) :
+    fftwT<Real>((nx-1)*stride+(M-1)*fftwbase::Dist(nx,stride,dist)+1,
+                0,threads,fftwbase::r2rsize(nx,kind)),
+    fftwblock<Real,Real,Real>(nx,M,stride,stride,dist,dist,(Complex *) in,
+                              (Complex *) out,threads,kind) {}
+
+  mr2r1dT(unsigned int nx, fftw_r2r_kind kind, unsigned int M,
+          size_t istride, size_t ostride, size_t idist, size_t odist,
+          Real *in=NULL, Real *out=NULL,
+          unsigned int threads=fftwbase::maxthreads):
+    fftwT<Real>(std::max((nx-1)*istride+
+                         (M-1)*fftwbase::Dist(nx,istride,idist)+1,
+                         (nx-1)*ostride+
+                         (M-1)*fftwbase::Dist(nx,ostride,odist)+1),0,
+                threads,fftwbase::r2rsize(nx,kind)),
+    fftwblock<Real,Real,Real>(nx,M,istride,ostride,idist,odist,
+                              (Complex *) in,(Complex *) out,threads,kind) {}
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return Lookup(threadtable,keytype3(this->nx,this->Q,this->R,threads,
+                                       inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    Store(threadtable,keytype3(this->nx,this->Q,this->R,threads,inplace),
+          data);
+  }
+
+  void Normalize(Real *out) {
+    fftwT<Real>::Normalize(this->nx,this->M,this->ostride,this->odist,out);
+  }
+
+  void fftNormalized(Real *in, Real *out=NULL) {
+    fftwT<Real>::fftNormalized(this->nx,this->M,this->ostride,this->odist,
+                               in,out);
+  }
+};
+
+// Compute the two-dimensional real-to-real transform of nx times ny real
+// values, of the type kindx along x and kindy along y.
+// Before calling fft(), the arrays in and out (which may coincide) must be
+// allocated as double[nx*ny].
+//
+// Out-of-place usage:
+//
+//   r2r2d Forward(nx,ny,FFTW_REDFT10,FFTW_REDFT10,in,out);
+//   Forward.fft(in,out);
+//
+// In-place usage:
+//
+//   r2r2d Forward(nx,ny,FFTW_REDFT10,FFTW_REDFT10);
+//   Forward.fft(in);
+//
+// Notes:
+//   in[ny*i+j] contains the (i,j)th value, indexed by i=0,...,nx-1 and
+//   j=0,...,ny-1;
+//   fftNormalized divides by the product of the logical sizes along each
+//   dimension (see r2r1d).
+//
+template<class Real>
+class r2r2dT : public fftwT<Real>, public Threadtable<keytype2,keyless2> {
+  unsigned int nx;
+  unsigned int ny;
+  fftw_r2r_kind kindx,kindy;
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  r2r2dT(unsigned int nx, unsigned int ny, fftw_r2r_kind kindx,
+         fftw_r2r_kind kindy, Real *in=NULL, Real *out=NULL,
+         unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(nx*ny,0,threads,
+                  fftwbase::r2rsize(nx,kindx)*fftwbase::r2rsize(ny,kindy)),
+      nx(nx), ny(ny), kindx(kindx), kindy(kindy) {
+    this->Setup(in,out);
+  }
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return this->Lookup(threadtable,keytype2(nx,ny,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype2(nx,ny,threads,inplace),data);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_r2r_2d(nx,ny,(Real *) in,(Real *) out,kindx,kindy,
+                               this->effort);
+  }
+
+  void Execute(Complex *in, Complex *out, bool=false) {
+    Traits::execute_r2r(this->plan,(Real *) in,(Real *) out);
+  }
+};
+
+// Compute the three-dimensional real-to-real transform of
+// nx times ny times nz real values, of the type kindx along x, kindy
+// along y, and kindz along z.
+// Before calling fft(), the arrays in and out (which may coincide) must be
+// allocated as double[nx*ny*nz].
+//
+// Out-of-place usage:
+//
+//   r2r3d Forward(nx,ny,nz,FFTW_REDFT10,FFTW_REDFT10,FFTW_REDFT10,in,out);
+//   Forward.fft(in,out);
+//
+// In-place usage:
+//
+//   r2r3d Forward(nx,ny,nz,FFTW_REDFT10,FFTW_REDFT10,FFTW_REDFT10);
+//   Forward.fft(in);
+//
+// Notes:
+//   in[nz*(ny*i+j)+k] contains the (i,j,k)th value,
+//   indexed by i=0,...,nx-1, j=0,...,ny-1, and k=0,...,nz-1;
+//   fftNormalized divides by the product of the logical sizes along each
+//   dimension (see r2r1d).
+//
+template<class Real>
+class r2r3dT : public fftwT<Real>, public Threadtable<keytype3,keyless3> {
+  unsigned int nx;
+  unsigned int ny;
+  unsigned int nz;
+  fftw_r2r_kind kindx,kindy,kindz;
+  static Table threadtable;
+public:
+  FFTWPP_TYPES(Real)
+
+  r2r3dT(unsigned int nx, unsigned int ny, unsigned int nz,
+         fftw_r2r_kind kindx, fftw_r2r_kind kindy, fftw_r2r_kind kindz,
+         Real *in=NULL, Real *out=NULL,
+         unsigned int threads=fftwbase::maxthreads)
+    : fftwT<Real>(nx*ny*nz,0,threads,
+                  fftwbase::r2rsize(nx,kindx)*fftwbase::r2rsize(ny,kindy)*
+                  fftwbase::r2rsize(nz,kindz)),
+      nx(nx), ny(ny), nz(nz), kindx(kindx), kindy(kindy), kindz(kindz) {
+    this->Setup(in,out);
+  }
+
+  threaddata lookup(bool inplace, unsigned int threads) {
+    return this->Lookup(threadtable,keytype3(nx,ny,nz,threads,inplace));
+  }
+  void store(bool inplace, unsigned int threads,
+             const threaddata& data) {
+    this->Store(threadtable,keytype3(nx,ny,nz,threads,inplace),data);
+  }
+
+  fftwplan Plan(Complex *in, Complex *out) {
+    return Traits::plan_r2r_3d(nx,ny,nz,(Real *) in,(Real *) out,
+                               kindx,kindy,kindz,this->effort);
+  }
+
+  void Execute(Complex *in, Complex *out, bool=false) {
+    Traits::execute_r2r(this->plan,(Real *) in,(Real *) out);
+  }
+};
+
+// Each transform class has a thread table for each precision.
+#define FFTWPP_THREADTABLE(Class)                               \
+  template<class Real>                                          \
+  typename Class##T<Real>::Table                                \
+  Class##T<Real>::threadtable(fftwTraits<Real>::name(#Class));
+
+FFTWPP_THREADTABLE(fft1d)
+FFTWPP_THREADTABLE(mfft1d)
+FFTWPP_THREADTABLE(rcfft1d)
+FFTWPP_THREADTABLE(crfft1d)
+FFTWPP_THREADTABLE(mrcfft1d)
+FFTWPP_THREADTABLE(mcrfft1d)
+FFTWPP_THREADTABLE(fft2d)
+FFTWPP_THREADTABLE(rcfft2d)
+FFTWPP_THREADTABLE(crfft2d)
+FFTWPP_THREADTABLE(fft3d)
+FFTWPP_THREADTABLE(rcfft3d)
+FFTWPP_THREADTABLE(crfft3d)
+FFTWPP_THREADTABLE(mfft2d)
+FFTWPP_THREADTABLE(mfft3d)
+FFTWPP_THREADTABLE(mrcfft2d)
+FFTWPP_THREADTABLE(mcrfft2d)
+FFTWPP_THREADTABLE(mrcfft3d)
+FFTWPP_THREADTABLE(mcrfft3d)
+FFTWPP_THREADTABLE(r2r1d)
+FFTWPP_THREADTABLE(mr2r1d)
+FFTWPP_THREADTABLE(r2r2d)
+FFTWPP_THREADTABLE(r2r3d)
+
+// The double, float, and long double versions of each transform class.
+#define FFTWPP_PRECISIONS(Class)                \
+  typedef Class##T<double> Class;               \
+  typedef Class##T<float> Class##f;             \
+  typedef Class##T<long double> Class##l;
+
+FFTWPP_PRECISIONS(fft1d)
+FFTWPP_PRECISIONS(mfft1d)
+FFTWPP_PRECISIONS(fft1d4step)
+FFTWPP_PRECISIONS(rcfft1d)
+FFTWPP_PRECISIONS(crfft1d)
+FFTWPP_PRECISIONS(mrcfft1d)
+FFTWPP_PRECISIONS(mcrfft1d)
+FFTWPP_PRECISIONS(fft2d)
+FFTWPP_PRECISIONS(rcfft2d)
+FFTWPP_PRECISIONS(crfft2d)
+FFTWPP_PRECISIONS(fft3d)
+FFTWPP_PRECISIONS(rcfft3d)
+FFTWPP_PRECISIONS(crfft3d)
+FFTWPP_PRECISIONS(mfft2d)
+FFTWPP_PRECISIONS(mfft3d)
+FFTWPP_PRECISIONS(mrcfft2d)
+FFTWPP_PRECISIONS(mcrfft2d)
+FFTWPP_PRECISIONS(mrcfft3d)
+FFTWPP_PRECISIONS(mcrfft3d)
+FFTWPP_PRECISIONS(r2r1d)
+FFTWPP_PRECISIONS(mr2r1d)
+FFTWPP_PRECISIONS(r2r2d)
+FFTWPP_PRECISIONS(r2r3d)
+
 }
 
 #endif
@@ -0,0 +1,1355 @@
+/* SIMD kernels of the implicitly dealiased convolution routines.
+   Copyright (C) 2017 John C. Bowman and Malcolm Roberts, Univ. of Alberta
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
+
+// This file has no include guard: convolution.cc includes it once for each
+// instruction set and precision, in its own namespace, which defines the
+// floating-point type Real and the routines of cmult-sse2.h, or of
+// cmult-scalar.h for the scalar float and long double kernels, with
+// PVECSIZE defined to the number of complex values in a Pvec (see
+// cmult-avx.h), or undefined for the SSE2 and scalar kernels. The
+// multipliers and the pre- and post-transforms of the convolution classes
+// call the kernels of the selected set.
+
+// Run the SSE2 loop that completes a PVECSIZE-wide loop serially; without
+// wide vectors it is the whole loop, so it is then run in parallel.
+#ifdef PVECSIZE
+#define REMAINDER(code) {code}
+#else
+#define REMAINDER(code) PARALLEL(code)
+#endif
+
+template<class T>
+inline void pretransform(Complex **F, unsigned int A, unsigned int k,
+                         Vec& Zetak)
+{
+  for(unsigned int a=0; a < A; ++a) {
+    Complex *fka=F[a]+k;
+    STORE(fka,ZMULT(Zetak,LOAD(fka)));
+  }
+}
+
+template<>
+inline void pretransform<pretransform1>(Complex **F, unsigned int A,
+                                      unsigned int k, Vec& Zetak)
+{
+  Complex *fk0=F[0]+k;
+  Vec Fk0=LOAD(fk0);
+  STORE(fk0,ZMULT(Zetak,Fk0));
+}
+
+template<>
+inline void pretransform<pretransform2>(Complex **F, unsigned int A,
+                                      unsigned int k, Vec& Zetak)
+{
+  Complex *fk0=F[0]+k;
+  Complex *fk1=F[1]+k;
+  Vec Fk0=LOAD(fk0);
+  Vec Fk1=LOAD(fk1);
+  STORE(fk0,ZMULT(Zetak,Fk0));
+  STORE(fk1,ZMULT(Zetak,Fk1));
+}
+
+template<>
+inline void pretransform<pretransform3>(Complex **F, unsigned int A,
+                                      unsigned int k, Vec& Zetak)
+{
+  Complex *fk0=F[0]+k;
+  Complex *fk1=F[1]+k;
+  Complex *fk2=F[2]+k;
+  Vec Fk0=LOAD(fk0);
+  Vec Fk1=LOAD(fk1);
+  Vec Fk2=LOAD(fk2);
+  STORE(fk0,ZMULT(Zetak,Fk0));
+  STORE(fk1,ZMULT(Zetak,Fk1));
+  STORE(fk2,ZMULT(Zetak,Fk2));
+}
+
+template<>
+inline void pretransform<pretransform4>(Complex **F, unsigned int A,
+                                      unsigned int k, Vec& Zetak)
+{
+  Complex *fk0=F[0]+k;
+  Complex *fk1=F[1]+k;
+  Complex *fk2=F[2]+k;
+  Complex *fk3=F[3]+k;
+  Vec Fk0=LOAD(fk0);
+  Vec Fk1=LOAD(fk1);
+  Vec Fk2=LOAD(fk2);
+  Vec Fk3=LOAD(fk3);
+  STORE(fk0,ZMULT(Zetak,Fk0));
+  STORE(fk1,ZMULT(Zetak,Fk1));
+  STORE(fk2,ZMULT(Zetak,Fk2));
+  STORE(fk3,ZMULT(Zetak,Fk3));
+}
+
+// multiply by root of unity to prepare for inverse FFT for odd modes
+template<class T>
+void pretransform(Complex **F, unsigned int A, unsigned int m, unsigned int s,
+                  Complex *ZetaH, Complex *ZetaL, unsigned int threads)
+{  
+  PARALLEL(
+    for(unsigned int K=0; K < m; K += s) {
+      Complex *ZetaL0=ZetaL-K;
+      unsigned int stop=min(K+s,m);
+      Vec Zeta=LOAD(ZetaH+K/s);
+      Vec X=UNPACKL(Zeta,Zeta);
+      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+      unsigned int k=K;
+#ifdef PVECSIZE
+      Pvec PX=PLOAD(X);
+      Pvec PY=PLOAD(Y);
+      for(; k+PVECSIZE <= stop; k += PVECSIZE) {
+        Pvec Zetak=ZMULT(PX,PY,PLOAD(ZetaL0+k));
+        for(unsigned int a=0; a < A; ++a) {
+          Complex *fka=F[a]+k;
+          PSTORE(fka,ZMULT(Zetak,PLOAD(fka)));
+        }
+      }
+#endif
+      for(; k < stop; ++k) {
+        Vec Zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
+        pretransform<T>(F,A,k,Zetak);
+      }
+    }
+    );
+}
+
+void pretransform(Complex **F, unsigned int A, unsigned int m, unsigned int s,
+                  Complex *ZetaH, Complex *ZetaL, unsigned int threads)
+{
+  switch(A) {
+    case 1: pretransform<pretransform1>(F,A,m,s,ZetaH,ZetaL,threads); break;
+    case 2: pretransform<pretransform2>(F,A,m,s,ZetaH,ZetaL,threads); break;
+    case 3: pretransform<pretransform3>(F,A,m,s,ZetaH,ZetaL,threads); break;
+    case 4: pretransform<pretransform4>(F,A,m,s,ZetaH,ZetaL,threads); break;
+    default: pretransform<general>(F,A,m,s,ZetaH,ZetaL,threads);
+  }
+}
+
+// multiply by root of unity to prepare and add for inverse FFT for odd modes
+void posttransform(Complex *f, Complex *u, unsigned int m, unsigned int s,
+                   Complex *ZetaH, Complex *ZetaL, unsigned int threads)
+{
+  Real ninv=0.5/(Real) m;
+  Vec Ninv=LOAD(ninv);
+#ifdef PVECSIZE
+  Pvec PNinv=PLOAD(ninv);
+#endif
+  PARALLEL(
+    for(unsigned int K=0; K < m; K += s) {
+      unsigned int stop=min(K+s,m);
+      Complex *ZetaL0=ZetaL-K;
+      Vec Zeta=Ninv*LOAD(ZetaH+K/s);
+      Vec X=UNPACKL(Zeta,Zeta);
+      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+      unsigned int k=K;
+#ifdef PVECSIZE
+      Pvec PX=PLOAD(X);
+      Pvec PY=PLOAD(Y);
+      for(; k+PVECSIZE <= stop; k += PVECSIZE) {
+        Pvec Zetak=ZMULT(PX,PY,PLOAD(ZetaL0+k));
+        Complex *fki=f+k;
+        PSTORE(fki,ZMULTC(Zetak,PLOAD(fki))+PNinv*PLOAD(u+k));
+      }
+#endif
+      for(; k < stop; ++k) {
+        Vec Zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
+        Complex *fki=f+k;
+        STORE(fki,ZMULTC(Zetak,LOAD(fki))+Ninv*LOAD(u+k));
+      }
+    }
+    );
+}
+
+void pretransformH(Complex *F, Complex *f1c, Complex *U, unsigned int m,
+                   unsigned int c, bool compact, bool even, unsigned int s,
+                   Complex *ZetaH, Complex *ZetaL, unsigned int threads)
+{
+  Vec Mhalf=LOAD(-0.5);
+  Vec HSqrt3=LOAD(hsqrt3);
+  
+  Real Re=0.0, Im=0.0;
+
+  unsigned int m1=m-1;
+
+  U[0]=compact ? F->real() : F->real()-F[m].real(); // Nyquist
+
+  if(even) {
+    unsigned int a=1/s;
+    Vec Zeta=LOAD(ZetaH+a);
+    Vec X=UNPACKL(Zeta,Zeta);
+    Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+    Vec zeta1=ZMULT(X,Y,LOAD(ZetaL+1-s*a));
+    Vec Fa=LOAD(F+1);
+    Vec Fb=LOAD(F+m1);
+    Vec B=Fb*Mhalf+CONJ(Fa);
+    Fb *= HSqrt3;
+    Vec A=ZMULTC(zeta1,UNPACKL(B,Fb)); // Optimize?
+    B=ZMULTIC(zeta1,UNPACKH(B,Fb));
+    STORE(f1c,CONJ(A+B));
+        
+    Real re=F[c].real();
+    Re=2.0*re;
+    Im=re+sqrt3*F[c].imag();
+  }
+  
+  unsigned int c1=c+1;
+  unsigned int d=c1/2;
+  unsigned int a=c1/s;
+  Vec Zeta=LOAD(ZetaH+a);
+  Vec X=UNPACKL(Zeta,Zeta);
+  Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+  Vec Zetac1=ZMULT(X,Y,LOAD(ZetaL+c1-s*a));
+#ifdef PVECSIZE
+  Pvec PMhalf=PLOAD(-0.5);
+  Pvec PHSqrt3=PLOAD(hsqrt3);
+  Pvec PZetac1=PLOAD(Zetac1);
+#endif
+  PARALLEL(
+    for(unsigned int K=0; K <= d; K += s) {
+      Complex *ZetaL0=ZetaL-K;
+      unsigned int stop=min(K+s,d+1);
+      Vec Zeta=LOAD(ZetaH+K/s);
+      Vec X=UNPACKL(Zeta,Zeta);
+      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+      Complex *fm=F+m;
+      Complex *fpc1=F+c1;
+      Complex *fmc1=fm-c1;
+      Complex *upc1=U+c1;
+      unsigned int k=max(1,K);
+#ifdef PVECSIZE
+      // Distinct iterations access distinct elements, so PVECSIZE
+      // consecutive iterations can be packed, reversing the packs of the
+      // elements indexed by decreasing offsets.
+      Pvec PX=PLOAD(X);
+      Pvec PY=PLOAD(Y);
+      for(; k+PVECSIZE <= stop; k += PVECSIZE) {
+        unsigned int klast=k+PVECSIZE-1;
+        Pvec zetak=ZMULT(PX,PY,PLOAD(ZetaL0+k));
+        Pvec Zetak=ZMULTC(zetak,PZetac1);
+          
+        Pvec Fa=PLOAD(F+k);
+        Pvec FA=REVERSE(PLOAD(fpc1-klast));
+        Pvec FB=PLOAD(fmc1+k);
+        Pvec Fb=REVERSE(PLOAD(fm-klast));
+          
+        Pvec b=Fb*PMhalf+CONJ(Fa);
+        PSTORE(F+k,Fa+CONJ(Fb));
+        Fb *= PHSqrt3;
+        Pvec a=ZMULTC(zetak,UNPACKL(b,Fb));
+        b=ZMULTIC(zetak,UNPACKH(b,Fb));
+        
+        PSTORE(fmc1+k,CONJ(a+b));
+        PSTORE(U+k,a-b);
+        
+        b=FB*PMhalf+CONJ(FA);
+        PSTORE(fpc1-klast,REVERSE(FA+CONJ(FB)));
+        FB *= PHSqrt3;
+        a=ZMULTC(Zetak,UNPACKL(b,FB));
+        b=ZMULTIC(Zetak,UNPACKH(b,FB));
+
+        PSTORE(upc1-klast,REVERSE(a-b));
+        PSTORE(fm-klast,REVERSE(CONJ(a+b)));
+      }
+#endif
+      for(; k < stop; ++k) {
+        Vec zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
+        Vec Zetak=ZMULTC(zetak,Zetac1);
+          
+        Vec Fa=LOAD(F+k);
+        Vec FA=LOAD(fpc1-k);
+        Vec FB=LOAD(fmc1+k);
+        Vec Fb=LOAD(fm-k);
+          
+        Vec b=Fb*Mhalf+CONJ(Fa);
+        STORE(F+k,Fa+CONJ(Fb));
+        Fb *= HSqrt3;
+        Vec a=ZMULTC(zetak,UNPACKL(b,Fb));
+        b=ZMULTIC(zetak,UNPACKH(b,Fb));
+        
+        STORE(fmc1+k,CONJ(a+b));
+        STORE(U+k,a-b);
+        
+        b=FB*Mhalf+CONJ(FA);
+        STORE(fpc1-k,FA+CONJ(FB));
+        FB *= HSqrt3;
+        a=ZMULTC(Zetak,UNPACKL(b,FB));
+        b=ZMULTIC(Zetak,UNPACKH(b,FB));
+
+        STORE(upc1-k,a-b);
+        STORE(fm-k,CONJ(a+b));
+      }
+    }
+    );
+    
+  if(even) {
+    F[c]=Re;
+    U[c]=Im;
+  }
+}
+
+void posttransformH(Complex *F, const Complex& w, Complex *U, unsigned int m,
+                    unsigned int c, bool even, unsigned int s,
+                    Complex *ZetaH, Complex *ZetaL, unsigned int threads)
+{
+  Real ninv=1.0/(3.0*(Real) m);
+  Vec Ninv=LOAD(ninv);
+
+  Vec Mhalf=LOAD(-0.5);
+  Vec HSqrt3=LOAD(hsqrt3);
+
+  unsigned int m1=m-1;  
+  unsigned int c1=c+1;
+  unsigned int d=c1/2;
+  unsigned int a=c1/s;
+  Vec Zeta=LOAD(ZetaH+a);
+  Vec X=UNPACKL(Zeta,Zeta);
+  Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+  Vec Zetac1=ZMULT(X,Y,LOAD(ZetaL+c1-s*a));
+
+  if(even && m > 2) {
+    unsigned int a=1/s;
+    Vec Zeta=LOAD(ZetaH+a);
+    Vec X=UNPACKL(Zeta,Zeta);
+    Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+    Vec zeta1=Ninv*ZMULT(X,Y,LOAD(ZetaL+1-s*a));
+    Vec Zeta1=ZMULTC(zeta1,Zetac1);
+    Complex *f0=F;
+    Vec F0=LOAD(f0+1)*Ninv;
+    Vec F1=ZMULTC(zeta1,LOAD(&w));
+    Vec F2=ZMULT(zeta1,LOAD(U+1));
+    Vec S=F1+F2;
+    F2=CONJ(F0+Mhalf*S)-HSqrt3*FLIP(F1-F2);
+    STORE(f0+1,F0+S);
+    F0=LOAD(f0+c)*Ninv;
+    F1=ZMULTC(Zeta1,LOAD(f0+m1));
+    STORE(f0+m1,F2);
+    F2=ZMULT(Zeta1,LOAD(U+c));
+    STORE(f0+c,F0+F1+F2);
+  }
+  
+  unsigned int D=c-d;
+#ifdef PVECSIZE
+  Pvec PNinv=PLOAD(ninv);
+  Pvec PMhalf=PLOAD(-0.5);
+  Pvec PHSqrt3=PLOAD(hsqrt3);
+  Pvec PZetac1=PLOAD(Zetac1);
+#endif
+  PARALLEL(
+    for(unsigned int K=0; K <= D; K += s) {
+      Complex *ZetaL0=ZetaL-K;
+      unsigned int stop=min(K+s,D+1);
+      Vec Zeta=Ninv*LOAD(ZetaH+K/s);
+      Vec X=UNPACKL(Zeta,Zeta);
+      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+      Complex *fm=F+m;
+      Complex *fpc1=F+c1;
+      Complex *fmc1=fm-c1;
+      Complex *upc1=U+c1;
+      unsigned int k=max(even+1,K);
+#ifdef PVECSIZE
+      Pvec PX=PLOAD(X);
+      Pvec PY=PLOAD(Y);
+      for(; k+PVECSIZE <= stop; k += PVECSIZE) {
+        unsigned int klast=k+PVECSIZE-1;
+        Pvec zetak=ZMULT(PX,PY,PLOAD(ZetaL0+k));
+        Pvec Zetak=ZMULTC(zetak,PZetac1);
+          
+        Pvec F0=PLOAD(F+k)*PNinv;
+        Pvec F1=ZMULTC(zetak,PLOAD(fmc1+k));
+        Pvec F2=ZMULT(zetak,PLOAD(U+k));
+        Pvec S=F1+F2;
+        F2=CONJ(F0+PMhalf*S)-PHSqrt3*FLIP(F1-F2);
+            
+        Pvec FA=REVERSE(PLOAD(fpc1-klast))*PNinv;
+        Pvec FB=ZMULTC(Zetak,REVERSE(PLOAD(fm-klast)));
+        Pvec FC=ZMULT(Zetak,REVERSE(PLOAD(upc1-klast)));
+        Pvec T=FB+FC;
+            
+        PSTORE(F+k,F0+S);
+        PSTORE(fpc1-klast,REVERSE(FA+T));
+        PSTORE(fmc1+k,CONJ(FA+PMhalf*T)-PHSqrt3*FLIP(FB-FC));
+        PSTORE(fm-klast,REVERSE(F2));
+      }  
+#endif
+      for(; k < stop; ++k) {
+        Vec zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
+        Vec Zetak=ZMULTC(zetak,Zetac1);
+          
+        Vec F0=LOAD(F+k)*Ninv;
+        Vec F1=ZMULTC(zetak,LOAD(fmc1+k));
+        Vec F2=ZMULT(zetak,LOAD(U+k));
+        Vec S=F1+F2;
+        F2=CONJ(F0+Mhalf*S)-HSqrt3*FLIP(F1-F2);
+            
+        Vec FA=LOAD(fpc1-k)*Ninv;
+        Vec FB=ZMULTC(Zetak,LOAD(fm-k));
+        Vec FC=ZMULT(Zetak,LOAD(upc1-k));
+        Vec T=FB+FC;
+            
+        STORE(F+k,F0+S);
+        STORE(fpc1-k,FA+T);
+        STORE(fmc1+k,CONJ(FA+Mhalf*T)-HSqrt3*FLIP(FB-FC));
+        STORE(fm-k,F2);
+      }  
+    }
+    );
+
+  
+  if(d == D+1) {
+    unsigned int a=d/s;
+    Vec Zeta=Ninv*LOAD(ZetaH+a);
+    Vec X=UNPACKL(Zeta,Zeta);
+    Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+    Vec Zetak=ZMULT(X,Y,LOAD(ZetaL+d-s*a));
+    Vec F0=LOAD(F+d)*Ninv;
+    Vec F1=ZMULTC(Zetak,LOAD(d == 1 && even ? &w : F+m-d));
+    Vec F2=ZMULT(Zetak,LOAD(U+d));
+    Vec S=F1+F2;
+    STORE(F+d,F0+S);
+    STORE(F+m-d,CONJ(F0+Mhalf*S)-HSqrt3*FLIP(F1-F2));
+  }
+}
+
+void fftpadexpand(Complex *f, Complex *u, unsigned int m, unsigned int M,
+                  unsigned int stride, unsigned int s, Complex *ZetaH,
+                  Complex *ZetaL, unsigned int threads)
+{
+  PARALLEL(
+    for(unsigned int K=0; K < m; K += s) {
+      Complex *ZetaL0=ZetaL-K;
+      unsigned int stop=min(K+s,m);
+      Vec H=LOAD(ZetaH+K/s);
+      for(unsigned int k=K; k < stop; ++k) {
+        Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
+        Vec X=UNPACKL(Zetak,Zetak);
+        Vec Y=UNPACKH(CONJ(Zetak),Zetak);
+        unsigned int kstride=k*stride;
+        Complex *fk=f+kstride;
+        Complex *uk=u+kstride;
+        unsigned int i=0;
+#ifdef PVECSIZE
+        Pvec PX=PLOAD(X);
+        Pvec PY=PLOAD(Y);
+        for(; i+PVECSIZE <= M; i += PVECSIZE)
+          PSTORE(uk+i,ZMULT(PX,PY,PLOAD(fk+i)));
+#endif
+        for(; i < M; ++i)
+          STORE(uk+i,ZMULT(X,Y,LOAD(fk+i)));
+      }
+    }
+    );
+}
+
+void fftpadreduce(Complex *f, Complex *u, unsigned int m, unsigned int M,
+                  unsigned int stride, unsigned int s, Complex *ZetaH,
+                  Complex *ZetaL, unsigned int threads)
+{
+  Real ninv=0.5/(Real) m;
+  Vec Ninv=LOAD(ninv);
+#ifdef PVECSIZE
+  Pvec PNinv=PLOAD(ninv);
+#endif
+  PARALLEL(
+    for(unsigned int K=0; K < m; K += s) {
+      Complex *ZetaL0=ZetaL-K;
+      unsigned int stop=min(K+s,m);
+      Vec H=Ninv*LOAD(ZetaH+K/s);
+      for(unsigned int k=K; k < stop; ++k) {
+        Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
+        Vec X=UNPACKL(Zetak,Zetak);
+        Vec Y=UNPACKH(Zetak,CONJ(Zetak));
+        unsigned int kstride=k*stride;
+        Complex *uk=u+kstride;
+        Complex *fk=f+kstride;
+        unsigned int i=0;
+#ifdef PVECSIZE
+        Pvec PX=PLOAD(X);
+        Pvec PY=PLOAD(Y);
+        for(; i+PVECSIZE <= M; i += PVECSIZE)
+          PSTORE(fk+i,PLOAD(fk+i)*PNinv+ZMULT(PX,PY,PLOAD(uk+i)));
+#endif
+        for(; i < M; ++i)
+          STORE(fk+i,LOAD(fk+i)*Ninv+ZMULT(X,Y,LOAD(uk+i)));
+      }
+    }
+    );
+}
+
+// Fold the m rows of f, each multiplied by the twiddle factor of its index
+// k, into the c rows of u.
+void fftpadpqexpand(Complex *f, Complex *u, unsigned int m, unsigned int c,
+                    unsigned int M, unsigned int stride, unsigned int s,
+                    Complex *ZetaH, Complex *ZetaL, unsigned int threads)
+{
+  for(unsigned int k0=0; k0 < m; k0 += c) {
+    unsigned int k1=min(k0+c,m);
+    unsigned int K0=k0-k0 % s;
+    bool first=k0 == 0;
+    PARALLEL(
+      for(unsigned int K=K0; K < k1; K += s) {
+        Complex *ZetaL0=ZetaL-K;
+        unsigned int start=max(K,k0);
+        unsigned int stop=min(K+s,k1);
+        Vec H=LOAD(ZetaH+K/s);
+        for(unsigned int k=start; k < stop; ++k) {
+          Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
+          Vec X=UNPACKL(Zetak,Zetak);
+          Vec Y=UNPACKH(CONJ(Zetak),Zetak);
+          Complex *fk=f+k*stride;
+          Complex *uk=u+(k-k0)*stride;
+          unsigned int i=0;
+#ifdef PVECSIZE
+          Pvec PX=PLOAD(X);
+          Pvec PY=PLOAD(Y);
+          if(first)
+            for(; i+PVECSIZE <= M; i += PVECSIZE)
+              PSTORE(uk+i,ZMULT(PX,PY,PLOAD(fk+i)));
+          else
+            for(; i+PVECSIZE <= M; i += PVECSIZE)
+              PSTORE(uk+i,PLOAD(uk+i)+ZMULT(PX,PY,PLOAD(fk+i)));
+#endif
+          if(first)
+            for(; i < M; ++i)
+              STORE(uk+i,ZMULT(X,Y,LOAD(fk+i)));
+          else
+            for(; i < M; ++i)
+              STORE(uk+i,LOAD(uk+i)+ZMULT(X,Y,LOAD(fk+i)));
+        }
+      }
+      );
+  }
+}
+
+// Add to (or, if first, store in) the m rows of f the rows k mod c of u,
+// each multiplied by ninv and the conjugate twiddle factor of its index k.
+void fftpadpqreduce(Complex *u, Complex *f, unsigned int m, unsigned int c,
+                    unsigned int M, unsigned int stride, unsigned int s,
+                    Complex *ZetaH, Complex *ZetaL, Real ninv, bool first,
+                    unsigned int threads)
+{
+  Vec Ninv=LOAD(ninv);
+  for(unsigned int k0=0; k0 < m; k0 += c) {
+    unsigned int k1=min(k0+c,m);
+    unsigned int K0=k0-k0 % s;
+    PARALLEL(
+      for(unsigned int K=K0; K < k1; K += s) {
+        Complex *ZetaL0=ZetaL-K;
+        unsigned int start=max(K,k0);
+        unsigned int stop=min(K+s,k1);
+        Vec H=Ninv*LOAD(ZetaH+K/s);
+        for(unsigned int k=start; k < stop; ++k) {
+          Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
+          Vec X=UNPACKL(Zetak,Zetak);
+          Vec Y=UNPACKH(Zetak,CONJ(Zetak));
+          Complex *uk=u+(k-k0)*stride;
+          Complex *fk=f+k*stride;
+          unsigned int i=0;
+#ifdef PVECSIZE
+          Pvec PX=PLOAD(X);
+          Pvec PY=PLOAD(Y);
+          if(first)
+            for(; i+PVECSIZE <= M; i += PVECSIZE)
+              PSTORE(fk+i,ZMULT(PX,PY,PLOAD(uk+i)));
+          else
+            for(; i+PVECSIZE <= M; i += PVECSIZE)
+              PSTORE(fk+i,PLOAD(fk+i)+ZMULT(PX,PY,PLOAD(uk+i)));
+#endif
+          if(first)
+            for(; i < M; ++i)
+              STORE(fk+i,ZMULT(X,Y,LOAD(uk+i)));
+          else
+            for(; i < M; ++i)
+              STORE(fk+i,LOAD(fk+i)+ZMULT(X,Y,LOAD(uk+i)));
+        }
+      }
+      );
+  }
+}
+
+void fft0padexpand(Complex *f, Complex *u, unsigned int m, unsigned int M,
+                   unsigned int stride, unsigned int s, Complex *ZetaH,
+                   Complex *ZetaL, unsigned int threads)
+{
+  Complex *fm1stride=f+(m-1)*stride;
+  for(unsigned int i=0; i < M; ++i)
+    u[i]=fm1stride[i];
+    
+  Vec Mhalf=LOAD(-0.5);
+  Vec Mhsqrt3=LOAD(-hsqrt3);
+#ifdef PVECSIZE
+  Pvec PMhalf=PLOAD(-0.5);
+  Pvec PMhsqrt3=PLOAD(-hsqrt3);
+#endif
+  unsigned int stop=s;
+  
+  for(unsigned int K=0; K < m; K += s) {
+    Complex *ZetaL0=ZetaL-K;
+    Vec H=LOAD(ZetaH+K/s);
+    for(unsigned int k=max(1,K); k < stop; ++k) {
+      Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
+      Vec X=UNPACKL(Zetak,Zetak);
+      Vec Y=UNPACKH(CONJ(Zetak),Zetak);
+      unsigned int kstride=k*stride;
+      Complex *uk=u+kstride;
+      Complex *fk=f+kstride;
+      Complex *fmk=fm1stride+kstride;
+      unsigned int i=0;
+#ifdef PVECSIZE
+      Pvec PX=PLOAD(X);
+      Pvec PY=PLOAD(Y);
+      for(; i+PVECSIZE <= M; i += PVECSIZE) {
+        Pvec A=PLOAD(fmk+i);
+        Pvec B=PLOAD(f+i);
+        Pvec Z=B*PMhalf+A;
+        PSTORE(f+i,PLOAD(fk+i));
+        PSTORE(fk+i,B+A);
+        B *= PMhsqrt3;
+        A=ZMULT(PX,PY,UNPACKL(Z,B));
+        B=ZMULTI(PX,PY,UNPACKH(Z,B));
+        PSTORE(fmk+i,A+B);
+        PSTORE(uk+i,CONJ(A-B));
+      }
+#endif
+      for(; i < M; ++i) {
+        Vec A=LOAD(fmk+i);
+        Vec B=LOAD(f+i);
+        Vec Z=B*Mhalf+A;
+        STORE(f+i,LOAD(fk+i));
+        STORE(fk+i,B+A);
+        B *= Mhsqrt3;
+        A=ZMULT(X,Y,UNPACKL(Z,B));
+        B=ZMULTI(X,Y,UNPACKH(Z,B));
+        STORE(fmk+i,A+B);
+        STORE(uk+i,CONJ(A-B));
+      }
+    }
+    stop=min(stop+s,m);
+  }
+}
+
+void fft0padreduce(Complex *f, Complex *u, unsigned int m, unsigned int M,
+                   unsigned int stride, unsigned int s, Complex *ZetaH,
+                   Complex *ZetaL, unsigned int threads)
+{
+  Complex *umstride=u+m*stride;
+  Real ninv=1.0/(3.0*(Real) m);
+  for(unsigned int i=0; i < M; ++i)
+    umstride[i]=(umstride[i]+f[i]+u[i])*ninv;
+
+  Vec Ninv=LOAD(ninv);
+  Vec Mhalf=LOAD(-0.5);
+  Vec HSqrt3=LOAD(hsqrt3);
+#ifdef PVECSIZE
+  Pvec PNinv=PLOAD(ninv);
+  Pvec PMhalf=PLOAD(-0.5);
+  Pvec PHSqrt3=PLOAD(hsqrt3);
+#endif
+  Complex *fm1stride=f+(m-1)*stride;
+  
+  unsigned int stop=s;
+  for(unsigned int K=0; K < m; K += s) {
+    Complex *ZetaL0=ZetaL-K;
+    Vec H=LOAD(ZetaH+K/s)*Ninv;
+    for(unsigned int k=max(1,K); k < stop; ++k) {
+      Vec Zetak=ZMULT(H,LOAD(ZetaL0+k));
+      Vec X=UNPACKL(Zetak,Zetak);
+      Vec Y=UNPACKH(CONJ(Zetak),Zetak);
+      unsigned int kstride=k*stride;
+      Complex *fk=f+kstride;
+      Complex *fm1k=fm1stride+kstride;
+      Complex *uk=u+kstride;
+      unsigned int i=0;
+#ifdef PVECSIZE
+      Pvec PX=PLOAD(X);
+      Pvec PY=PLOAD(Y);
+      for(; i+PVECSIZE <= M; i += PVECSIZE) {
+        Pvec F0=PLOAD(fk+i)*PNinv;
+        Pvec F1=ZMULT(PX,-PY,PLOAD(fm1k+i));
+        Pvec F2=ZMULT(PX,PY,PLOAD(uk+i));
+        Pvec S=F1+F2;
+        PSTORE(fk+i-stride,F0+PMhalf*S+PHSqrt3*ZMULTI(F1-F2));
+        PSTORE(fm1k+i,F0+S);
+      }
+#endif
+      for(; i < M; ++i) {
+        Vec F0=LOAD(fk+i)*Ninv;
+        Vec F1=ZMULT(X,-Y,LOAD(fm1k+i));
+        Vec F2=ZMULT(X,Y,LOAD(uk+i));
+        Vec S=F1+F2;
+        STORE(fk+i-stride,F0+Mhalf*S+HSqrt3*ZMULTI(F1-F2));
+        STORE(fm1k+i,F0+S);
+      }
+    }
+    stop=min(stop+s,m);
+  }
+    
+  for(unsigned int i=0; i < M; ++i)
+    fm1stride[i]=umstride[i];
+}
+
+void fft1padexpand(Complex *f, Complex *u, unsigned int m, unsigned int M,
+                   unsigned int stride, unsigned int s, Complex *ZetaH,
+                   Complex *ZetaL, unsigned int threads)
+{
+  Complex *fmstride=f+m*stride;
+  for(unsigned int i=0; i < M; ++i) {
+    Complex Nyquist=f[i];
+    f[i]=fmstride[i]+(Real) 2.0*Nyquist;
+    u[i]=fmstride[i] -= Nyquist;
+  }
+    
+  Vec Mhalf=LOAD(-0.5);
+  Vec Mhsqrt3=LOAD(-hsqrt3);
+#ifdef PVECSIZE
+  Pvec PMhalf=PLOAD(-0.5);
+  Pvec PMhsqrt3=PLOAD(-hsqrt3);
+#endif
+  unsigned int inc=s;
+  PARALLEL(
+    for(unsigned int K=0; K < m; K += inc) {
+      Complex *ZetaL0=ZetaL-K;
+      unsigned int stop=min(K+s,m);
+      Vec Zeta=LOAD(ZetaH+K/s);
+      Vec X=UNPACKL(Zeta,Zeta);
+      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+      for(unsigned int k=max(1,K); k < stop; ++k) {
+        Vec zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
+        unsigned int kstride=k*stride;
+        Complex *uk=u+kstride;
+        Complex *fk=f+kstride;
+        Complex *fmk=fmstride+kstride;
+        unsigned int i=0;
+#ifdef PVECSIZE
+        Pvec Pzetak=PLOAD(zetak);
+        for(; i+PVECSIZE <= M; i += PVECSIZE) {
+          Pvec Fa=PLOAD(fk+i);
+          Pvec Fb=PLOAD(fmk+i);
+        
+          Pvec B=Fa*PMhalf+Fb;
+          PSTORE(fk+i,Fa+Fb);
+          Fa *= PMhsqrt3;
+          Pvec A=ZMULT(Pzetak,UNPACKL(B,Fa));
+          B=ZMULTI(Pzetak,UNPACKH(B,Fa));
+          PSTORE(fmk+i,A+B);
+          PSTORE(uk+i,CONJ(A-B));
+        }
+#endif
+        for(; i < M; ++i) {
+          Vec Fa=LOAD(fk+i);
+          Vec Fb=LOAD(fmk+i);
+        
+          Vec B=Fa*Mhalf+Fb;
+          STORE(fk+i,Fa+Fb);
+          Fa *= Mhsqrt3;
+          Vec A=ZMULT(zetak,UNPACKL(B,Fa));
+          B=ZMULTI(zetak,UNPACKH(B,Fa));
+          STORE(fmk+i,A+B);
+          STORE(uk+i,CONJ(A-B));
+        }
+      }
+    }
+    );
+}
+
+void fft1padreduce(Complex *f, Complex *u, unsigned int m, unsigned int M,
+                   unsigned int stride, unsigned int s, Complex *ZetaH,
+                   Complex *ZetaL, unsigned int threads)
+{
+  Complex *fmstride=f+m*stride;
+
+  Real ninv=1.0/(3.0*(Real) m);
+  for(unsigned int i=0; i < M; ++i) {
+    Complex f0=f[i];
+    Complex f1=fmstride[i];
+    Complex f2=u[i];
+    f[i]=0.0; // Zero Nyquist mode, for Hermitian symmetry.
+    fmstride[i]=(f0+f1+f2)*ninv;
+  }
+  Vec Ninv=LOAD(ninv);
+  Vec Mhalf=LOAD(-0.5);
+  Vec HSqrt3=LOAD(hsqrt3);
+#ifdef PVECSIZE
+  Pvec PNinv=PLOAD(ninv);
+  Pvec PMhalf=PLOAD(-0.5);
+  Pvec PHSqrt3=PLOAD(hsqrt3);
+#endif
+  
+  unsigned int inc=s;
+  PARALLEL(
+    for(unsigned int K=0; K < m; K += inc) {
+      Complex *ZetaL0=ZetaL-K;
+      unsigned int stop=min(K+s,m);
+      Vec Zeta=Ninv*LOAD(ZetaH+K/s);
+      Vec X=UNPACKL(Zeta,Zeta);
+      Vec Y=UNPACKH(CONJ(Zeta),Zeta);
+      for(unsigned int k=max(1,K); k < stop; ++k) {
+        Vec zetak=ZMULT(X,Y,LOAD(ZetaL0+k));
+        unsigned int kstride=k*stride;
+        Complex *fk=f+kstride;
+        Complex *fmk=fmstride+kstride;
+        Complex *uk=u+kstride;
+        unsigned int i=0;
+#ifdef PVECSIZE
+        Pvec Pzetak=PLOAD(zetak);
+        for(; i+PVECSIZE <= M; i += PVECSIZE) {
+          Pvec F0=PLOAD(fk+i)*PNinv;
+          Pvec F1=ZMULTC(Pzetak,PLOAD(fmk+i));
+          Pvec F2=ZMULT(Pzetak,PLOAD(uk+i));
+          Pvec S=F1+F2;
+          PSTORE(fk+i,F0+PMhalf*S+PHSqrt3*ZMULTI(F1-F2));
+          PSTORE(fmk+i,F0+S);
+        }
+#endif
+        for(; i < M; ++i) {
+          Vec F0=LOAD(fk+i)*Ninv;
+          Vec F1=ZMULTC(zetak,LOAD(fmk+i));
+          Vec F2=ZMULT(zetak,LOAD(uk+i));
+          Vec S=F1+F2;
+          STORE(fk+i,F0+Mhalf*S+HSqrt3*ZMULTI(F1-F2));
+          STORE(fmk+i,F0+S);
+        }
+      }
+    }
+    );
+}
+
+// This multiplication routine is for binary convolutions and takes two inputs
+// of size m.
+// F[0][j] *= conj(F[0][j]);
+void multautocorrelation(Complex **F, unsigned int m,
+                         const unsigned int indexsize,
+                         const unsigned int *index,
+                         unsigned int r, unsigned int threads)
+{
+  Complex* F0=F[0];
+  
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%PVECSIZE;
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += PVECSIZE) {
+      Complex *p=F0+j;
+      PSTORE(p,ZMULT(PLOAD(p),CONJ(PLOAD(p))));
+    }
+    );
+#else
+  unsigned int stop=0;
+#endif
+  REMAINDER(
+    for(unsigned int j=stop; j < m; ++j) {
+      Complex *p=F0+j;
+      STORE(p,ZMULT(LOAD(p),CONJ(LOAD(p))));
+    }
+    );
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j] *= conj(F0[j]);
+    );
+#endif
+}
+
+void multcorrelation(Complex **F, unsigned int m,
+                     const unsigned int indexsize,
+                     const unsigned int *index,
+                     unsigned int r, unsigned int threads)
+{
+  Complex* F0=F[0];
+  Complex* F1=F[1];
+  
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%PVECSIZE;
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += PVECSIZE) {
+      Complex *p=F0+j;
+      Complex *q=F1+j;
+      PSTORE(p,ZMULT(PLOAD(p),CONJ(PLOAD(q))));
+    }
+    );
+#else
+  unsigned int stop=0;
+#endif
+  REMAINDER(
+    for(unsigned int j=stop; j < m; ++j) {
+      Complex *p=F0+j;
+      Complex *q=F1+j;
+      STORE(p,ZMULT(LOAD(p),CONJ(LOAD(q))));
+    }
+    );
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j] *= conj(F1[j]);
+    );
+#endif
+}
+
+// Unscramble indices, returning spatial index for remainder r at position j.
+inline unsigned innerindex(unsigned j, int r) {return 2*j+r;}
+  
+// This multiplication routine is for binary convolutions and takes two inputs
+// of size m.
+// F[0][j] *= F[1][j];
+void multbinary(Complex **F, unsigned int m,
+                const unsigned int indexsize,
+                const unsigned int *index,
+                unsigned int r, unsigned int threads)
+{
+  Complex* F0=F[0];
+  Complex* F1=F[1];
+  
+#if 0 // Spatial indices are available, if needed.
+  size_t n=indexsize;
+  for(unsigned int j=0; j < m; ++j) {
+    for(unsigned int d=0; d < n; ++d)
+      cout << index[d] << ",";
+    cout << innerindex(j,r) << endl;
+  }
+#endif  
+      
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%PVECSIZE;
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += PVECSIZE) {
+      Complex *p=F0+j;
+      PSTORE(p,ZMULT(PLOAD(p),PLOAD(F1+j)));
+    }
+    );
+#else
+  unsigned int stop=0;
+#endif
+  REMAINDER(
+    for(unsigned int j=stop; j < m; ++j) {
+      Complex *p=F0+j;
+      STORE(p,ZMULT(LOAD(p),LOAD(F1+j)));
+    }
+    );
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j] *= F1[j];
+    );
+#endif
+}
+
+// F[0][j] *= F[0][j];
+void multautoconvolution(Complex **F, unsigned int m,
+                         const unsigned int indexsize,
+                         const unsigned int *index,
+                         unsigned int r, unsigned int threads)
+{
+  Complex* F0=F[0];
+  
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%PVECSIZE;
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += PVECSIZE) {
+      Complex *p=F0+j;
+      PSTORE(p,ZMULT(PLOAD(p),PLOAD(p)));
+    }
+    );
+#else
+  unsigned int stop=0;
+#endif
+  REMAINDER(
+    for(unsigned int j=stop; j < m; ++j) {
+      Complex *p=F0+j;
+      STORE(p,ZMULT(LOAD(p),LOAD(p)));
+    }
+    );
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j] *= F0[j];
+    );
+#endif
+}
+
+// Unscramble indices, returning spatial index for remainder r at position j.
+inline unsigned innerindex(unsigned j, int r, unsigned int m) {
+  int x=3*j+r;
+  return x >= 0 ? x : 3*m-1;
+}
+  
+// This multiplication routine is for binary Hermitian convolutions and takes
+// two inputs.
+// F[0][j] *= F[1][j];
+void multbinary(Real **F, unsigned int m,
+                const unsigned int indexsize,
+                const unsigned int *index,
+                unsigned int r, unsigned int threads)
+{
+  Real* F0=F[0];
+  Real* F1=F[1];
+  
+#if 0 // Spatial indices are available, if needed.
+  //size_t n=index.size();
+  size_t n=indexsize;
+  for(unsigned int j=0; j < m; ++j) {
+    for(unsigned int d=0; d < n; ++d)
+      cout << index[d] << ",";
+    cout << innerindex(j,r,m) << endl;
+  }
+#endif
+      
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%(2*PVECSIZE);
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += 2*PVECSIZE) {
+      Real *p=F0+j;
+      PSTORE(p,PLOAD(p)*PLOAD(F1+j));
+    }
+    );
+  for(unsigned int j=stop; j < m; ++j)
+    F0[j] *= F1[j];
+#else
+  unsigned int m1=m-1;
+  PARALLEL(
+    for(unsigned int j=0; j < m1; j += 2) {
+      Real *p=F0+j;
+      STORE(p,LOAD(p)*LOAD(F1+j));
+    }
+    if(m % 2)
+      F0[m1] *= F1[m1];
+    );
+#endif
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j] *= F1[j];
+    );
+#endif
+}
+
+// F[0][j]=F[0][j]*F[2][j]+F[1][j]*F[3][j]
+void multbinary2(Complex **F, unsigned int m,
+                 const unsigned int indexsize,
+                 const unsigned int *index,
+                 unsigned int r, unsigned int threads)
+{
+  Complex* F0=F[0];
+  Complex* F1=F[1];
+  Complex* F2=F[2];
+  Complex* F3=F[3];
+  
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%PVECSIZE;
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += PVECSIZE) {
+      Complex *F0j=F0+j;
+      PSTORE(F0j,ZMULT(PLOAD(F0j),PLOAD(F2+j))
+             +ZMULT(PLOAD(F1+j),PLOAD(F3+j)));
+    }
+    );
+#else
+  unsigned int stop=0;
+#endif
+  REMAINDER(
+    for(unsigned int j=stop; j < m; ++j) {
+      Complex *F0j=F0+j;
+      STORE(F0j,ZMULT(LOAD(F0j),LOAD(F2+j))
+            +ZMULT(LOAD(F1+j),LOAD(F3+j)));
+    }
+    );
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j]=F0[j]*F2[j]+F1[j]*F3[j];
+    );
+#endif
+}
+
+// F[0][j]=F[0][j]*F[2][j]+F[1][j]*F[3][j]
+void multbinary2(Real **F, unsigned int m,
+                 const unsigned int indexsize,
+                 const unsigned int *index,
+                 unsigned int r, unsigned int threads)
+{
+  Real* F0=F[0];
+  Real* F1=F[1];
+  Real* F2=F[2];
+  Real* F3=F[3];
+  
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%(2*PVECSIZE);
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += 2*PVECSIZE) {
+      Real *F0j=F0+j;
+      PSTORE(F0j,PLOAD(F0j)*PLOAD(F2+j)+PLOAD(F1+j)*PLOAD(F3+j));
+    }
+    );
+  for(unsigned int j=stop; j < m; ++j)
+    F0[j]=F0[j]*F2[j]+F1[j]*F3[j];
+#else
+  unsigned int m1=m-1;
+  PARALLEL(
+    for(unsigned int j=0; j < m1; j += 2) {
+      Real *F0j=F0+j;
+      STORE(F0j,LOAD(F0j)*LOAD(F2+j)+LOAD(F1+j)*LOAD(F3+j));
+    }
+    );
+  if(m % 2)
+    F0[m1]=F0[m1]*F2[m1]+F1[m1]*F3[m1];
+#endif
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j]=F0[j]*F2[j]+F1[j]*F3[j];
+    );
+#endif
+}
+
+// F[0][j]=F[0][j]*F[3][j]+F[1][j]*F[4][j]+F[2][j]*F[5][j];
+void multbinary3(Complex **F, unsigned int m,
+                 const unsigned int indexsize,
+                 const unsigned int *index,
+                 unsigned int r, unsigned int threads)
+{
+  Complex* F0=F[0];
+  Complex* F1=F[1];
+  Complex* F2=F[2];
+  Complex* F3=F[3];
+  Complex* F4=F[4];
+  Complex* F5=F[5];
+  
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%PVECSIZE;
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += PVECSIZE) {
+      Complex *F0j=F0+j;
+      PSTORE(F0j,ZMULT(PLOAD(F0j),PLOAD(F3+j))
+             +ZMULT(PLOAD(F1+j),PLOAD(F4+j))
+             +ZMULT(PLOAD(F2+j),PLOAD(F5+j))
+        );
+    }
+    );
+#else
+  unsigned int stop=0;
+#endif
+  REMAINDER(
+    for(unsigned int j=stop; j < m; ++j) {
+      Complex *F0j=F0+j;
+      STORE(F0j,ZMULT(LOAD(F0j),LOAD(F3+j))
+            +ZMULT(LOAD(F1+j),LOAD(F4+j))
+            +ZMULT(LOAD(F2+j),LOAD(F5+j))
+        );
+    }
+    );
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j]=F0[j]*F3[j]+F1[j]*F4[j]+F2[j]*F5[j];
+    );
+
+#endif
+}
+
+// F[0][j]=F[0][j]*F[4][j]+F[1][j]*F[5][j]+F[2][j]*F[6][j]+F[3][j]*F[7][j];
+void multbinary4(Complex **F, unsigned int m,
+                 const unsigned int indexsize,           
+                 const unsigned int *index,
+                 unsigned int r, unsigned int threads)
+{
+  Complex* F0=F[0];
+  Complex* F1=F[1];
+  Complex* F2=F[2];
+  Complex* F3=F[3];
+  Complex* F4=F[4];
+  Complex* F5=F[5];
+  Complex* F6=F[6];
+  Complex* F7=F[7];
+  
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%PVECSIZE;
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += PVECSIZE) {
+      Complex *F0j=F0+j;
+      PSTORE(F0j,ZMULT(PLOAD(F0j),PLOAD(F4+j))
+             +ZMULT(PLOAD(F1+j),PLOAD(F5+j))
+             +ZMULT(PLOAD(F2+j),PLOAD(F6+j))
+             +ZMULT(PLOAD(F3+j),PLOAD(F7+j))
+        );
+    }
+    );
+#else
+  unsigned int stop=0;
+#endif
+  REMAINDER(
+    for(unsigned int j=stop; j < m; ++j) {
+      Complex *F0j=F0+j;
+      STORE(F0j,ZMULT(LOAD(F0j),LOAD(F4+j))
+            +ZMULT(LOAD(F1+j),LOAD(F5+j))
+            +ZMULT(LOAD(F2+j),LOAD(F6+j))
+            +ZMULT(LOAD(F3+j),LOAD(F7+j))
+        );
+    }
+    );
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j]=F0[j]*F4[j]+F1[j]*F5[j]+F2[j]*F6[j]+F3[j]*F7[j];
+    );
+
+#endif
+}
+
+// F[0][j]=F[0][j]*F[8][j]+F[1][j]*F[9][j]+F[2][j]*F[10][j]+F[3][j]*F[11][j]+
+//         F[4][j]*F[12][j]+F[5][j]*F[13][j]+F[6][j]*F[14][j]+F[7][j]*F[15][j];
+void multbinary8(Complex **F, unsigned int m,
+                 const unsigned int indexsize,
+                 const unsigned int *index,
+                 unsigned int r, unsigned int threads)
+{
+  Complex* F0=F[0];
+  Complex* F1=F[1];
+  Complex* F2=F[2];
+  Complex* F3=F[3];
+  Complex* F4=F[4];
+  Complex* F5=F[5];
+  Complex* F6=F[6];
+  Complex* F7=F[7];
+  Complex* F8=F[8];
+  Complex* F9=F[9];
+  Complex* F10=F[10];
+  Complex* F11=F[11];
+  Complex* F12=F[12];
+  Complex* F13=F[13];
+  Complex* F14=F[14];
+  Complex* F15=F[15];
+    
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%PVECSIZE;
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += PVECSIZE) {
+      Complex *F0j=F0+j;
+      PSTORE(F0j,
+             ZMULT(PLOAD(F0j),PLOAD(F8+j))
+             +ZMULT(PLOAD(F1+j),PLOAD(F9+j))
+             +ZMULT(PLOAD(F2+j),PLOAD(F10+j))
+             +ZMULT(PLOAD(F3+j),PLOAD(F11+j))
+             +ZMULT(PLOAD(F4+j),PLOAD(F12+j))
+             +ZMULT(PLOAD(F5+j),PLOAD(F13+j))
+             +ZMULT(PLOAD(F6+j),PLOAD(F14+j))
+             +ZMULT(PLOAD(F7+j),PLOAD(F15+j))
+        );
+    }
+    );
+#else
+  unsigned int stop=0;
+#endif
+  REMAINDER(
+    for(unsigned int j=stop; j < m; ++j) {
+      Complex *F0j=F0+j;
+      STORE(F0j,
+            ZMULT(LOAD(F0j),LOAD(F8+j))
+            +ZMULT(LOAD(F1+j),LOAD(F9+j))
+            +ZMULT(LOAD(F2+j),LOAD(F10+j))
+            +ZMULT(LOAD(F3+j),LOAD(F11+j))
+            +ZMULT(LOAD(F4+j),LOAD(F12+j))
+            +ZMULT(LOAD(F5+j),LOAD(F13+j))
+            +ZMULT(LOAD(F6+j),LOAD(F14+j))
+            +ZMULT(LOAD(F7+j),LOAD(F15+j))
+        );
+    }
+    );
+#else
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j)
+      F0[j]=F0[j]*F8[j]+F1[j]*F9[j]+F2[j]*F10[j]+F3[j]*F11[j]
+        +F4[j]*F12[j]+F5[j]*F13[j]+F6[j]*F14[j]+F7[j]*F15[j];
+    );
+#endif
+}
+
+// This 2D version of the scheme of Basdevant, J. Comp. Phys, 50, 1983
+// requires only 4 FFTs per stage.
+void multadvection2(Real **F, unsigned int m,
+                    const unsigned int indexsize,
+                    const unsigned int *index,
+                    unsigned int r, unsigned int threads)
+{
+  Real* F0=F[0];
+  Real* F1=F[1];
+  
+#ifdef __SSE2__
+#ifdef PVECSIZE
+  unsigned int stop=m-m%(2*PVECSIZE);
+  PARALLEL(
+    for(unsigned int j=0; j < stop; j += 2*PVECSIZE) {
+      Real *F0j=F0+j;
+      Real *F1j=F1+j;
+      Pvec u=PLOAD(F0j);
+      Pvec v=PLOAD(F1j);
+      PSTORE(F0j,v*v-u*u);
+      PSTORE(F1j,u*v);
+    }
+    );
+  for(unsigned int j=stop; j < m; ++j) {
+    Real u=F0[j];
+    Real v=F1[j];
+    F0[j]=v*v-u*u;
+    F1[j]=u*v;
+  }
+#else
+  unsigned int m1=m-1;
+  PARALLEL(
+    for(unsigned int j=0; j < m1; j += 2) {
+      Real *F0j=F0+j;
+      Real *F1j=F1+j;
+      Vec u=LOAD(F0j);
+      Vec v=LOAD(F1j);
+      STORE(F0j,v*v-u*u);
+      STORE(F1j,u*v);
+    }
+    );
+  if(m % 2) {
+    Real u=F0[m1];
+    Real v=F1[m1];
+    F0[m1]=v*v-u*u;
+    F1[m1]=u*v;
+  }
+#endif
+#else
+  for(unsigned int j=0; j < m; ++j) {
+    Real u=F0[j];
+    Real v=F1[j];
+    F0[j]=v*v-u*u;
+    F1[j]=u*v;
+  }
+#endif  
+}
+
+const KernelsT<Real> kernels={
+  multautocorrelation,multcorrelation,multbinary,multautoconvolution,
+  multbinary2,multbinary3,multbinary4,multbinary8,
+  multbinary,multbinary2,multadvection2,
+  pretransform,posttransform,pretransformH,posttransformH,
+  fftpadexpand,fftpadreduce,fft0padexpand,fft0padreduce,
+  fft1padexpand,fft1padreduce,fftpadpqexpand,fftpadpqreduce
+};
+
+#undef REMAINDER
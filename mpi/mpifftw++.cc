@@ -188,6 +188,7 @@ fftw_plan MPIplanner(fftw *F, Complex *in, Complex *out)
 {
   if(utils::Active == MPI_COMM_NULL)
     return Planner(F,in,out);
+  Planlock lock;
   fftw_plan plan;
   int rank;
   MPI_Comm_rank(utils::Active,&rank);
@@ -200,9 +201,10 @@ fftw_plan MPIplanner(fftw *F, Complex *in, Complex *out)
     bool learned=false;
     if(!Wise)
       LoadWisdom();
+    unsigned int effort=fftw::effort;
     fftw::effort |= FFTW_WISDOM_ONLY;
     plan=F->Plan(in,out);
-    fftw::effort &= !FFTW_WISDOM_ONLY;
+    fftw::effort=effort;
     int length=0;
     char *experience=NULL;
     char *inspiration=NULL;
@@ -242,7 +244,7 @@ fftw_plan MPIplanner(fftw *F, Complex *in, Complex *out)
         fftw_import_wisdom_from_string(inspiration);
       }
     }
-    if(learned) SaveWisdom();
+    if(learned) UpdateWisdom();
   } else {
     int flag=false;
     MPI_Status status;
@@ -259,9 +261,10 @@ fftw_plan MPIplanner(fftw *F, Complex *in, Complex *out)
       inspiration[length]=0;
       fftw_import_wisdom_from_string(inspiration);
     }
+    unsigned int effort=fftw::effort;
     fftw::effort |= FFTW_WISDOM_ONLY;
     plan=F->Plan(in,out);
-    fftw::effort &= !FFTW_WISDOM_ONLY;
+    fftw::effort=effort;
     char *experience=NULL;
     char *inspiration=NULL;
     if(plan)
@@ -191,8 +191,9 @@ private:
   MPI_Comm split;
   MPI_Comm split2;
   MPI_Comm splitv;
-  fftwpp::Transpose *Tin1,*Tin2;
-  fftwpp::Transpose *Tout1,*Tout2;
+  typedef typename fftwpp::TransposeOf<T>::type Transpose;
+  Transpose *Tin1,*Tin2;
+  Transpose *Tout1,*Tout2;
   int a,b;
   bool outflag;
   bool uniform;
@@ -447,16 +448,16 @@ public:
     subblock=a > 1 && rank < a*b;
     
     if(uniform) {
-      Tin1=new fftwpp::Transpose(b,n*a,m*L,data,work,threads);
-      Tout1=new fftwpp::Transpose(n*a,b,m*L,data,work,threads);
+      Tin1=new Transpose(b,n*a,m*L,data,work,threads);
+      Tout1=new Transpose(n*a,b,m*L,data,work,threads);
     } else {
       Tin1=NULL;
       Tout1=NULL;      
     }
     
     if(subblock) {
-      Tin2=new fftwpp::Transpose(a,n*b,m*L,data,work,threads);
-      Tout2=new fftwpp::Transpose(n*b,a,m*L,data,work,threads);
+      Tin2=new Transpose(a,n*b,m*L,data,work,threads);
+      Tout2=new Transpose(n*b,a,m*L,data,work,threads);
     } else {
       Tin2=NULL;
       Tout2=NULL;
@@ -0,0 +1,212 @@
+#include "streamconvolution.h"
+
+using namespace std;
+using namespace utils;
+
+namespace fftwpp {
+
+void multoverlapadd::operator()(Complex **F, unsigned int m,
+                                const unsigned int indexsize,
+                                const unsigned int *index,
+                                unsigned int r, unsigned int threads) const
+{
+  Complex* F0=F[0];
+  Complex* F1=F[1];
+  Complex* Hr=H+r*m;
+
+  double sign=r == 0 ? 1 : -1;
+
+  PARALLEL(
+    for(unsigned int j=0; j < m; ++j) {
+      Complex *F0j=F0+j;
+      Vec h=ZMULT(LOAD(F0j),LOAD(Hr+j));
+      STORE(F0j,h);
+      STORE(F1+j,sign*h);
+    }
+    );
+}
+
+// Store the values of the block on the padded grid in H.
+class multcapture {
+  Complex *H;
+public:
+  multcapture(Complex *H) : H(H) {}
+  void operator()(Complex **F, unsigned int m,
+                  const unsigned int indexsize, const unsigned int *index,
+                  unsigned int r, unsigned int threads) const {
+    Complex* F0=F[0];
+    Complex* Hr=H+r*m;
+    PARALLEL(
+      for(unsigned int j=0; j < m; ++j)
+        Hr[j]=F0[j];
+      );
+  }
+};
+
+// The block length chosen for each kernel length, maximum block length,
+// and number of threads; never destroyed, like the engine cache of
+// AutoConvolution.
+typedef pair<unsigned int,pair<unsigned int,unsigned int> > BlockKey;
+typedef map<BlockKey,unsigned int> BlockMap;
+
+static BlockMap& BlockCache()
+{
+  static BlockMap *cache=new BlockMap;
+  return *cache;
+}
+
+StreamConvolution::StreamConvolution(const Complex *kernel, unsigned int K,
+                                     unsigned int m, unsigned int maxblock,
+                                     unsigned int threads) :
+  ThreadBase(threads), K(K), m(0), C(NULL)
+{
+  if(K == 0 || (m > 0 && m < K)) {
+    std::cerr << "StreamConvolution requires 0 < K <= m" << std::endl;
+    exit(1);
+  }
+  h=ComplexAlign(K);
+  for(unsigned int i=0; i < K; ++i)
+    h[i]=kernel[i];
+  init(m > 0 ? m : select(maxblock));
+}
+
+void StreamConvolution::init(unsigned int m)
+{
+  this->m=m;
+  f=ComplexAlign(m);
+  g=ComplexAlign(m);
+  tail=ComplexAlign(m);
+  H=ComplexAlign(2*m);
+  C=new ImplicitConvolution(m,1,2,threads);
+
+  for(unsigned int i=0; i < K; ++i)
+    f[i]=h[i];
+  for(unsigned int i=K; i < m; ++i)
+    f[i]=0.0;
+  Complex *F[]={f,g};
+  C->convolve(F,multcapture(H));
+
+  reset();
+}
+
+void StreamConvolution::clear()
+{
+  if(!C) return;
+  delete C;
+  deleteAlign(H);
+  deleteAlign(tail);
+  deleteAlign(g);
+  deleteAlign(f);
+  C=NULL;
+}
+
+void StreamConvolution::reset()
+{
+  fill=0;
+  for(unsigned int i=0; i < m; ++i)
+    tail[i]=0.0;
+}
+
+// Convolve the current block with the kernel, writing the next m output
+// values to y.
+void StreamConvolution::process(Complex *y)
+{
+  Complex *F[]={f,g};
+  C->convolve(F,multoverlapadd(H));
+
+  unsigned int stop=m-1;
+  for(unsigned int i=0; i < stop; ++i) {
+    y[i]=f[i]+tail[i];
+    tail[i]=g[i];
+  }
+  y[stop]=f[stop];
+}
+
+// Return the block length between K and maxblock that takes the least time
+// per value, timing each candidate on zero data.
+unsigned int StreamConvolution::select(unsigned int maxblock)
+{
+  if(maxblock == 0) maxblock=max(16*K,4096);
+  maxblock=max(maxblock,K);
+
+  Planlock lock;
+  BlockMap& cache=BlockCache();
+  BlockKey key(K,pair<unsigned int,unsigned int>(maxblock,threads));
+  BlockMap::iterator p=cache.find(key);
+  if(p != cache.end()) return p->second;
+
+  unsigned int n=fftsize(K);
+  if(n > maxblock) n=K;
+
+  unsigned int best=n;
+  if((fftwbase::effort & FFTW_ESTIMATE) || fftwbase::upgrade) {
+    while(best < 4*K && 2*best <= maxblock)
+      best *= 2;
+  } else {
+    double tbest=0.0;
+    for(; n <= maxblock; n *= 2) {
+      init(n);
+      Complex *y=ComplexAlign(n);
+      for(unsigned int i=0; i < n; ++i)
+        f[i]=0.0;
+      process(y);
+      double stop=totalseconds()+0.05*fftwbase::testseconds;
+      unsigned int N=0;
+      double t0=totalseconds();
+      double t;
+      do {
+        process(y);
+        ++N;
+      } while((t=totalseconds()) < stop && N < 1000);
+      t=(t-t0)/(N*n);
+      deleteAlign(y);
+      clear();
+      if(n == best || t < tbest) {
+        best=n;
+        tbest=t;
+      }
+    }
+  }
+  cache[key]=best;
+  return best;
+}
+
+unsigned int StreamConvolution::push(const Complex *x, unsigned int n,
+                                     Complex *y)
+{
+  unsigned int count=0;
+  while(n > 0) {
+    unsigned int k=min(n,m-fill);
+    Complex *f0=f+fill;
+    for(unsigned int i=0; i < k; ++i)
+      f0[i]=x[i];
+    fill += k;
+    x += k;
+    n -= k;
+    if(fill == m) {
+      process(y+count);
+      count += m;
+      fill=0;
+    }
+  }
+  return count;
+}
+
+unsigned int StreamConvolution::flush(Complex *y)
+{
+  unsigned int n=fill+K-1;
+  if(fill > 0) {
+    for(unsigned int i=fill; i < m; ++i)
+      f[i]=0.0;
+    process(y);
+    for(unsigned int i=m; i < n; ++i)
+      y[i]=tail[i-m];
+  } else {
+    for(unsigned int i=0; i < n; ++i)
+      y[i]=tail[i];
+  }
+  reset();
+  return n;
+}
+
+} //end namespace fftwpp
@@ -0,0 +1,98 @@
+/* Streaming convolution of long signals with a fixed kernel.
+   Copyright (C) 2010-2015 John C. Bowman and Malcolm Roberts, Univ. of Alberta
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
+
+#include "autoconvolution.h"
+
+namespace fftwpp {
+
+#ifndef __streamconvolution_h__
+#define __streamconvolution_h__ 1
+
+// Multiply the values of a block of data on the implicitly padded grid by
+// those of the kernel, stored in H for the even (r=0) and odd (r=1) points,
+// returning the product in F[0] and, negated at the odd points, in F[1],
+// so that the two outputs of the convolution hold the first m and the
+// last m-1 values of the full linear convolution.
+class multoverlapadd {
+  Complex *H;
+public:
+  multoverlapadd(Complex *H) : H(H) {}
+  void operator()(Complex **F, unsigned int m,
+                  const unsigned int indexsize, const unsigned int *index,
+                  unsigned int r, unsigned int threads) const;
+};
+
+// Linear convolution y=h (*) x of a stream x, delivered in chunks of any
+// length, with a fixed kernel h of K complex values, by implicitly dealiased
+// overlap-add: each block of m input values is convolved with h, the values
+// of h on the padded grid having been computed once, and the last m-1
+// values of each block's full convolution are added to the next block.
+//
+// The output lags the input by at most m-1 values. Unless it is given
+// explicitly, the block length m is chosen the first time that K, maxblock,
+// and the number of threads are seen, as the size between K and maxblock
+// (by default max(16K,4096)) that takes the least time per value; under
+// FFTW_ESTIMATE the smallest size that is at least 4K is used instead.
+//
+//   StreamConvolution C(h,K);
+//   n=C.push(x,L,y);   // y[0,...,n-1] are the next n output values.
+//   n=C.flush(y);      // The last values of the full convolution.
+//
+class StreamConvolution : public ThreadBase {
+protected:
+  unsigned int K;
+  unsigned int m;
+  unsigned int fill;    // The number of values in the current block.
+  Complex *h;           // A copy of the kernel.
+  Complex *H;           // The kernel on the padded grid.
+  Complex *f,*g;        // The current block and the upper half of its result.
+  Complex *tail;        // The last m-1 values of the previous block's result.
+  ImplicitConvolution *C;
+
+  void init(unsigned int m);
+  void clear();
+  void process(Complex *y);
+  unsigned int select(unsigned int maxblock);
+public:
+  // The block length m must be at least K; if m=0, it is chosen by timing.
+  StreamConvolution(const Complex *kernel, unsigned int K, unsigned int m=0,
+                    unsigned int maxblock=0,
+                    unsigned int threads=fftw::maxthreads);
+
+  ~StreamConvolution() {
+    clear();
+    utils::deleteAlign(h);
+  }
+
+  unsigned int block() const {return m;}
+
+  // Append the n values x to the stream, writing to y (of size at least
+  // n+block()-1) and returning the number of completed output values.
+  unsigned int push(const Complex *x, unsigned int n, Complex *y);
+
+  // End the stream, writing to y (of size at least block()+K-1) and
+  // returning the remaining values of the full linear convolution, of
+  // length L+K-1 for L input values, and start a new stream.
+  unsigned int flush(Complex *y);
+
+  // Discard the current stream.
+  void reset();
+};
+
+#endif
+
+} //end namespace fftwpp
@@ -0,0 +1,181 @@
+#include "autoconvolution.h"
+#include "utils.h"
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Report the engines chosen by the automatic complex and Hermitian
+// convolutions of size m in 1D, mx x my in 2D, and mx x my x mz in 3D, time
+// them, and compare their results with direct summation.
+
+// Number of iterations.
+unsigned int N0=10000000;
+unsigned int N=0;
+unsigned int m=12;
+unsigned int mx=8;
+unsigned int my=8;
+unsigned int mz=4;
+
+int stats=0; // Type of statistics used in timing test.
+
+inline void init(Complex *f, Complex *g, unsigned int m)
+{
+  for(unsigned int i=0; i < m; ++i) {
+    f[i]=Complex(i % 7,1.0/(i+1));
+    g[i]=Complex(2.0*(i % 5),1.0/(i+2));
+  }
+  f[0]=f[0].real();
+  g[0]=g[0].real();
+}
+
+void check(Complex *f, Complex *h, unsigned int m)
+{
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int i=0; i < m; ++i) {
+    error += abs2(f[i]-h[i]);
+    norm += abs2(h[i]);
+  }
+  if(norm > 0) error=sqrt(error/norm);
+  cout << "error=" << error << endl;
+  if(error > 1e-12)
+    cerr << "Caution! error=" << error << endl;
+}
+
+// Time the convolution C of n values, and compare its result with that of
+// the direct convolution D.
+template<class T, class Direct>
+void test(const char *name, T& C, Direct& D, Complex *f, Complex *g,
+          Complex *h, unsigned int n, double *Times)
+{
+  cout << name << " engine=" << EngineName[C.engine()] << endl;
+  for(unsigned int i=0; i < N; ++i) {
+    init(f,g,n);
+    seconds();
+    C.convolve(f,g);
+    Times[i]=seconds();
+  }
+  timings("Auto",n,Times,N,stats);
+
+  init(f,g,n);
+  D.convolve(h,f,g);
+  C.convolve(f,g);
+  check(f,h,n);
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+#ifndef __SSE2__
+  fftw::effort |= FFTW_NO_SIMD;
+#endif
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c=getopt(argc,argv,"hN:m:x:y:z:n:T:S:");
+    if (c == -1) break;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'N':
+        N=atoi(optarg);
+        break;
+      case 'm':
+        m=atoi(optarg);
+        break;
+      case 'x':
+        mx=atoi(optarg);
+        break;
+      case 'y':
+        my=atoi(optarg);
+        break;
+      case 'z':
+        mz=atoi(optarg);
+        break;
+      case 'n':
+        N0=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'S':
+        stats=atoi(optarg);
+        break;
+      case 'h':
+      default:
+        usageCommon(3);
+        exit(0);
+    }
+  }
+
+  cout << "m=" << m << endl;
+  cout << "mx=" << mx << ", my=" << my << ", mz=" << mz << endl;
+
+  if(N == 0) {
+    N=N0/m;
+    N=max(N,20);
+  }
+  cout << "N=" << N << endl;
+
+  double *T=new double[N];
+
+  unsigned int n=max(m,2*mx*my);
+  n=max(n,4*mx*my*mz);
+  Complex *f=ComplexAlign(n);
+  Complex *g=ComplexAlign(n);
+  Complex *h=ComplexAlign(n);
+
+  cout << endl;
+  {
+    AutoConvolution C(m);
+    DirectConvolution D(m);
+    test("1D complex",C,D,f,g,h,m,T);
+  }
+
+  cout << endl;
+  {
+    AutoHConvolution C(m);
+    DirectHConvolution D(m);
+    test("1D Hermitian",C,D,f,g,h,m,T);
+  }
+
+  cout << endl;
+  {
+    AutoConvolution2 C(mx,my);
+    DirectConvolution2 D(mx,my);
+    test("2D complex",C,D,f,g,h,mx*my,T);
+  }
+
+  cout << endl;
+  {
+    AutoHConvolution2 C(mx,my);
+    DirectHConvolution2 D(mx,my);
+    test("2D Hermitian",C,D,f,g,h,(2*mx-1)*my,T);
+  }
+
+  cout << endl;
+  {
+    AutoConvolution3 C(mx,my,mz);
+    DirectConvolution3 D(mx,my,mz);
+    test("3D complex",C,D,f,g,h,mx*my*mz,T);
+  }
+
+  cout << endl;
+  {
+    AutoHConvolution3 C(mx,my,mz);
+    DirectHConvolution3 D(mx,my,mz);
+    test("3D Hermitian",C,D,f,g,h,(2*mx-1)*(2*my-1)*mz,T);
+  }
+
+  deleteAlign(h);
+  deleteAlign(g);
+  deleteAlign(f);
+  delete [] T;
+
+  return 0;
+}
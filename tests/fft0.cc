@@ -0,0 +1,158 @@
+#include "Complex.h"
+#include "fftw++.h"
+#include "utils.h"
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Compare the shifted real transforms, of even and odd sizes, with a
+// direct translation of the unshifted transforms.
+
+double tolerance=1e-12;
+
+inline double abs2(double x) {return x*x;}
+
+// Print the relative error of the rows x n values g, stored in rows of
+// length pad, with respect to the rows x n values f.
+template<class T>
+void test(const char *name, T *f, T *g, unsigned int rows, unsigned int n,
+          unsigned int pad)
+{
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int r=0; r < rows; ++r) {
+    for(unsigned int k=0; k < n; ++k) {
+      error += abs2(f[r*n+k]-g[r*pad+k]);
+      norm += abs2(f[r*n+k]);
+    }
+  }
+  if(norm > 0) error=sqrt(error/norm);
+  cout << name << " error=" << error << endl;
+  if(error > tolerance)
+    cerr << "Caution! error=" << error << endl;
+}
+
+void init(double *f, unsigned int rows, unsigned int n, unsigned int pad)
+{
+  for(unsigned int r=0; r < rows; ++r)
+    for(unsigned int k=0; k < n; ++k)
+      f[r*pad+k]=(r*n+k) % 5+1.0/(r+k+1);
+}
+
+// Test the shifted transforms of nx x ny x n real values (ny=1 for two
+// dimensions), stored in rows of length pad, using the arrays f and g,
+// which may coincide.
+template<class RC, class CR>
+void test(const char *name, RC& Forward, CR& Backward, unsigned int nx,
+          unsigned int ny, unsigned int n, unsigned int pad,
+          double *f, Complex *g)
+{
+  unsigned int rows=nx*ny;
+  unsigned int np=n/2+1;
+  unsigned int size=rows*np;
+  double scale=1.0/(rows*n);
+  double *F=doubleAlign(rows*n);
+  Complex *G=ComplexAlign(size);
+  string s=name;
+
+  // Translate the unshifted transform to move its origin to (nx/2,ny/2).
+  init(f,rows,n,pad);
+  Forward.fft(f,g);
+  for(unsigned int i=0; i < nx; ++i)
+    for(unsigned int j=0; j < ny; ++j) {
+      unsigned int I=(i+nx/2) % nx;
+      unsigned int J=(j+ny/2) % ny;
+      for(unsigned int k=0; k < np; ++k)
+        G[(I*ny+J)*np+k]=g[(i*ny+j)*np+k];
+    }
+
+  init(f,rows,n,pad);
+  Forward.fft0(f,g);
+  test((s+" fft0").c_str(),G,g,rows,np,np);
+
+  for(unsigned int i=0; i < size; ++i) G[i] *= scale;
+  init(f,rows,n,pad);
+  Forward.fft0Normalized(f,g);
+  test((s+" fft0Normalized").c_str(),G,g,rows,np,np);
+
+  init(F,rows,n,n);
+  for(unsigned int i=0; i < size; ++i) g[i]=G[i];
+  Backward.fft0(g,f);
+  test((s+" backward fft0").c_str(),F,f,rows,n,pad);
+
+  for(unsigned int i=0; i < size; ++i) g[i]=G[i]/scale;
+  Backward.fft0Normalized(g,f);
+  test((s+" backward fft0Normalized").c_str(),F,f,rows,n,pad);
+
+  deleteAlign(G);
+  deleteAlign(F);
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+  unsigned int nx=6;
+  unsigned int ny=4;
+  unsigned int nz=5;
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c = getopt(argc,argv,"x:y:z:T:h");
+    if (c == -1) break;
+    switch (c) {
+      case 0:
+        break;
+      case 'x':
+        nx=atoi(optarg);
+        break;
+      case 'y':
+        ny=atoi(optarg);
+        break;
+      case 'z':
+        nz=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'h':
+      default:
+        usageCommon(3);
+        exit(0);
+    }
+  }
+
+  cout << "nx=" << nx << ", ny=" << ny << ", nz=" << nz << endl;
+
+  unsigned int nzp=nz/2+1;
+  unsigned int size=max(nx*ny*nzp,nx*(ny*nz/2+1));
+  Complex *g=ComplexAlign(size);
+  double *f=doubleAlign(2*size);
+
+  {
+    rcfft2d Forward(nx,ny*nz,f,g);
+    crfft2d Backward(nx,ny*nz,g,f);
+    test("2D",Forward,Backward,nx,1,ny*nz,ny*nz,f,g);
+    rcfft2d Forward1(nx,ny*nz,g);
+    crfft2d Backward1(nx,ny*nz,g);
+    test("2D in-place",Forward1,Backward1,nx,1,ny*nz,2*(ny*nz/2+1),
+         (double *) g,g);
+  }
+
+  {
+    rcfft3d Forward(nx,ny,nz,f,g);
+    crfft3d Backward(nx,ny,nz,g,f);
+    test("3D",Forward,Backward,nx,ny,nz,nz,f,g);
+    rcfft3d Forward1(nx,ny,nz,g);
+    crfft3d Backward1(nx,ny,nz,g);
+    test("3D in-place",Forward1,Backward1,nx,ny,nz,2*nzp,(double *) g,g);
+  }
+
+  deleteAlign(f);
+  deleteAlign(g);
+
+  return 0;
+}
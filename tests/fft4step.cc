@@ -0,0 +1,116 @@
+#include "Complex.h"
+#include "Array.h"
+#include "fftw++.h"
+#include "utils.h"
+
+using namespace std;
+using namespace utils;
+using namespace Array;
+using namespace fftwpp;
+
+// Time the four-step 1D FFT against a plain fft1d plan and compare their
+// results.
+
+int main(int argc, char* argv[])
+{
+  cout << "1D Complex to complex four-step FFT" << endl;
+
+  unsigned int m=1 << 20; // Problem size
+  unsigned int n1=0;
+
+  int N=10;
+  int stats=MEAN; // Type of statistics used in timing test.
+
+  fftw::maxthreads=get_max_threads();
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c = getopt(argc,argv,"N:m:x:n:T:S:h");
+    if (c == -1) break;
+    switch (c) {
+      case 0:
+        break;
+      case 'N':
+        N=atoi(optarg);
+        break;
+      case 'm':
+        m=atoi(optarg);
+        break;
+      case 'x':
+        m=atoi(optarg);
+        break;
+      case 'n':
+        n1=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'S':
+        stats=atoi(optarg);
+        break;
+      case 'h':
+      default:
+        usageFFT(1);
+        std::cerr << "-n\t\t factor n1 of m (0=automatic)" << std::endl;
+        exit(0);
+    }
+  }
+
+  size_t align=sizeof(Complex);
+
+  array1<Complex> f(m,align);
+  array1<Complex> g(m,align);
+  array1<Complex> h(m,align);
+
+  fft1d Forward(m,-1,f,h);
+  fft1d4step Forward4(m,-1,f,g,n1);
+  fft1d4step Backward4(m,1,g,g,n1);
+
+  cout << "engine=" << (Forward4.engine == fft1d4step::FOURSTEP ?
+                        "four-step" : "plain") << endl;
+  Forward4.engine=Backward4.engine=fft1d4step::FOURSTEP;
+
+  double *T=new double[N];
+
+  for(int i=0; i < N; ++i) {
+    for(unsigned int j=0; j < m; j++) f[j]=Complex(j % 7,1.0/(j+1));
+    seconds();
+    Forward.fft(f,h);
+    T[i]=seconds();
+  }
+  timings("fft1d",m,T,N,stats);
+
+  for(int i=0; i < N; ++i) {
+    for(unsigned int j=0; j < m; j++) f[j]=Complex(j % 7,1.0/(j+1));
+    seconds();
+    Forward4.fft(f,g);
+    T[i]=seconds();
+  }
+  timings("four-step",m,T,N,stats);
+
+  for(unsigned int i=0; i < m; i++) f[i]=Complex(i % 7,1.0/(i+1));
+  Forward.fft(f,h);
+  Forward4.fft(f,g);
+
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int i=0; i < m; i++) {
+    error += abs2(g[i]-h[i]);
+    norm += abs2(h[i]);
+  }
+
+  Backward4.fftNormalized(g);
+  for(unsigned int i=0; i < m; i++) {
+    error += abs2(g[i]-f[i]);
+    norm += abs2(f[i]);
+  }
+
+  if(norm > 0) error=sqrt(error/norm);
+  cout << "error=" << error << endl;
+  if(error > 1e-12)
+    cerr << "Caution! error=" << error << endl;
+
+  delete [] T;
+}
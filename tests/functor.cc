@@ -0,0 +1,224 @@
+#include "convolution.h"
+#include "utils.h"
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Time a binary product passed to convolve as an inline multiplier object,
+// both through pointwise and as a hand-written object with the multiplier
+// signature, against the multbinary function pointer, and check that they
+// give the same results in 1D, 2D, and 3D.
+
+// Number of iterations.
+unsigned int N0=10000000;
+unsigned int N=0;
+unsigned int mx=1024;
+unsigned int my=0;
+unsigned int mz=0;
+
+struct product {
+  template<class T>
+  void operator()(T **F, unsigned int k) const {
+    F[0][k] *= F[1][k];
+  }
+};
+
+// A multiplier object with the full multiplier signature.
+struct binary {
+  void operator()(Complex **F, unsigned int m,
+                  const unsigned int indexsize, const unsigned int *index,
+                  unsigned int r, unsigned int threads) const {
+    Complex *F0=F[0];
+    Complex *F1=F[1];
+    PARALLEL(
+      for(unsigned int j=0; j < m; ++j)
+        F0[j] *= F1[j];
+      );
+  }
+};
+
+inline void init(Complex **F, unsigned int n, bool hermitian=false)
+{
+  for(unsigned int a=0; a < 2; ++a) {
+    Complex *f=F[a];
+    for(unsigned int i=0; i < n; ++i)
+      f[i]=Complex((a+1)*(i % 7),1.0/(a+i+1));
+    if(hermitian) f[0]=f[0].real();
+  }
+}
+
+void check(Complex *f, Complex *h, unsigned int n)
+{
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int i=0; i < n; ++i) {
+    error += abs2(f[i]-h[i]);
+    norm += abs2(h[i]);
+  }
+  if(norm > 0) error=sqrt(error/norm);
+  cout << "error=" << error << endl;
+  if(error > 1e-12)
+    cerr << "Caution! error=" << error << endl;
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+  int stats=0; // Type of statistics used in timing test.
+
+#ifndef __SSE2__
+  fftw::effort |= FFTW_NO_SIMD;
+#endif
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c=getopt(argc,argv,"hN:m:x:y:z:n:T:S:");
+    if (c == -1) break;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'N':
+        N=atoi(optarg);
+        break;
+      case 'm':
+        mx=atoi(optarg);
+        break;
+      case 'x':
+        mx=atoi(optarg);
+        break;
+      case 'y':
+        my=atoi(optarg);
+        break;
+      case 'z':
+        mz=atoi(optarg);
+        break;
+      case 'n':
+        N0=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'S':
+        stats=atoi(optarg);
+        break;
+      case 'h':
+      default:
+        usageCommon(3);
+        exit(0);
+    }
+  }
+
+  unsigned int m=mx;
+  if(my == 0) my=min(mx,64);
+  if(mz == 0) mz=min(mx,16);
+  cout << "m=" << m << endl;
+
+  if(N == 0) {
+    N=N0/m;
+    N=max(N,20);
+  }
+  cout << "N=" << N << endl;
+
+  double *T=new double[N];
+
+  unsigned int n=max(m,mx*my);
+  n=max(n,mz*mz*mz);
+  Complex *f=ComplexAlign(2*n);
+  Complex *F[]={f,f+n};
+  Complex *h=ComplexAlign(n);
+
+  cout << endl << "1D complex:" << endl;
+  {
+    ImplicitConvolution C(m);
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m);
+      seconds();
+      C.convolve(F,multbinary);
+      T[i]=seconds();
+    }
+    timings("multbinary",m,T,N,stats);
+    for(unsigned int i=0; i < m; ++i)
+      h[i]=F[0][i];
+
+    pointwise<product> mult;
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m);
+      seconds();
+      C.convolve(F,mult);
+      T[i]=seconds();
+    }
+    timings("pointwise",m,T,N,stats);
+    check(F[0],h,m);
+
+    init(F,m);
+    C.convolve(F,binary());
+    check(F[0],h,m);
+  }
+
+  cout << endl << "1D Hermitian:" << endl;
+  {
+    ImplicitHConvolution C(m);
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m,true);
+      seconds();
+      C.convolve(F,multbinary);
+      T[i]=seconds();
+    }
+    timings("multbinary",m,T,N,stats);
+    for(unsigned int i=0; i < m; ++i)
+      h[i]=F[0][i];
+
+    pointwise<product> mult;
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m,true);
+      seconds();
+      C.convolve(F,mult);
+      T[i]=seconds();
+    }
+    timings("pointwise",m,T,N,stats);
+    check(F[0],h,m);
+  }
+
+  cout << endl << "2D complex:" << endl;
+  {
+    unsigned int n=mx*my;
+    ImplicitConvolution2 C(mx,my);
+    init(F,n);
+    C.convolve(F,multbinary);
+    for(unsigned int i=0; i < n; ++i)
+      h[i]=F[0][i];
+
+    init(F,n);
+    C.convolve(F,pointwise<product>());
+    check(F[0],h,n);
+
+    init(F,n);
+    C.convolve(F,binary());
+    check(F[0],h,n);
+  }
+
+  cout << endl << "3D complex:" << endl;
+  {
+    unsigned int n=mz*mz*mz;
+    ImplicitConvolution3 C(mz,mz,mz);
+    init(F,n);
+    C.convolve(F,multbinary);
+    for(unsigned int i=0; i < n; ++i)
+      h[i]=F[0][i];
+
+    init(F,n);
+    C.convolve(F,pointwise<product>());
+    check(F[0],h,n);
+  }
+
+  deleteAlign(h);
+  deleteAlign(f);
+  delete [] T;
+
+  return 0;
+}
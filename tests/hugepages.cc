@@ -0,0 +1,181 @@
+#include "convolution.h"
+#include "utils.h"
+#include <sstream>
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Compare 3D transforms and convolutions on arrays backed by ordinary and
+// by transparent huge pages. The x and y passes of a 3D transform access
+// memory with the large strides my*mz and mz, respectively.
+
+// Number of iterations.
+unsigned int N0=10000000;
+unsigned int N=0;
+unsigned int mx=64;
+unsigned int my=64;
+unsigned int mz=64;
+
+inline void init(Complex *f, unsigned int n)
+{
+  for(unsigned int i=0; i < n; ++i)
+    f[i]=Complex(i % 7,1.0/(i+1));
+}
+
+inline void init(Complex **F)
+{
+  unsigned int n=mx*my*mz;
+  for(unsigned int i=0; i < n; ++i) {
+    F[0][i]=Complex(i % 5,1.0/(i+1));
+    F[1][i]=Complex(1.0/(i+1),i % 3);
+  }
+}
+
+void test(bool huge, int r, int stats, double *T)
+{
+  Array::HugePageBytes()=huge ? Array::hugepagesize : 0;
+  const char *pages=huge ? "huge pages" : "standard pages";
+  unsigned int n=mx*my*mz;
+  ostringstream text;
+
+  Complex *f=ComplexAlign(n);
+
+  if(r == -1 || r == 0) {
+    fft3d Forward(mx,my,mz,-1,f);
+    fft3d Backward(mx,my,mz,1,f);
+    for(unsigned int i=0; i < N; ++i) {
+      init(f,n);
+      seconds();
+      Forward.fft(f);
+      Backward.fft(f);
+      T[i]=0.5*seconds();
+    }
+    text.str("");
+    text << "fft3d, " << pages;
+    timings(text.str().c_str(),mx,T,N,stats);
+  }
+
+  if(r == -1 || r == 1) {
+    unsigned int myz=my*mz;
+    mfft1d Forward(mx,-1,myz,myz,1,f);
+    for(unsigned int i=0; i < N; ++i) {
+      init(f,n);
+      seconds();
+      Forward.fft(f);
+      T[i]=seconds();
+    }
+    text.str("");
+    text << "x pass, " << pages;
+    timings(text.str().c_str(),mx,T,N,stats);
+
+    mfft1d Forwardy(my,-1,mz,mz,1,f);
+    for(unsigned int i=0; i < N; ++i) {
+      init(f,n);
+      seconds();
+      for(unsigned int j=0; j < mx; ++j)
+        Forwardy.fft(f+j*myz);
+      T[i]=seconds();
+    }
+    text.str("");
+    text << "y pass, " << pages;
+    timings(text.str().c_str(),mx,T,N,stats);
+  }
+
+  if(r == -1 || r == 2) {
+    Complex *F[]={f,ComplexAlign(n)};
+    // The work arrays are allocated with the current page size.
+    ImplicitConvolution3 C(mx,my,mz);
+    for(unsigned int i=0; i < N; ++i) {
+      init(F);
+      seconds();
+      C.convolve(F,multbinary);
+      T[i]=seconds();
+    }
+    text.str("");
+    text << "cconv3, " << pages;
+    timings(text.str().c_str(),mx,T,N,stats);
+    deleteAlign(F[1]);
+  }
+
+  deleteAlign(f);
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+  int r=-1; // Which test to run: -1=all, 0=fft3d, 1=strided passes, 2=cconv3
+
+  int stats=0; // Type of statistics used in timing test.
+
+#ifndef __SSE2__
+  fftw::effort |= FFTW_NO_SIMD;
+#endif
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c=getopt(argc,argv,"hN:m:x:y:z:n:T:S:r:");
+    if (c == -1) break;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'N':
+        N=atoi(optarg);
+        break;
+      case 'm':
+        mx=my=mz=atoi(optarg);
+        break;
+      case 'x':
+        mx=atoi(optarg);
+        break;
+      case 'y':
+        my=atoi(optarg);
+        break;
+      case 'z':
+        mz=atoi(optarg);
+        break;
+      case 'n':
+        N0=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'S':
+        stats=atoi(optarg);
+        break;
+      case 'r':
+        r=atoi(optarg);
+        break;
+      case 'h':
+      default:
+        usageCommon(3);
+        std::cerr << "-r\t\t type of run:\n"
+                  << "\t\t r=-1: all runs\n"
+                  << "\t\t r=0: fft3d\n"
+                  << "\t\t r=1: strided x and y passes\n"
+                  << "\t\t r=2: cconv3\n";
+        exit(0);
+    }
+  }
+
+  cout << "mx=" << mx << ", my=" << my << ", mz=" << mz << endl;
+
+  if(N == 0) {
+    N=N0/mx/my/mz;
+    N=max(N,20);
+  }
+  cout << "N=" << N << endl;
+
+  double *T=new double[N];
+
+  test(false,r,stats,T);
+  cout << endl;
+  test(true,r,stats,T);
+
+  delete [] T;
+
+  return 0;
+}
@@ -0,0 +1,213 @@
+#include "Complex.h"
+#include "fftw++.h"
+#include "utils.h"
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Compare the batched two- and three-dimensional transforms with
+// transforms of the individual arrays.
+
+double tolerance=1e-12;
+
+inline double abs2(double x) {return x*x;}
+
+// Print the relative error of the M arrays g, spaced dist apart, with
+// respect to the M arrays f, each of length n and spaced n apart.
+template<class T>
+void test(const char *name, T *f, T *g, unsigned int n, unsigned int M,
+          size_t dist)
+{
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int m=0; m < M; ++m) {
+    for(unsigned int i=0; i < n; ++i) {
+      error += abs2(f[m*n+i]-g[m*dist+i]);
+      norm += abs2(f[m*n+i]);
+    }
+  }
+  if(norm > 0) error=sqrt(error/norm);
+  cout << name << " error=" << error << endl;
+  if(error > tolerance)
+    cerr << "Caution! error=" << error << endl;
+}
+
+void init(Complex *f, unsigned int n, unsigned int M, size_t dist)
+{
+  for(unsigned int m=0; m < M; ++m)
+    for(unsigned int i=0; i < n; ++i)
+      f[m*dist+i]=Complex(i % 7+m,1.0/(i+1));
+}
+
+void init(double *f, unsigned int rows, unsigned int cols,
+          unsigned int pad, unsigned int M, size_t dist)
+{
+  for(unsigned int m=0; m < M; ++m)
+    for(unsigned int i=0; i < rows; ++i)
+      for(unsigned int j=0; j < cols; ++j)
+        f[m*dist+i*pad+j]=(i*cols+j) % 5+m+1.0/(i+j+1);
+}
+
+// Test the complex transform of M arrays with dimensions nx x ny x nz
+// (nz=1 for two dimensions) against that of each array.
+template<class B, class S>
+void testcomplex(const char *name, B& Batch, S& Single,
+                 unsigned int n, unsigned int M, size_t dist,
+                 Complex *f, Complex *g, Complex *h)
+{
+  init(f,n,M,n);
+  for(unsigned int m=0; m < M; ++m)
+    Single.fft(f+m*n,g+m*n);
+  init(h,n,M,dist);
+  Batch.fft(h);
+  test(name,g,h,n,M,dist);
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+  unsigned int nx=6;
+  unsigned int ny=5;
+  unsigned int nz=4;
+  unsigned int M=5;
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c = getopt(argc,argv,"M:x:y:z:T:h");
+    if (c == -1) break;
+    switch (c) {
+      case 0:
+        break;
+      case 'M':
+        M=atoi(optarg);
+        break;
+      case 'x':
+        nx=atoi(optarg);
+        break;
+      case 'y':
+        ny=atoi(optarg);
+        break;
+      case 'z':
+        nz=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'h':
+      default:
+        usageCommon(3);
+        exit(0);
+    }
+  }
+
+  cout << "nx=" << nx << ", ny=" << ny << ", nz=" << nz << ", M=" << M
+       << endl;
+
+  unsigned int n=nx*ny*nz;
+  unsigned int nzp=nz/2+1;
+  unsigned int np=nx*ny*nzp;
+  size_t dist=n+3; // Leave gaps between the arrays.
+
+  Complex *f=ComplexAlign(M*dist);
+  Complex *g=ComplexAlign(M*dist);
+  Complex *h=ComplexAlign(M*dist);
+
+  {
+    mfft2d Batch(nx,ny*nz,-1,M,1,dist,h);
+    fft2d Single(nx,ny*nz,-1,f,g);
+    testcomplex("mfft2d",Batch,Single,n,M,dist,f,g,h);
+  }
+
+  {
+    mfft3d Batch(nx,ny,nz,1,M,1,dist,h);
+    fft3d Single(nx,ny,nz,1,f,g);
+    testcomplex("mfft3d",Batch,Single,n,M,dist,f,g,h);
+  }
+
+  {
+    // Interleaved arrays: stride M and dist 1.
+    mfft3d Batch(nx,ny,nz,-1,M,M,1,h);
+    fft3d Single(nx,ny,nz,-1,f,g);
+    init(f,n,M,n);
+    for(unsigned int m=0; m < M; ++m) {
+      Single.fft(f+m*n,g+m*n);
+      for(unsigned int i=0; i < n; ++i)
+        h[i*M+m]=f[m*n+i];
+    }
+    Batch.fft(h);
+    for(unsigned int m=0; m < M; ++m)
+      for(unsigned int i=0; i < n; ++i)
+        f[m*n+i]=h[i*M+m];
+    test("mfft3d interleaved",g,f,n,M,n);
+  }
+
+  double *r=doubleAlign(M*dist);
+  double *s=doubleAlign(2*M*dist);
+
+  {
+    // Out of place.
+    mrcfft3d Forward(nx,ny,nz,M,1,1,n,np,r,h);
+    mcrfft3d Backward(nx,ny,nz,M,1,1,np,n,h,r);
+    rcfft3d Single(nx,ny,nz,s,g);
+    init(s,nx*ny,nz,nz,M,n);
+    for(unsigned int m=0; m < M; ++m)
+      Single.fft(s+m*n,g+m*np);
+    init(r,nx*ny,nz,nz,M,n);
+    Forward.fft(r,h);
+    test("mrcfft3d",g,h,np,M,np);
+    Backward.fftNormalized(h,r);
+    test("mcrfft3d",s,r,M*n,1,0);
+  }
+
+  {
+    // In place, with each row padded to 2*nzp values.
+    size_t cdist=np+1;
+    mrcfft3d Forward(nx,ny,nz,M,1,1,2*cdist,cdist,(double *) h,h);
+    mcrfft3d Backward(nx,ny,nz,M,1,1,cdist,2*cdist,h,(double *) h);
+    rcfft3d Single(nx,ny,nz,s,g);
+    init(s,nx*ny,nz,nz,M,n);
+    for(unsigned int m=0; m < M; ++m)
+      Single.fft(s+m*n,g+m*np);
+    init((double *) h,nx*ny,nz,2*nzp,M,2*cdist);
+    Forward.fft(h);
+    test("mrcfft3d in-place",g,h,np,M,cdist);
+    Backward.fftNormalized(h);
+    double *H=(double *) h;
+    for(unsigned int m=0; m < M; ++m)
+      for(unsigned int i=0; i < nx*ny; ++i)
+        for(unsigned int k=0; k < nz; ++k)
+          r[m*n+i*nz+k]=H[m*2*cdist+i*2*nzp+k];
+    test("mcrfft3d in-place",s,r,M*n,1,0);
+  }
+
+  {
+    unsigned int my=ny*nz;
+    unsigned int myp=my/2+1;
+    unsigned int mp=nx*myp;
+    size_t rdist=n+1;
+    size_t cdist=mp+2;
+    mrcfft2d Forward(nx,my,M,1,1,rdist,cdist,r,h);
+    mcrfft2d Backward(nx,my,M,1,1,cdist,rdist,h,r);
+    rcfft2d Single(nx,my,s,g);
+    init(s,nx,my,my,M,n);
+    for(unsigned int m=0; m < M; ++m)
+      Single.fft(s+m*n,g+m*mp);
+    init(r,nx,my,my,M,rdist);
+    Forward.fft(r,h);
+    test("mrcfft2d",g,h,mp,M,cdist);
+    Backward.fftNormalized(h,r);
+    test("mcrfft2d",s,r,n,M,rdist);
+  }
+
+  deleteAlign(s);
+  deleteAlign(r);
+  deleteAlign(h);
+  deleteAlign(g);
+  deleteAlign(f);
+
+  return 0;
+}
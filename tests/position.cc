@@ -0,0 +1,223 @@
+#include "convolution.h"
+#include "utils.h"
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Time a position-dependent product, computed with the positional
+// multiplier object, against multbinary, and check the coordinates: a
+// factor exp(i(x+y)) in physical space shifts a complex convolution by one
+// mode along each dimension, and a factor cos(x) averages the neighbouring
+// modes of a Hermitian convolution.
+
+// Number of iterations.
+unsigned int N0=10000000;
+unsigned int N=0;
+unsigned int mx=1024;
+unsigned int my=0;
+
+struct ramp {
+  template<class T>
+  void operator()(T **F, unsigned int k, const position& P) const {
+    F[0][k] *= F[1][k]*P(k);
+  }
+};
+
+struct shift {
+  void operator()(Complex **F, unsigned int k, const position& P) const {
+    double x=P.x[0]+P(k);
+    F[0][k] *= F[1][k]*Complex(cos(x),sin(x));
+  }
+};
+
+struct average {
+  void operator()(double **F, unsigned int k, const position& P) const {
+    F[0][k] *= F[1][k]*cos(P(k));
+  }
+};
+
+inline void init(Complex **F, unsigned int n)
+{
+  for(unsigned int a=0; a < 2; ++a) {
+    Complex *f=F[a];
+    for(unsigned int i=0; i < n; ++i)
+      f[i]=Complex((a+1)*(i % 7),1.0/(a+i+1));
+  }
+}
+
+inline void hinit(Complex **F, unsigned int n)
+{
+  init(F,n);
+  for(unsigned int a=0; a < 2; ++a)
+    F[a][0]=F[a][0].real();
+}
+
+void check(double error, double norm)
+{
+  error=norm > 0 ? sqrt(error/norm) : 0.0;
+  cout << "error=" << error << endl;
+  if(error > 1e-12)
+    cerr << "Caution! error=" << error << endl;
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+  int stats=0; // Type of statistics used in timing test.
+
+#ifndef __SSE2__
+  fftw::effort |= FFTW_NO_SIMD;
+#endif
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c=getopt(argc,argv,"hN:m:x:y:n:T:S:");
+    if (c == -1) break;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'N':
+        N=atoi(optarg);
+        break;
+      case 'm':
+        mx=my=atoi(optarg);
+        break;
+      case 'x':
+        mx=atoi(optarg);
+        break;
+      case 'y':
+        my=atoi(optarg);
+        break;
+      case 'n':
+        N0=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'S':
+        stats=atoi(optarg);
+        break;
+      case 'h':
+      default:
+        usageCommon(2);
+        exit(0);
+    }
+  }
+
+  if(my == 0) my=mx;
+  unsigned int m=mx;
+  cout << "m=" << m << endl;
+
+  if(N == 0) {
+    N=N0/m;
+    N=max(N,20);
+  }
+  cout << "N=" << N << endl;
+
+  double *T=new double[N];
+
+  unsigned int n=max(m,mx*my);
+  Complex *f=ComplexAlign(2*n);
+  Complex *F[]={f,f+n};
+  Complex *h=ComplexAlign(n);
+
+  cout << endl << "1D complex:" << endl;
+  {
+    ImplicitConvolution C(m);
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m);
+      seconds();
+      C.convolve(F,multbinary);
+      T[i]=seconds();
+    }
+    timings("multbinary",m,T,N,stats);
+    for(unsigned int i=0; i < m; ++i)
+      h[i]=F[0][i];
+
+    positional<ramp> mult(grid(false));
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m);
+      seconds();
+      C.convolve(F,mult);
+      T[i]=seconds();
+    }
+    timings("positional",m,T,N,stats);
+
+    init(F,m);
+    C.convolve(F,positional<shift>(grid(false)));
+
+    double error=abs2(F[0][0]), norm=0.0;
+    for(unsigned int i=1; i < m; ++i) {
+      error += abs2(F[0][i]-h[i-1]);
+      norm += abs2(h[i-1]);
+    }
+    check(error,norm);
+  }
+
+  cout << endl << "1D Hermitian:" << endl;
+  {
+    ImplicitHConvolution C(m);
+    for(unsigned int i=0; i < N; ++i) {
+      hinit(F,m);
+      seconds();
+      C.convolve(F,multbinary);
+      T[i]=seconds();
+    }
+    timings("multbinary",m,T,N,stats);
+    for(unsigned int i=0; i < m; ++i)
+      h[i]=F[0][i];
+
+    positional<ramp> mult(grid(true));
+    for(unsigned int i=0; i < N; ++i) {
+      hinit(F,m);
+      seconds();
+      C.convolve(F,mult);
+      T[i]=seconds();
+    }
+    timings("positional",m,T,N,stats);
+
+    hinit(F,m);
+    C.convolve(F,positional<average>(grid(true)));
+
+    double error=abs2(F[0][0]-0.5*(conj(h[1])+h[1])), norm=0.0;
+    for(unsigned int i=1; i < m-1; ++i) {
+      Complex hi=0.5*(h[i-1]+h[i+1]);
+      error += abs2(F[0][i]-hi);
+      norm += abs2(hi);
+    }
+    check(error,norm);
+  }
+
+  cout << endl << "2D complex:" << endl;
+  {
+    ImplicitConvolution2 C(mx,my);
+    init(F,mx*my);
+    C.convolve(F,multbinary);
+    for(unsigned int i=0; i < mx*my; ++i)
+      h[i]=F[0][i];
+
+    init(F,mx*my);
+    C.convolve(F,positional<shift>(grid(false,mx)));
+
+    double error=0.0, norm=0.0;
+    for(unsigned int i=0; i < mx; ++i) {
+      for(unsigned int j=0; j < my; ++j) {
+        Complex hij=i > 0 && j > 0 ? h[(i-1)*my+j-1] : 0.0;
+        error += abs2(F[0][i*my+j]-hij);
+        norm += abs2(hij);
+      }
+    }
+    check(error,norm);
+  }
+
+  deleteAlign(h);
+  deleteAlign(f);
+  delete [] T;
+
+  return 0;
+}
@@ -0,0 +1,217 @@
+#include "convolution.h"
+#include "direct.h"
+#include "utils.h"
+
+#include <sys/wait.h>
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Time the implicitly dealiased complex convolutions with the padding ratio
+// p/q, and compare their results with direct summation: binary products in
+// 1, 2, and 3 dimensions, and, in 1D, a ternary product. Finally, check that
+// a ratio too small to dealias a binary product is rejected.
+
+// Number of iterations.
+unsigned int N0=10000000;
+unsigned int N=0;
+unsigned int m=12;
+unsigned int mx=8;
+unsigned int my=8;
+unsigned int mz=8;
+unsigned int p=9;
+unsigned int q=4;
+
+struct ternary {
+  void operator()(Complex **F, unsigned int k) const {
+    F[0][k] *= F[1][k]*F[2][k];
+  }
+};
+
+inline void init(Complex **F, unsigned int n, unsigned int A)
+{
+  for(unsigned int a=0; a < A; ++a) {
+    Complex *f=F[a];
+    for(unsigned int i=0; i < n; ++i)
+      f[i]=Complex((a+1)*(i % 7),1.0/(a+i+1));
+  }
+}
+
+void check(Complex *f, Complex *h, unsigned int n)
+{
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int i=0; i < n; ++i) {
+    error += abs2(f[i]-h[i]);
+    norm += abs2(h[i]);
+  }
+  if(norm > 0) error=sqrt(error/norm);
+  cout << "error=" << error << endl;
+  if(error > 1e-12)
+    cerr << "Caution! error=" << error << endl;
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+  int stats=0; // Type of statistics used in timing test.
+
+#ifndef __SSE2__
+  fftw::effort |= FFTW_NO_SIMD;
+#endif
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c=getopt(argc,argv,"hN:m:x:y:z:p:q:n:T:S:");
+    if (c == -1) break;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'N':
+        N=atoi(optarg);
+        break;
+      case 'm':
+        m=atoi(optarg);
+        break;
+      case 'x':
+        mx=atoi(optarg);
+        break;
+      case 'y':
+        my=atoi(optarg);
+        break;
+      case 'z':
+        mz=atoi(optarg);
+        break;
+      case 'p':
+        p=atoi(optarg);
+        break;
+      case 'q':
+        q=atoi(optarg);
+        break;
+      case 'n':
+        N0=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'S':
+        stats=atoi(optarg);
+        break;
+      case 'h':
+      default:
+        usageCommon(3);
+        std::cerr << "-p\t\t padding ratio numerator" << std::endl;
+        std::cerr << "-q\t\t padding ratio denominator" << std::endl;
+        exit(0);
+    }
+  }
+
+  cout << "m=" << m << endl;
+  cout << "p/q=" << p << "/" << q << endl;
+
+  if(N == 0) {
+    N=N0/m;
+    N=max(N,20);
+  }
+  cout << "N=" << N << endl;
+
+  double *T=new double[N];
+
+  unsigned int n=max(m,mx*my*mz);
+  Complex *f=ComplexAlign(3*n);
+  Complex *F[]={f,f+n,f+2*n};
+  Complex *h=ComplexAlign(n);
+  Complex *h2=ComplexAlign(n);
+
+  cout << endl << "1D binary:" << endl;
+  {
+    ImplicitPQConvolution C(m,p,q);
+    cout << "N=" << p*ceilquotient(m,q) << endl;
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m,2);
+      seconds();
+      C.convolve(F,multbinary);
+      T[i]=seconds();
+    }
+    timings("Implicit p/q",m,T,N,stats);
+
+    ImplicitConvolution C2(m);
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m,2);
+      seconds();
+      C2.convolve(F,multbinary);
+      T[i]=seconds();
+    }
+    timings("Implicit 2/1",m,T,N,stats);
+
+    init(F,m,2);
+    DirectConvolution D(m);
+    D.convolve(h,F[0],F[1]);
+    C.convolve(F,multbinary);
+    check(F[0],h,m);
+  }
+
+  cout << endl << "1D ternary:" << endl;
+  {
+    unsigned int p3=max(p,3*q);
+    cout << "p/q=" << p3 << "/" << q << endl;
+    ImplicitPQConvolution C(m,p3,q,3,1);
+    init(F,m,3);
+    DirectConvolution D(m);
+    D.convolve(h2,F[0],F[1]);
+    D.convolve(h,h2,F[2]);
+    C.convolve(F,pointwise<ternary>());
+    check(F[0],h,m);
+  }
+
+  cout << endl << "2D binary:" << endl;
+  {
+    ImplicitPQConvolution2 C(mx,my,p,q);
+    init(F,mx*my,2);
+    DirectConvolution2 D(mx,my);
+    D.convolve(h,F[0],F[1]);
+    C.convolve(F,multbinary);
+    check(F[0],h,mx*my);
+  }
+
+  cout << endl << "3D binary:" << endl;
+  {
+    ImplicitPQConvolution3 C(mx,my,mz,p,q);
+    init(F,mx*my*mz,2);
+    DirectConvolution3 D(mx,my,mz);
+    D.convolve(h,F[0],F[1]);
+    C.convolve(F,multbinary);
+    check(F[0],h,mx*my*mz);
+  }
+
+  cout << endl << "Insufficient ratio:" << endl;
+  {
+    unsigned int p=5, q=3;
+    cout << "p/q=" << p << "/" << q << endl;
+    if(ImplicitPQConvolution::dealiased(m,p,q,2))
+      cerr << "Caution! p/q=" << p << "/" << q << " does not dealias m=" << m
+           << endl;
+    pid_t pid=fork();
+    if(pid == 0) {
+      ImplicitPQConvolution C(m,p,q);
+      _exit(0);
+    }
+    int status;
+    waitpid(pid,&status,0);
+    if(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+      cerr << "Caution! p/q=" << p << "/" << q << " was not rejected" << endl;
+    else cout << "rejected" << endl;
+  }
+
+  deleteAlign(h2);
+  deleteAlign(h);
+  deleteAlign(f);
+  delete [] T;
+
+  return 0;
+}
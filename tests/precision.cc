@@ -0,0 +1,357 @@
+#include "Complex.h"
+#include "fftw++.h"
+#include "convolution.h"
+#include "utils.h"
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Compare the float and long double transforms and implicit convolutions
+// with the double ones, and the transforms with a direct transform computed
+// in long double.
+
+// Allocate n values of type T, aligned as the transforms of precision Real
+// require.
+template<class Real, class T>
+T *Align(unsigned int n)
+{
+  T *v;
+  Array::newAlign(v,n,sizeof(typename fftwTraits<Real>::Complex));
+  return v;
+}
+
+// Print the relative error of g with respect to the n values f.
+template<class C>
+void test(const char *name, const char *precision, Complex *f, C *g,
+          unsigned int n, double tolerance)
+{
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int i=0; i < n; ++i) {
+    error += abs2(f[i]-Complex(g[i].real(),g[i].imag()));
+    norm += abs2(f[i]);
+  }
+  if(norm > 0) error=sqrt(error/norm);
+  cout << precision << " " << name << " error=" << error << endl;
+  if(error > tolerance)
+    cerr << "Caution! error=" << error << endl;
+}
+
+// Planning may overwrite the arrays, so initialize them afterwards.
+template<class Real, class C>
+void init(Complex *f, C *g, unsigned int n, double *r, Real *s,
+          unsigned int nr)
+{
+  for(unsigned int i=0; i < n; ++i) {
+    f[i]=Complex(i % 7,1.0/(i+1));
+    g[i]=C(f[i].real(),f[i].imag());
+  }
+  for(unsigned int i=0; i < nr; ++i) {
+    r[i]=(i % 5)+1.0/(i+1);
+    s[i]=r[i];
+  }
+}
+
+template<class Real>
+void test(const char *precision, unsigned int m, double tolerance)
+{
+  typedef typename fftwTraits<Real>::Complex C;
+  unsigned int M=3;
+  unsigned int n=m*m*m;
+  unsigned int mp=m/2+1;
+
+  Complex *f=ComplexAlign(M*n);
+  C *g=Align<Real,C>(M*n);
+  Complex *F=ComplexAlign(M*n);
+  C *G=Align<Real,C>(M*n);
+  double *r=doubleAlign(n);
+  Real *s=Align<Real,Real>(n);
+
+  {
+    fft1d Forward(m,-1,f,F);
+    fft1dT<Real> ForwardT(m,-1,g,G);
+    init(f,g,M*n,r,s,n);
+    Forward.fft(f,F);
+    ForwardT.fft(g,G);
+    test("fft1d",precision,F,G,m,tolerance);
+  }
+
+  {
+    mfft1d Forward(m,-1,M,1,m,f,F);
+    mfft1dT<Real> ForwardT(m,-1,M,1,m,g,G);
+    init(f,g,M*n,r,s,n);
+    Forward.fft(f,F);
+    ForwardT.fft(g,G);
+    test("mfft1d",precision,F,G,M*m,tolerance);
+  }
+
+  {
+    rcfft1d Forward(m,r,F);
+    rcfft1dT<Real> ForwardT(m,s,G);
+    crfft1d Backward(m,F,(double *) f);
+    crfft1dT<Real> BackwardT(m,G,(Real *) g);
+    init(f,g,M*n,r,s,n);
+    Forward.fft(r,F);
+    ForwardT.fft(s,G);
+    test("rcfft1d",precision,F,G,mp,tolerance);
+
+    Backward.fftNormalized(F,(double *) f);
+    BackwardT.fftNormalized(G,(Real *) g);
+    test("crfft1d",precision,f,g,m/2,tolerance);
+  }
+
+  {
+    fft2d Forward(m,m,-1,f,F);
+    fft2dT<Real> ForwardT(m,m,-1,g,G);
+    init(f,g,M*n,r,s,n);
+    Forward.fft(f,F);
+    ForwardT.fft(g,G);
+    test("fft2d",precision,F,G,m*m,tolerance);
+  }
+
+  {
+    rcfft2d Forward(m,m,r,F);
+    rcfft2dT<Real> ForwardT(m,m,s,G);
+    init(f,g,M*n,r,s,n);
+    Forward.fft(r,F);
+    ForwardT.fft(s,G);
+    test("rcfft2d",precision,F,G,m*mp,tolerance);
+  }
+
+  {
+    fft3d Forward(m,m,m,-1,f,F);
+    fft3dT<Real> ForwardT(m,m,m,-1,g,G);
+    init(f,g,M*n,r,s,n);
+    Forward.fft(f,F);
+    ForwardT.fft(g,G);
+    test("fft3d",precision,F,G,n,tolerance);
+  }
+
+  {
+    rcfft3d Forward(m,m,m,r,F);
+    rcfft3dT<Real> ForwardT(m,m,m,s,G);
+    init(f,g,M*n,r,s,n);
+    Forward.fft(r,F);
+    ForwardT.fft(s,G);
+    test("rcfft3d",precision,F,G,m*m*mp,tolerance);
+  }
+
+  {
+    Transpose T(m,m*m,1,f,F);
+    TransposeT<Real> TT(m,m*m,1,g,G);
+    init(f,g,M*n,r,s,n);
+    T.transpose(f,F);
+    TT.transpose(g,G);
+    test("Transpose",precision,F,G,n,tolerance);
+  }
+
+  deleteAlign(s);
+  deleteAlign(r);
+  deleteAlign(G);
+  deleteAlign(F);
+  deleteAlign(g);
+  deleteAlign(f);
+}
+
+// Set the A inputs of length n of the double and Real convolutions,
+// making the first value of each real when hermitian is true.
+template<class C>
+void init(Complex **F, C **G, unsigned int A, unsigned int n,
+          bool hermitian=false)
+{
+  for(unsigned int a=0; a < A; ++a) {
+    for(unsigned int i=0; i < n; ++i) {
+      F[a][i]=Complex(i % 7+a,1.0/(i+a+1));
+      G[a][i]=C(F[a][i].real(),F[a][i].imag());
+    }
+    if(hermitian) {
+      F[a][0]=F[a][0].real();
+      G[a][0]=G[a][0].real();
+    }
+  }
+}
+
+// Compare the binary implicit convolutions of precision Real with the
+// double ones.
+template<class Real>
+void convolution(const char *precision, unsigned int m, double tolerance)
+{
+  typedef typename fftwTraits<Real>::Complex C;
+  unsigned int A=2;
+  unsigned int nx=2*m-1;
+  unsigned int n=nx*m;
+
+  Complex *F[2];
+  C *G[2];
+  for(unsigned int a=0; a < A; ++a) {
+    F[a]=ComplexAlign(n);
+    G[a]=Align<Real,C>(n);
+  }
+
+  {
+    ImplicitConvolution Convolution(m);
+    ImplicitConvolutionT<Real> ConvolutionT(m);
+    init(F,G,A,m);
+    Convolution.convolve(F,multbinary);
+    ConvolutionT.convolve(G,multbinary);
+    test("ImplicitConvolution",precision,F[0],G[0],m,tolerance);
+  }
+
+  {
+    ImplicitHConvolution Convolution(m);
+    ImplicitHConvolutionT<Real> ConvolutionT(m);
+    init(F,G,A,m,true);
+    Convolution.convolve(F,multbinary);
+    ConvolutionT.convolve(G,multbinary);
+    test("ImplicitHConvolution",precision,F[0],G[0],m,tolerance);
+  }
+
+  {
+    ImplicitConvolution2 Convolution(m,m);
+    ImplicitConvolution2T<Real> ConvolutionT(m,m);
+    init(F,G,A,m*m);
+    Convolution.convolve(F,multbinary);
+    ConvolutionT.convolve(G,multbinary);
+    test("ImplicitConvolution2",precision,F[0],G[0],m*m,tolerance);
+  }
+
+  {
+    ImplicitHConvolution2 Convolution(m,m);
+    ImplicitHConvolution2T<Real> ConvolutionT(m,m);
+    init(F,G,A,n);
+    for(unsigned int a=0; a < A; ++a) {
+      HermitianSymmetrizeX(m,m,m-1,F[a]);
+      HermitianSymmetrizeX(m,m,m-1,G[a]);
+    }
+    Convolution.convolve(F,multbinary);
+    ConvolutionT.convolve(G,multbinary);
+    test("ImplicitHConvolution2",precision,F[0],G[0],n,tolerance);
+  }
+
+  for(unsigned int a=0; a < A; ++a) {
+    deleteAlign(G[a]);
+    deleteAlign(F[a]);
+  }
+}
+
+// Compare the complex and real transforms of length m in precision Real with
+// a direct transform computed in long double, which resolves the roundoff
+// error of the long double transforms.
+template<class Real>
+void direct(const char *precision, unsigned int m, long double tolerance)
+{
+  typedef typename fftwTraits<Real>::Complex C;
+  typedef std::complex<long double> L;
+  unsigned int mp=m/2+1;
+
+  C *g=Align<Real,C>(m);
+  C *G=Align<Real,C>(m);
+  Real *s=Align<Real,Real>(m);
+  L *h=new L[m];
+  L *H=new L[m];
+  L *S=new L[mp];
+
+  fft1dT<Real> Forward(m,-1,g,G);
+  rcfft1dT<Real> rcForward(m,s,G);
+
+  for(unsigned int i=0; i < m; ++i) {
+    g[i]=C(i % 7,(Real) 1/(i+1));
+    h[i]=L(g[i].real(),g[i].imag());
+  }
+  Forward.fft(g,G);
+
+  long double twopi=2*acosl(-1.0L);
+  for(unsigned int k=0; k < m; ++k) {
+    L sum=0.0L;
+    for(unsigned int j=0; j < m; ++j) {
+      long double theta=-twopi*((j*k) % m)/m;
+      sum += h[j]*L(cosl(theta),sinl(theta));
+    }
+    H[k]=sum;
+  }
+
+  long double error=0.0L;
+  long double norm=0.0L;
+  for(unsigned int k=0; k < m; ++k) {
+    error += std::norm(H[k]-L(G[k].real(),G[k].imag()));
+    norm += std::norm(H[k]);
+  }
+  error=sqrtl(error/norm);
+  cout << precision << " fft1d direct error=" << error << endl;
+  if(error > tolerance)
+    cerr << "Caution! error=" << error << endl;
+
+  for(unsigned int i=0; i < m; ++i)
+    s[i]=(i % 5)+(Real) 1/(i+1);
+  rcForward.fft(s,G);
+
+  for(unsigned int k=0; k < mp; ++k) {
+    L sum=0.0L;
+    for(unsigned int j=0; j < m; ++j) {
+      long double theta=-twopi*((j*k) % m)/m;
+      sum += (long double) s[j]*L(cosl(theta),sinl(theta));
+    }
+    S[k]=sum;
+  }
+
+  error=0.0L;
+  norm=0.0L;
+  for(unsigned int k=0; k < mp; ++k) {
+    error += std::norm(S[k]-L(G[k].real(),G[k].imag()));
+    norm += std::norm(S[k]);
+  }
+  error=sqrtl(error/norm);
+  cout << precision << " rcfft1d direct error=" << error << endl;
+  if(error > tolerance)
+    cerr << "Caution! error=" << error << endl;
+
+  delete [] S;
+  delete [] H;
+  delete [] h;
+  deleteAlign(s);
+  deleteAlign(G);
+  deleteAlign(g);
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+  unsigned int m=16;
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c = getopt(argc,argv,"m:T:h");
+    if (c == -1) break;
+    switch (c) {
+      case 0:
+        break;
+      case 'm':
+        m=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'h':
+      default:
+        usageCommon(1);
+        exit(0);
+    }
+  }
+
+  cout << "Precision test with m=" << m << endl;
+
+  test<float>("float",m,1e-5);
+  test<long double>("long double",m,1e-12);
+
+  convolution<float>("float",m,1e-5);
+  convolution<long double>("long double",m,1e-12);
+
+  direct<float>("float",m,1e-6L);
+  direct<long double>("long double",m,1e-18L);
+
+  return 0;
+}
@@ -0,0 +1,207 @@
+#include "Complex.h"
+#include "convolution.h"
+#include "utils.h"
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Test the real-to-real transforms against direct sums and against each
+// other, and the implicitly dealiased cosine-series product against a
+// direct product.
+
+double tolerance=1e-12;
+
+inline double abs2(double x) {return x*x;}
+
+// Print the relative error of the M vectors g, spaced dist apart, with
+// respect to the M vectors f, each of length n and spaced n apart.
+void test(const char *name, double *f, double *g, unsigned int n,
+          unsigned int M=1, size_t dist=0)
+{
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int m=0; m < M; ++m) {
+    for(unsigned int i=0; i < n; ++i) {
+      error += abs2(f[m*n+i]-g[m*dist+i]);
+      norm += abs2(f[m*n+i]);
+    }
+  }
+  if(norm > 0) error=sqrt(error/norm);
+  cout << name << " error=" << error << endl;
+  if(error > tolerance)
+    cerr << "Caution! error=" << error << endl;
+}
+
+void init(double *f, unsigned int n, unsigned int M=1, size_t dist=0)
+{
+  for(unsigned int m=0; m < M; ++m)
+    for(unsigned int i=0; i < n; ++i)
+      f[m*dist+i]=(i % 7)+m+1.0/(i+1);
+}
+
+// The DCT-II of the n values f.
+void redft10(double *f, double *g, unsigned int n)
+{
+  for(unsigned int k=0; k < n; ++k) {
+    double sum=0.0;
+    for(unsigned int j=0; j < n; ++j)
+      sum += 2.0*f[j]*cos(M_PI*(j+0.5)*k/n);
+    g[k]=sum;
+  }
+}
+
+// The first m cosine coefficients of the product of the m-term cosine
+// series f and g.
+void cosineproduct(double *f, double *g, double *h, unsigned int m)
+{
+  for(unsigned int k=0; k < m; ++k) h[k]=0.0;
+  for(unsigned int i=0; i < m; ++i) {
+    for(unsigned int j=0; j < m; ++j) {
+      double p=0.5*f[i]*g[j];
+      if(i+j < m) h[i+j] += p;
+      h[i > j ? i-j : j-i] += p;
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+  unsigned int nx=6;
+  unsigned int ny=5;
+  unsigned int nz=4;
+  unsigned int M=5;
+  unsigned int m=11;
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c = getopt(argc,argv,"M:m:x:y:z:T:h");
+    if (c == -1) break;
+    switch (c) {
+      case 0:
+        break;
+      case 'M':
+        M=atoi(optarg);
+        break;
+      case 'm':
+        m=atoi(optarg);
+        break;
+      case 'x':
+        nx=atoi(optarg);
+        break;
+      case 'y':
+        ny=atoi(optarg);
+        break;
+      case 'z':
+        nz=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'h':
+      default:
+        usageCommon(3);
+        exit(0);
+    }
+  }
+
+  cout << "nx=" << nx << ", ny=" << ny << ", nz=" << nz << ", M=" << M
+       << ", m=" << m << endl;
+
+  unsigned int n=nx*ny*nz;
+  size_t dist=n+3; // Leave gaps between the vectors.
+
+  double *f=doubleAlign(M*dist);
+  double *g=doubleAlign(M*dist);
+  double *h=doubleAlign(M*dist);
+
+  {
+    r2r1d Forward(n,FFTW_REDFT10,f,g);
+    r2r1d Backward(n,FFTW_REDFT01,g,h);
+    init(f,n);
+    redft10(f,h,n);
+    Forward.fft(f,g);
+    test("r2r1d",h,g,n);
+    Backward.fftNormalized(g,h);
+    test("r2r1d inverse",f,h,n);
+  }
+
+  {
+    r2r1d Single(n,FFTW_REDFT00);
+    mr2r1d Forward(n,FFTW_REDFT00,M,1,dist,h);
+    init(f,n,M,n);
+    for(unsigned int i=0; i < M; ++i)
+      Single.fft(f+i*n);
+    init(h,n,M,dist);
+    Forward.fft(h);
+    test("mr2r1d",f,h,n,M,dist);
+    Forward.fftNormalized(h);
+    init(f,n,M,n);
+    test("mr2r1d inverse",f,h,n,M,dist);
+  }
+
+  {
+    // Separable transforms along the rows and then the columns.
+    unsigned int my=ny*nz;
+    r2r2d Forward(nx,my,FFTW_REDFT10,FFTW_RODFT10,f,g);
+    r2r2d Backward(nx,my,FFTW_REDFT01,FFTW_RODFT01,g,h);
+    mr2r1d Rows(my,FFTW_RODFT10,nx,1,my,h);
+    mr2r1d Columns(nx,FFTW_REDFT10,my,my,1,h);
+    init(f,n);
+    init(h,n);
+    Forward.fft(f,g);
+    Rows.fft(h);
+    Columns.fft(h);
+    test("r2r2d",h,g,n);
+    Backward.fftNormalized(g,h);
+    test("r2r2d inverse",f,h,n);
+  }
+
+  {
+    unsigned int nyz=ny*nz;
+    r2r3d Forward(nx,ny,nz,FFTW_REDFT10,FFTW_REDFT11,FFTW_RODFT00,f,g);
+    r2r3d Backward(nx,ny,nz,FFTW_REDFT01,FFTW_REDFT11,FFTW_RODFT00,g,h);
+    mr2r1d Z(nz,FFTW_RODFT00,nx*ny,1,nz,h);
+    mr2r1d Y(ny,FFTW_REDFT11,nz,nz,1,h);
+    mr2r1d X(nx,FFTW_REDFT10,nyz,nyz,1,h);
+    init(f,n);
+    init(h,n);
+    Forward.fft(f,g);
+    Z.fft(h);
+    for(unsigned int i=0; i < nx; ++i)
+      Y.fft(h+i*nyz);
+    X.fft(h);
+    test("r2r3d",h,g,n);
+    Backward.fftNormalized(g,h);
+    test("r2r3d inverse",f,h,n);
+  }
+
+  deleteAlign(h);
+  deleteAlign(g);
+  deleteAlign(f);
+
+  if(m > 1) {
+    f=doubleAlign(m);
+    g=doubleAlign(m);
+    h=doubleAlign(m);
+    double *F=doubleAlign(m);
+    ImplicitCosineConvolution C(m);
+    for(unsigned int k=0; k < m; ++k) {
+      f[k]=F[k]=1.0/(k+1);
+      g[k]=k % 3+1.0;
+    }
+    cosineproduct(f,g,h,m);
+    C.convolve(F,g);
+    test("cosine product",h,F,m);
+    deleteAlign(F);
+    deleteAlign(h);
+    deleteAlign(g);
+    deleteAlign(f);
+  }
+
+  return 0;
+}
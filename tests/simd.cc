@@ -0,0 +1,190 @@
+#include "convolution.h"
+#include "utils.h"
+#include <sstream>
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Time the 1D complex and Hermitian convolutions with the kernels of each
+// instruction set available on this processor, and compare their results
+// with those of the SSE2 kernels.
+
+// Number of iterations.
+unsigned int N0=10000000;
+unsigned int N=0;
+unsigned int m=1024;
+unsigned int A=2;
+
+inline void init(Complex **F, unsigned int n, unsigned int A)
+{
+  for(unsigned int a=0; a < A; ++a) {
+    Complex *f=F[a];
+    for(unsigned int i=0; i < n; ++i)
+      f[i]=Complex((a+1)*(i % 7),1.0/(a+i+1));
+  }
+}
+
+double difference(Complex *f, Complex *g, unsigned int n)
+{
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int i=0; i < n; ++i) {
+    error += abs2(f[i]-g[i]);
+    norm += abs2(g[i]);
+  }
+  return norm > 0 ? sqrt(error/norm) : 0.0;
+}
+
+multiplier *Multiplier(unsigned int A)
+{
+  switch(A) {
+    case 2: return multbinary;
+    case 4: return multbinary2;
+    case 6: return multbinary3;
+    case 8: return multbinary4;
+    case 16: return multbinary8;
+  }
+  cerr << "A=" << A << " is not yet implemented" << endl;
+  exit(1);
+}
+
+realmultiplier *RealMultiplier(unsigned int A)
+{
+  switch(A) {
+    case 2: return multbinary;
+    case 4: return multbinary2;
+  }
+  cerr << "A=" << A << " is not yet implemented" << endl;
+  exit(1);
+}
+
+// Run test r with the selected kernels, leaving the result in h.
+void test(int r, int stats, double *T, Complex **F, Complex *h)
+{
+  ostringstream text;
+  text << ISAName[CurrentISA()];
+  if(r == 0) {
+    ImplicitConvolution C(m,A);
+    multiplier *mult=Multiplier(A);
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m,A);
+      seconds();
+      C.convolve(F,mult);
+      T[i]=seconds();
+    }
+    text << " cconv";
+  } else {
+    ImplicitHConvolution C(m,A);
+    realmultiplier *mult=RealMultiplier(A);
+    for(unsigned int i=0; i < N; ++i) {
+      init(F,m,A);
+      seconds();
+      C.convolve(F,mult);
+      T[i]=seconds();
+    }
+    text << " conv";
+  }
+  timings(text.str().c_str(),m,T,N,stats);
+  for(unsigned int i=0; i < m; ++i)
+    h[i]=F[0][i];
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+  int r=-1; // Which test to run: -1=all, 0=cconv, 1=conv
+
+  int stats=0; // Type of statistics used in timing test.
+
+#ifndef __SSE2__
+  fftw::effort |= FFTW_NO_SIMD;
+#endif
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c=getopt(argc,argv,"hA:N:m:n:T:S:r:");
+    if (c == -1) break;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'A':
+        A=atoi(optarg);
+        break;
+      case 'N':
+        N=atoi(optarg);
+        break;
+      case 'm':
+        m=atoi(optarg);
+        break;
+      case 'n':
+        N0=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'S':
+        stats=atoi(optarg);
+        break;
+      case 'r':
+        r=atoi(optarg);
+        break;
+      case 'h':
+      default:
+        usageCommon(1);
+        std::cerr << "-A\t\t number of data blocks in input" << std::endl;
+        std::cerr << "-r\t\t type of run:\n"
+                  << "\t\t r=-1: all runs\n"
+                  << "\t\t r=0: cconv\n"
+                  << "\t\t r=1: conv\n";
+        exit(0);
+    }
+  }
+
+  cout << "m=" << m << endl;
+
+  if(N == 0) {
+    N=N0/m;
+    N=max(N,20);
+  }
+  cout << "N=" << N << endl;
+
+  cout << "ISA=" << ISAName[CurrentISA()] << endl;
+
+  double *T=new double[N];
+
+  Complex *f=ComplexAlign(A*m);
+  Complex **F=new Complex *[A];
+  for(unsigned int a=0; a < A; ++a)
+    F[a]=f+a*m;
+  Complex *h0=ComplexAlign(m);
+  Complex *h=ComplexAlign(m);
+
+  ISA isa=CurrentISA();
+  for(int R=0; R <= 1; ++R) {
+    if(r != -1 && r != R) continue;
+    cout << endl;
+    SelectISA(SSE2);
+    test(R,stats,T,F,h0);
+    for(int i=AVX2; i <= AVX512; ++i) {
+      if(!SelectISA((ISA) i)) continue;
+      test(R,stats,T,F,h);
+      double error=difference(h,h0,m);
+      cout << "difference=" << error << endl;
+      if(error > 1e-12)
+        cerr << "Caution! difference=" << error << endl;
+    }
+  }
+  SelectISA(isa);
+
+  deleteAlign(h);
+  deleteAlign(h0);
+  delete [] F;
+  deleteAlign(f);
+  delete [] T;
+
+  return 0;
+}
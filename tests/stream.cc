@@ -0,0 +1,144 @@
+#include "streamconvolution.h"
+#include "utils.h"
+
+using namespace std;
+using namespace utils;
+using namespace fftwpp;
+
+// Time the streaming convolution of a signal of length L, pushed in chunks
+// of length n, with a kernel of length K, and compare the result with
+// direct summation.
+
+// Number of iterations.
+unsigned int N0=10000000;
+unsigned int N=0;
+unsigned int K=100;
+unsigned int L=10000;
+unsigned int n=777;
+unsigned int m=0;
+
+inline void init(Complex *x, unsigned int L, unsigned int a)
+{
+  for(unsigned int i=0; i < L; ++i)
+    x[i]=Complex((a+1)*(i % 7),1.0/(a+i+1));
+}
+
+// Convolve the L values x in chunks of length n, returning the
+// L+K-1 values of the full convolution in y.
+void stream(StreamConvolution& C, Complex *x, Complex *y)
+{
+  unsigned int count=0;
+  for(unsigned int i=0; i < L; i += n)
+    count += C.push(x+i,min(n,L-i),y+count);
+  count += C.flush(y+count);
+  if(count != L+K-1)
+    cerr << "Caution! " << count << " values returned instead of "
+         << L+K-1 << endl;
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+  int stats=0; // Type of statistics used in timing test.
+
+#ifndef __SSE2__
+  fftw::effort |= FFTW_NO_SIMD;
+#endif
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c=getopt(argc,argv,"hN:m:K:L:c:n:T:S:");
+    if (c == -1) break;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'N':
+        N=atoi(optarg);
+        break;
+      case 'm':
+        m=atoi(optarg);
+        break;
+      case 'K':
+        K=atoi(optarg);
+        break;
+      case 'L':
+        L=atoi(optarg);
+        break;
+      case 'c':
+        n=max(atoi(optarg),1);
+        break;
+      case 'n':
+        N0=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'S':
+        stats=atoi(optarg);
+        break;
+      case 'h':
+      default:
+        usageCommon(1);
+        std::cerr << "-K\t\t kernel length" << std::endl;
+        std::cerr << "-L\t\t signal length" << std::endl;
+        std::cerr << "-c\t\t chunk length" << std::endl;
+        exit(0);
+    }
+  }
+
+  cout << "K=" << K << endl;
+  cout << "L=" << L << endl;
+  cout << "chunk=" << n << endl;
+
+  if(N == 0) {
+    N=N0/L;
+    N=max(N,20);
+  }
+  cout << "N=" << N << endl;
+
+  double *T=new double[N];
+
+  Complex *h=ComplexAlign(K);
+  Complex *x=ComplexAlign(L);
+  init(h,K,1);
+  init(x,L,0);
+
+  StreamConvolution C(h,K,m);
+  cout << "m=" << C.block() << endl;
+
+  Complex *y=ComplexAlign(L+K-1+C.block());
+
+  for(unsigned int i=0; i < N; ++i) {
+    seconds();
+    stream(C,x,y);
+    T[i]=seconds();
+  }
+  timings("Stream",L,T,N,stats);
+
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int i=0; i < L+K-1; ++i) {
+    Complex sum=0.0;
+    unsigned int start=i >= K ? i-K+1 : 0;
+    unsigned int stop=min(i+1,L);
+    for(unsigned int j=start; j < stop; ++j)
+      sum += x[j]*h[i-j];
+    error += abs2(y[i]-sum);
+    norm += abs2(sum);
+  }
+  if(norm > 0) error=sqrt(error/norm);
+  cout << "error=" << error << endl;
+  if(error > 1e-12)
+    cerr << "Caution! error=" << error << endl;
+
+  deleteAlign(y);
+  deleteAlign(x);
+  deleteAlign(h);
+  delete [] T;
+
+  return 0;
+}
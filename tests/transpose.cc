@@ -20,7 +20,7 @@ inline void init(array3<Complex>& f, bool transpose=false)
   for(unsigned int i=0; i < mx; ++i) {
     for(unsigned int j=0; j < my; ++j) {
       for(unsigned int k=0; k < mz; ++k) {
-        Complex val=Complex(i,j);
+        Complex val=Complex(i+0.5*k,j);
         if(!transpose)
           f[i][j][k]=val;
         else
@@ -39,6 +39,8 @@ int main(int argc, char* argv[])
   int stats=0; // Type of statistics used in timing test.
 
   bool inplace = true;
+
+  int engine=-1; // Engine chosen by timing
   
 #ifndef __SSE2__
   fftw::effort |= FFTW_NO_SIMD;
@@ -48,7 +50,7 @@ int main(int argc, char* argv[])
   optind=0;
 #endif  
   for (;;) {
-    int c = getopt(argc,argv,"hN:m:x:y:z:n:T:S:i:d");
+    int c = getopt(argc,argv,"hN:m:x:y:z:n:T:S:i:e:d");
     if (c == -1) break;
                 
     switch (c) {
@@ -81,9 +83,14 @@ int main(int argc, char* argv[])
       case 'i':
         inplace = atoi(optarg);
         break;
+      case 'e':
+        engine=atoi(optarg);
+        break;
       case 'h':
       default:
         usageInplace(2);
+        cerr << "-e\t\t 0=FFTW, 1=blocked, 2=blocked with streaming stores,"
+             << endl << "\t\t 3=native in-place" << endl;
         exit(1);
     }
   }
@@ -106,6 +113,9 @@ int main(int argc, char* argv[])
   array3<Complex> g(my,mx,mz,pg);
 
   Transpose transpose(mx,my,mz,f(),g());
+  if(engine >= 0)
+    transpose.engine=(Transpose::Engine) engine;
+  cout << "engine=" << transpose.engine << endl;
 
   if(N == 0) {
     init(f);
@@ -0,0 +1,198 @@
+#include "Complex.h"
+#include "Array.h"
+#include "fftw++.h"
+#include "convolution.h"
+#include "utils.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace utils;
+using namespace Array;
+using namespace fftwpp;
+
+// Construct, use, and destroy small transforms and convolutions while a
+// measured plan of length m is built in the background (see fftw::upgrade),
+// reporting the longest constructor time, and destroy the owner of that
+// plan while it is still being built. Wisdom is kept in a fresh directory,
+// so that the plans are always built.
+
+unsigned int m=1 << 20;
+unsigned int N=1000;
+
+char dir[]="/tmp/fftwpp-XXXXXX";
+
+// Remove the wisdom directory, after the wisdom has been saved at exit.
+void cleanup()
+{
+  DIR *d=opendir(dir);
+  if(!d) return;
+  struct dirent *e;
+  while((e=readdir(d)))
+    unlink((string(dir)+"/"+e->d_name).c_str());
+  closedir(d);
+  rmdir(dir);
+}
+
+inline void init(Complex *f, unsigned int n)
+{
+  for(unsigned int i=0; i < n; ++i)
+    f[i]=Complex(i % 7,1.0/(i+1));
+}
+
+double error(Complex *f, Complex *g, unsigned int n)
+{
+  double error=0.0;
+  double norm=0.0;
+  for(unsigned int i=0; i < n; ++i) {
+    error += abs2(f[i]-g[i]);
+    norm += abs2(g[i]);
+  }
+  return norm > 0 ? sqrt(error/norm) : 0.0;
+}
+
+// Apply the forward and normalized backward transforms of length n to f,
+// returning the error.
+template<class Forward, class Backward, class T>
+double roundtrip(Forward& F, Backward& B, Complex *f, T *g, unsigned int n)
+{
+  array1<Complex> h(n,sizeof(Complex));
+  init(f,n);
+  for(unsigned int i=0; i < n; ++i)
+    h[i]=f[i];
+  F.fft(f,g);
+  B.fftNormalized(g,f);
+  return error(f,h,n);
+}
+
+int main(int argc, char* argv[])
+{
+  fftw::maxthreads=get_max_threads();
+
+#ifdef __GNUC__
+  optind=0;
+#endif
+  for (;;) {
+    int c=getopt(argc,argv,"hN:m:x:T:");
+    if (c == -1) break;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'N':
+        N=atoi(optarg);
+        break;
+      case 'm':
+        m=atoi(optarg);
+        break;
+      case 'x':
+        m=atoi(optarg);
+        break;
+      case 'T':
+        fftw::maxthreads=max(atoi(optarg),1);
+        break;
+      case 'h':
+      default:
+        usageFFT(1);
+        exit(0);
+    }
+  }
+
+  cout << "m=" << m << endl;
+  cout << "N=" << N << endl;
+
+  if(!mkdtemp(dir)) {
+    cerr << "Cannot create a wisdom directory" << endl;
+    exit(1);
+  }
+  atexit(cleanup);
+  string wisdom=string(dir)+"/wisdom3.txt";
+  fftw::WisdomName=wisdom.c_str();
+  fftw::upgrade=true;
+
+  size_t align=sizeof(Complex);
+  array1<Complex> f(m,align);
+  array1<Complex> g(m,align);
+
+  double maxerror=0.0;
+  double maxtime=0.0;
+  double total=0.0;
+  unsigned int count=0;
+
+  fft1d *Big=new fft1d(m,-1,f,g);
+  init(f,m);
+  Big->fft(f,g); // Start the upgrade
+
+  for(unsigned int i=0; i < N; ++i) {
+    unsigned int n=12+i % 37;
+    Complex *F[]={f,f+n};
+
+    seconds();
+    fft1d Forward(n,-1,f,g);
+    fft1d Backward(n,1,g,f);
+    double t=seconds();
+    maxtime=max(maxtime,0.5*t);
+    total += t;
+    count += 2;
+    maxerror=max(maxerror,roundtrip(Forward,Backward,f,(Complex *) g,n));
+
+    seconds();
+    mfft1d mForward(n,-1,4,1,0,f,g);
+    mfft1d mBackward(n,1,4,1,0,g,f);
+    t=seconds();
+    maxtime=max(maxtime,0.5*t);
+    total += t;
+    count += 2;
+    maxerror=max(maxerror,roundtrip(mForward,mBackward,f,(Complex *) g,4*n));
+
+    seconds();
+    rcfft1d rcForward(2*n,(double *) f(),g);
+    crfft1d crBackward(2*n,g,(double *) f());
+    t=seconds();
+    maxtime=max(maxtime,0.5*t);
+    total += t;
+    count += 2;
+    double *r=(double *) f();
+    for(unsigned int j=0; j < 2*n; ++j)
+      r[j]=j % 5;
+    rcForward.fft(r,g);
+    crBackward.fftNormalized(g,r);
+    double rerror=0.0;
+    for(unsigned int j=0; j < 2*n; ++j)
+      rerror=max(rerror,fabs(r[j]-j % 5));
+    maxerror=max(maxerror,rerror);
+
+    seconds();
+    ImplicitConvolution C(n);
+    t=seconds();
+    maxtime=max(maxtime,t);
+    total += t;
+    ++count;
+    init(F[0],n);
+    init(F[1],n);
+    C.convolve(F,multbinary);
+
+    if(i == N/2) {
+      // Destroy the big transform, most likely while its plan is being
+      // built, and replace it.
+      delete Big;
+      Big=new fft1d(m,-1,f,g);
+      init(f,m);
+      Big->fft(f,g);
+    }
+  }
+
+  cout << "mean constructor time=" << total/count << endl;
+  cout << "max constructor time=" << maxtime << endl;
+
+  fft1d Backward(m,1,g,f);
+  maxerror=max(maxerror,roundtrip(*Big,Backward,f,(Complex *) g,m));
+  delete Big;
+
+  cout << "error=" << maxerror << endl;
+  if(maxerror > 1e-12)
+    cerr << "Caution! error=" << maxerror << endl;
+
+  return 0;
+}
@@ -11,7 +11,25 @@
 #define _CFFTWPP_H_
 
 #ifdef  __cplusplus
-namespace fftwpp { extern "C" {
+// In C++, the implicit convolutions are the double instances of class
+// templates (see convolution.h) rather than the opaque structs declared
+// below for C.
+namespace fftwpp {
+template<class Real> class ImplicitConvolutionT;
+template<class Real> class ImplicitHConvolutionT;
+template<class Real> class ImplicitConvolution2T;
+template<class Real> class ImplicitHConvolution2T;
+template<class Real> class ImplicitConvolution3T;
+template<class Real> class ImplicitHConvolution3T;
+
+typedef ImplicitConvolutionT<double> ImplicitConvolution;
+typedef ImplicitHConvolutionT<double> ImplicitHConvolution;
+typedef ImplicitConvolution2T<double> ImplicitConvolution2;
+typedef ImplicitHConvolution2T<double> ImplicitHConvolution2;
+typedef ImplicitConvolution3T<double> ImplicitConvolution3;
+typedef ImplicitHConvolution3T<double> ImplicitHConvolution3;
+
+extern "C" {
 #endif
 
 // wrappers for allocating aligned memory arrays
@@ -25,7 +43,9 @@ namespace fftwpp { extern "C" {
   void set_fftwpp_maxthreads(unsigned int nthreads);
 
 // 1d complex non-centered convolution
+#ifndef __cplusplus
   typedef struct ImplicitConvolution ImplicitConvolution;
+#endif
   ImplicitConvolution *fftwpp_create_conv1d(unsigned int nx);
   ImplicitConvolution *fftwpp_create_conv1d_dot(unsigned int m, 
                                                 unsigned int M);
@@ -51,7 +71,9 @@ namespace fftwpp { extern "C" {
   void fftwpp_conv1d_delete(ImplicitConvolution *conv);
 
 // 1d Hermitian-symmetric entered convolution
+#ifndef __cplusplus
   typedef struct ImplicitHConvolution ImplicitHConvolution;
+#endif
   ImplicitHConvolution *fftwpp_create_hconv1d(unsigned int m);
   ImplicitHConvolution *fftwpp_create_hconv1d_dot(unsigned int m,
                                                   unsigned int M);
@@ -75,7 +97,9 @@ namespace fftwpp { extern "C" {
   void fftwpp_hconv1d_delete(ImplicitHConvolution *conv);
 
 // 2d complex non-centered convolution
+#ifndef __cplusplus
   typedef struct ImplicitConvolution2 ImplicitConvolution2;
+#endif
   ImplicitConvolution2 *fftwpp_create_conv2d(unsigned int mx, unsigned int my);
   ImplicitConvolution2 *fftwpp_create_conv2d_dot(unsigned int mx, unsigned int my,
                                                  unsigned int M);
@@ -102,7 +126,9 @@ namespace fftwpp { extern "C" {
   void fftwpp_conv2d_delete(ImplicitConvolution2 *conv);
 
 // 2d Hermitian-symmetric centered convolution
+#ifndef __cplusplus
   typedef struct ImplicitHConvolution2 ImplicitHConvolution2;
+#endif
   ImplicitHConvolution2 *fftwpp_create_hconv2d(unsigned int mx, unsigned int my);
   ImplicitHConvolution2 *fftwpp_create_hconv2d_dot(unsigned int mx, 
                                                    unsigned int my,
@@ -133,7 +159,9 @@ namespace fftwpp { extern "C" {
   void fftwpp_hconv2d_delete(ImplicitHConvolution2 *conv);
 
 // 3d complex non-centered convolution
+#ifndef __cplusplus
   typedef struct ImplicitConvolution3 ImplicitConvolution3;
+#endif
   ImplicitConvolution3 *fftwpp_create_conv3d(unsigned int mx, unsigned int my, 
                                              unsigned int mz);
   ImplicitConvolution3 *fftwpp_create_conv3d_work(unsigned int mx,
@@ -158,7 +186,9 @@ namespace fftwpp { extern "C" {
   void fftwpp_conv3d_delete(ImplicitConvolution3 *conv);
 
 // 3d Hermitian-symmetric centered convolution
+#ifndef __cplusplus
   typedef struct ImplicitHConvolution3 ImplicitHConvolution3;
+#endif
   ImplicitHConvolution3 *fftwpp_create_hconv3d(unsigned int mx, unsigned int my, 
                                                unsigned int mz);
   ImplicitHConvolution3 *fftwpp_create_hconv3d_dot(unsigned int mx, 